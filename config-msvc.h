@@ -3,6 +3,9 @@
 /* 
 / Sandro: manually adjusted so to support the MSVC compiler 
 /         using the OsGeo4W libraries
+/* Should be defined in order to enable libdeflate support. */
+/* #undef ENABLE_LIBDEFLATE */
+
 /* Define to 1 if you have the <dlfcn.h> header file. */
 #define HAVE_DLFCN_H 1
 
@@ -28,6 +31,9 @@
 /* Define to 1 if you have the <minizip/unzip.h> header file. */
 /* #undef HAVE_MINIZIP_UNZIP_H */
 
+/* Define to 1 if you have the <pthread.h> header file. */
+/* #undef HAVE_PTHREAD_H */
+
 /* Define to 1 if you have the `sqrt' function. */
 /* #undef HAVE_SQRT */
 
@@ -74,6 +80,9 @@
 /* Define to 1 if you have the <unistd.h> header file. */
 /* #undef HAVE_UNISTD_H 1 */
 
+/* Define to 1 if you have the <zlib.h> header file. */
+#define HAVE_ZLIB_H 1
+
 /* Define to 1 if `lstat' dereferences a symlink specified with a trailing
    slash. */
 #define LSTAT_FOLLOWS_SLASHED_SYMLINK 1
@@ -85,6 +94,9 @@
 /* Should be defined in order to disable XML documents support. */
 /* #undef OMIT_XMLDOC */
 
+/* Should be defined in order to disable multithreading support. */
+/* #undef OMIT_THREADS */
+
 /* Name of package */
 #define PACKAGE "freexl"
 
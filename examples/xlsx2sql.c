@@ -118,6 +118,7 @@ main (int argc, char *argv[])
     unsigned short columns;
     unsigned int row;
     unsigned short col;
+    FreeXL_CellValue *cells = NULL;
 
     if (argc == 2 || argc == 3)
       {
@@ -178,6 +179,18 @@ main (int argc, char *argv[])
 		fprintf (stderr, "WORKSHEET-DIMENSIONS Error: %d\n", ret);
 		goto stop;
 	    }
+	  /* a whole Row of Cells will be fetched at once */
+	  if (columns > 0)
+	    {
+		FreeXL_CellValue *p =
+		    realloc (cells, sizeof (FreeXL_CellValue) * columns);
+		if (p == NULL)
+		  {
+		      fprintf (stderr, "INSUFFICIENT MEMORY\n");
+		      goto stop;
+		  }
+		cells = p;
+	    }
 
 	  printf ("--\n-- creating a DB table\n");
 	  printf ("-- extracting data from Worksheet #%u: %s\n--\n",
@@ -192,38 +205,36 @@ main (int argc, char *argv[])
 	  for (row = 0; row < rows; row++)
 	    {
 		/* INSERT INTO statements */
-		FreeXL_CellValue cell;
-
 		printf ("INSERT INTO %s (row_no", table_name);
 		for (col = 0; col < columns; col++)
 		    printf (", col_%03u", col);
 		printf (") VALUES (%u", row);
+		ret = freexl_get_row_values (handle, row, 0, columns, cells);
+		if (ret != FREEXL_OK)
+		  {
+		      fprintf (stderr, "ROW-VALUES-ERROR (r=%u): %d\n", row,
+			       ret);
+		      goto stop;
+		  }
 		for (col = 0; col < columns; col++)
 		  {
-		      ret = freexl_get_cell_value (handle, row, col, &cell);
-		      if (ret != FREEXL_OK)
-			{
-			    fprintf (stderr,
-				     "CELL-VALUE-ERROR (r=%u c=%u): %d\n", row,
-				     col, ret);
-			    goto stop;
-			}
-		      switch (cell.type)
+		      FreeXL_CellValue *cell = cells + col;
+		      switch (cell->type)
 			{
 			case FREEXL_CELL_INT:
-			    printf (", %d", cell.value.int_value);
+			    printf (", %d", cell->value.int_value);
 			    break;
 			case FREEXL_CELL_DOUBLE:
-			    printf (", %1.12f", cell.value.double_value);
+			    printf (", %1.12f", cell->value.double_value);
 			    break;
 			case FREEXL_CELL_TEXT:
 			case FREEXL_CELL_SST_TEXT:
-			    print_sql_string (cell.value.text_value);
+			    print_sql_string (cell->value.text_value);
 			    break;
 			case FREEXL_CELL_DATE:
 			case FREEXL_CELL_DATETIME:
 			case FREEXL_CELL_TIME:
-			    printf (", '%s'", cell.value.text_value);
+			    printf (", '%s'", cell->value.text_value);
 			    break;
 			case FREEXL_CELL_NULL:
 			default:
@@ -238,6 +249,8 @@ main (int argc, char *argv[])
     printf ("COMMIT;\n");
 
   stop:
+    if (cells != NULL)
+	free (cells);
 /* closing the .ODS file [Workbook] */
     ret = freexl_close (handle);
     if (ret != FREEXL_OK)
@@ -63,6 +63,8 @@
 #define _FREEXL_H
 #endif
 
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -228,6 +230,21 @@ extern "C"
 #define FREEXL_BIFF_FORMAT_COUNT	32012
 /** Information query for BIFF extended format count */
 #define FREEXL_BIFF_XF_COUNT		32013
+/** Information query for the declared row count of the active worksheet */
+#define FREEXL_SHEET_ROWS		32014
+/** Information query for the declared column count of the active
+    worksheet */
+#define FREEXL_SHEET_COLUMNS		32015
+
+/* XLSX Shared Strings loading modes */
+/** all XLSX Shared Strings are decoded when opening (default) */
+#define FREEXL_XLSX_STRINGS_EAGER	0
+/** XLSX Shared Strings are decoded on demand; only the compressed XML is
+    kept in memory */
+#define FREEXL_XLSX_STRINGS_LAZY	1
+/** XLSX Shared Strings are decoded on demand; the inflated XML is kept in
+    a temporary file */
+#define FREEXL_XLSX_STRINGS_LAZY_TMPFILE	2
 
 /* Error codes */
 #define FREEXL_OK			0 /**< No error, success */
@@ -314,6 +331,10 @@ extern "C"
                                               worksheet. Possibly a forgotten
                                               call to 
                                               freexl_select_active_worksheet() */
+#define FREEXL_BUFFER_TOO_SMALL		-34 /**< The caller supplied buffer is
+                                              not big enough */
+#define FREEXL_UNDECLARED_DIMENSION	-35 /**< The worksheet does not
+                                              declare its own dimensions */
 
     /**
      Container for a cell value
@@ -388,6 +409,326 @@ extern "C"
      */
     typedef struct FreeXL_CellValue_str FreeXL_CellValue;
 
+    /**
+     Container for a block of values taken from a single column
+     
+     freexl_get_column_block() takes a pointer to this structure, and fills
+     in all the arrays the caller has supplied; any array set to NULL
+     will simply be ignored.
+     
+     Text values (including dates and times) are stored back to back
+     into the text buffer, without any NUL terminator: the value of
+     the i-th cell spans from text[offsets[i]] to text[offsets[i + 1]].
+     
+     \code
+	unsigned char types[100];
+	double numbers[100];
+	unsigned int offsets[101];
+	char text[8192];
+	FreeXL_ColumnBlock block;
+	memset(&block, 0, sizeof(block));
+	block.types = types;
+	block.double_values = numbers;
+	block.offsets = offsets;
+	block.text = text;
+	block.text_size = sizeof(text);
+	freexl_get_column_block(handle, 0, 0, 100, &block);
+     \endcode
+     */
+    struct FreeXL_ColumnBlock_str
+    {
+	unsigned char *types; /**< n_rows cell types (FREEXL_CELL_NULL,
+	FREEXL_CELL_INT and so on) */
+	int *int_values; /**< n_rows values: the int_value of any
+	FREEXL_CELL_INT cell, 0 for any other cell */
+	double *double_values; /**< n_rows values: the double_value of any
+	FREEXL_CELL_DOUBLE cell, 0.0 for any other cell */
+	unsigned char *validity; /**< (n_rows + 7) / 8 bytes: a bitmap with
+	one bit set for each non-NULL cell, least significant bit first */
+	unsigned int *offsets; /**< n_rows + 1 offsets into the text buffer;
+	any cell without a text value has a zero length */
+	char *text; /**< UTF-8 buffer receiving all text values */
+	unsigned int text_size; /**< the size (in bytes) of the text buffer */
+	unsigned int text_length; /**< the number of bytes required by all
+	text values (return value) */
+    };
+
+    /**
+     Typedef for column block structure.
+     
+     \sa FreeXL_ColumnBlock_str
+     */
+    typedef struct FreeXL_ColumnBlock_str FreeXL_ColumnBlock;
+
+    /**
+     Container for the statistics of a worksheet column, as returned
+     by freexl_get_column_stats()
+     */
+    struct FreeXL_ColumnStats_str
+    {
+	unsigned int null_count; /**< number of NULL (empty) cells */
+	unsigned int int_count; /**< number of FREEXL_CELL_INT cells */
+	unsigned int double_count; /**< number of FREEXL_CELL_DOUBLE cells */
+	unsigned int text_count; /**< number of FREEXL_CELL_TEXT and 
+	FREEXL_CELL_SST_TEXT cells */
+	unsigned int date_count; /**< number of FREEXL_CELL_DATE cells */
+	unsigned int datetime_count; /**< number of FREEXL_CELL_DATETIME
+	cells */
+	unsigned int time_count; /**< number of FREEXL_CELL_TIME cells */
+	double min_value; /**< the smallest FREEXL_CELL_INT or 
+	FREEXL_CELL_DOUBLE value (0.0 if there isn't any) */
+	double max_value; /**< the largest FREEXL_CELL_INT or 
+	FREEXL_CELL_DOUBLE value (0.0 if there isn't any) */
+	unsigned int max_text_length; /**< the length (in bytes) of the 
+	longest text value */
+	int suggested_type; /**< the narrowest cell type able to hold every
+	value of the column: FREEXL_CELL_INT, FREEXL_CELL_DOUBLE, 
+	FREEXL_CELL_DATE, FREEXL_CELL_DATETIME, FREEXL_CELL_TIME or 
+	FREEXL_CELL_TEXT; FREEXL_CELL_NULL if all cells are empty */
+    };
+
+    /**
+     Typedef for column statistics structure.
+     
+     \sa FreeXL_ColumnStats_str
+     */
+    typedef struct FreeXL_ColumnStats_str FreeXL_ColumnStats;
+
+    /**
+     Callback receiving the cells of a row, as used by freexl_scan_xls()
+     
+     \param ctx the opaque pointer passed to freexl_scan_xls()
+     \param row row number (zero base)
+     \param n_cells number of cells in this row
+     \param columns column number of each cell (zero base)
+     \param values type and value of each cell
+     
+     \return 0 in order to continue the scan; any other value will stop
+     the scan immediately
+     
+     \note only non-NULL cells are reported. All pointers (including 
+     any text_value) are valid only until the callback returns.
+     */
+    typedef int (*FreeXL_RowCallback) (void *ctx, unsigned int row,
+				       unsigned short n_cells,
+				       const unsigned short *columns,
+				       const FreeXL_CellValue * values);
+
+/* 
+ Apache Arrow C Data Interface and C Stream Interface
+ (ABI-stable definitions, exactly as published by the Arrow project)
+*/
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+    struct ArrowSchema
+    {
+	/* Array type description */
+	const char *format;
+	const char *name;
+	const char *metadata;
+	int64_t flags;
+	int64_t n_children;
+	struct ArrowSchema **children;
+	struct ArrowSchema *dictionary;
+
+	/* Release callback */
+	void (*release) (struct ArrowSchema *);
+	/* Opaque producer-specific data */
+	void *private_data;
+    };
+
+    struct ArrowArray
+    {
+	/* Array data description */
+	int64_t length;
+	int64_t null_count;
+	int64_t offset;
+	int64_t n_buffers;
+	int64_t n_children;
+	const void **buffers;
+	struct ArrowArray **children;
+	struct ArrowArray *dictionary;
+
+	/* Release callback */
+	void (*release) (struct ArrowArray *);
+	/* Opaque producer-specific data */
+	void *private_data;
+    };
+
+#endif /* ARROW_C_DATA_INTERFACE */
+
+#ifndef ARROW_C_STREAM_INTERFACE
+#define ARROW_C_STREAM_INTERFACE
+
+    struct ArrowArrayStream
+    {
+	/* Callbacks providing stream functionality */
+	int (*get_schema) (struct ArrowArrayStream *, struct ArrowSchema * out);
+	int (*get_next) (struct ArrowArrayStream *, struct ArrowArray * out);
+	const char *(*get_last_error) (struct ArrowArrayStream *);
+
+	/* Release callback */
+	void (*release) (struct ArrowArrayStream *);
+
+	/* Opaque producer-specific data */
+	void *private_data;
+    };
+
+#endif /* ARROW_C_STREAM_INTERFACE */
+
+    /**
+     Container for the options supported by the extended open functions
+     
+     Always call freexl_init_open_options() before setting any option,
+     so that any option you do not care about will get its default value.
+     
+     \code
+	FreeXL_OpenOptions options;
+	freexl_init_open_options(&options);
+	options.xlsx_strings_mode = FREEXL_XLSX_STRINGS_LAZY;
+	freexl_open_xlsx_ex("sample.xlsx", &options, &handle);
+     \endcode
+     */
+    struct FreeXL_OpenOptions_str
+    {
+	/**
+	 How XLSX Shared Strings will be loaded. Can be one of the following:
+	 - FREEXL_XLSX_STRINGS_EAGER all strings are decoded when opening.
+	 - FREEXL_XLSX_STRINGS_LAZY only the position of each string is
+	 recorded when opening; strings will be decoded the first time they
+	 are requested, and just the compressed XML (plus a few restart
+	 points, one every MB or so) is kept in memory.
+	 - FREEXL_XLSX_STRINGS_LAZY_TMPFILE same as above, but the inflated
+	 XML is kept in a temporary file.
+	 */
+	int xlsx_strings_mode;
+	/**
+	 Max number of decoded strings kept by the lazy modes; the least
+	 recently used ones will be discarded. 0 means the default (4096).
+	 
+	 \note in the lazy modes any text_value returned for a 
+	 FREEXL_CELL_SST_TEXT cell will stay valid only until as many other
+	 distinct strings have been requested.
+	 */
+	int xlsx_strings_cache;
+	/**
+	 If non-zero, each XLSX Worksheet and the ODS content.xml will be
+	 inflated by a separate thread while the XML is being parsed, so
+	 that decompression and parsing overlap. 0 (the default) means
+	 that each XLSX Worksheet is inflated first and parsed next, while
+	 the ODS content.xml is inflated and parsed a chunk at a time by
+	 the calling thread.
+	 
+	 \note this option is silently ignored when the library has been
+	 built without multithreading support.
+	 */
+	int xml_pipeline;
+	/**
+	 NULL-terminated list of the ODS Worksheets to be loaded; NULL
+	 (the default) means all of them.
+	 
+	 \note any other Worksheet will still be reported by 
+	 freexl_get_worksheets_count() and freexl_get_worksheet_name(),
+	 but will always be empty (zero rows and zero columns) because
+	 its content is skipped while parsing.
+	 */
+	const char **ods_sheets;
+	/**
+	 Max number of threads parsing the ODS Worksheets at the same time.
+	 0 or 1 (the default) means that content.xml will be parsed
+	 sequentially a chunk at a time; any greater value means that the
+	 whole content.xml will be inflated in memory, so that each 
+	 Worksheet could then be parsed by its own thread.
+	 
+	 \note this option is silently ignored when the library has been
+	 built without multithreading support.
+	 */
+	int ods_threads;
+	/**
+	 Max number of threads parsing the XLS Worksheets at the same time.
+	 0 or 1 (the default) means that the whole Workbook stream will be
+	 parsed sequentially; any greater value means that once the global
+	 tables (shared strings, formats) have been parsed each Worksheet 
+	 substream will be parsed by its own thread, directly seeking to
+	 its starting offset. Only supported by freexl_open_ex().
+	 
+	 \note this option is silently ignored when the library has been
+	 built without multithreading support, and for very small files.
+	 */
+	int xls_threads;
+	/**
+	 Index (base 0) of the only Worksheet to be loaded; -1 (the default)
+	 means all of them.
+	 
+	 \note any other Worksheet will still be reported by 
+	 freexl_get_worksheets_count() and freexl_get_worksheet_name(),
+	 but will be empty because its cells are skipped while parsing.
+	 */
+	int sheet_index;
+	/**
+	 Array of the column numbers (base 0) to be loaded, containing
+	 n_columns elements; NULL (the default) means all columns.
+	 */
+	const unsigned short *columns;
+	/**
+	 Number of elements in the columns array.
+	 */
+	int n_columns;
+	/**
+	 Row number (base 0) of the first row to be loaded; 0 by default.
+	 */
+	unsigned int first_row;
+	/**
+	 Max number of rows to be loaded, starting from first_row; 0 (the
+	 default) means up to the last row.
+	 
+	 \note sheet_index, columns, first_row and n_rows together define
+	 a projection: any cell outside it is discarded while parsing, 
+	 before being decoded or stored. All other cells keep their own row
+	 and column numbers; the discarded ones will simply be reported as
+	 FREEXL_CELL_NULL, and the worksheet dimensions never extend past 
+	 the last requested row and the highest requested column. XLSX and
+	 ODS worksheets stop being parsed as soon as the requested rows 
+	 are over.
+	 */
+	unsigned int n_rows;
+	/**
+	 If non-zero, enables the preview mode: no more than preview_rows
+	 rows (starting from first_row) will be loaded from each worksheet,
+	 exactly as for n_rows, and each worksheet will be abandoned as
+	 soon as the first later row is found. XLSX worksheets stop being
+	 inflated, ODS parsing jumps to the next table and XLS parsing seeks
+	 to the BOF of the next worksheet substream. 0 (the default) means
+	 no preview.
+	 
+	 \note in preview mode the XLS cell records are assumed to be stored
+	 in ascending row order, as every known writer does. The full
+	 dimensions of each worksheet, when declared by the file itself,
+	 can still be retrieved by freexl_worksheet_declared_dimensions().
+	 */
+	unsigned int preview_rows;
+	/**
+	 If non-zero, the XLSX \<sheetData\> content will always be parsed
+	 by the full XML parser, bypassing the fast scanner that otherwise
+	 decodes plain rows and cells directly. Both ways produce exactly
+	 the same cells, so this is mainly intended for validation and
+	 troubleshooting. 0 (the default) means using the fast scanner.
+	 */
+	int xlsx_xml_only;
+    };
+
+    /**
+     Typedef for open options structure.
+     
+     \sa FreeXL_OpenOptions_str
+     */
+    typedef struct FreeXL_OpenOptions_str FreeXL_OpenOptions;
+
 
     /**
      Return the current library version.
@@ -414,6 +755,30 @@ extern "C"
     FREEXL_DECLARE int freexl_open (const char *path,
 				    const void **freexl_handle);
 
+    /**
+     Open the .xls file, preparing for future functions
+     
+     This is similar to freexl_open(), except that some options can
+     be specified.
+     
+     \param path full or relative pathname of the input .xls file.
+     \param options pointer to the options to be applied; NULL means
+     all the default options.
+     \param freexl_handle an opaque reference (handle) to be used in each
+     subsequent function (return value).
+
+     \return FREEXL_OK will be returned on success, otherwise any appropriate
+     error code on failure.
+
+     \note You are expected to freexl_close() even on failure, so as to
+     correctly release any dynamic memory allocation.
+     
+     \sa freexl_open, freexl_init_open_options, freexl_close.
+     */
+    FREEXL_DECLARE int freexl_open_ex (const char *path,
+				       const FreeXL_OpenOptions * options,
+				       const void **freexl_handle);
+
     /**
      Open the .xlsx file, preparing for future functions
      
@@ -432,6 +797,41 @@ extern "C"
     FREEXL_DECLARE int freexl_open_xlsx (const char *path,
 					 const void **freexl_handle);
 
+    /**
+     Initialize an open options structure with default values
+     
+     \param options pointer to the structure to be initialized.
+     
+     \sa freexl_open_ex, freexl_open_xlsx_ex, freexl_open_ods_ex
+     */
+    FREEXL_DECLARE void freexl_init_open_options (FreeXL_OpenOptions *
+						  options);
+
+    /**
+     Open the .xlsx file, preparing for future functions
+     
+     This is similar to freexl_open_xlsx(), except that some options can
+     be specified.
+     
+     \param path full or relative pathname of the input .xlsx file.
+     \param options pointer to the options to be applied; NULL means
+     all the default options.
+     \param freexl_handle an opaque reference (handle) to be used in each
+     subsequent function (return value).
+
+     \return FREEXL_OK will be returned on success, otherwise any appropriate
+     error code on failure.
+
+     \note You are expected to freexl_close() even on failure, so as to
+     correctly release any dynamic memory allocation.
+     
+     \sa freexl_open_xlsx, freexl_init_open_options, freexl_close.
+     */
+    FREEXL_DECLARE int freexl_open_xlsx_ex (const char *path,
+					    const FreeXL_OpenOptions *
+					    options,
+					    const void **freexl_handle);
+
     /**
      Open the .ods file, preparing for future functions
      
@@ -450,6 +850,31 @@ extern "C"
     FREEXL_DECLARE int freexl_open_ods (const char *path,
 					const void **freexl_handle);
 
+    /**
+     Open the .ods file, preparing for future functions
+     
+     This is similar to freexl_open_ods(), except that some options can
+     be specified.
+     
+     \param path full or relative pathname of the input .ods file.
+     \param options pointer to the options to be applied; NULL means
+     all the default options.
+     \param freexl_handle an opaque reference (handle) to be used in each
+     subsequent function (return value).
+
+     \return FREEXL_OK will be returned on success, otherwise any appropriate
+     error code on failure.
+
+     \note You are expected to freexl_close() even on failure, so as to
+     correctly release any dynamic memory allocation.
+     
+     \sa freexl_open_ods, freexl_init_open_options, freexl_close.
+     */
+    FREEXL_DECLARE int freexl_open_ods_ex (const char *path,
+					   const FreeXL_OpenOptions *
+					   options,
+					   const void **freexl_handle);
+
     /**
      Open the .xls file for metadata query only
      
@@ -472,6 +897,60 @@ extern "C"
     FREEXL_DECLARE int freexl_open_info (const char *path,
 					 const void **freexl_handle);
 
+    /**
+     Open the .xlsx file for metadata query only
+     
+     This is similar to freexl_open_xlsx(), except that only the workbook
+     structure is parsed: the worksheet names, the declared \<dimension\>
+     of each worksheet and the count attribute of the Shared Strings.
+     No worksheet body and no Shared String is ever inflated, so this is
+     much faster, but does not support queries for cell values (any
+     attempt to read some cell will return FREEXL_INVALID_HANDLE, just
+     as for freexl_open_info()).
+     
+     \param path full or relative pathname of the input .xlsx file.
+     \param freexl_handle an opaque reference (handle) to be used in each
+     subsequent function (return value).
+
+     \return FREEXL_OK will be returned on success, otherwise any appropriate
+     error code on failure.
+
+     \note You are expected to freexl_close() even on failure, so as to
+     correctly release any dynamic memory allocation. The dimensions 
+     reported by freexl_worksheet_dimensions() are the declared ones;
+     a worksheet lacking any \<dimension\> will be reported as empty.
+     
+     \sa freexl_open_xlsx, freexl_open_info, freexl_get_info, freexl_close
+     */
+    FREEXL_DECLARE int freexl_open_xlsx_info (const char *path,
+					      const void **freexl_handle);
+
+    /**
+     Open the .ods file for metadata query only
+     
+     This is similar to freexl_open_ods(), except that the content of 
+     each worksheet is skipped while parsing, so that only the worksheet
+     names are retrieved. This is faster and requires very little memory,
+     but does not support queries for cell values (any attempt to read
+     some cell will return FREEXL_INVALID_HANDLE).
+     
+     \param path full or relative pathname of the input .ods file.
+     \param freexl_handle an opaque reference (handle) to be used in each
+     subsequent function (return value).
+
+     \return FREEXL_OK will be returned on success, otherwise any appropriate
+     error code on failure.
+
+     \note You are expected to freexl_close() even on failure, so as to
+     correctly release any dynamic memory allocation. ODS neither declares
+     the worksheet dimensions nor has Shared Strings, so all worksheets 
+     will be reported as empty.
+     
+     \sa freexl_open_ods, freexl_open_info, freexl_get_info, freexl_close
+     */
+    FREEXL_DECLARE int freexl_open_ods_info (const char *path,
+					     const void **freexl_handle);
+
     /** 
      Closing the FREEXL file and releasing any allocated resource
 
@@ -531,10 +1010,10 @@ extern "C"
     FREEXL_DECLARE int freexl_close_ods (const void *freexl_handle);
 
     /**
-     Query general information about the Workbook and Worksheets - XLS
+     Query general information about the Workbook and Worksheets
 
-     \param freexl_handle the handle previously returned by freexl_open()
-     or freexl_open_info()
+     \param freexl_handle the handle previously returned by freexl_open(),
+     freexl_open_info() or any other open function
      \param what the info to be queried.
      \param info the corresponding information value (return value)
      
@@ -565,8 +1044,17 @@ extern "C"
     Table entries)
     - FREEXL_BIFF_FORMAT_COUNT (returning the total number of format entries)
     - FREEXL_BIFF_XF_COUNT (returning the number of extended format entries)
+    - FREEXL_SHEET_ROWS (returning the declared row count of the currently
+    selected worksheet)
+    - FREEXL_SHEET_COLUMNS (returning the declared column count of the
+    currently selected worksheet)
      
-    \note will only work when the handle if of the XLS type.
+    \note for XLSX and ODS handles only FREEXL_BIFF_SHEET_COUNT,
+    FREEXL_BIFF_STRING_COUNT (the XLSX Shared Strings count), 
+    FREEXL_SHEET_ROWS and FREEXL_SHEET_COLUMNS are supported; any other
+    query will return FREEXL_UNKNOWN.
+    
+    \sa freexl_worksheet_declared_dimensions
     */
     FREEXL_DECLARE int freexl_get_info (const void *freexl_handle,
 					unsigned short what,
@@ -667,6 +1155,36 @@ extern "C"
 						    unsigned int *rows,
 						    unsigned short *columns);
 
+    /**
+     Query the declared worksheet dimensions
+     
+     This function returns the number of rows and columns declared by the
+     file itself for the currently selected worksheet (the XLS DIMENSION
+     record, or the XLSX \<dimension\> element), even when only a part
+     of it has been loaded.
+
+     \param freexl_handle the handle previously returned by freexl_open()
+     \param rows the declared row count (return value)
+     \param columns the declared column count (return value)
+
+     \return FREEXL_OK will be returned on success; 
+     FREEXL_UNDECLARED_DIMENSION if the worksheet doesn't declare its
+     own dimensions (this is always the case for ODS).
+
+     \note unlike freexl_worksheet_dimensions(), these are the dimensions
+     of the whole worksheet, unaffected by any projection or preview
+     requested by the open options; rows and columns are counted just
+     the same way.
+     
+     \sa freexl_worksheet_dimensions, FreeXL_OpenOptions
+     */
+    FREEXL_DECLARE int freexl_worksheet_declared_dimensions (const void
+							     *freexl_handle,
+							     unsigned int
+							     *rows,
+							     unsigned short
+							     *columns);
+
     /**
      Retrieve string entries from SST
      
@@ -719,12 +1237,313 @@ extern "C"
      \param value the cell type and value (return value)
 
      \return FREEXL_OK will be returned on success
+
+     \note ODS dates and times are returned as FREEXL_CELL_TEXT values
+     formatted as 'YYYY-MM-DD', 'YYYY-MM-DD HH:MM:SS' or 'HH:MM:SS' (any
+     fractional second being rounded); exactly as for XLSX, such a
+     text_value stays valid until freexl_close() is called.
     */
     FREEXL_DECLARE int freexl_get_cell_value (const void *freexl_handle,
 					      unsigned int row,
 					      unsigned short column,
 					      FreeXL_CellValue * value);
 
+    /**
+     Retrieve many cell values at once from the same row of the 
+     currently active worksheet
+
+     \param freexl_handle the handle previously returned by freexl_open()
+     \param row row number of the cells to query (zero base)
+     \param first_column column number of the first cell to query 
+     (zero base)
+     \param n_columns number of adjacent cells to query
+     \param values an array of at least n_columns elements, that will be
+     filled with the cell types and values (return value)
+
+     \return FREEXL_OK will be returned on success
+
+     \note this is equivalent to calling freexl_get_cell_value() for
+     each cell in turn, but much faster. For ODS documents any date or
+     time text_value, and for XLSX documents opened in one of the lazy
+     Shared Strings modes any FREEXL_CELL_SST_TEXT text_value, stays
+     valid only until the next call to this function.
+    */
+    FREEXL_DECLARE int freexl_get_row_values (const void *freexl_handle,
+					      unsigned int row,
+					      unsigned short first_column,
+					      unsigned short n_columns,
+					      FreeXL_CellValue * values);
+
+    /**
+     Retrieve many cell values at once from the same column of the
+     currently active worksheet, as separate typed arrays
+
+     \param freexl_handle the handle previously returned by freexl_open()
+     \param column column number of the cells to query (zero base)
+     \param first_row row number of the first cell to query (zero base)
+     \param n_rows number of adjacent cells to query
+     \param block the arrays to be filled (in and return value)
+
+     \return FREEXL_OK will be returned on success; 
+     FREEXL_BUFFER_TOO_SMALL will be returned if the text buffer cannot
+     hold all text values (text_length will then report the required size).
+
+     \note text_length and offsets are always computed, even when the
+     text buffer is NULL; so a first call without any text buffer can be
+     used in order to find out how big the text buffer must be.
+    */
+    FREEXL_DECLARE int freexl_get_column_block (const void *freexl_handle,
+						unsigned short column,
+						unsigned int first_row,
+						unsigned int n_rows,
+						FreeXL_ColumnBlock * block);
+
+    /**
+     Export the currently active worksheet (or a range of its rows) as an
+     Apache Arrow C stream
+
+     \param freexl_handle the handle previously returned by freexl_open()
+     \param first_row row number of the first row to be exported 
+     (zero base)
+     \param n_rows number of rows to be exported; 0 means up to the end
+     of the worksheet
+     \param batch_rows max number of rows for each record batch; 0 means
+     the default (65536 rows)
+     \param stream the ArrowArrayStream to be initialized (return value)
+
+     \return FREEXL_OK will be returned on success
+
+     \note each column is named col_NNN, and its type is inferred from
+     the whole range of rows: int32 if all cells are integers, float64 if
+     all cells are numbers, date32 if all cells are dates, timestamp
+     (seconds, no timezone) if all cells are dates or datetimes, and utf8
+     in any other case. NULL cells never affect the inferred type.
+     An Arrow stream cannot change its schema from one batch to the next,
+     so all types are inferred before this function returns, by a pre-pass
+     reading the range once column by column (a column stops being read
+     as soon as it is known to be UTF8); the record batches themselves
+     are then built one at a time, each time that get_next is called.
+     The stream reads the currently active worksheet, so the handle
+     must not be closed nor switched to another worksheet until 
+     the stream has been released.
+    */
+    FREEXL_DECLARE int freexl_export_arrow_stream (const void
+						   *freexl_handle,
+						   unsigned int first_row,
+						   unsigned int n_rows,
+						   unsigned int batch_rows,
+						   struct ArrowArrayStream
+						   *stream);
+
+    /**
+     Stream a single worksheet of an .xls file through a callback
+
+     \param path full or relative pathname of the input .xls file.
+     \param sheet_index the index identifying the worksheet (base 0).
+     \param callback the function that will receive the cells of each
+     row, one row at a time.
+     \param ctx an opaque pointer that will be passed to the callback.
+
+     \return FREEXL_OK will be returned on success (even when the 
+     callback stopped the scan), otherwise any appropriate error code.
+
+     \note unlike freexl_open() no cell store is ever allocated: memory 
+     usage stays constant however big the worksheet is, and the limits 
+     affecting the whole worksheet size don't apply. Rows are reported
+     in the same order they are stored into the file (usually ascending);
+     no random access is possible.
+    */
+    FREEXL_DECLARE int freexl_scan_xls (const char *path,
+					unsigned int sheet_index,
+					FreeXL_RowCallback callback,
+					void *ctx);
+
+    /**
+     Create an iterator returning only the non-NULL cells of the currently
+     active worksheet
+
+     \param freexl_handle the handle previously returned by freexl_open()
+     \param iterator an opaque reference (handle) to the new iterator
+     (return value)
+
+     \return FREEXL_OK will be returned on success
+
+     \note the iterator is bound to the worksheet that was active when it
+     was created, and it must be destroyed by calling 
+     freexl_destroy_cell_iterator() before closing the freexl_handle.
+     
+     \code
+	const void *iter;
+	unsigned int row;
+	unsigned short col;
+	FreeXL_CellValue val;
+	freexl_create_cell_iterator(handle, &iter);
+	while (freexl_next_cell(iter, &row, &col, &val) == FREEXL_OK
+	       && val.type != FREEXL_CELL_NULL)
+	{
+	    ...
+	}
+	freexl_destroy_cell_iterator(iter);
+     \endcode
+    */
+    FREEXL_DECLARE int freexl_create_cell_iterator (const void
+						    *freexl_handle,
+						    const void **iterator);
+
+    /**
+     Return the next non-NULL cell from a cell iterator
+
+     \param iterator the handle previously returned by 
+     freexl_create_cell_iterator()
+     \param row row number of the cell (zero base, return value)
+     \param column column number of the cell (zero base, return value)
+     \param value the cell type and value (return value)
+
+     \return FREEXL_OK will be returned on success
+
+     \note cells are returned in row-major order, and empty cells are
+     never visited: so the cost of a full scan depends on the number
+     of cells actually holding some value. Once all cells have been 
+     returned value->type will be set to FREEXL_CELL_NULL, and row and
+     column will be left unchanged. The text of any date or time is 
+     stored into the iterator itself, and it will be overwritten by the
+     next call.
+    */
+    FREEXL_DECLARE int freexl_next_cell (const void *iterator,
+					 unsigned int *row,
+					 unsigned short *column,
+					 FreeXL_CellValue * value);
+
+    /**
+     Destroy a cell iterator
+
+     \param iterator the handle previously returned by 
+     freexl_create_cell_iterator()
+
+     \return FREEXL_OK will be returned on success
+    */
+    FREEXL_DECLARE int freexl_destroy_cell_iterator (const void *iterator);
+
+    /**
+     Gather per-column statistics (cell type counts, numeric range, 
+     longest text and a suggested column type) about the currently
+     active worksheet
+
+     \param freexl_handle the handle previously returned by freexl_open()
+     \param first_column column number of the first column to examine
+     (zero base)
+     \param n_columns number of adjacent columns to examine
+     \param stats an array of at least n_columns elements, that will be
+     filled with the statistics of each column (return value)
+
+     \return FREEXL_OK will be returned on success
+
+     \note the first call about some worksheet examines all its columns
+     by a single sweep over the non-NULL cells already held in memory,
+     and keeps the results until the workbook is closed: any further
+     call about the same worksheet just copies the requested columns. ODS dates and times are
+     returned as FREEXL_CELL_TEXT by freexl_get_cell_value(), and so
+     they are accounted for as text values.
+     
+     \code
+	FreeXL_ColumnStats *stats;
+	unsigned int rows;
+	unsigned short columns;
+	freexl_worksheet_dimensions(handle, &rows, &columns);
+	stats = malloc(sizeof(FreeXL_ColumnStats) * columns);
+	freexl_get_column_stats(handle, 0, columns, stats);
+	// stats[0].suggested_type is the SQL type of the first column
+	free(stats);
+     \endcode
+    */
+    FREEXL_DECLARE int freexl_get_column_stats (const void *freexl_handle,
+						unsigned short first_column,
+						unsigned short n_columns,
+						FreeXL_ColumnStats * stats);
+
+    /**
+     Create a read-only cursor over an open workbook
+
+     \param freexl_handle the handle previously returned by freexl_open(),
+     freexl_open_xlsx() or freexl_open_ods()
+     \param cursor an opaque reference (handle) to the new cursor
+     (return value)
+
+     \return FREEXL_OK will be returned on success
+
+     \note each cursor carries its own selected worksheet (initially the
+     one currently active on the handle) and its own scratch buffers, 
+     so several cursors over the same handle can be used at the same time
+     from different threads; each single cursor must be used by one 
+     thread at a time. The handle itself must not be used for anything 
+     else than creating cursors while they are in use, and all cursors 
+     must be destroyed by calling freexl_destroy_cursor() before closing
+     the freexl_handle. Cursors aren't supported by handles returned by
+     freexl_open_info().
+    */
+    FREEXL_DECLARE int freexl_create_cursor (const void *freexl_handle,
+					     const void **cursor);
+
+    /**
+     Set the worksheet of a cursor
+
+     \param cursor the handle previously returned by freexl_create_cursor()
+     \param worksheet_index the index identifying the worksheet (base 0)
+
+     \return FREEXL_OK will be returned on success
+
+     \note this doesn't affect the handle nor any other cursor.
+    */
+    FREEXL_DECLARE int freexl_cursor_select_worksheet (const void *cursor,
+						       unsigned short
+						       worksheet_index);
+
+    /**
+     Query the dimensions of the worksheet of a cursor
+
+     \param cursor the handle previously returned by freexl_create_cursor()
+     \param rows the number of rows (return value)
+     \param columns the number of columns (return value)
+
+     \return FREEXL_OK will be returned on success
+    */
+    FREEXL_DECLARE int freexl_cursor_worksheet_dimensions (const void
+							   *cursor,
+							   unsigned int
+							   *rows,
+							   unsigned short
+							   *columns);
+
+    /**
+     Retrieve the value of a cell from the worksheet of a cursor
+
+     \param cursor the handle previously returned by freexl_create_cursor()
+     \param row row number of the cell (zero base)
+     \param column column number of the cell (zero base)
+     \param value the cell type and value (return value)
+
+     \return FREEXL_OK will be returned on success
+
+     \note this is the thread-safe equivalent of freexl_get_cell_value().
+     Any formatted date or time (and any XLSX shared string decoded in
+     lazy mode) is stored into the cursor itself: such text_value 
+     pointers remain valid for the next 127 calls on the same cursor.
+    */
+    FREEXL_DECLARE int freexl_cursor_get_cell_value (const void *cursor,
+						     unsigned int row,
+						     unsigned short column,
+						     FreeXL_CellValue *
+						     value);
+
+    /**
+     Destroy a cursor
+
+     \param cursor the handle previously returned by freexl_create_cursor()
+
+     \return FREEXL_OK will be returned on success
+    */
+    FREEXL_DECLARE int freexl_destroy_cursor (const void *cursor);
+
 #ifdef __cplusplus
 }
 #endif
@@ -51,6 +51,14 @@
 #define FREEXL_MAGIC_INFO	1675437821
 #define FREEXL_MAGIC_START	1675431287
 #define FREEXL_MAGIC_END	178213456
+#define FREEXL_MAGIC_CURSOR	1675432769
+
+/* internal helpers shared by the library modules are never exported */
+#if defined(__GNUC__) && !defined(_WIN32)
+#define FREEXL_PRIVATE __attribute__ ((visibility ("hidden")))
+#else
+#define FREEXL_PRIVATE
+#endif
 
 /* BIFF record types */
 #define BIFF_EOF		0x000A
@@ -95,6 +103,29 @@
 #define XLSX_TIME_SIMPLE	2
 #define XLSX_DATE_AND_TIME	3
 
+/* XLSX sheet limits (A1:XFD1048576) */
+#define XLSX_MAX_COLUMNS	16384
+#define XLSX_MAX_ROWS		1048576
+
+/* never pre-allocating more than so many cells for a single row */
+#define XLSX_MAX_CELLS_HINT	256
+
+/* never pre-allocating more than so many rows for a single Worksheet */
+#define XLSX_MAX_ROWS_HINT	4096
+
+/* chunked Worksheet parsing phases */
+#define XLSX_STREAM_HEADER	0
+#define XLSX_STREAM_FAST	1
+#define XLSX_STREAM_XML		2
+#define XLSX_STREAM_MAX_HEADER	(1024 * 1024)
+
+/* metadata only: XML heads are inflated by chunks of this size */
+#define XLSX_PEEK_CHUNK		4096
+
+/* XML numeric tokens */
+#define XML_NUMBER_INTEGER	1
+#define XML_NUMBER_DOUBLE	2
+
 /* ODS data types */
 #define ODS_VOID		1
 #define ODS_FLOAT		2
@@ -105,6 +136,10 @@
 #define ODS_TIME		7
 #define ODS_STRING		8
 #define ODS_INTEGER		9
+#define ODS_DATETIME	10
+
+/* longest ODS time-value normalized as HH:MM:SS (about 63 years) */
+#define ODS_MAX_TIME_SECONDS	2000000000.0
 
 typedef union biff_word
 {
@@ -210,6 +245,13 @@ typedef struct biff_cell_value_struct
     } value;
 } biff_cell_value;
 
+typedef struct biff_row_span_struct
+{
+/* the range of columns actually used by some BIFF row */
+    unsigned short first;	/* first non-NULL column */
+    unsigned short last;	/* one past the last non-NULL column; 0 = empty */
+} biff_row_span;
+
 typedef struct biff_sheet_struct
 {
 /* a strunct representing a BIFF Sheet */
@@ -220,8 +262,13 @@ typedef struct biff_sheet_struct
     unsigned int rows;		/* number of rows */
     unsigned short columns;	/* number of columns */
     biff_cell_value *cell_values;	/* cell values array */
+    biff_row_span *row_spans;	/* used columns of each row */
     int valid_dimension;	/* set to 1=TRUE only when DIMENSION is surely known */
+    int declared;		/* set to 1=TRUE if a DIMENSION record was found */
+    unsigned int declared_rows;	/* number of rows as declared by DIMENSION */
+    unsigned short declared_columns;	/* number of columns as declared by DIMENSION */
     int already_done;		/* set to 1=TRUE if already loaded in pass #1 */
+    FreeXL_ColumnStats *column_stats;	/* cached column statistics */
     struct biff_sheet_struct *next;	/* linked-list pointer */
 } biff_sheet;
 
@@ -264,6 +311,43 @@ typedef struct fat_chain_struct
     unsigned char *miniStream;	/* the whole mini-stream */
 } fat_chain;
 
+typedef struct biff_scan_struct
+{
+/* 
+ * streaming a single BIFF Worksheet through a callback
+ * (no cell store at all: one row of cells is buffered at a time)
+ */
+    unsigned int sheet_index;	/* the requested Worksheet */
+    biff_sheet *sheet;		/* the requested Worksheet, once known */
+    FreeXL_RowCallback callback;	/* the caller's row callback */
+    void *ctx;			/* the caller's context */
+    unsigned int row;		/* row number of the buffered cells */
+    unsigned short *columns;	/* buffered column numbers */
+    biff_cell_value *cells;	/* buffered cell values */
+    FreeXL_CellValue *values;	/* the values passed to the callback */
+    unsigned int n_cells;	/* number of buffered cells */
+    unsigned int max_cells;	/* buffers capacity */
+    biff_cell_value discard;	/* scratch cell for any unwanted value */
+    int done;			/* 1 once the Worksheet EOF was found */
+    int stop;			/* 1 when no further record is needed */
+    int error;			/* error code (if any) */
+} biff_scan;
+
+typedef struct freexl_projection_struct
+{
+/* 
+ * restricting the cells to be loaded (see FreeXL_OpenOptions)
+ *
+ * all row and column numbers are zero based
+ */
+    int sheet_index;		/* the only Worksheet to be loaded; -1 = all */
+    unsigned char *columns;	/* one flag for each column; NULL = all */
+    unsigned int n_columns;	/* number of flags (highest column + 1) */
+    unsigned int first_row;	/* the first row to be loaded */
+    unsigned int end_row;	/* the first row following the range */
+    int preview;		/* 1 = abandoning each Worksheet past end_row */
+} freexl_projection;
+
 typedef struct biff_workbook_struct
 {
 /* 
@@ -311,9 +395,28 @@ typedef struct biff_workbook_struct
     unsigned short max_format_index;	/* max array index [formats] */
     unsigned short biff_xf_array[BIFF_MAX_XF];	/* the array for XF/Format association */
     unsigned short biff_xf_next_index;	/* next XF index */
+    biff_scan *scan;		/* not NULL when streaming through a callback */
+    int threads;		/* max number of parallel parsing threads */
+    int stop_at_eof;		/* 1 = stop parsing at the end of the substream */
+    int eof_found;		/* set to 1 once such EOF has been found */
+    freexl_projection *projection;	/* cells to be loaded; NULL = all */
+    int skip_sheet;		/* 1 = skipping the rest of the current substream */
     int magic2;			/* magic signature #2 */
 } biff_workbook;
 
+typedef struct biff_sheet_jobs_struct
+{
+/* a set of Worksheet substreams to be parsed by several threads */
+    const char *path;		/* the XLS file (opened again by each thread) */
+    biff_workbook *workbook;	/* the shared Workbook (read only) */
+    biff_sheet **sheets;
+    int count;
+    int next;			/* the next Worksheet to be parsed */
+    int swap;
+    int error;			/* the first error code (if any) */
+    void *mutex;
+} biff_sheet_jobs;
+
 typedef struct xlsx_cell_struct
 {
 /* a struct representing a XLSX cell */
@@ -324,7 +427,6 @@ typedef struct xlsx_cell_struct
     int int_value;
     double dbl_value;
     int str_index;
-    struct xlsx_cell_struct *next;
 } xlsx_cell;
 
 typedef struct xlsx_row_struct
@@ -332,8 +434,10 @@ typedef struct xlsx_row_struct
 /* a struct representing a XLSX row of cells */
     int row_no;
     int max_cell;
-    xlsx_cell *first;
-    xlsx_cell *last;
+    xlsx_cell *cells;		/* the cells array */
+    int n_cells;		/* number of cells actually in use */
+    int max_cells;		/* allocated capacity */
+    int sorted;			/* 1 if cells are in strictly ascending column order */
     struct xlsx_row_struct *next;
 } xlsx_row;
 
@@ -346,7 +450,9 @@ typedef struct xlsx_worksheet_struct
     xlsx_row *last;
     int max_row;
     int max_cell;
-    xlsx_row **rows;
+    xlsx_row **rows;		/* the ROWS Array, indexed by row number */
+    int rows_alloc;		/* allocated ROWS Array capacity */
+    int cells_hint;		/* initial cells capacity for the next row */
     int error;
     char *CharData;
     int CharDataLen;
@@ -355,6 +461,16 @@ typedef struct xlsx_worksheet_struct
     int RowOk;
     int ColOk;
     int CellValueOk;
+    int CellPending;		/* current cell: 1 = not yet allocated, 2 = allocated */
+    int PendingColNo;
+    int PendingType;
+    int PendingIsDatetime;
+    int LastColNo;		/* last cell seen in the current row */
+    int RowImplicit;		/* 1 = the current row lacks any "r" attribute */
+    int stop;			/* 1 once the requested rows are over */
+    int declared_rows;		/* as declared by <dimension>; -1 = undeclared */
+    int declared_columns;
+    FreeXL_ColumnStats *column_stats;	/* cached column statistics */
     struct xlsx_workbook_struct *wbRef;
     struct xlsx_worksheet_struct *next;
 } xlsx_worksheet;
@@ -383,6 +499,45 @@ typedef struct xml_datetime_struct
     struct xml_datetime_struct *next;
 } xml_datetime;
 
+typedef struct xlsx_string_struct
+{
+/* a struct representing a XLSX SharedString (into the strings pool) */
+    size_t offset;
+    unsigned int length;
+} xlsx_string;
+
+typedef struct xlsx_lazy_entry_struct
+{
+/* a struct representing a lazily decoded XLSX SharedString */
+    int index;
+    char *text;
+    struct xlsx_lazy_entry_struct *prev;	/* LRU list */
+    struct xlsx_lazy_entry_struct *next;	/* LRU list */
+    struct xlsx_lazy_entry_struct *hash_next;	/* hash bucket chain */
+} xlsx_lazy_entry;
+
+typedef struct xlsx_lazy_strings_struct
+{
+/* a struct supporting on demand decoding of XLSX SharedStrings */
+    struct zip_random_struct *zdata;	/* the compressed SharedStrings.xml */
+    FILE *tmp;			/* the inflated SharedStrings.xml (temporary file) */
+    char *encoding;		/* the document encoding (NULL: UTF-8) */
+    void *parser;		/* the XML parser to be reused */
+    char *buf;			/* read buffer for the temporary file */
+    unsigned int buf_max;
+    char *text;			/* decoded text */
+    unsigned int text_len;
+    unsigned int text_max;
+    int text_ok;
+    int capacity;		/* max number of decoded strings */
+    int count;
+    int hash_size;
+    xlsx_lazy_entry **hash;
+    xlsx_lazy_entry *first;	/* most recently used */
+    xlsx_lazy_entry *last;	/* least recently used */
+    void *mutex;		/* serializing concurrent cursors (if any) */
+} xlsx_lazy_strings;
+
 typedef struct xlsx_workbook_struct
 {
 /* a struct representing a XLSX Workbook */
@@ -391,7 +546,15 @@ typedef struct xlsx_workbook_struct
     xlsx_worksheet *active_sheet;	/* currently active SHEET */
     int n_strings;
     int xml_strings;
-    char **strings;
+    xlsx_string *strings;	/* lazy mode: <si> byte spans into the XML */
+    char *strings_pool;		/* all SharedStrings are contiguously stored here */
+    size_t strings_pool_len;
+    size_t strings_pool_max;
+    int strings_mode;		/* eager or lazy SharedStrings */
+    int strings_cache;
+    xlsx_lazy_strings *lazy_strings;
+    char **RowTexts;		/* lazy mode: SharedStrings copied for a whole row */
+    int RowTextsMax;		/* RowTexts capacity (number of strings) */
     int n_formats;
     int next_format;
     xlsx_format *formats;
@@ -401,9 +564,15 @@ typedef struct xlsx_workbook_struct
     xml_datetime *first_date;
     xml_datetime *last_date;
     int error;
+    int no_memory;		/* 1 = the error was an allocation failure */
     char *SharedStringsZipEntry;
     char *WorkbookZipEntry;
     char *StylesZipEntry;
+    struct zip_index_struct *ZipIndex;
+    int xml_pipeline;
+    int xml_only;		/* 1 = never using the <sheetData> fast path */
+    freexl_projection *projection;	/* cells to be loaded; NULL = all */
+    int info;			/* 1 = metadata only (no cell is loaded) */
     char *CharData;
     int CharDataLen;
     int CharDataMax;
@@ -415,9 +584,212 @@ typedef struct xlsx_workbook_struct
     int CellStylesOk;
 } xlsx_workbook;
 
+typedef struct zip_entry_struct
+{
+/* a struct representing an entry from the Zipfile directory */
+    char *name;
+    uint64_t pos_in_zip_directory;
+    uint64_t num_of_file;
+    uint64_t compressed_size;
+    uint64_t uncompressed_size;
+    uint64_t local_header_offset;
+    unsigned long crc;
+    int method;
+    int direct;			/* can be directly inflated */
+    struct zip_entry_struct *next;	/* directory order */
+    struct zip_entry_struct *hash_next;	/* hash bucket chain */
+} zip_entry;
+
+typedef struct zip_index_struct
+{
+/* a struct representing a hashed index of the Zipfile directory */
+    int n_entries;
+    int n_buckets;
+    zip_entry **buckets;
+    zip_entry *first;
+    zip_entry *last;
+    FILE *in;			/* direct access to the Zipfile */
+    void *decompressor;		/* libdeflate */
+} zip_index;
+
+typedef struct zip_stream_struct
+{
+/* a struct representing an open (uncompressing) Zipfile entry */
+    void *zip_handle;
+    zip_index *index;
+    zip_entry *entry;
+    int direct;
+    void *inflater;		/* zlib z_stream */
+    unsigned char *in_buf;
+    uint64_t in_offset;
+    uint64_t in_left;
+    uint64_t out_left;
+    unsigned long crc;
+} zip_stream;
+
+typedef struct zip_pipeline_struct
+{
+/* 
+ * a struct representing a bounded queue of inflated chunks
+ * (optionally filled by a separate thread)
+ */
+    zip_stream *stream;
+    int threaded;
+    void *thread;
+    void *mutex;
+    void *cond;
+    int n_slots;
+    unsigned int slot_size;
+    unsigned char **slots;
+    unsigned int *lengths;
+    int head;			/* first slot to be consumed */
+    int count;			/* filled slots (including the consumed one) */
+    int eof;
+    int error;
+    int abort;
+} zip_pipeline;
+
+typedef struct zip_access_point_struct
+{
+/* a point from which some deflated data can be inflated again */
+    uint64_t out;		/* offset into the inflated data */
+    uint64_t in;		/* offset into the compressed data */
+    int bits;			/* bits still to be read from the previous byte */
+    unsigned char *window;	/* the 32 KB of inflated data preceding it */
+} zip_access_point;
+
+typedef struct zip_random_struct
+{
+/* 
+ * a struct supporting random access to some Zipfile entry
+ *
+ * only the compressed data is kept in memory; deflated data will be
+ * inflated again starting from the nearest access point
+ */
+    unsigned char *data;	/* the compressed (or stored) data */
+    uint64_t data_size;
+    uint64_t size;		/* uncompressed size */
+    unsigned long crc;
+    int deflated;
+    zip_access_point *points;
+    int n_points;
+    int max_points;
+    void *inflater;		/* zlib z_stream */
+    uint64_t pos;		/* inflated offset the z_stream has reached */
+    int positioned;		/* 1 if the z_stream can go on from pos */
+    unsigned char *scratch;	/* inflated data being skipped */
+} zip_random;
+
+typedef int (*zip_chunk_callback) (void *ctx, const unsigned char *buf,
+				   unsigned int len);
+
+extern FREEXL_PRIVATE zip_index *zip_build_index (const char *path,
+						  void *zip_handle);
+
+extern FREEXL_PRIVATE void zip_destroy_index (zip_index * index);
+
+extern FREEXL_PRIVATE zip_entry *zip_find_entry (zip_index * index,
+						 const char *name);
+
+extern FREEXL_PRIVATE int zip_goto_entry (void *zip_handle, zip_entry * entry);
+
+extern FREEXL_PRIVATE zip_stream *zip_open_stream (void *zip_handle,
+						   zip_index * index,
+						   zip_entry * entry);
+
+extern FREEXL_PRIVATE int zip_read_stream (zip_stream * stream,
+					   unsigned char *buf,
+					   unsigned int len);
+
+extern FREEXL_PRIVATE void zip_close_stream (zip_stream * stream);
+
+extern FREEXL_PRIVATE unsigned char *zip_fetch_entry (void *zip_handle,
+						      zip_index * index,
+						      zip_entry * entry,
+						      uint64_t * size);
+
+extern FREEXL_PRIVATE zip_pipeline *zip_pipeline_start (void *zip_handle,
+							zip_index * index,
+							zip_entry * entry,
+							int threaded);
+
+extern FREEXL_PRIVATE int zip_pipeline_next (zip_pipeline * pipe,
+					     const unsigned char **buf,
+					     unsigned int *len);
+
+extern FREEXL_PRIVATE void zip_pipeline_release (zip_pipeline * pipe);
+
+extern FREEXL_PRIVATE void zip_pipeline_stop (zip_pipeline * pipe);
+
+extern FREEXL_PRIVATE zip_random *zip_random_open (zip_index * index,
+						   zip_entry * entry);
+
+extern FREEXL_PRIVATE int zip_random_scan (zip_random * rnd,
+					   zip_chunk_callback callback,
+					   void *ctx);
+
+extern FREEXL_PRIVATE int zip_random_read (zip_random * rnd, uint64_t offset,
+					   unsigned char *buf,
+					   unsigned int len);
+
+extern FREEXL_PRIVATE void zip_random_close (zip_random * rnd);
+
+extern FREEXL_PRIVATE void *freexl_thread_create (void (*func) (void *),
+						  void *arg);
+
+extern FREEXL_PRIVATE void freexl_thread_join (void *thread);
+
+extern FREEXL_PRIVATE void *freexl_mutex_create (void);
+
+extern FREEXL_PRIVATE void freexl_mutex_lock (void *mutex);
+
+extern FREEXL_PRIVATE void freexl_mutex_unlock (void *mutex);
+
+extern FREEXL_PRIVATE void freexl_mutex_destroy (void *mutex);
+
+extern FREEXL_PRIVATE void *freexl_cond_create (void);
+
+extern FREEXL_PRIVATE void freexl_cond_wait (void *cond, void *mutex);
+
+extern FREEXL_PRIVATE void freexl_cond_broadcast (void *cond);
+
+extern FREEXL_PRIVATE void freexl_cond_destroy (void *cond);
+
+extern FREEXL_PRIVATE int parse_xml_number (const char *str, int *int_value,
+					    double *dbl_value);
+
+extern FREEXL_PRIVATE int
+freexl_create_projection (const FreeXL_OpenOptions * options,
+			  freexl_projection ** projection);
+
+extern FREEXL_PRIVATE void
+freexl_destroy_projection (freexl_projection * projection);
+
+extern FREEXL_PRIVATE int
+freexl_projected_sheet (const freexl_projection * projection, int sheet_index);
+
+extern FREEXL_PRIVATE int
+freexl_projected_row (const freexl_projection * projection, unsigned int row);
+
+extern FREEXL_PRIVATE int
+freexl_projected_cell (const freexl_projection * projection, unsigned int row,
+		       unsigned int column);
+
+extern FREEXL_PRIVATE const char *
+xlsx_get_lazy_string (xlsx_workbook * workbook, int string_index);
+
+extern FREEXL_PRIVATE char *xlsx_copy_lazy_string (xlsx_workbook * workbook,
+						   int string_index);
+
 typedef struct ods_cell_struct
 {
-/* a struct representing an ODS cell */
+/* 
+ * a struct representing an ODS cell 
+ *
+ * DATE and DATETIME values are stored as YYYYMMDD into int_value;
+ * DATETIME and TIME values are stored as seconds into dbl_value
+ * (unless some unusual format was found: txt_value is set instead)
+ */
     int col_no;
     int type;
     int assigned;
@@ -453,6 +825,8 @@ typedef struct ods_worksheet_struct
     int ColOk;
     int CellValueOk;
     int NextRowNo;
+    int skipped;		/* 1 if not loaded at all */
+    FreeXL_ColumnStats *column_stats;	/* cached column statistics */
     struct ods_worksheet_struct *next;
 } ods_worksheet;
 
@@ -466,14 +840,43 @@ typedef struct ods_workbook_struct
     xml_datetime *last_date;
     int error;
     char *ContentZipEntry;
+    struct zip_index_struct *ZipIndex;
+    int xml_pipeline;
     char *CharData;
     int CharDataLen;
     int CharDataMax;
     int CharDataStep;
     int ContentOk;
     int NextWorksheetId;
+    const char **SheetNames;	/* only loading these Worksheets; NULL = all */
+    freexl_projection *projection;	/* cells to be loaded; NULL = all */
+    int info;			/* 1 = metadata only (all tables are skipped) */
+    int SkipDepth;		/* nesting level within a skipped Worksheet */
+    int threads;		/* max number of parallel parsing threads */
+    char *RowDates;		/* formatted dates/times for a whole row */
+    int RowDatesMax;		/* RowDates capacity (number of strings) */
 } ods_workbook;
 
+typedef struct ods_table_range_struct
+{
+/* a top-level table:table element found within Content.xml */
+    uint64_t offset;
+    uint64_t length;
+    ods_workbook *parsed;	/* the temporary Workbook it was parsed into */
+} ods_table_range;
+
+typedef struct ods_table_jobs_struct
+{
+/* a set of table:table elements to be parsed by several threads */
+    const unsigned char *buf;
+    ods_table_range *ranges;
+    int count;
+    int next;			/* the next range to be parsed */
+    const char **SheetNames;
+    freexl_projection *projection;
+    void *mutex;
+} ods_table_jobs;
+
 typedef struct freexl_handle_struct
 {
 /* 
@@ -483,3 +886,39 @@ typedef struct freexl_handle_struct
     xlsx_workbook *xlsx_handle;
     ods_workbook *ods_handle;
 } freexl_handle;
+
+typedef struct freexl_cell_iterator_struct
+{
+/* 
+ * a sparse iterator over the non-NULL cells of a Worksheet
+ */
+    freexl_handle *handle;
+    biff_sheet *xls_sheet;
+    xlsx_worksheet *xlsx_sheet;
+    ods_worksheet *ods_sheet;
+    unsigned int row;		/* current row */
+    int col;			/* next column (XLS) or cell index (XLSX) */
+    int last_col;		/* last column returned from an unsorted row */
+    ods_cell *ods_next;		/* next ODS cell of the current row */
+    int row_started;		/* 1 once ods_next has been set for this row */
+    char datetime[STR_DATETIME_LEN];	/* last date/time text */
+} freexl_cell_iterator;
+
+typedef struct freexl_cursor_struct
+{
+/* 
+ * a read-only cursor over a shared Workbook
+ *
+ * each cursor has its own active Worksheet and its own scratch
+ * buffers, so that many cursors can safely be used in parallel
+ */
+    int magic1;			/* magic signature #1 */
+    freexl_handle *handle;
+    biff_sheet *xls_sheet;
+    xlsx_worksheet *xlsx_sheet;
+    ods_worksheet *ods_sheet;
+    unsigned int next_slot;	/* next recycled slot */
+    char datetime[MAX_DATETIME_STR][STR_DATETIME_LEN];	/* DATE/TIME texts */
+    char *texts[MAX_DATETIME_STR];	/* copies of lazy SharedStrings */
+    int magic2;			/* magic signature #2 */
+} freexl_cursor;
@@ -48,6 +48,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <math.h>
+#include <stdint.h>
 
 #if defined(__MINGW32__) || defined(_WIN32)
 #define LIBICONV_STATIC
@@ -606,6 +607,186 @@ compute_date (int *year, int *month, int *day, int count)
     *day = dd;
 }
 
+static void
+destroy_cell (biff_cell_value * cell)
+{
+/* destroying a cell */
+    if (cell->type == FREEXL_CELL_TEXT || cell->type == FREEXL_CELL_DATE
+	|| cell->type == FREEXL_CELL_DATETIME || cell->type == FREEXL_CELL_TIME)
+      {
+	  if (cell->value.text_value)
+	      free (cell->value.text_value);
+      }
+}
+
+static void
+fill_biff_value (biff_cell_value * p_cell, FreeXL_CellValue * val)
+{
+/* returning the value of some XLS Cell */
+    val->type = p_cell->type;
+    switch (p_cell->type)
+      {
+      case FREEXL_CELL_INT:
+	  val->value.int_value = p_cell->value.int_value;
+	  break;
+      case FREEXL_CELL_DOUBLE:
+	  val->value.double_value = p_cell->value.dbl_value;
+	  break;
+      case FREEXL_CELL_DATE:
+      case FREEXL_CELL_DATETIME:
+      case FREEXL_CELL_TIME:
+      case FREEXL_CELL_TEXT:
+	  val->value.text_value = p_cell->value.text_value;
+	  break;
+      case FREEXL_CELL_SST_TEXT:
+	  val->value.text_value = p_cell->value.sst_value;
+	  break;
+      };
+}
+
+static biff_sheet *
+get_scan_sheet (biff_workbook * workbook)
+{
+/* the Worksheet requested by a streaming scan (once it's known) */
+    biff_scan *scan = workbook->scan;
+    biff_sheet *p_sheet;
+    unsigned int count = 0;
+    if (scan->sheet != NULL)
+	return scan->sheet;
+    p_sheet = workbook->first_sheet;
+    while (p_sheet)
+      {
+	  if (count == scan->sheet_index)
+	    {
+		scan->sheet = p_sheet;
+		break;
+	    }
+	  count++;
+	  p_sheet = p_sheet->next;
+      }
+    return scan->sheet;
+}
+
+static void
+flush_scan_row (biff_scan * scan)
+{
+/* passing the buffered row to the callback */
+    unsigned int i;
+    unsigned short n = 0;
+    for (i = 0; i < scan->n_cells; i++)
+      {
+	  /* NULL cells are never reported */
+	  biff_cell_value *p_cell = scan->cells + i;
+	  if (p_cell->type == FREEXL_CELL_NULL)
+	      continue;
+	  fill_biff_value (p_cell, scan->values + n);
+	  *(scan->columns + n) = *(scan->columns + i);
+	  n++;
+      }
+    if (n > 0 && !scan->stop)
+      {
+	  if (scan->callback (scan->ctx, scan->row, n, scan->columns,
+			      scan->values) != 0)
+	      scan->stop = 1;
+      }
+    for (i = 0; i < scan->n_cells; i++)
+	destroy_cell (scan->cells + i);
+    scan->n_cells = 0;
+}
+
+static biff_cell_value *
+get_scan_cell_slot (biff_workbook * workbook, unsigned int row,
+		    unsigned short col)
+{
+/* buffering some cell of the current row */
+    biff_scan *scan = workbook->scan;
+    biff_cell_value *p_cell;
+
+    destroy_cell (&(scan->discard));
+    scan->discard.type = FREEXL_CELL_NULL;
+    if (scan->stop || workbook->active_sheet != get_scan_sheet (workbook))
+	return &(scan->discard);
+    if (scan->n_cells > 0 && row != scan->row)
+      {
+	  /* a new row starts here */
+	  flush_scan_row (scan);
+	  if (scan->stop)
+	      return &(scan->discard);
+      }
+    if (scan->n_cells == scan->max_cells)
+      {
+	  /* growing the row buffers */
+	  unsigned int max = scan->max_cells + 256;
+	  unsigned short *columns =
+	      realloc (scan->columns, sizeof (unsigned short) * max);
+	  biff_cell_value *cells;
+	  FreeXL_CellValue *values;
+	  if (columns != NULL)
+	      scan->columns = columns;
+	  cells = realloc (scan->cells, sizeof (biff_cell_value) * max);
+	  if (cells != NULL)
+	      scan->cells = cells;
+	  values = realloc (scan->values, sizeof (FreeXL_CellValue) * max);
+	  if (values != NULL)
+	      scan->values = values;
+	  if (columns == NULL || cells == NULL || values == NULL)
+	    {
+		scan->error = FREEXL_INSUFFICIENT_MEMORY;
+		scan->stop = 1;
+		return &(scan->discard);
+	    }
+	  scan->max_cells = max;
+      }
+    scan->row = row;
+    *(scan->columns + scan->n_cells) = col;
+    p_cell = scan->cells + scan->n_cells;
+    p_cell->type = FREEXL_CELL_NULL;
+    scan->n_cells += 1;
+    return p_cell;
+}
+
+static int
+check_biff_cell (biff_workbook * workbook, unsigned int row,
+		 unsigned short col)
+{
+/* checking if some cell can be set */
+    if (workbook->active_sheet == NULL)
+	return 0;
+    if (workbook->scan != NULL)
+	return 1;		/* streaming: there is no cell store at all */
+    if (workbook->active_sheet->cell_values == NULL)
+	return 0;
+    if (row >= workbook->active_sheet->rows
+	|| col >= workbook->active_sheet->columns)
+	return 0;
+    return 1;
+}
+
+static biff_cell_value *
+get_biff_cell_slot (biff_workbook * workbook, unsigned int row,
+		    unsigned short col)
+{
+/* locating some cell, and widening the span of its row */
+    biff_sheet *sheet = workbook->active_sheet;
+    biff_row_span *span;
+    if (workbook->scan != NULL)
+	return get_scan_cell_slot (workbook, row, col);
+    span = sheet->row_spans + row;
+    if (span->last == 0)
+      {
+	  span->first = col;
+	  span->last = col + 1;
+      }
+    else
+      {
+	  if (col < span->first)
+	      span->first = col;
+	  if (col >= span->last)
+	      span->last = col + 1;
+      }
+    return sheet->cell_values + (row * sheet->columns) + col;
+}
+
 static int
 set_date_int_value (biff_workbook * workbook, unsigned int row,
 		    unsigned short col, unsigned short mode, int num)
@@ -620,12 +801,7 @@ set_date_int_value (biff_workbook * workbook, unsigned int row,
     int dd;
     int count = num;
 
-    if (workbook->active_sheet == NULL)
-	return FREEXL_ILLEGAL_CELL_ROW_COL;
-    if (workbook->active_sheet->cell_values == NULL)
-	return FREEXL_ILLEGAL_CELL_ROW_COL;
-    if (row >= workbook->active_sheet->rows
-	|| col >= workbook->active_sheet->columns)
+    if (!check_biff_cell (workbook, row, col))
 	return FREEXL_ILLEGAL_CELL_ROW_COL;
 
     if (mode)
@@ -648,9 +824,7 @@ set_date_int_value (biff_workbook * workbook, unsigned int row,
 	return FREEXL_INSUFFICIENT_MEMORY;
     strcpy (string, buf);
 
-    p_cell =
-	workbook->active_sheet->cell_values +
-	(row * workbook->active_sheet->columns) + col;
+    p_cell = get_biff_cell_slot (workbook, row, col);
     p_cell->type = FREEXL_CELL_DATE;
     p_cell->value.text_value = string;
     return FREEXL_OK;
@@ -670,12 +844,7 @@ set_datetime_int_value (biff_workbook * workbook, unsigned int row,
     int dd;
     int count = num;
 
-    if (workbook->active_sheet == NULL)
-	return FREEXL_ILLEGAL_CELL_ROW_COL;
-    if (workbook->active_sheet->cell_values == NULL)
-	return FREEXL_ILLEGAL_CELL_ROW_COL;
-    if (row >= workbook->active_sheet->rows
-	|| col >= workbook->active_sheet->columns)
+    if (!check_biff_cell (workbook, row, col))
 	return FREEXL_ILLEGAL_CELL_ROW_COL;
 
     if (mode)
@@ -698,9 +867,7 @@ set_datetime_int_value (biff_workbook * workbook, unsigned int row,
 	return FREEXL_INSUFFICIENT_MEMORY;
     strcpy (string, buf);
 
-    p_cell =
-	workbook->active_sheet->cell_values +
-	(row * workbook->active_sheet->columns) + col;
+    p_cell = get_biff_cell_slot (workbook, row, col);
     p_cell->type = FREEXL_CELL_DATETIME;
     p_cell->value.text_value = string;
     return FREEXL_OK;
@@ -720,12 +887,7 @@ set_date_double_value (biff_workbook * workbook, unsigned int row,
     int dd;
     int count = (int) floor (num);
 
-    if (workbook->active_sheet == NULL)
-	return FREEXL_ILLEGAL_CELL_ROW_COL;
-    if (workbook->active_sheet->cell_values == NULL)
-	return FREEXL_ILLEGAL_CELL_ROW_COL;
-    if (row >= workbook->active_sheet->rows
-	|| col >= workbook->active_sheet->columns)
+    if (!check_biff_cell (workbook, row, col))
 	return FREEXL_ILLEGAL_CELL_ROW_COL;
 
     if (mode)
@@ -748,9 +910,7 @@ set_date_double_value (biff_workbook * workbook, unsigned int row,
 	return FREEXL_INSUFFICIENT_MEMORY;
     strcpy (string, buf);
 
-    p_cell =
-	workbook->active_sheet->cell_values +
-	(row * workbook->active_sheet->columns) + col;
+    p_cell = get_biff_cell_slot (workbook, row, col);
     p_cell->type = FREEXL_CELL_DATE;
     p_cell->value.text_value = string;
     return FREEXL_OK;
@@ -774,12 +934,7 @@ set_datetime_double_value (biff_workbook * workbook, unsigned int row,
     int count = (int) floor (num);
     double percent = num - (double) count;
 
-    if (workbook->active_sheet == NULL)
-	return FREEXL_ILLEGAL_CELL_ROW_COL;
-    if (workbook->active_sheet->cell_values == NULL)
-	return FREEXL_ILLEGAL_CELL_ROW_COL;
-    if (row >= workbook->active_sheet->rows
-	|| col >= workbook->active_sheet->columns)
+    if (!check_biff_cell (workbook, row, col))
 	return FREEXL_ILLEGAL_CELL_ROW_COL;
 
     if (mode)
@@ -803,9 +958,7 @@ set_datetime_double_value (biff_workbook * workbook, unsigned int row,
 	return FREEXL_INSUFFICIENT_MEMORY;
     strcpy (string, buf);
 
-    p_cell =
-	workbook->active_sheet->cell_values +
-	(row * workbook->active_sheet->columns) + col;
+    p_cell = get_biff_cell_slot (workbook, row, col);
     p_cell->type = FREEXL_CELL_DATETIME;
     p_cell->value.text_value = string;
     return FREEXL_OK;
@@ -826,12 +979,7 @@ set_time_double_value (biff_workbook * workbook, unsigned int row,
     int count = (int) floor (num);
     double percent = num - (double) count;
 
-    if (workbook->active_sheet == NULL)
-	return FREEXL_ILLEGAL_CELL_ROW_COL;
-    if (workbook->active_sheet->cell_values == NULL)
-	return FREEXL_ILLEGAL_CELL_ROW_COL;
-    if (row >= workbook->active_sheet->rows
-	|| col >= workbook->active_sheet->columns)
+    if (!check_biff_cell (workbook, row, col))
 	return FREEXL_ILLEGAL_CELL_ROW_COL;
 
     compute_time (&h, &m, &s, percent);
@@ -842,9 +990,7 @@ set_time_double_value (biff_workbook * workbook, unsigned int row,
 	return FREEXL_INSUFFICIENT_MEMORY;
     strcpy (string, buf);
 
-    p_cell =
-	workbook->active_sheet->cell_values +
-	(row * workbook->active_sheet->columns) + col;
+    p_cell = get_biff_cell_slot (workbook, row, col);
     p_cell->type = FREEXL_CELL_TIME;
     p_cell->value.text_value = string;
     return FREEXL_OK;
@@ -857,17 +1003,10 @@ set_int_value (biff_workbook * workbook, unsigned int row, unsigned short col,
 /* setting an INTEGER value to some cell */
     biff_cell_value *p_cell;
 
-    if (workbook->active_sheet == NULL)
-	return FREEXL_ILLEGAL_CELL_ROW_COL;
-    if (workbook->active_sheet->cell_values == NULL)
-	return FREEXL_ILLEGAL_CELL_ROW_COL;
-    if (row >= workbook->active_sheet->rows
-	|| col >= workbook->active_sheet->columns)
+    if (!check_biff_cell (workbook, row, col))
 	return FREEXL_ILLEGAL_CELL_ROW_COL;
 
-    p_cell =
-	workbook->active_sheet->cell_values +
-	(row * workbook->active_sheet->columns) + col;
+    p_cell = get_biff_cell_slot (workbook, row, col);
     p_cell->type = FREEXL_CELL_INT;
     p_cell->value.int_value = num;
     return FREEXL_OK;
@@ -880,17 +1019,10 @@ set_double_value (biff_workbook * workbook, unsigned int row,
 /* setting a DOUBLE value to some cell */
     biff_cell_value *p_cell;
 
-    if (workbook->active_sheet == NULL)
-	return FREEXL_ILLEGAL_CELL_ROW_COL;
-    if (workbook->active_sheet->cell_values == NULL)
-	return FREEXL_ILLEGAL_CELL_ROW_COL;
-    if (row >= workbook->active_sheet->rows
-	|| col >= workbook->active_sheet->columns)
+    if (!check_biff_cell (workbook, row, col))
 	return FREEXL_ILLEGAL_CELL_ROW_COL;
 
-    p_cell =
-	workbook->active_sheet->cell_values +
-	(row * workbook->active_sheet->columns) + col;
+    p_cell = get_biff_cell_slot (workbook, row, col);
     p_cell->type = FREEXL_CELL_DOUBLE;
     p_cell->value.dbl_value = num;
     return FREEXL_OK;
@@ -903,17 +1035,10 @@ set_text_value (biff_workbook * workbook, unsigned int row, unsigned short col,
 /* setting a TEXT value to some cell */
     biff_cell_value *p_cell;
 
-    if (workbook->active_sheet == NULL)
-	return FREEXL_ILLEGAL_CELL_ROW_COL;
-    if (workbook->active_sheet->cell_values == NULL)
-	return FREEXL_ILLEGAL_CELL_ROW_COL;
-    if (row >= workbook->active_sheet->rows
-	|| col >= workbook->active_sheet->columns)
+    if (!check_biff_cell (workbook, row, col))
 	return FREEXL_ILLEGAL_CELL_ROW_COL;
 
-    p_cell =
-	workbook->active_sheet->cell_values +
-	(row * workbook->active_sheet->columns) + col;
+    p_cell = get_biff_cell_slot (workbook, row, col);
     if (!text)
       {
 	  p_cell->type = FREEXL_CELL_NULL;
@@ -931,17 +1056,10 @@ set_sst_value (biff_workbook * workbook, unsigned int row, unsigned short col,
 /* setting an SST-TEXT value to some cell */
     biff_cell_value *p_cell;
 
-    if (workbook->active_sheet == NULL)
-	return FREEXL_ILLEGAL_CELL_ROW_COL;
-    if (workbook->active_sheet->cell_values == NULL)
-	return FREEXL_ILLEGAL_CELL_ROW_COL;
-    if (row >= workbook->active_sheet->rows
-	|| col >= workbook->active_sheet->columns)
+    if (!check_biff_cell (workbook, row, col))
 	return FREEXL_ILLEGAL_CELL_ROW_COL;
 
-    p_cell =
-	workbook->active_sheet->cell_values +
-	(row * workbook->active_sheet->columns) + col;
+    p_cell = get_biff_cell_slot (workbook, row, col);
     if (!text)
       {
 	  p_cell->type = FREEXL_CELL_NULL;
@@ -1044,18 +1162,6 @@ get_worksheet_count (biff_workbook * workbook)
     return count;
 }
 
-static void
-destroy_cell (biff_cell_value * cell)
-{
-/* destroying a cell */
-    if (cell->type == FREEXL_CELL_TEXT || cell->type == FREEXL_CELL_DATE
-	|| cell->type == FREEXL_CELL_DATETIME || cell->type == FREEXL_CELL_TIME)
-      {
-	  if (cell->value.text_value)
-	      free (cell->value.text_value);
-      }
-}
-
 static void
 destroy_sheet (biff_sheet * sheet)
 {
@@ -1083,9 +1189,39 @@ destroy_sheet (biff_sheet * sheet)
 	    }
       }
     free (sheet->cell_values);
+    if (sheet->row_spans)
+	free (sheet->row_spans);
+    if (sheet->column_stats)
+	free (sheet->column_stats);
     free (sheet);
 }
 
+static void
+apply_biff_projection (biff_workbook * workbook)
+{
+/* restricting the dimensions of the active Worksheet to the projection */
+    freexl_projection *proj = workbook->projection;
+    biff_sheet *sheet = workbook->active_sheet;
+    biff_sheet *p_sheet = workbook->first_sheet;
+    int index = 0;
+    while (p_sheet != NULL && p_sheet != sheet)
+      {
+	  index++;
+	  p_sheet = p_sheet->next;
+      }
+    if (!freexl_projected_sheet (proj, index))
+      {
+	  /* a Worksheet not to be loaded at all */
+	  sheet->rows = 0;
+	  sheet->columns = 0;
+	  return;
+      }
+    if (sheet->rows > proj->end_row)
+	sheet->rows = proj->end_row;
+    if (proj->columns != NULL && sheet->columns > proj->n_columns)
+	sheet->columns = proj->n_columns;
+}
+
 static int
 allocate_cells (biff_workbook * workbook)
 {
@@ -1099,6 +1235,10 @@ allocate_cells (biff_workbook * workbook)
 	return FREEXL_NULL_ARGUMENT;
     if (workbook->active_sheet == NULL)
 	return FREEXL_NULL_ARGUMENT;
+    if (workbook->scan != NULL)
+	return FREEXL_OK;	/* streaming: cells aren't stored at all */
+    if (workbook->projection != NULL)
+	apply_biff_projection (workbook);
 
 /* testing for an unrealistically high memory size > 256MB */
     dsize =
@@ -1112,6 +1252,7 @@ allocate_cells (biff_workbook * workbook)
     if (workbook->active_sheet->rows * workbook->active_sheet->columns <= 0)
       {
 	  workbook->active_sheet->cell_values = NULL;
+	  workbook->active_sheet->row_spans = NULL;
 	  return FREEXL_OK;
       }
     workbook->active_sheet->cell_values =
@@ -1133,9 +1274,40 @@ allocate_cells (biff_workbook * workbook)
 	    }
       }
 
+/* allocating the row spans array */
+    workbook->active_sheet->row_spans =
+	calloc (workbook->active_sheet->rows, sizeof (biff_row_span));
+    if (workbook->active_sheet->row_spans == NULL)
+	return FREEXL_INSUFFICIENT_MEMORY;
+
     return FREEXL_OK;
 }
 
+static int
+check_projected_cell (biff_workbook * workbook, unsigned int row,
+		      unsigned short col)
+{
+/* checking if some cell falls outside the requested projection */
+    if (workbook->projection == NULL || workbook->scan != NULL)
+	return 0;
+    if (workbook->active_sheet == NULL)
+	return 0;
+    if (workbook->active_sheet->cell_values == NULL)
+      {
+	  /* a Worksheet not to be loaded at all */
+	  workbook->skip_sheet = 1;
+	  return 1;
+      }
+    if (workbook->projection->preview
+	&& row >= workbook->projection->end_row)
+      {
+	  /* preview: any following cell will be out of range as well */
+	  workbook->skip_sheet = 1;
+	  return 1;
+      }
+    return !freexl_projected_cell (workbook->projection, row, col);
+}
+
 static int
 add_sheet_to_workbook (biff_workbook * workbook, unsigned int offset,
 		       unsigned char visible, unsigned char type, char *name)
@@ -1151,8 +1323,13 @@ add_sheet_to_workbook (biff_workbook * workbook, unsigned int offset,
     sheet->rows = 0;
     sheet->columns = 0;
     sheet->cell_values = NULL;
+    sheet->row_spans = NULL;
     sheet->valid_dimension = 0;
+    sheet->declared = 0;
+    sheet->declared_rows = 0;
+    sheet->declared_columns = 0;
     sheet->already_done = 0;
+    sheet->column_stats = NULL;
     sheet->next = NULL;
 
 /* updating the linked list */
@@ -1202,6 +1379,7 @@ destroy_workbook (biff_workbook * workbook)
 	    }
 	  if (workbook->fat)
 	      destroy_fat_chain (workbook->fat);
+	  freexl_destroy_projection (workbook->projection);
 	  free (workbook);
       }
 }
@@ -1254,6 +1432,12 @@ alloc_workbook (int magic)
     workbook->last_sheet = NULL;
     workbook->active_sheet = NULL;
     workbook->second_pass = 0;
+    workbook->scan = NULL;
+    workbook->threads = 0;
+    workbook->stop_at_eof = 0;
+    workbook->eof_found = 0;
+    workbook->projection = NULL;
+    workbook->skip_sheet = 0;
     workbook->max_format_index = 0;
     workbook->biff_xf_next_index = 0;
     return workbook;
@@ -2224,9 +2408,13 @@ check_legacy_undeclared_dimension (biff_workbook * workbook, int swap,
 	  char *utf8_name;
 	  unsigned int rows = 0;
 	  unsigned short columns = 0;
-	  if (!legacy_emergency_dimension
-	      (workbook, swap, type, size, &rows, &columns))
-	      return 0;
+	  if (workbook->scan == NULL)
+	    {
+		/* streaming doesn't need any preliminary pass */
+		if (!legacy_emergency_dimension
+		    (workbook, swap, type, size, &rows, &columns))
+		    return 0;
+	    }
 	  /* initializing the worksheet */
 	  utf8_name = malloc (10);
 	  strcpy (utf8_name, "Worksheet");
@@ -2298,6 +2486,10 @@ read_legacy_biff (biff_workbook * workbook, int swap)
     while (1)
       {
 	  /* looping on BIFF records */
+	  if (workbook->scan != NULL && workbook->scan->stop)
+	      return 1;
+	  if (workbook->skip_sheet)
+	      return 1;		/* nothing else to be loaded */
 
 	  if (xls_fread (sizeof (buf), &buf, 1, 4, workbook->xls) != 4)
 	      return 0;
@@ -2501,6 +2693,9 @@ read_legacy_biff (biff_workbook * workbook, int swap)
 		      int ret;
 		      workbook->active_sheet->rows = rows;
 		      workbook->active_sheet->columns = columns;
+		      workbook->active_sheet->declared = 1;
+		      workbook->active_sheet->declared_rows = rows;
+		      workbook->active_sheet->declared_columns = columns;
 		      ret = allocate_cells (workbook);
 		      if (ret != FREEXL_OK)
 			  return 0;
@@ -2540,6 +2735,8 @@ read_legacy_biff (biff_workbook * workbook, int swap)
 		if (swap)
 		    swap16 (&word16);
 		col = word16.value;
+		if (check_projected_cell (workbook, row, col))
+		    continue;
 
 		format = *(workbook->record + 4);
 		format &= 0x3F;
@@ -2608,6 +2805,8 @@ read_legacy_biff (biff_workbook * workbook, int swap)
 		if (swap)
 		    swap16 (&word16);
 		col = word16.value;
+		if (check_projected_cell (workbook, row, col))
+		    continue;
 
 		if (workbook->biff_version == FREEXL_BIFF_VER_2)
 		  {
@@ -2687,6 +2886,8 @@ read_legacy_biff (biff_workbook * workbook, int swap)
 		if (swap)
 		    swap16 (&word16);
 		col = word16.value;
+		if (check_projected_cell (workbook, row, col))
+		    continue;
 
 		if (workbook->biff_version == FREEXL_BIFF_VER_2)
 		  {
@@ -2740,6 +2941,8 @@ read_legacy_biff (biff_workbook * workbook, int swap)
 		if (swap)
 		    swap16 (&word16);
 		col = word16.value;
+		if (check_projected_cell (workbook, row, col))
+		    continue;
 		memcpy (word16.bytes, workbook->record + 4, 2);
 		if (swap)
 		    swap16 (&word16);
@@ -2842,6 +3045,8 @@ read_legacy_biff (biff_workbook * workbook, int swap)
 		if (swap)
 		    swap16 (&word16);
 		col = word16.value;
+		if (check_projected_cell (workbook, row, col))
+		    continue;
 
 		if (workbook->biff_version == FREEXL_BIFF_VER_2)
 		  {
@@ -2891,6 +3096,15 @@ static int
 check_already_done (biff_workbook * workbook)
 {
 /* checking if the currently active sheet has been already loaded */
+    if (workbook->scan != NULL)
+      {
+	  /* streaming: only the requested Worksheet is of interest */
+	  if (workbook->active_sheet == NULL || workbook->scan->stop)
+	      return 1;
+	  if (workbook->active_sheet != get_scan_sheet (workbook))
+	      return 1;
+	  return 0;
+      }
     if (workbook->active_sheet != NULL)
       {
 	  if (workbook->active_sheet->already_done)
@@ -2907,6 +3121,8 @@ check_undeclared_dimension (biff_workbook * workbook, unsigned int row,
 			    unsigned short col)
 {
 /* checking if DIMENSION isn't yet set */
+    if (workbook->scan != NULL)
+	return 0;		/* streaming: no DIMENSION is required */
     if (workbook->active_sheet != NULL)
       {
 	  if (workbook->active_sheet->valid_dimension == 0)
@@ -3015,6 +3231,21 @@ parse_biff_record (biff_workbook * workbook, int swap)
     if (workbook->record_type == BIFF_EOF)
       {
 	  /* EOF marker found: the current stream is terminated */
+	  if (workbook->scan != NULL && workbook->active_sheet != NULL
+	      && workbook->active_sheet == get_scan_sheet (workbook))
+	    {
+		/* streaming: the requested Worksheet is now complete */
+		flush_scan_row (workbook->scan);
+		workbook->scan->done = 1;
+		workbook->scan->stop = 1;
+	    }
+	  if (workbook->scan != NULL && workbook->active_sheet == NULL)
+	    {
+		/* streaming: globals done, seeking to the scanned sheet */
+		workbook->skip_sheet = 1;
+	    }
+	  if (workbook->stop_at_eof)
+	      workbook->eof_found = 1;
 	  workbook->ok_bof = 0;
 	  workbook->biff_content_type = 0;
 	  workbook->biff_code_page = 0;
@@ -3171,10 +3402,19 @@ parse_biff_record (biff_workbook * workbook, int swap)
 		int ret;
 		workbook->active_sheet->rows = rows;
 		workbook->active_sheet->columns = columns;
+		workbook->active_sheet->declared = 1;
+		workbook->active_sheet->declared_rows = rows;
+		workbook->active_sheet->declared_columns = columns;
 		ret = allocate_cells (workbook);
 		if (ret != FREEXL_OK)
 		    return ret;
 		workbook->active_sheet->valid_dimension = 1;
+		if (workbook->projection != NULL
+		    && workbook->active_sheet->cell_values == NULL)
+		  {
+		      /* no cell of this Worksheet could ever be loaded */
+		      workbook->skip_sheet = 1;
+		  }
 	    }
 	  return FREEXL_OK;
       }
@@ -3317,6 +3557,8 @@ parse_biff_record (biff_workbook * workbook, int swap)
 
 	  if (check_undeclared_dimension (workbook, row, col))
 	      return FREEXL_OK;
+	  if (check_projected_cell (workbook, row, col))
+	      return FREEXL_OK;
 
 	  memcpy (word16.bytes, workbook->record + 4, 2);
 	  if (swap)
@@ -3376,6 +3618,8 @@ parse_biff_record (biff_workbook * workbook, int swap)
 
 	  if (check_undeclared_dimension (workbook, row, col))
 	      return FREEXL_OK;
+	  if (check_projected_cell (workbook, row, col))
+	      return FREEXL_OK;
 
 	  value = *(workbook->record + 6);
 	  if (value != 0)
@@ -3417,6 +3661,8 @@ parse_biff_record (biff_workbook * workbook, int swap)
 
 	  if (check_undeclared_dimension (workbook, row, col))
 	      return FREEXL_OK;
+	  if (check_projected_cell (workbook, row, col))
+	      return FREEXL_OK;
 
 	  memcpy (word16.bytes, workbook->record + 4, 2);
 	  if (swap)
@@ -3516,6 +3762,12 @@ parse_biff_record (biff_workbook * workbook, int swap)
 	  while ((off + 6) < workbook->record_size)
 	    {
 		/* fetching one cell value */
+		if (check_projected_cell (workbook, row, col))
+		  {
+		      off += 6;
+		      col++;
+		      continue;
+		  }
 		memcpy (word16.bytes, workbook->record + off, 2);
 		if (swap)
 		    swap16 (&word16);
@@ -3616,6 +3868,8 @@ parse_biff_record (biff_workbook * workbook, int swap)
 
 	  if (check_undeclared_dimension (workbook, row, col))
 	      return FREEXL_OK;
+	  if (check_projected_cell (workbook, row, col))
+	      return FREEXL_OK;
 
 	  memcpy (word16.bytes, workbook->record + 6, 2);
 	  if (swap)
@@ -3688,6 +3942,8 @@ parse_biff_record (biff_workbook * workbook, int swap)
 
 	  if (check_undeclared_dimension (workbook, row, col))
 	      return FREEXL_OK;
+	  if (check_projected_cell (workbook, row, col))
+	      return FREEXL_OK;
 
 	  memcpy (word32.bytes, workbook->record + 6, 4);
 	  if (swap)
@@ -3894,7 +4150,10 @@ read_biff_next_record (biff_workbook * workbook, int swap, int *errcode)
   record_done:
     ret = parse_biff_record (workbook, swap);
     if (ret != FREEXL_OK)
-	return 0;
+      {
+	  *errcode = ret;
+	  return 0;
+      }
     *errcode = FREEXL_OK;
     return 1;
 }
@@ -3945,7 +4204,10 @@ read_mini_biff_next_record (biff_workbook * workbook, int swap, int *errcode)
 
     ret = parse_biff_record (workbook, swap);
     if (ret != FREEXL_OK)
-	return 0;
+      {
+	  *errcode = ret;
+	  return 0;
+      }
     *errcode = FREEXL_OK;
     return 1;
 }
@@ -4082,79 +4344,138 @@ check_little_endian_arch ()
 }
 
 static int
-common_open_xls (const char *path, freexl_handle ** handle, int magic)
+seek_workbook_stream (biff_workbook * workbook, unsigned int offset)
 {
-/* opening and initializing the Workbook - XLS */
-    biff_workbook *workbook;
-    biff_sheet *p_sheet;
-    fat_chain *chain = NULL;
-    int errcode;
+/* positioning the Workbook stream at some offset (following the FAT chain) */
+    unsigned int sector_size = workbook->fat->sector_size;
+    unsigned int sector = workbook->start_sector;
+    unsigned int skip = offset / sector_size;
+    unsigned int i;
     int ret;
-    int swap = check_little_endian_arch ();
-
-    *handle = malloc (sizeof (freexl_handle));
-    (*handle)->xls_handle = NULL;
-    (*handle)->xlsx_handle = NULL;
-    (*handle)->ods_handle = NULL;
-/* allocating the Workbook struct */
-    workbook = alloc_workbook (magic);
-    if (!workbook)
-	return FREEXL_INSUFFICIENT_MEMORY;
-    (*handle)->xls_handle = workbook;
-
-    workbook->xls = fopen (path, "rb");
-    if (workbook->xls == NULL)
-	return FREEXL_FILE_NOT_FOUND;
 
-/*
- * the XLS file is internally structured as a FAT-like
- * file-system (Compound File Binary Format, CFBF) 
- * so we'll start by parsing the FAT
- */
-    chain = read_cfbf_header (workbook, swap, &errcode);
-    if (!chain)
+    for (i = 0; i < skip; i++)
       {
-	  /* it's not a CFBF file: testing older BIFF-(2,3,4) formats */
-	  if (read_legacy_biff (workbook, swap))
-	      return FREEXL_OK;
-	  goto stop;
+	  fat_entry *entry = get_fat_entry (workbook->fat, sector);
+	  if (entry == NULL || entry->next_sector == 0xfffffffe)
+	      return FREEXL_CFBF_ILLEGAL_FAT_ENTRY;
+	  sector = entry->next_sector;
+      }
+    workbook->current_sector = sector;
+    ret = read_cfbf_sector (workbook, workbook->sector_buf);
+    if (ret != FREEXL_OK)
+	return ret;
+    workbook->bytes_read = (skip + 1) * sector_size;
+    if (workbook->bytes_read > workbook->size)
+      {
+	  /* incomplete last sector */
+	  workbook->sector_end =
+	      sector_size - (workbook->bytes_read - workbook->size);
       }
+    else
+	workbook->sector_end = sector_size;
+    workbook->p_in = workbook->sector_buf + (offset % sector_size);
+    workbook->sector_ready = 1;
+    workbook->current_offset = offset;
+    return FREEXL_OK;
+}
 
-/* transferring FAT chain ownership */
-    workbook->fat = chain;
-    chain = NULL;
+static int
+skip_biff_substream (biff_workbook * workbook, int *errcode)
+{
+/* 
+ * skipping the rest of the current Worksheet substream
+ *
+ * no further cell could be loaded from it, so we'll directly
+ * seek to the BOF of the next Worksheet (if any); when streaming
+ * and the globals substream is complete, we'll directly seek to
+ * the BOF of the requested Worksheet instead
+ */
+    biff_sheet *p_sheet;
+    biff_sheet *next = NULL;
+    biff_sheet *current = workbook->active_sheet;
+    int ret;
 
-/* creating the UTF16/UTF8 converter */
-    workbook->utf16_converter = create_utf16_utf8_converter ();
-    if (workbook->utf16_converter == NULL)
+    workbook->skip_sheet = 0;
+    *errcode = FREEXL_OK;
+    if (current == NULL)
       {
-	  errcode = FREEXL_UNSUPPORTED_CHARSET;
-	  goto stop;
+	  if (workbook->scan == NULL)
+	      return 1;
+	  /* streaming: any other Worksheet is of no interest */
+	  next = get_scan_sheet (workbook);
       }
-
-/* we'll now retrieve the FAT main Directory */
-    ret = get_workbook_stream (workbook);
-    if (ret != FREEXL_OK)
+    else if (workbook->stop_at_eof)
       {
-	  errcode = ret;
-	  goto stop;
+	  /* a single substream is being parsed */
+	  workbook->eof_found = 1;
+	  return 1;
+      }
+    else
+      {
+	  p_sheet = workbook->first_sheet;
+	  while (p_sheet)
+	    {
+		/* searching the substream immediately following the current one */
+		if (p_sheet->start_offset > current->start_offset
+		    && (next == NULL
+			|| p_sheet->start_offset < next->start_offset))
+		    next = p_sheet;
+		p_sheet = p_sheet->next;
+	    }
+      }
+    if (next == NULL || next->start_offset >= workbook->size)
+      {
+	  /* the last Worksheet: nothing else is left to be parsed */
+	  workbook->eof_found = 1;
+	  return 1;
+      }
+    if (workbook->size <= workbook->fat->miniCutOff)
+      {
+	  /* mini-stream: already in memory */
+	  workbook->p_in = workbook->fat->miniStream + next->start_offset;
+	  workbook->current_offset = next->start_offset;
+      }
+    else
+      {
+	  ret = seek_workbook_stream (workbook, next->start_offset);
+	  if (ret != FREEXL_OK)
+	    {
+		*errcode = ret;
+		return 0;
+	    }
       }
+    /* just as after the EOF of the current substream */
+    workbook->ok_bof = 0;
+    workbook->active_sheet = NULL;
+    workbook->biff_content_type = 0;
+    workbook->biff_code_page = 0;
+    return 1;
+}
 
-/* we'll now parse the Workbook */
+static int
+read_xls_workbook_stream (biff_workbook * workbook, int swap, int *errcode)
+{
+/* parsing all BIFF records from the Workbook stream */
+    int ret;
     if (workbook->size <= workbook->fat->miniCutOff)
       {
 	  /* mini-stream stored in miniFAT */
-	  int ret = read_mini_stream (workbook, &errcode);
-	  if (!ret)
-	      goto stop;
+	  if (!read_mini_stream (workbook, errcode))
+	      return 0;
 	  workbook->p_in = workbook->fat->miniStream;
 	  while (1)
 	    {
-		ret = read_mini_biff_next_record (workbook, swap, &errcode);
+		if (workbook->eof_found
+		    || (workbook->scan != NULL && workbook->scan->stop))
+		    break;
+		ret = read_mini_biff_next_record (workbook, swap, errcode);
 		if (ret == -1)
 		    break;	/* EOF */
 		if (ret == 0)
-		    goto stop;
+		    return 0;
+		if (workbook->skip_sheet
+		    && !skip_biff_substream (workbook, errcode))
+		    return 0;
 	    }
       }
     else
@@ -4162,13 +4483,307 @@ common_open_xls (const char *path, freexl_handle ** handle, int magic)
 	  /* normal stream */
 	  while (1)
 	    {
-		int ret = read_biff_next_record (workbook, swap, &errcode);
+		if (workbook->eof_found
+		    || (workbook->scan != NULL && workbook->scan->stop))
+		    break;
+		ret = read_biff_next_record (workbook, swap, errcode);
+		if (ret == -1)
+		    break;	/* EOF */
+		if (ret == 0)
+		    return 0;
+		if (workbook->skip_sheet
+		    && !skip_biff_substream (workbook, errcode))
+		    return 0;
+	    }
+      }
+    return 1;
+}
+
+#ifndef OMIT_THREADS		/* only if multithreading is enabled */
+static int
+parse_xls_worksheet (biff_sheet_jobs * jobs, biff_sheet * sheet)
+{
+/* 
+ * parsing a single Worksheet substream
+ *
+ * each thread uses its own private copy of the Workbook struct,
+ * so that the shared one (SST, formats, XFs, FAT) is never modified
+ */
+    biff_workbook *workbook;
+    int errcode = FREEXL_OK;
+    int ret;
+    int pass;
+
+    workbook = malloc (sizeof (biff_workbook));
+    if (workbook == NULL)
+	return FREEXL_INSUFFICIENT_MEMORY;
+    memcpy (workbook, jobs->workbook, sizeof (biff_workbook));
+    workbook->utf8_converter = NULL;
+    workbook->utf16_converter = create_utf16_utf8_converter ();
+    workbook->xls = fopen (jobs->path, "rb");
+    if (workbook->xls == NULL)
+      {
+	  errcode = FREEXL_FILE_NOT_FOUND;
+	  goto stop;
+      }
+    if (workbook->utf16_converter == NULL)
+      {
+	  errcode = FREEXL_UNSUPPORTED_CHARSET;
+	  goto stop;
+      }
+    if (jobs->workbook->utf8_converter != NULL)
+      {
+	  /* creating a private charset converter */
+	  workbook->biff_code_page = workbook->biff_book_code_page;
+	  if (!biff_set_utf8_converter (workbook))
+	    {
+		errcode = FREEXL_UNSUPPORTED_CHARSET;
+		goto stop;
+	    }
+      }
+
+    for (pass = 0; pass < 2; pass++)
+      {
+	  ret = seek_workbook_stream (workbook, sheet->start_offset);
+	  if (ret != FREEXL_OK)
+	    {
+		errcode = ret;
+		goto stop;
+	    }
+	  workbook->ok_bof = 0;
+	  workbook->active_sheet = NULL;
+	  workbook->stop_at_eof = 1;
+	  workbook->eof_found = 0;
+	  while (!workbook->eof_found)
+	    {
+		ret = read_biff_next_record (workbook, jobs->swap, &errcode);
 		if (ret == -1)
 		    break;	/* EOF */
 		if (ret == 0)
 		    goto stop;
+		if (workbook->skip_sheet)
+		    skip_biff_substream (workbook, &errcode);
+	    }
+	  if (sheet->valid_dimension)
+	      break;
+	  /* DIMENSION is missing: a second pass is required */
+	  sheet->rows += 1;
+	  sheet->columns += 1;
+	  workbook->active_sheet = sheet;
+	  ret = allocate_cells (workbook);
+	  if (ret != FREEXL_OK)
+	    {
+		errcode = ret;
+		goto stop;
+	    }
+	  sheet->valid_dimension = 1;
+      }
+    sheet->already_done = 1;
+    errcode = FREEXL_OK;
+
+  stop:
+    if (workbook->xls)
+	fclose (workbook->xls);
+    if (workbook->utf8_converter)
+	iconv_close (workbook->utf8_converter);
+    if (workbook->utf16_converter)
+	iconv_close (workbook->utf16_converter);
+    free (workbook);
+    return errcode;
+}
+
+static void
+xls_sheet_worker (void *arg)
+{
+/* a thread parsing Worksheet substreams until none is left */
+    biff_sheet_jobs *jobs = (biff_sheet_jobs *) arg;
+    int i;
+    int ret;
+    while (1)
+      {
+	  freexl_mutex_lock (jobs->mutex);
+	  i = jobs->next;
+	  jobs->next += 1;
+	  if (jobs->error != FREEXL_OK)
+	      i = jobs->count;	/* giving up */
+	  freexl_mutex_unlock (jobs->mutex);
+	  if (i >= jobs->count)
+	      break;
+	  ret = parse_xls_worksheet (jobs, *(jobs->sheets + i));
+	  if (ret != FREEXL_OK)
+	    {
+		freexl_mutex_lock (jobs->mutex);
+		if (jobs->error == FREEXL_OK)
+		    jobs->error = ret;
+		freexl_mutex_unlock (jobs->mutex);
 	    }
       }
+}
+
+static int
+do_parallel_xls_worksheets (biff_workbook * workbook, const char *path,
+			    int swap)
+{
+/* 
+ * parsing each Worksheet substream by a separate thread
+ *
+ * the globals substream must have already been parsed
+ */
+    biff_sheet_jobs jobs;
+    biff_sheet *p_sheet;
+    void **threads = NULL;
+    int n_threads;
+    int i;
+
+    jobs.path = path;
+    jobs.workbook = workbook;
+    jobs.count = 0;
+    jobs.next = 0;
+    jobs.swap = swap;
+    jobs.error = FREEXL_OK;
+    p_sheet = workbook->first_sheet;
+    while (p_sheet)
+      {
+	  jobs.count += 1;
+	  p_sheet = p_sheet->next;
+      }
+    if (jobs.count == 0)
+	return FREEXL_OK;
+    jobs.sheets = malloc (sizeof (biff_sheet *) * jobs.count);
+    jobs.mutex = freexl_mutex_create ();
+    /* the current thread will be a worker as well */
+    n_threads = workbook->threads - 1;
+    if (n_threads > jobs.count - 1)
+	n_threads = jobs.count - 1;
+    if (n_threads > 0)
+	threads = malloc (sizeof (void *) * n_threads);
+    if (jobs.sheets == NULL || jobs.mutex == NULL
+	|| (n_threads > 0 && threads == NULL))
+      {
+	  jobs.error = FREEXL_INSUFFICIENT_MEMORY;
+	  goto stop;
+      }
+    i = 0;
+    p_sheet = workbook->first_sheet;
+    while (p_sheet)
+      {
+	  *(jobs.sheets + i) = p_sheet;
+	  i++;
+	  p_sheet = p_sheet->next;
+      }
+
+    for (i = 0; i < n_threads; i++)
+	*(threads + i) = freexl_thread_create (xls_sheet_worker, &jobs);
+    xls_sheet_worker (&jobs);
+    for (i = 0; i < n_threads; i++)
+      {
+	  if (*(threads + i) != NULL)
+	      freexl_thread_join (*(threads + i));
+      }
+/* just as after a sequential parse: the last Sheet is the active one */
+    workbook->active_sheet = workbook->last_sheet;
+
+  stop:
+    if (jobs.sheets != NULL)
+	free (jobs.sheets);
+    if (threads != NULL)
+	free (threads);
+    if (jobs.mutex != NULL)
+	freexl_mutex_destroy (jobs.mutex);
+    return jobs.error;
+}
+#endif /* end conditional multithreading support */
+
+static int
+common_open_xls (const char *path, freexl_handle ** handle, int magic,
+		 biff_scan * scan, const FreeXL_OpenOptions * options)
+{
+/* opening and initializing the Workbook - XLS */
+    biff_workbook *workbook;
+    biff_sheet *p_sheet;
+    fat_chain *chain = NULL;
+    int errcode;
+    int ret;
+    int swap = check_little_endian_arch ();
+
+    *handle = malloc (sizeof (freexl_handle));
+    (*handle)->xls_handle = NULL;
+    (*handle)->xlsx_handle = NULL;
+    (*handle)->ods_handle = NULL;
+/* allocating the Workbook struct */
+    workbook = alloc_workbook (magic);
+    if (!workbook)
+	return FREEXL_INSUFFICIENT_MEMORY;
+    (*handle)->xls_handle = workbook;
+    workbook->scan = scan;
+    if (!freexl_create_projection (options, &(workbook->projection)))
+	return FREEXL_INSUFFICIENT_MEMORY;
+
+    workbook->xls = fopen (path, "rb");
+    if (workbook->xls == NULL)
+	return FREEXL_FILE_NOT_FOUND;
+
+/*
+ * the XLS file is internally structured as a FAT-like
+ * file-system (Compound File Binary Format, CFBF) 
+ * so we'll start by parsing the FAT
+ */
+    chain = read_cfbf_header (workbook, swap, &errcode);
+    if (!chain)
+      {
+	  /* it's not a CFBF file: testing older BIFF-(2,3,4) formats */
+	  if (read_legacy_biff (workbook, swap))
+	      return FREEXL_OK;
+	  goto stop;
+      }
+
+/* transferring FAT chain ownership */
+    workbook->fat = chain;
+    chain = NULL;
+
+/* creating the UTF16/UTF8 converter */
+    workbook->utf16_converter = create_utf16_utf8_converter ();
+    if (workbook->utf16_converter == NULL)
+      {
+	  errcode = FREEXL_UNSUPPORTED_CHARSET;
+	  goto stop;
+      }
+
+/* we'll now retrieve the FAT main Directory */
+    ret = get_workbook_stream (workbook);
+    if (ret != FREEXL_OK)
+      {
+	  errcode = ret;
+	  goto stop;
+      }
+
+/* we'll now parse the Workbook */
+#ifndef OMIT_THREADS		/* only if multithreading is enabled */
+    if (options != NULL && options->xls_threads > 1 && scan == NULL
+	&& magic == FREEXL_MAGIC_START
+	&& workbook->size > workbook->fat->miniCutOff)
+      {
+	  /* only the globals substream will be parsed sequentially */
+	  workbook->threads = options->xls_threads;
+	  workbook->stop_at_eof = 1;
+      }
+#endif
+    if (!read_xls_workbook_stream (workbook, swap, &errcode))
+	goto stop;
+    if (workbook->scan != NULL)
+	return FREEXL_OK;	/* streaming: a single pass is enough */
+#ifndef OMIT_THREADS
+    if (workbook->stop_at_eof)
+      {
+	  /* parsing all Worksheet substreams in parallel */
+	  workbook->stop_at_eof = 0;
+	  workbook->eof_found = 0;
+	  errcode = do_parallel_xls_worksheets (workbook, path, swap);
+	  if (errcode != FREEXL_OK)
+	      goto stop;
+	  return FREEXL_OK;
+      }
+#endif
 
     p_sheet = workbook->first_sheet;
     while (p_sheet)
@@ -4206,6 +4821,8 @@ common_open_xls (const char *path, freexl_handle ** handle, int magic)
 	  workbook->sector_end = 0;
 	  workbook->sector_ready = 0;
 	  workbook->ok_bof = -1;
+	  workbook->eof_found = 0;
+	  workbook->skip_sheet = 0;
 
 	  ret = get_workbook_stream (workbook);
 	  if (ret != FREEXL_OK)
@@ -4215,36 +4832,8 @@ common_open_xls (const char *path, freexl_handle ** handle, int magic)
 	    }
 
 /* we'll now parse the Workbook */
-	  if (workbook->size <= workbook->fat->miniCutOff)
-	    {
-		/* mini-stream stored in miniFAT */
-		int ret = read_mini_stream (workbook, &errcode);
-		if (!ret)
-		    goto stop;
-		workbook->p_in = workbook->fat->miniStream;
-		while (1)
-		  {
-		      ret =
-			  read_mini_biff_next_record (workbook, swap, &errcode);
-		      if (ret == -1)
-			  break;	/* EOF */
-		      if (ret == 0)
-			  goto stop;
-		  }
-	    }
-	  else
-	    {
-		/* normal stream */
-		while (1)
-		  {
-		      int ret =
-			  read_biff_next_record (workbook, swap, &errcode);
-		      if (ret == -1)
-			  break;	/* EOF */
-		      if (ret == 0)
-			  goto stop;
-		  }
-	    }
+	  if (!read_xls_workbook_stream (workbook, swap, &errcode))
+	      goto stop;
       }
 
     return FREEXL_OK;
@@ -4258,20 +4847,99 @@ common_open_xls (const char *path, freexl_handle ** handle, int magic)
     return errcode;
 }
 
+FREEXL_DECLARE void
+freexl_init_open_options (FreeXL_OpenOptions * options)
+{
+/* initializing the open options to their default values */
+    if (options == NULL)
+	return;
+    options->xlsx_strings_mode = FREEXL_XLSX_STRINGS_EAGER;
+    options->xlsx_strings_cache = 0;
+    options->xml_pipeline = 0;
+    options->ods_sheets = NULL;
+    options->ods_threads = 0;
+    options->xls_threads = 0;
+    options->sheet_index = -1;
+    options->columns = NULL;
+    options->n_columns = 0;
+    options->first_row = 0;
+    options->n_rows = 0;
+    options->preview_rows = 0;
+    options->xlsx_xml_only = 0;
+}
+
 FREEXL_DECLARE int
 freexl_open (const char *path, const void **xl_handle)
 {
 /* opening and initializing the Workbook - XLS format expected */
     freexl_handle **handle = (freexl_handle **) xl_handle;
-    return common_open_xls (path, handle, FREEXL_MAGIC_START);
+    return common_open_xls (path, handle, FREEXL_MAGIC_START, NULL, NULL);
 }
 
 FREEXL_DECLARE int
-freexl_open_info (const char *path, const void **xl_handle)
+freexl_open_ex (const char *path, const FreeXL_OpenOptions * options,
+		const void **xl_handle)
+{
+/* opening and initializing the Workbook - XLS format expected */
+    freexl_handle **handle = (freexl_handle **) xl_handle;
+    return common_open_xls (path, handle, FREEXL_MAGIC_START, NULL, options);
+}
+
+FREEXL_DECLARE int
+freexl_open_info (const char *path, const void **xl_handle)
 {
 /* opening and initializing the Workbook (only for Info) */
     freexl_handle **handle = (freexl_handle **) xl_handle;
-    return common_open_xls (path, handle, FREEXL_MAGIC_INFO);
+    return common_open_xls (path, handle, FREEXL_MAGIC_INFO, NULL, NULL);
+}
+
+FREEXL_DECLARE int
+freexl_scan_xls (const char *path, unsigned int sheet_index,
+		 FreeXL_RowCallback callback, void *ctx)
+{
+/* streaming a single Worksheet - XLS format expected */
+    freexl_handle *handle = NULL;
+    biff_scan scan;
+    unsigned int i;
+    int ret;
+
+    if (path == NULL || callback == NULL)
+	return FREEXL_NULL_ARGUMENT;
+    memset (&scan, 0, sizeof (biff_scan));
+    scan.sheet_index = sheet_index;
+    scan.callback = callback;
+    scan.ctx = ctx;
+    scan.discard.type = FREEXL_CELL_NULL;
+
+    ret = common_open_xls (path, &handle, FREEXL_MAGIC_START, &scan, NULL);
+    if (ret == FREEXL_OK)
+      {
+	  /* delivering the last row (if still pending) */
+	  if (!scan.stop)
+	      flush_scan_row (&scan);
+	  if (scan.error != FREEXL_OK)
+	      ret = scan.error;
+	  else if (scan.sheet == NULL)
+	      ret = FREEXL_BIFF_ILLEGAL_SHEET_INDEX;
+      }
+
+/* memory cleanup */
+    for (i = 0; i < scan.n_cells; i++)
+	destroy_cell (scan.cells + i);
+    destroy_cell (&(scan.discard));
+    if (scan.columns)
+	free (scan.columns);
+    if (scan.cells)
+	free (scan.cells);
+    if (scan.values)
+	free (scan.values);
+    if (handle != NULL)
+      {
+	  if (handle->xls_handle != NULL)
+	      destroy_workbook (handle->xls_handle);
+	  free (handle);
+      }
+    return ret;
 }
 
 FREEXL_DECLARE int
@@ -4330,7 +4998,9 @@ freexl_close (const void *xl_handle)
       }
 #endif /* end conditional XML support */
 
-    return FREEXL_INVALID_HANDLE;
+/* a failed open: no Workbook at all, just the handle itself */
+    free (handle);
+    return FREEXL_OK;
 }
 
 static int
@@ -4369,6 +5039,75 @@ count_worksheets_ods (ods_workbook * wb)
     return count;
 }
 
+static int
+get_sheet_dimension_info (const void *xl_handle, unsigned short what,
+			  unsigned int *info)
+{
+/* retrieving the declared dimensions of the active Worksheet */
+    unsigned int rows;
+    unsigned short columns;
+    int ret = freexl_worksheet_declared_dimensions (xl_handle, &rows,
+						    &columns);
+    if (ret == FREEXL_UNDECLARED_DIMENSION)
+      {
+	  *info = FREEXL_UNKNOWN;
+	  return FREEXL_OK;
+      }
+    if (ret != FREEXL_OK)
+	return ret;
+    if (what == FREEXL_SHEET_ROWS)
+	*info = rows;
+    else
+	*info = columns;
+    return FREEXL_OK;
+}
+
+static int
+is_info_xml (freexl_handle * handle)
+{
+/* checking for an XLSX or ODS handle opened in INFO mode (no cell) */
+    if (handle->xlsx_handle != NULL && handle->xlsx_handle->info)
+	return 1;
+    if (handle->ods_handle != NULL && handle->ods_handle->info)
+	return 1;
+    return 0;
+}
+
+static int
+get_info_xml (freexl_handle * handle, unsigned short what, unsigned int *info)
+{
+/* XLSX or ODS: attempting to retrieve some info */
+    if (!info)
+	return FREEXL_NULL_ARGUMENT;
+    *info = FREEXL_UNKNOWN;
+    switch (what)
+      {
+      case FREEXL_BIFF_SHEET_COUNT:
+	  return freexl_get_worksheets_count (handle, info);
+      case FREEXL_BIFF_STRING_COUNT:
+	  /* ODS has no Shared Strings at all */
+	  if (handle->xlsx_handle != NULL)
+	      *info = handle->xlsx_handle->n_strings;
+	  return FREEXL_OK;
+      case FREEXL_SHEET_ROWS:
+      case FREEXL_SHEET_COLUMNS:
+	  return get_sheet_dimension_info (handle, what, info);
+      case FREEXL_CFBF_VERSION:
+      case FREEXL_CFBF_SECTOR_SIZE:
+      case FREEXL_CFBF_FAT_COUNT:
+      case FREEXL_BIFF_VERSION:
+      case FREEXL_BIFF_MAX_RECSIZE:
+      case FREEXL_BIFF_DATEMODE:
+      case FREEXL_BIFF_PASSWORD:
+      case FREEXL_BIFF_CODEPAGE:
+      case FREEXL_BIFF_FORMAT_COUNT:
+      case FREEXL_BIFF_XF_COUNT:
+	  /* not appropriate for XML documents */
+	  return FREEXL_OK;
+      };
+    return FREEXL_INVALID_INFO_ARG;
+}
+
 FREEXL_DECLARE int
 freexl_get_info (const void *xl_handle, unsigned short what, unsigned int *info)
 {
@@ -4377,6 +5116,8 @@ freexl_get_info (const void *xl_handle, unsigned short what, unsigned int *info)
     biff_workbook *workbook;
     if (!handle)
 	return FREEXL_NULL_HANDLE;
+    if (handle->xlsx_handle != NULL || handle->ods_handle != NULL)
+	return get_info_xml (handle, what, info);
     workbook = handle->xls_handle;
     if (!workbook)
 	return FREEXL_NULL_HANDLE;
@@ -4579,6 +5320,9 @@ freexl_get_info (const void *xl_handle, unsigned short what, unsigned int *info)
 	  else
 	      *info = workbook->biff_xf_next_index;
 	  return FREEXL_OK;
+      case FREEXL_SHEET_ROWS:
+      case FREEXL_SHEET_COLUMNS:
+	  return get_sheet_dimension_info (xl_handle, what, info);
       };
 
     return FREEXL_INVALID_INFO_ARG;
@@ -5053,6 +5797,84 @@ freexl_worksheet_dimensions (const void *xl_handle, unsigned int *rows,
     return FREEXL_OK;
 }
 
+static int
+declared_dimensions_xlsx (xlsx_workbook * workbook, unsigned int *rows,
+			  unsigned short *columns)
+{
+/* XLSX: declared dimensions: currently selected Worksheet */
+    if (!workbook)
+	return FREEXL_NULL_HANDLE;
+
+    if (workbook->active_sheet == NULL)
+	return FREEXL_XSLX_UNSELECTED_SHEET;
+    if (workbook->active_sheet->declared_rows < 0)
+	return FREEXL_UNDECLARED_DIMENSION;
+
+    *rows = workbook->active_sheet->declared_rows;
+    *columns = workbook->active_sheet->declared_columns;
+    return FREEXL_OK;
+}
+
+FREEXL_DECLARE int
+freexl_worksheet_declared_dimensions (const void *xl_handle,
+				      unsigned int *rows,
+				      unsigned short *columns)
+{
+/* declared dimensions: currently selected Worksheet */
+    freexl_handle *handle = (freexl_handle *) xl_handle;
+    biff_workbook *workbook;
+    if (!handle)
+	return FREEXL_NULL_HANDLE;
+    if (!rows)
+	return FREEXL_NULL_ARGUMENT;
+    if (!columns)
+	return FREEXL_NULL_ARGUMENT;
+    if (handle->xlsx_handle != NULL)
+	return declared_dimensions_xlsx (handle->xlsx_handle, rows, columns);
+    if (handle->ods_handle != NULL)
+      {
+	  /* ODS never declares the Worksheet dimensions */
+	  if (handle->ods_handle->active_sheet == NULL)
+	      return FREEXL_ODS_UNSELECTED_SHEET;
+	  return FREEXL_UNDECLARED_DIMENSION;
+      }
+    workbook = handle->xls_handle;
+    if (!workbook)
+	return FREEXL_NULL_HANDLE;
+    if ((workbook->magic1 == FREEXL_MAGIC_INFO
+	 || workbook->magic1 == FREEXL_MAGIC_START)
+	&& workbook->magic2 == FREEXL_MAGIC_END)
+	;
+    else
+	return FREEXL_INVALID_HANDLE;
+
+    if (workbook->active_sheet == NULL)
+	return FREEXL_BIFF_UNSELECTED_SHEET;
+    if (!workbook->active_sheet->declared)
+	return FREEXL_UNDECLARED_DIMENSION;
+
+    *rows = workbook->active_sheet->declared_rows;
+    *columns = workbook->active_sheet->declared_columns;
+    return FREEXL_OK;
+}
+
+static const char *
+get_xlsx_shared_string (xlsx_workbook * workbook, int string_index)
+{
+/* XLSX: returning a SharedString from the strings pool */
+    xlsx_string *string;
+#ifndef OMIT_XMLDOC		/* only if XML support is enabled */
+    if (workbook->lazy_strings != NULL)
+	return xlsx_get_lazy_string (workbook, string_index);
+#endif /* end conditional XML support */
+    if (workbook->strings == NULL || workbook->strings_pool == NULL)
+	return NULL;
+    if (string_index < 0 || string_index >= workbook->xml_strings)
+	return NULL;
+    string = workbook->strings + string_index;
+    return workbook->strings_pool + string->offset;
+}
+
 static int
 get_SST_string_xlsx (xlsx_workbook * workbook, unsigned short string_index,
 		     const char **string)
@@ -5066,7 +5888,7 @@ get_SST_string_xlsx (xlsx_workbook * workbook, unsigned short string_index,
 	return FREEXL_XLSX_INVALID_SST;
     if (string_index < workbook->n_strings)
       {
-	  *string = *(workbook->strings + string_index);
+	  *string = get_xlsx_shared_string (workbook, string_index);
 	  return FREEXL_OK;
       }
     return FREEXL_XLSX_ILLEGAL_SST_INDEX;
@@ -5081,6 +5903,8 @@ freexl_get_SST_string (const void *xl_handle, unsigned short string_index,
     biff_workbook *workbook;
     if (!handle)
 	return FREEXL_NULL_HANDLE;
+    if (is_info_xml (handle))
+	return FREEXL_INVALID_HANDLE;
     if (handle->xlsx_handle != NULL)
 	return get_SST_string_xlsx (handle->xlsx_handle, string_index, string);
     workbook = handle->xls_handle;
@@ -5106,12 +5930,16 @@ freexl_get_SST_string (const void *xl_handle, unsigned short string_index,
 }
 
 static char *
-find_datetime_xlsx (xlsx_workbook * workbook)
+find_datetime_xml (xml_datetime ** first_date, xml_datetime ** last_date)
 {
-/* managing the DATETIME strings dynamic allocation - XLSX */
+/* 
+ * managing the DATETIME strings dynamic allocation - XLSX and ODS
+ *
+ * each string stays valid until the Workbook is destroyed
+ */
     xml_datetime *date;
     int r;
-    if (workbook->first_date == NULL)
+    if (*first_date == NULL)
       {
 	  /* inserting the first block into the list */
 	  date = malloc (sizeof (xml_datetime));
@@ -5119,11 +5947,11 @@ find_datetime_xlsx (xlsx_workbook * workbook)
 	      date->datetime[r][0] = '\0';
 	  date->next_str = 1;
 	  date->next = NULL;
-	  workbook->first_date = date;
-	  workbook->last_date = date;
+	  *first_date = date;
+	  *last_date = date;
 	  return date->datetime[0];
       }
-    if (workbook->last_date->next_str >= 128)
+    if ((*last_date)->next_str >= 128)
       {
 	  /* inserting a further block into the list */
 	  date = malloc (sizeof (xml_datetime));
@@ -5131,50 +5959,155 @@ find_datetime_xlsx (xlsx_workbook * workbook)
 	      date->datetime[r][0] = '\0';
 	  date->next_str = 1;
 	  date->next = NULL;
-	  workbook->last_date->next = date;
-	  workbook->last_date = date;
+	  (*last_date)->next = date;
+	  *last_date = date;
 	  return date->datetime[0];
       }
 /* continuing to consume the current block */
-    r = workbook->last_date->next_str;
-    workbook->last_date->next_str += 1;
-    return workbook->last_date->datetime[r];
+    r = (*last_date)->next_str;
+    (*last_date)->next_str += 1;
+    return (*last_date)->datetime[r];
 }
 
 static char *
-find_datetime_ods (ods_workbook * workbook)
+find_datetime_xlsx (xlsx_workbook * workbook)
 {
-/* managing the DATETIME strings dynamic allocation - ODS */
-    xml_datetime *date;
-    int r;
-    if (workbook->first_date == NULL)
+/* managing the DATETIME strings dynamic allocation - XLSX */
+    return find_datetime_xml (&(workbook->first_date),
+			      &(workbook->last_date));
+}
+
+static xlsx_cell *
+find_xlsx_cell (xlsx_row * row, unsigned short column)
+{
+/* searching a Cell within a Row */
+    int i;
+    if (row->sorted)
       {
-	  /* inserting the first block into the list */
-	  date = malloc (sizeof (xml_datetime));
-	  for (r = 0; r < MAX_DATETIME_STR; r++)
-	      date->datetime[r][0] = '\0';
-	  date->next_str = 1;
-	  date->next = NULL;
-	  workbook->first_date = date;
-	  workbook->last_date = date;
-	  return date->datetime[0];
+	  /* binary search */
+	  int lo = 0;
+	  int hi = row->n_cells - 1;
+	  while (lo <= hi)
+	    {
+		int mid = (lo + hi) / 2;
+		xlsx_cell *cell = row->cells + mid;
+		if (cell->col_no == (int) column)
+		    return cell->assigned ? cell : NULL;
+		if (cell->col_no < (int) column)
+		    lo = mid + 1;
+		else
+		    hi = mid - 1;
+	    }
+	  return NULL;
       }
-    if (workbook->last_date->next_str >= 128)
+    for (i = 0; i < row->n_cells; i++)
       {
-	  /* inserting a further block into the list */
-	  date = malloc (sizeof (xml_datetime));
-	  for (r = 0; r < MAX_DATETIME_STR; r++)
-	      date->datetime[r][0] = '\0';
-	  date->next_str = 1;
-	  date->next = NULL;
-	  workbook->last_date->next = date;
-	  workbook->last_date = date;
-	  return date->datetime[0];
+	  /* unordered Row: sequential scan */
+	  xlsx_cell *cell = row->cells + i;
+	  if (cell->col_no == (int) column && cell->assigned)
+	      return cell;
       }
-/* continuing to consume the current block */
-    r = workbook->last_date->next_str;
-    workbook->last_date->next_str += 1;
-    return workbook->last_date->datetime[r];
+    return NULL;
+}
+
+static void
+fill_xlsx_value (xlsx_workbook * workbook, xlsx_cell * p_col,
+		 FreeXL_CellValue * val, char *slot)
+{
+/* 
+ * returning the value of some XLSX Cell
+ *
+ * any date or time will be formatted into the given slot, if any
+ */
+    val->type = FREEXL_CELL_NULL;
+    if (p_col->is_datetime != XLSX_DATE_NONE)
+      {
+	  /* special case: DATE, TIME, DATETIME */
+	  char *datetime =
+	      (slot != NULL) ? slot : find_datetime_xlsx (workbook);
+	  double value;
+	  int count;
+	  int hh;
+	  int mm;
+	  int ss;
+	  int year = 1900;
+	  int month = 1;
+	  int day = 1;
+	  if (p_col->type == XLSX_INTEGER)
+	    {
+		value = 0.0;
+		count = p_col->int_value;
+	    }
+	  else if (p_col->type == XLSX_DOUBLE)
+	    {
+		count = (int) floor (p_col->dbl_value);
+		value = p_col->dbl_value - count;
+	    }
+	  else
+	    {
+		value = 0.0;
+		count = 0;
+	    }
+	  compute_time (&hh, &mm, &ss, value);
+	  compute_date (&year, &month, &day, count);
+	  if (p_col->is_datetime == XLSX_DATE_SIMPLE)
+	    {
+		sprintf (datetime, "%04d-%02d-%02d", year, month, day);
+		val->type = FREEXL_CELL_DATE;
+	    }
+	  else if (p_col->is_datetime == XLSX_TIME_SIMPLE)
+	    {
+		sprintf (datetime, "%02d:%02d:%02d", hh, mm, ss);
+		val->type = FREEXL_CELL_TIME;
+	    }
+	  else
+	    {
+		sprintf (datetime, "%04d-%02d-%02d %02d:%02d:%02d",
+			 year, month, day, hh, mm, ss);
+		val->type = FREEXL_CELL_DATETIME;
+	    }
+	  val->value.text_value = datetime;
+      }
+    else
+      {
+	  /* ordinary values */
+	  if (p_col->type == XLSX_INTEGER)
+	    {
+		val->type = FREEXL_CELL_INT;
+		val->value.int_value = p_col->int_value;
+	    }
+	  if (p_col->type == XLSX_DOUBLE)
+	    {
+		val->type = FREEXL_CELL_DOUBLE;
+		val->value.double_value = p_col->dbl_value;
+	    }
+	  if (p_col->type == XLSX_STR_INDEX)
+	    {
+		val->type = FREEXL_CELL_SST_TEXT;
+		val->value.text_value =
+		    get_xlsx_shared_string (workbook, p_col->str_index);
+	    }
+      }
+}
+
+static int
+lookup_xlsx_cell (xlsx_worksheet * sheet, unsigned int row,
+		  unsigned short column, xlsx_cell ** cell)
+{
+/* locating some Cell within a XLSX Worksheet (NULL if undefined) */
+    xlsx_row *p_row;
+
+    *cell = NULL;
+    if (sheet == NULL)
+	return FREEXL_XSLX_UNSELECTED_SHEET;
+    if ((int) row >= sheet->max_row || (int) column > sheet->max_cell)
+	return FREEXL_ILLEGAL_CELL_ROW_COL;
+    if (sheet->rows == NULL)
+	return FREEXL_OK;
+    p_row = *(sheet->rows + row);
+    if (p_row != NULL)
+	*cell = find_xlsx_cell (p_row, column);
+    return FREEXL_OK;
 }
 
 static int
@@ -5182,198 +6115,158 @@ get_cell_value_xlsx (xlsx_workbook * workbook, unsigned int row,
 		     unsigned short column, FreeXL_CellValue * val)
 {
 /* attempting to fetch a cell value */
-    xlsx_row *p_row;
     xlsx_cell *p_col;
+    int ret;
 
     if (!workbook)
 	return FREEXL_NULL_HANDLE;
-    if (workbook->active_sheet == NULL)
-	return FREEXL_XSLX_UNSELECTED_SHEET;
-    if ((int) row >= workbook->active_sheet->max_row
-	|| (int) column > workbook->active_sheet->max_cell)
-	return FREEXL_ILLEGAL_CELL_ROW_COL;
-
-    if (workbook->active_sheet->rows == NULL)
-	goto stop;
-    p_row = *(workbook->active_sheet->rows + row);
-    if (p_row == NULL)
-	goto stop;
-
-    p_col = p_row->first;
-    while (p_col != NULL)
+    ret = lookup_xlsx_cell (workbook->active_sheet, row, column, &p_col);
+    if (ret != FREEXL_OK)
+	return ret;
+    if (p_col == NULL)
       {
-	  /* looping on row columns */
-	  if ((unsigned int) (p_col->col_no) == column)
-	    {
-		if (p_col->assigned)
-		  {
-		      /* ok, found the requested Cell */
-		      val->type = FREEXL_CELL_NULL;
-		      if (p_col->is_datetime != XLSX_DATE_NONE)
-			{
-			    /* special case: DATE, TIME, DATETIME */
-			    char *datetime = find_datetime_xlsx (workbook);
-			    double value;
-			    int count;
-			    int hh;
-			    int mm;
-			    int ss;
-			    int year = 1900;
-			    int month = 1;
-			    int day = 1;
-			    if (p_col->type == XLSX_INTEGER)
-			      {
-				  value = 0.0;
-				  count = p_col->int_value;
-			      }
-			    else if (p_col->type == XLSX_DOUBLE)
-			      {
-				  count = (int) floor (p_col->dbl_value);
-				  value = p_col->dbl_value - count;
-			      }
-			    else
-			      {
-				  value = 0.0;
-				  count = 0;
-			      }
-			    compute_time (&hh, &mm, &ss, value);
-			    compute_date (&year, &month, &day, count);
-			    if (p_col->is_datetime == XLSX_DATE_SIMPLE)
-			      {
-				  sprintf (datetime,
-					   "%04d-%02d-%02d", year, month, day);
-				  val->type = FREEXL_CELL_DATE;
-			      }
-			    else if (p_col->is_datetime == XLSX_TIME_SIMPLE)
-			      {
-				  sprintf (datetime,
-					   "%02d:%02d:%02d", hh, mm, ss);
-				  val->type = FREEXL_CELL_TIME;
-			      }
-			    else
-			      {
-				  sprintf (datetime,
-					   "%04d-%02d-%02d %02d:%02d:%02d",
-					   year, month, day, hh, mm, ss);
-				  val->type = FREEXL_CELL_DATETIME;
-			      }
-			    //val->value.text_value = NULL;
-			    val->value.text_value = datetime;
-			}
-		      else
-			{
-			    /* ordinary values */
-			    if (p_col->type == XLSX_INTEGER)
-			      {
-				  val->type = FREEXL_CELL_INT;
-				  val->value.int_value = p_col->int_value;
-			      }
-			    if (p_col->type == XLSX_DOUBLE)
-			      {
-				  val->type = FREEXL_CELL_DOUBLE;
-				  val->value.double_value = p_col->dbl_value;
-			      }
-			    if (p_col->type == XLSX_STR_INDEX)
-			      {
-				  val->type = FREEXL_CELL_SST_TEXT;
-				  val->value.text_value =
-				      *(workbook->strings + p_col->str_index);
-			      }
-			}
-		      return FREEXL_OK;
-		  }
-	    }
-	  p_col = p_col->next;
+	  /* any undefined Cell is assumed to be NULL */
+	  val->type = FREEXL_CELL_NULL;
+	  return FREEXL_OK;
       }
 
-/* any undefined Cell is assumed to be NULL */
-  stop:
-    val->type = FREEXL_CELL_NULL;
+/* ok, found the requested Cell */
+    fill_xlsx_value (workbook, p_col, val, NULL);
     return FREEXL_OK;
 }
 
 static void
-adjust_ods_datetime (char *datetime)
+format_ods_time (char *datetime, double seconds)
 {
-/* adjusting an ODS Datatine value */
-    char *p = datetime;
-    if (datetime == NULL)
-	return;
-    while (*p != '\0')
-      {
-	  if (*p == 'T')
-	      *p = ' ';
-	  p++;
-      }
+/* formatting an ODS time as HH:MM:SS (rounded, just as Excel times) */
+    long secs = lround (seconds);
+    sprintf (datetime, "%02ld:%02ld:%02ld", secs / 3600, (secs / 60) % 60,
+	     secs % 60);
 }
 
-static int
-get_cell_value_ods (ods_workbook * workbook, unsigned int row,
-		    unsigned short column, FreeXL_CellValue * val)
+static char *
+cache_ods_datetime (ods_cell * p_col)
 {
-/* attempting to fetch a cell value */
-    ods_row *p_row;
-    ods_cell *p_col;
+/* 
+ * allocating the DATE/TIME text of some ODS Cell
+ *
+ * the text is formatted just once and then kept into the Cell itself
+ * (as an ordinary txt_value), so any further read will simply return
+ * the same string without allocating anything
+ */
+    p_col->txt_value = malloc (STR_DATETIME_LEN);
+    return p_col->txt_value;
+}
 
-    if (!workbook)
-	return FREEXL_NULL_HANDLE;
-    if (workbook->active_sheet == NULL)
-	return FREEXL_ODS_UNSELECTED_SHEET;
-    if ((int) row >= workbook->active_sheet->max_row
-	|| (int) column > workbook->active_sheet->max_cell)
-	return FREEXL_ILLEGAL_CELL_ROW_COL;
+static void
+fill_ods_value (ods_cell * p_col, FreeXL_CellValue * val, char *slot)
+{
+/* 
+ * returning the value of some ODS Cell
+ *
+ * any date or time will be formatted into the given slot, if any,
+ * or otherwise cached into the Cell itself
+ */
+    val->type = FREEXL_CELL_NULL;
+    if (p_col->type == ODS_INTEGER || p_col->type == ODS_BOOLEAN)
+      {
+	  val->type = FREEXL_CELL_INT;
+	  val->value.int_value = p_col->int_value;
+      }
+    if (p_col->type == ODS_FLOAT || p_col->type == ODS_CURRENCY
+	|| p_col->type == ODS_PERCENTAGE)
+      {
+	  val->type = FREEXL_CELL_DOUBLE;
+	  val->value.double_value = p_col->dbl_value;
+      }
+    if (p_col->type == ODS_STRING || p_col->txt_value != NULL)
+      {
+	  /* including any unusual date or time */
+	  val->type = FREEXL_CELL_TEXT;
+	  val->value.text_value = p_col->txt_value;
+      }
+    else if (p_col->type == ODS_DATE || p_col->type == ODS_DATETIME)
+      {
+	  char *datetime = (slot != NULL) ? slot : cache_ods_datetime (p_col);
+	  int ymd = p_col->int_value;
+	  if (datetime == NULL)
+	      return;		/* insufficient memory */
+	  sprintf (datetime, "%04d-%02d-%02d", ymd / 10000, (ymd / 100) % 100,
+		   ymd % 100);
+	  if (p_col->type == ODS_DATETIME)
+	    {
+		datetime[10] = ' ';
+		format_ods_time (datetime + 11, p_col->dbl_value);
+	    }
+	  val->value.text_value = datetime;
+	  val->type = FREEXL_CELL_TEXT;
+      }
+    else if (p_col->type == ODS_TIME)
+      {
+	  char *datetime = (slot != NULL) ? slot : cache_ods_datetime (p_col);
+	  if (datetime == NULL)
+	      return;		/* insufficient memory */
+	  format_ods_time (datetime, p_col->dbl_value);
+	  val->value.text_value = datetime;
+	  val->type = FREEXL_CELL_TEXT;
+      }
+}
 
-    if (workbook->active_sheet->rows == NULL)
-	goto stop;
-    p_row = *(workbook->active_sheet->rows + row);
+static int
+lookup_ods_cell (ods_worksheet * sheet, unsigned int row,
+		 unsigned short column, ods_cell ** cell)
+{
+/* locating some Cell within an ODS Worksheet (NULL if undefined) */
+    ods_row *p_row;
+    ods_cell *p_col;
+
+    *cell = NULL;
+    if (sheet == NULL)
+	return FREEXL_ODS_UNSELECTED_SHEET;
+    if ((int) row >= sheet->max_row || (int) column > sheet->max_cell)
+	return FREEXL_ILLEGAL_CELL_ROW_COL;
+    if (sheet->rows == NULL)
+	return FREEXL_OK;
+    p_row = *(sheet->rows + row);
     if (p_row == NULL)
-	goto stop;
+	return FREEXL_OK;
 
     p_col = p_row->first;
     while (p_col != NULL)
       {
 	  /* looping on row columns */
-	  if ((unsigned int) (p_col->col_no) == column)
+	  if ((unsigned int) (p_col->col_no) == column && p_col->assigned)
 	    {
-		if (p_col->assigned)
-		  {
-		      /* ok, found the requested Cell */
-		      val->type = FREEXL_CELL_NULL;
-		      if (p_col->type == ODS_INTEGER
-			  || p_col->type == ODS_BOOLEAN)
-			{
-			    val->type = FREEXL_CELL_INT;
-			    val->value.int_value = p_col->int_value;
-			}
-		      if (p_col->type == ODS_FLOAT
-			  || p_col->type == ODS_CURRENCY
-			  || p_col->type == ODS_PERCENTAGE)
-			{
-			    val->type = FREEXL_CELL_DOUBLE;
-			    val->value.double_value = p_col->dbl_value;
-			}
-		      if (p_col->type == ODS_STRING || p_col->type == ODS_TIME)
-			{
-			    val->type = FREEXL_CELL_TEXT;
-			    val->value.text_value = p_col->txt_value;
-			}
-		      if (p_col->type == ODS_DATE)
-			{
-			    char *datetime = find_datetime_ods (workbook);
-			    strcpy (datetime, p_col->txt_value);
-			    adjust_ods_datetime (datetime);
-			    val->value.text_value = datetime;
-			    val->type = FREEXL_CELL_TEXT;
-			}
-		      return FREEXL_OK;
-		  }
+		*cell = p_col;
+		break;
 	    }
 	  p_col = p_col->next;
       }
+    return FREEXL_OK;
+}
 
-/* any undefined Cell is assumed to be NULL */
-  stop:
-    val->type = FREEXL_CELL_NULL;
+static int
+get_cell_value_ods (ods_workbook * workbook, unsigned int row,
+		    unsigned short column, FreeXL_CellValue * val)
+{
+/* attempting to fetch a cell value */
+    ods_cell *p_col;
+    int ret;
+
+    if (!workbook)
+	return FREEXL_NULL_HANDLE;
+    ret = lookup_ods_cell (workbook->active_sheet, row, column, &p_col);
+    if (ret != FREEXL_OK)
+	return ret;
+    if (p_col == NULL)
+      {
+	  /* any undefined Cell is assumed to be NULL */
+	  val->type = FREEXL_CELL_NULL;
+	  return FREEXL_OK;
+      }
+
+/* ok, found the requested Cell */
+    fill_ods_value (p_col, val, NULL);
     return FREEXL_OK;
 }
 
@@ -5387,6 +6280,8 @@ freexl_get_cell_value (const void *xl_handle, unsigned int row,
     biff_workbook *workbook;
     if (!handle)
 	return FREEXL_NULL_HANDLE;
+    if (is_info_xml (handle))
+	return FREEXL_INVALID_HANDLE;
     if (handle->xlsx_handle != NULL)
 	return get_cell_value_xlsx (handle->xlsx_handle, row, column, val);
     if (handle->ods_handle != NULL)
@@ -5418,25 +6313,1122 @@ freexl_get_cell_value (const void *xl_handle, unsigned int row,
 / this function now return the Cell Value using the
 / FreeXL_CellValue multi-type container 
 */
-    val->type = p_cell->type;
-    switch (p_cell->type)
+    fill_biff_value (p_cell, val);
+
+    return FREEXL_OK;
+}
+
+static int
+reset_xlsx_row_texts (xlsx_workbook * workbook, unsigned short n_columns)
+{
+/* lazy SharedStrings: releasing the copies made for the previous row */
+    int i;
+    for (i = 0; i < workbook->RowTextsMax; i++)
       {
-      case FREEXL_CELL_INT:
-	  val->value.int_value = p_cell->value.int_value;
-	  break;
-      case FREEXL_CELL_DOUBLE:
-	  val->value.double_value = p_cell->value.dbl_value;
-	  break;
+	  if (workbook->RowTexts[i] != NULL)
+	      free (workbook->RowTexts[i]);
+	  workbook->RowTexts[i] = NULL;
+      }
+    if (n_columns > workbook->RowTextsMax)
+      {
+	  /* each Cell could require its own string copy */
+	  char **texts = realloc (workbook->RowTexts,
+				  sizeof (char *) * n_columns);
+	  if (texts == NULL)
+	      return 0;
+	  for (i = workbook->RowTextsMax; i < n_columns; i++)
+	      texts[i] = NULL;
+	  workbook->RowTexts = texts;
+	  workbook->RowTextsMax = n_columns;
+      }
+    return 1;
+}
+
+static void
+fill_xlsx_row_value (xlsx_workbook * workbook, xlsx_cell * p_col,
+		     FreeXL_CellValue * val, int i)
+{
+/* 
+ * returning the value of some XLSX Cell belonging to a whole row
+ *
+ * a lazy SharedString could be recycled while decoding the next
+ * cells of the same row, so a private copy is returned instead
+ */
+    fill_xlsx_value (workbook, p_col, val, NULL);
+#ifndef OMIT_XMLDOC		/* only if XML support is enabled */
+    if (workbook->lazy_strings == NULL || val->type != FREEXL_CELL_SST_TEXT)
+	return;
+    workbook->RowTexts[i] =
+	xlsx_copy_lazy_string (workbook, p_col->str_index);
+    val->value.text_value = workbook->RowTexts[i];
+#else
+    (void) i;
+#endif /* end conditional XML support */
+}
+
+static int
+get_row_values_xlsx (xlsx_workbook * workbook, unsigned int row,
+		     unsigned short first_column, unsigned short n_columns,
+		     FreeXL_CellValue * values)
+{
+/* attempting to fetch many cell values from the same row */
+    xlsx_row *p_row = NULL;
+    int last_column = first_column + n_columns - 1;
+    int i;
+
+    if (!workbook)
+	return FREEXL_NULL_HANDLE;
+    if (workbook->active_sheet == NULL)
+	return FREEXL_XSLX_UNSELECTED_SHEET;
+    if ((int) row >= workbook->active_sheet->max_row
+	|| last_column > workbook->active_sheet->max_cell)
+	return FREEXL_ILLEGAL_CELL_ROW_COL;
+    if (workbook->lazy_strings != NULL
+	&& !reset_xlsx_row_texts (workbook, n_columns))
+	return FREEXL_INSUFFICIENT_MEMORY;
+
+/* any undefined Cell is assumed to be NULL */
+    for (i = 0; i < n_columns; i++)
+	(values + i)->type = FREEXL_CELL_NULL;
+    if (workbook->active_sheet->rows != NULL)
+	p_row = *(workbook->active_sheet->rows + row);
+    if (p_row == NULL)
+	return FREEXL_OK;
+
+    if (p_row->sorted)
+      {
+	  /* locating the first Cell, then a single ordered pass */
+	  int lo = 0;
+	  int hi = p_row->n_cells;
+	  while (lo < hi)
+	    {
+		int mid = (lo + hi) / 2;
+		if ((p_row->cells + mid)->col_no < (int) first_column)
+		    lo = mid + 1;
+		else
+		    hi = mid;
+	    }
+	  for (i = lo; i < p_row->n_cells; i++)
+	    {
+		xlsx_cell *p_col = p_row->cells + i;
+		if (p_col->col_no > last_column)
+		    break;
+		if (p_col->assigned)
+		    fill_xlsx_row_value (workbook, p_col,
+					 values + (p_col->col_no -
+						   first_column),
+					 p_col->col_no - first_column);
+	    }
+      }
+    else
+      {
+	  /* unordered Row: searching each Cell in turn */
+	  for (i = 0; i < n_columns; i++)
+	    {
+		xlsx_cell *p_col = find_xlsx_cell (p_row, first_column + i);
+		if (p_col != NULL)
+		    fill_xlsx_row_value (workbook, p_col, values + i, i);
+	    }
+      }
+    return FREEXL_OK;
+}
+
+static int
+get_row_values_ods (ods_workbook * workbook, unsigned int row,
+		    unsigned short first_column, unsigned short n_columns,
+		    FreeXL_CellValue * values)
+{
+/* attempting to fetch many cell values from the same row */
+    ods_row *p_row = NULL;
+    ods_cell *p_col;
+    int last_column = first_column + n_columns - 1;
+    int i;
+
+    if (!workbook)
+	return FREEXL_NULL_HANDLE;
+    if (workbook->active_sheet == NULL)
+	return FREEXL_ODS_UNSELECTED_SHEET;
+    if ((int) row >= workbook->active_sheet->max_row
+	|| last_column > workbook->active_sheet->max_cell)
+	return FREEXL_ILLEGAL_CELL_ROW_COL;
+    if (n_columns > workbook->RowDatesMax)
+      {
+	  /* each Cell could require its own date/time string */
+	  char *dates = realloc (workbook->RowDates,
+				 (size_t) n_columns * STR_DATETIME_LEN);
+	  if (dates == NULL)
+	      return FREEXL_INSUFFICIENT_MEMORY;
+	  workbook->RowDates = dates;
+	  workbook->RowDatesMax = n_columns;
+      }
+
+/* any undefined Cell is assumed to be NULL */
+    for (i = 0; i < n_columns; i++)
+	(values + i)->type = FREEXL_CELL_NULL;
+    if (workbook->active_sheet->rows != NULL)
+	p_row = *(workbook->active_sheet->rows + row);
+    if (p_row == NULL)
+	return FREEXL_OK;
+
+    p_col = p_row->first;
+    while (p_col != NULL)
+      {
+	  /* Cells are always sorted by column */
+	  if (p_col->col_no > last_column)
+	      break;
+	  if (p_col->col_no >= (int) first_column && p_col->assigned)
+	    {
+		i = p_col->col_no - first_column;
+		fill_ods_value (p_col, values + i,
+				workbook->RowDates + (i * STR_DATETIME_LEN));
+	    }
+	  p_col = p_col->next;
+      }
+    return FREEXL_OK;
+}
+
+FREEXL_DECLARE int
+freexl_get_row_values (const void *xl_handle, unsigned int row,
+		       unsigned short first_column, unsigned short n_columns,
+		       FreeXL_CellValue * values)
+{
+/* attempting to fetch many cell values from the same row */
+    biff_cell_value *p_cell;
+    freexl_handle *handle = (freexl_handle *) xl_handle;
+    biff_workbook *workbook;
+    unsigned short i;
+    if (!handle)
+	return FREEXL_NULL_HANDLE;
+    if (n_columns == 0)
+	return FREEXL_OK;
+    if (!values)
+	return FREEXL_NULL_ARGUMENT;
+    if (is_info_xml (handle))
+	return FREEXL_INVALID_HANDLE;
+    if (handle->xlsx_handle != NULL)
+	return get_row_values_xlsx (handle->xlsx_handle, row, first_column,
+				    n_columns, values);
+    if (handle->ods_handle != NULL)
+	return get_row_values_ods (handle->ods_handle, row, first_column,
+				   n_columns, values);
+    workbook = handle->xls_handle;
+    if (!workbook)
+	return FREEXL_NULL_HANDLE;
+    if (workbook->magic1 == FREEXL_MAGIC_START
+	&& workbook->magic2 == FREEXL_MAGIC_END)
+	;
+    else
+	return FREEXL_INVALID_HANDLE;
+
+    if (workbook->active_sheet == NULL)
+	return FREEXL_XSLX_UNSELECTED_SHEET;
+    if (row >= workbook->active_sheet->rows
+	|| (unsigned int) first_column + n_columns >
+	workbook->active_sheet->columns)
+	return FREEXL_ILLEGAL_CELL_ROW_COL;
+    if (workbook->active_sheet->cell_values == NULL)
+	return FREEXL_ILLEGAL_CELL_ROW_COL;
+
+    p_cell =
+	workbook->active_sheet->cell_values +
+	(row * workbook->active_sheet->columns) + first_column;
+    for (i = 0; i < n_columns; i++)
+	fill_biff_value (p_cell + i, values + i);
+    return FREEXL_OK;
+}
+
+static void
+put_block_value (FreeXL_ColumnBlock * block, unsigned int i,
+		 FreeXL_CellValue * val)
+{
+/* storing a Cell value into a Column Block */
+    const char *text = NULL;
+    if (block->types != NULL)
+	*(block->types + i) = val->type;
+    if (block->int_values != NULL)
+	*(block->int_values + i) =
+	    (val->type == FREEXL_CELL_INT) ? val->value.int_value : 0;
+    if (block->double_values != NULL)
+	*(block->double_values + i) =
+	    (val->type == FREEXL_CELL_DOUBLE) ? val->value.double_value : 0.0;
+    if (block->validity != NULL && val->type != FREEXL_CELL_NULL)
+	*(block->validity + (i / 8)) |= (unsigned char) (1 << (i % 8));
+    switch (val->type)
+      {
+      case FREEXL_CELL_TEXT:
+      case FREEXL_CELL_SST_TEXT:
       case FREEXL_CELL_DATE:
       case FREEXL_CELL_DATETIME:
       case FREEXL_CELL_TIME:
-      case FREEXL_CELL_TEXT:
-	  val->value.text_value = p_cell->value.text_value;
-	  break;
-      case FREEXL_CELL_SST_TEXT:
-	  val->value.text_value = p_cell->value.sst_value;
+	  text = val->value.text_value;
 	  break;
       };
+    if (text != NULL)
+      {
+	  /* appending to the text buffer */
+	  unsigned int len = strlen (text);
+	  if (block->text != NULL
+	      && block->text_length + len <= block->text_size)
+	      memcpy (block->text + block->text_length, text, len);
+	  block->text_length += len;
+      }
+    if (block->offsets != NULL)
+	*(block->offsets + i + 1) = block->text_length;
+}
+
+static int
+get_column_block_xlsx (xlsx_workbook * workbook, unsigned short column,
+		       unsigned int first_row, unsigned int n_rows,
+		       FreeXL_ColumnBlock * block)
+{
+/* attempting to fetch many cell values from the same column */
+    FreeXL_CellValue val;
+    char datetime[STR_DATETIME_LEN];
+    unsigned int i;
+
+    if (!workbook)
+	return FREEXL_NULL_HANDLE;
+    if (workbook->active_sheet == NULL)
+	return FREEXL_XSLX_UNSELECTED_SHEET;
+    if (first_row >= (unsigned int) workbook->active_sheet->max_row
+	|| n_rows >
+	(unsigned int) workbook->active_sheet->max_row - first_row
+	|| (int) column > workbook->active_sheet->max_cell)
+	return FREEXL_ILLEGAL_CELL_ROW_COL;
+
+    for (i = 0; i < n_rows; i++)
+      {
+	  xlsx_row *p_row = NULL;
+	  xlsx_cell *p_col = NULL;
+	  if (workbook->active_sheet->rows != NULL)
+	      p_row = *(workbook->active_sheet->rows + first_row + i);
+	  if (p_row != NULL)
+	      p_col = find_xlsx_cell (p_row, column);
+	  if (p_col != NULL)
+	    {
+		/* the text is copied at once, a single slot is enough */
+		fill_xlsx_value (workbook, p_col, &val, datetime);
+	    }
+	  else
+	      val.type = FREEXL_CELL_NULL;
+	  put_block_value (block, i, &val);
+      }
+    return FREEXL_OK;
+}
+
+static int
+get_column_block_ods (ods_workbook * workbook, unsigned short column,
+		      unsigned int first_row, unsigned int n_rows,
+		      FreeXL_ColumnBlock * block)
+{
+/* attempting to fetch many cell values from the same column */
+    FreeXL_CellValue val;
+    char datetime[STR_DATETIME_LEN];
+    unsigned int i;
+
+    if (!workbook)
+	return FREEXL_NULL_HANDLE;
+    if (workbook->active_sheet == NULL)
+	return FREEXL_ODS_UNSELECTED_SHEET;
+    if (first_row >= (unsigned int) workbook->active_sheet->max_row
+	|| n_rows >
+	(unsigned int) workbook->active_sheet->max_row - first_row
+	|| (int) column > workbook->active_sheet->max_cell)
+	return FREEXL_ILLEGAL_CELL_ROW_COL;
+
+    for (i = 0; i < n_rows; i++)
+      {
+	  ods_row *p_row = NULL;
+	  ods_cell *p_col = NULL;
+	  val.type = FREEXL_CELL_NULL;
+	  if (workbook->active_sheet->rows != NULL)
+	      p_row = *(workbook->active_sheet->rows + first_row + i);
+	  if (p_row != NULL)
+	      p_col = p_row->first;
+	  while (p_col != NULL)
+	    {
+		/* Cells are always sorted by column */
+		if (p_col->col_no > (int) column)
+		    break;
+		if (p_col->col_no == (int) column && p_col->assigned)
+		  {
+		      /* the text is copied at once, a single slot is enough */
+		      fill_ods_value (p_col, &val, datetime);
+		      break;
+		  }
+		p_col = p_col->next;
+	    }
+	  put_block_value (block, i, &val);
+      }
+    return FREEXL_OK;
+}
+
+FREEXL_DECLARE int
+freexl_get_column_block (const void *xl_handle, unsigned short column,
+			 unsigned int first_row, unsigned int n_rows,
+			 FreeXL_ColumnBlock * block)
+{
+/* attempting to fetch many cell values from the same column */
+    biff_cell_value *p_cell;
+    freexl_handle *handle = (freexl_handle *) xl_handle;
+    biff_workbook *workbook;
+    FreeXL_CellValue val;
+    unsigned int i;
+    int ret;
+    if (!handle)
+	return FREEXL_NULL_HANDLE;
+    if (!block)
+	return FREEXL_NULL_ARGUMENT;
 
+    block->text_length = 0;
+    if (block->offsets != NULL)
+	*(block->offsets) = 0;
+    if (block->validity != NULL)
+	memset (block->validity, 0, (n_rows + 7) / 8);
+    if (n_rows == 0)
+	return FREEXL_OK;
+
+    if (is_info_xml (handle))
+	return FREEXL_INVALID_HANDLE;
+    if (handle->xlsx_handle != NULL)
+	ret = get_column_block_xlsx (handle->xlsx_handle, column, first_row,
+				     n_rows, block);
+    else if (handle->ods_handle != NULL)
+	ret = get_column_block_ods (handle->ods_handle, column, first_row,
+				    n_rows, block);
+    else
+      {
+	  workbook = handle->xls_handle;
+	  if (!workbook)
+	      return FREEXL_NULL_HANDLE;
+	  if (workbook->magic1 == FREEXL_MAGIC_START
+	      && workbook->magic2 == FREEXL_MAGIC_END)
+	      ;
+	  else
+	      return FREEXL_INVALID_HANDLE;
+
+	  if (workbook->active_sheet == NULL)
+	      return FREEXL_XSLX_UNSELECTED_SHEET;
+	  if (first_row >= workbook->active_sheet->rows
+	      || n_rows > workbook->active_sheet->rows - first_row
+	      || column >= workbook->active_sheet->columns)
+	      return FREEXL_ILLEGAL_CELL_ROW_COL;
+	  if (workbook->active_sheet->cell_values == NULL)
+	      return FREEXL_ILLEGAL_CELL_ROW_COL;
+
+	  /* walking down the Column, one Row at each step */
+	  p_cell =
+	      workbook->active_sheet->cell_values +
+	      (first_row * workbook->active_sheet->columns) + column;
+	  for (i = 0; i < n_rows; i++)
+	    {
+		fill_biff_value (p_cell, &val);
+		put_block_value (block, i, &val);
+		p_cell += workbook->active_sheet->columns;
+	    }
+	  ret = FREEXL_OK;
+      }
+    if (ret != FREEXL_OK)
+	return ret;
+    if (block->text != NULL && block->text_length > block->text_size)
+	return FREEXL_BUFFER_TOO_SMALL;
+    return FREEXL_OK;
+}
+
+
+static int
+init_cell_iterator (freexl_handle * handle, freexl_cell_iterator * it)
+{
+/* binding an iterator to the active Worksheet */
+    biff_workbook *workbook;
+    it->handle = handle;
+    it->xls_sheet = NULL;
+    it->xlsx_sheet = NULL;
+    it->ods_sheet = NULL;
+    it->row = 0;
+    it->col = 0;
+    it->last_col = -1;
+    it->ods_next = NULL;
+    it->row_started = 0;
+    if (is_info_xml (handle))
+	return FREEXL_INVALID_HANDLE;
+    if (handle->xlsx_handle != NULL)
+      {
+	  it->xlsx_sheet = handle->xlsx_handle->active_sheet;
+	  if (it->xlsx_sheet == NULL)
+	      return FREEXL_XSLX_UNSELECTED_SHEET;
+	  return FREEXL_OK;
+      }
+    if (handle->ods_handle != NULL)
+      {
+	  it->ods_sheet = handle->ods_handle->active_sheet;
+	  if (it->ods_sheet == NULL)
+	      return FREEXL_ODS_UNSELECTED_SHEET;
+	  return FREEXL_OK;
+      }
+
+    workbook = handle->xls_handle;
+    if (!workbook)
+	return FREEXL_NULL_HANDLE;
+    if (workbook->magic1 != FREEXL_MAGIC_START
+	|| workbook->magic2 != FREEXL_MAGIC_END)
+	return FREEXL_INVALID_HANDLE;
+    it->xls_sheet = workbook->active_sheet;
+    if (it->xls_sheet == NULL)
+	return FREEXL_XSLX_UNSELECTED_SHEET;
+    return FREEXL_OK;
+}
+
+FREEXL_DECLARE int
+freexl_create_cell_iterator (const void *xl_handle, const void **iterator)
+{
+/* creating an iterator over the non-NULL cells of the active Worksheet */
+    freexl_handle *handle = (freexl_handle *) xl_handle;
+    freexl_cell_iterator *it;
+    int ret;
+    if (!handle)
+	return FREEXL_NULL_HANDLE;
+    if (!iterator)
+	return FREEXL_NULL_ARGUMENT;
+    *iterator = NULL;
+
+    it = malloc (sizeof (freexl_cell_iterator));
+    if (it == NULL)
+	return FREEXL_INSUFFICIENT_MEMORY;
+    ret = init_cell_iterator (handle, it);
+    if (ret != FREEXL_OK)
+      {
+	  free (it);
+	  return ret;
+      }
+    *iterator = it;
+    return FREEXL_OK;
+}
+
+static int
+next_xls_cell (freexl_cell_iterator * it, unsigned short *column,
+	       FreeXL_CellValue * value)
+{
+/* advancing to the next non-NULL XLS cell */
+    biff_sheet *sheet = it->xls_sheet;
+    if (sheet->cell_values == NULL || sheet->row_spans == NULL)
+	return 0;
+    while (it->row < sheet->rows)
+      {
+	  /* only the used span of each row has to be visited */
+	  biff_row_span *span = sheet->row_spans + it->row;
+	  if (it->col < span->first)
+	      it->col = span->first;
+	  while (it->col < span->last)
+	    {
+		biff_cell_value *p_cell =
+		    sheet->cell_values + (it->row * sheet->columns) + it->col;
+		it->col++;
+		if (p_cell->type != FREEXL_CELL_NULL)
+		  {
+		      fill_biff_value (p_cell, value);
+		      *column = it->col - 1;
+		      return 1;
+		  }
+	    }
+	  it->row++;
+	  it->col = 0;
+      }
+    return 0;
+}
+
+static xlsx_cell *
+next_unsorted_xlsx_cell (xlsx_row * p_row, int last_col, int max_cell)
+{
+/* the leftmost cell following last_col within an unordered Row */
+    xlsx_cell *found = NULL;
+    int i;
+    for (i = 0; i < p_row->n_cells; i++)
+      {
+	  /* the first duplicate wins, just as in find_xlsx_cell() */
+	  xlsx_cell *cell = p_row->cells + i;
+	  if (!cell->assigned || cell->col_no <= last_col
+	      || cell->col_no > max_cell)
+	      continue;
+	  if (found == NULL || cell->col_no < found->col_no)
+	      found = cell;
+      }
+    return found;
+}
+
+static int
+next_xlsx_cell (freexl_cell_iterator * it, unsigned short *column,
+		FreeXL_CellValue * value)
+{
+/* advancing to the next non-NULL XLSX cell */
+    xlsx_worksheet *sheet = it->xlsx_sheet;
+    if (sheet->rows == NULL)
+	return 0;
+    while ((int) (it->row) < sheet->max_row)
+      {
+	  xlsx_row *p_row = *(sheet->rows + it->row);
+	  xlsx_cell *p_col;
+	  while (p_row != NULL)
+	    {
+		if (p_row->sorted)
+		  {
+		      if (it->col >= p_row->n_cells)
+			  break;
+		      p_col = p_row->cells + it->col;
+		      it->col++;
+		      if (!p_col->assigned || p_col->col_no > sheet->max_cell)
+			  continue;
+		  }
+		else
+		  {
+		      p_col =
+			  next_unsorted_xlsx_cell (p_row, it->last_col,
+						   sheet->max_cell);
+		      if (p_col == NULL)
+			  break;
+		      it->last_col = p_col->col_no;
+		  }
+		fill_xlsx_value (it->handle->xlsx_handle, p_col, value,
+				 it->datetime);
+		if (value->type != FREEXL_CELL_NULL)
+		  {
+		      *column = p_col->col_no;
+		      return 1;
+		  }
+	    }
+	  it->row++;
+	  it->col = 0;
+	  it->last_col = -1;
+      }
+    return 0;
+}
+
+static int
+next_ods_cell (freexl_cell_iterator * it, unsigned short *column,
+	       FreeXL_CellValue * value)
+{
+/* advancing to the next non-NULL ODS cell */
+    ods_worksheet *sheet = it->ods_sheet;
+    if (sheet->rows == NULL)
+	return 0;
+    while ((int) (it->row) < sheet->max_row)
+      {
+	  if (!it->row_started)
+	    {
+		ods_row *p_row = *(sheet->rows + it->row);
+		it->ods_next = (p_row == NULL) ? NULL : p_row->first;
+		it->row_started = 1;
+	    }
+	  while (it->ods_next != NULL)
+	    {
+		/* Cells are always sorted by column */
+		ods_cell *p_col = it->ods_next;
+		if (p_col->col_no > sheet->max_cell)
+		  {
+		      it->ods_next = NULL;
+		      break;
+		  }
+		it->ods_next = p_col->next;
+		if (!p_col->assigned)
+		    continue;
+		fill_ods_value (p_col, value, it->datetime);
+		if (value->type != FREEXL_CELL_NULL)
+		  {
+		      *column = p_col->col_no;
+		      return 1;
+		  }
+	    }
+	  it->row++;
+	  it->row_started = 0;
+      }
+    return 0;
+}
+
+FREEXL_DECLARE int
+freexl_next_cell (const void *iterator, unsigned int *row,
+		  unsigned short *column, FreeXL_CellValue * value)
+{
+/* returning the next non-NULL cell */
+    freexl_cell_iterator *it = (freexl_cell_iterator *) iterator;
+    int found;
+    if (!it)
+	return FREEXL_NULL_HANDLE;
+    if (!row || !column || !value)
+	return FREEXL_NULL_ARGUMENT;
+
+    if (it->xlsx_sheet != NULL)
+	found = next_xlsx_cell (it, column, value);
+    else if (it->ods_sheet != NULL)
+	found = next_ods_cell (it, column, value);
+    else
+	found = next_xls_cell (it, column, value);
+    if (!found)
+      {
+	  /* end of the Worksheet */
+	  value->type = FREEXL_CELL_NULL;
+	  return FREEXL_OK;
+      }
+    *row = it->row;
+    return FREEXL_OK;
+}
+
+FREEXL_DECLARE int
+freexl_destroy_cell_iterator (const void *iterator)
+{
+/* destroying a cell iterator */
+    if (!iterator)
+	return FREEXL_NULL_HANDLE;
+    free ((void *) iterator);
+    return FREEXL_OK;
+}
+
+static void
+add_column_stats (FreeXL_ColumnStats * stats, FreeXL_CellValue * value)
+{
+/* accounting for a further non-NULL cell of some column */
+    double num;
+    size_t len;
+    switch (value->type)
+      {
+      case FREEXL_CELL_INT:
+      case FREEXL_CELL_DOUBLE:
+	  if (value->type == FREEXL_CELL_INT)
+	    {
+		num = value->value.int_value;
+		stats->int_count++;
+	    }
+	  else
+	    {
+		num = value->value.double_value;
+		stats->double_count++;
+	    }
+	  if (stats->int_count + stats->double_count == 1)
+	    {
+		stats->min_value = num;
+		stats->max_value = num;
+	    }
+	  if (num < stats->min_value)
+	      stats->min_value = num;
+	  if (num > stats->max_value)
+	      stats->max_value = num;
+	  break;
+      case FREEXL_CELL_TEXT:
+      case FREEXL_CELL_SST_TEXT:
+	  stats->text_count++;
+	  len = (value->value.text_value == NULL) ? 0 :
+	      strlen (value->value.text_value);
+	  if (len > stats->max_text_length)
+	      stats->max_text_length = len;
+	  break;
+      case FREEXL_CELL_DATE:
+	  stats->date_count++;
+	  break;
+      case FREEXL_CELL_DATETIME:
+	  stats->datetime_count++;
+	  break;
+      case FREEXL_CELL_TIME:
+	  stats->time_count++;
+	  break;
+      };
+}
+
+static int
+suggest_column_type (FreeXL_ColumnStats * stats)
+{
+/* the narrowest cell type able to hold every value of some column */
+    unsigned int numbers = stats->int_count + stats->double_count;
+    unsigned int dates = stats->date_count + stats->datetime_count;
+    unsigned int total = numbers + dates + stats->time_count +
+	stats->text_count;
+    if (total == 0)
+	return FREEXL_CELL_NULL;
+    if (stats->int_count == total)
+	return FREEXL_CELL_INT;
+    if (numbers == total)
+	return FREEXL_CELL_DOUBLE;
+    if (stats->date_count == total)
+	return FREEXL_CELL_DATE;
+    if (dates == total)
+	return FREEXL_CELL_DATETIME;
+    if (stats->time_count == total)
+	return FREEXL_CELL_TIME;
+    return FREEXL_CELL_TEXT;
+}
+
+static FreeXL_ColumnStats **
+active_column_stats (freexl_handle * handle)
+{
+/* the column statistics cached by the active Worksheet */
+    if (handle->xlsx_handle != NULL)
+      {
+	  if (handle->xlsx_handle->active_sheet == NULL)
+	      return NULL;
+	  return &(handle->xlsx_handle->active_sheet->column_stats);
+      }
+    if (handle->ods_handle != NULL)
+      {
+	  if (handle->ods_handle->active_sheet == NULL)
+	      return NULL;
+	  return &(handle->ods_handle->active_sheet->column_stats);
+      }
+    if (handle->xls_handle == NULL
+	|| handle->xls_handle->active_sheet == NULL)
+	return NULL;
+    return &(handle->xls_handle->active_sheet->column_stats);
+}
+
+static int
+build_column_stats (freexl_handle * handle, unsigned int rows,
+		    unsigned short columns, FreeXL_ColumnStats ** cache)
+{
+/* gathering the statistics of all columns by a single sweep */
+    freexl_cell_iterator it;
+    FreeXL_CellValue value;
+    FreeXL_ColumnStats *stats;
+    unsigned int row;
+    unsigned short column;
+    unsigned short i;
+    int ret;
+
+    ret = init_cell_iterator (handle, &it);
+    if (ret != FREEXL_OK)
+	return ret;
+    stats = calloc (columns, sizeof (FreeXL_ColumnStats));
+    if (stats == NULL)
+	return FREEXL_INSUFFICIENT_MEMORY;
+    while (1)
+      {
+	  ret = freexl_next_cell (&it, &row, &column, &value);
+	  if (ret != FREEXL_OK)
+	    {
+		free (stats);
+		return ret;
+	    }
+	  if (value.type == FREEXL_CELL_NULL)
+	      break;
+	  if (column < columns)
+	      add_column_stats (stats + column, &value);
+      }
+    for (i = 0; i < columns; i++)
+      {
+	  FreeXL_ColumnStats *p = stats + i;
+	  p->null_count = rows - (p->int_count + p->double_count +
+				  p->text_count + p->date_count +
+				  p->datetime_count + p->time_count);
+	  p->suggested_type = suggest_column_type (p);
+      }
+    *cache = stats;
+    return FREEXL_OK;
+}
+
+FREEXL_DECLARE int
+freexl_get_column_stats (const void *xl_handle, unsigned short first_column,
+			 unsigned short n_columns, FreeXL_ColumnStats * stats)
+{
+/* gathering statistics about many columns of the active Worksheet */
+    freexl_handle *handle = (freexl_handle *) xl_handle;
+    FreeXL_ColumnStats **cache;
+    unsigned int rows;
+    unsigned short columns;
+    int ret;
+    if (!handle)
+	return FREEXL_NULL_HANDLE;
+    if (n_columns == 0)
+	return FREEXL_OK;
+    if (!stats)
+	return FREEXL_NULL_ARGUMENT;
+    ret = freexl_worksheet_dimensions (xl_handle, &rows, &columns);
+    if (ret != FREEXL_OK)
+	return ret;
+    if ((unsigned int) first_column + n_columns > columns)
+	return FREEXL_ILLEGAL_CELL_ROW_COL;
+    cache = active_column_stats (handle);
+    if (cache == NULL)
+	return FREEXL_INVALID_HANDLE;
+    if (*cache == NULL)
+      {
+	  /* the first request about this Worksheet */
+	  ret = build_column_stats (handle, rows, columns, cache);
+	  if (ret != FREEXL_OK)
+	      return ret;
+      }
+    memcpy (stats, *cache + first_column,
+	    sizeof (FreeXL_ColumnStats) * n_columns);
+    return FREEXL_OK;
+}
+
+static int
+check_cursor (const void *cursor)
+{
+/* validating a cursor */
+    freexl_cursor *cur = (freexl_cursor *) cursor;
+    if (cur == NULL)
+	return FREEXL_NULL_HANDLE;
+    if (cur->magic1 != FREEXL_MAGIC_CURSOR || cur->magic2 != FREEXL_MAGIC_END)
+	return FREEXL_INVALID_HANDLE;
+    return FREEXL_OK;
+}
+
+FREEXL_DECLARE int
+freexl_create_cursor (const void *xl_handle, const void **cursor)
+{
+/* creating a read-only cursor over a shared Workbook */
+    freexl_handle *handle = (freexl_handle *) xl_handle;
+    freexl_cursor *cur;
+    biff_workbook *workbook;
+    int i;
+    if (!handle)
+	return FREEXL_NULL_HANDLE;
+    if (!cursor)
+	return FREEXL_NULL_ARGUMENT;
+    *cursor = NULL;
+    if (is_info_xml (handle))
+	return FREEXL_INVALID_HANDLE;
+    workbook = handle->xls_handle;
+    if (handle->xlsx_handle == NULL && handle->ods_handle == NULL)
+      {
+	  /* cursors require a fully loaded XLS Workbook */
+	  if (!workbook)
+	      return FREEXL_NULL_HANDLE;
+	  if (workbook->magic1 != FREEXL_MAGIC_START
+	      || workbook->magic2 != FREEXL_MAGIC_END)
+	      return FREEXL_INVALID_HANDLE;
+      }
+
+    cur = malloc (sizeof (freexl_cursor));
+    if (cur == NULL)
+	return FREEXL_INSUFFICIENT_MEMORY;
+    cur->magic1 = FREEXL_MAGIC_CURSOR;
+    cur->magic2 = FREEXL_MAGIC_END;
+    cur->handle = handle;
+/* initially selecting the same Worksheet currently active on the handle */
+    cur->xls_sheet = (workbook != NULL) ? workbook->active_sheet : NULL;
+    cur->xlsx_sheet =
+	(handle->xlsx_handle !=
+	 NULL) ? handle->xlsx_handle->active_sheet : NULL;
+    cur->ods_sheet =
+	(handle->ods_handle != NULL) ? handle->ods_handle->active_sheet : NULL;
+    cur->next_slot = 0;
+    for (i = 0; i < MAX_DATETIME_STR; i++)
+      {
+	  cur->datetime[i][0] = '\0';
+	  cur->texts[i] = NULL;
+      }
+    *cursor = cur;
+    return FREEXL_OK;
+}
+
+FREEXL_DECLARE int
+freexl_cursor_select_worksheet (const void *cursor,
+				unsigned short worksheet_index)
+{
+/* selecting the Worksheet of some cursor [by index] */
+    freexl_cursor *cur = (freexl_cursor *) cursor;
+    int ret = check_cursor (cursor);
+    unsigned int count = 0;
+    if (ret != FREEXL_OK)
+	return ret;
+
+    if (cur->handle->xlsx_handle != NULL)
+      {
+	  /* XLSX */
+	  xlsx_worksheet *worksheet = cur->handle->xlsx_handle->first;
+	  while (worksheet)
+	    {
+		if (count == worksheet_index)
+		  {
+		      cur->xlsx_sheet = worksheet;
+		      return FREEXL_OK;
+		  }
+		count++;
+		worksheet = worksheet->next;
+	    }
+	  return FREEXL_XLSX_ILLEGAL_SHEET_INDEX;
+      }
+    if (cur->handle->ods_handle != NULL)
+      {
+	  /* ODS */
+	  ods_worksheet *worksheet = cur->handle->ods_handle->first;
+	  while (worksheet)
+	    {
+		if (count == worksheet_index)
+		  {
+		      cur->ods_sheet = worksheet;
+		      return FREEXL_OK;
+		  }
+		count++;
+		worksheet = worksheet->next;
+	    }
+	  return FREEXL_ODS_ILLEGAL_SHEET_INDEX;
+      }
+    if (cur->handle->xls_handle != NULL)
+      {
+	  /* XLS */
+	  biff_sheet *worksheet = cur->handle->xls_handle->first_sheet;
+	  while (worksheet)
+	    {
+		if (count == worksheet_index)
+		  {
+		      cur->xls_sheet = worksheet;
+		      return FREEXL_OK;
+		  }
+		count++;
+		worksheet = worksheet->next;
+	    }
+      }
+    return FREEXL_BIFF_ILLEGAL_SHEET_INDEX;
+}
+
+FREEXL_DECLARE int
+freexl_cursor_worksheet_dimensions (const void *cursor, unsigned int *rows,
+				    unsigned short *columns)
+{
+/* dimensions: the Worksheet selected by some cursor */
+    freexl_cursor *cur = (freexl_cursor *) cursor;
+    int ret = check_cursor (cursor);
+    if (ret != FREEXL_OK)
+	return ret;
+    if (!rows || !columns)
+	return FREEXL_NULL_ARGUMENT;
+
+    if (cur->handle->xlsx_handle != NULL)
+      {
+	  if (cur->xlsx_sheet == NULL)
+	      return FREEXL_XSLX_UNSELECTED_SHEET;
+	  *rows = cur->xlsx_sheet->max_row;
+	  *columns = cur->xlsx_sheet->max_cell + 1;
+	  return FREEXL_OK;
+      }
+    if (cur->handle->ods_handle != NULL)
+      {
+	  if (cur->ods_sheet == NULL)
+	      return FREEXL_ODS_UNSELECTED_SHEET;
+	  *rows = cur->ods_sheet->max_row;
+	  *columns = cur->ods_sheet->max_cell + 1;
+	  return FREEXL_OK;
+      }
+    if (cur->xls_sheet == NULL)
+	return FREEXL_BIFF_UNSELECTED_SHEET;
+    *rows = cur->xls_sheet->rows;
+    *columns = cur->xls_sheet->columns;
+    return FREEXL_OK;
+}
+
+static int
+cursor_cell_value_xlsx (freexl_cursor * cur, unsigned int row,
+			unsigned short column, FreeXL_CellValue * val,
+			unsigned int slot)
+{
+/* XLSX: fetching a cell value through a cursor */
+    xlsx_workbook *workbook = cur->handle->xlsx_handle;
+    xlsx_cell *p_col;
+    int ret;
+
+    ret = lookup_xlsx_cell (cur->xlsx_sheet, row, column, &p_col);
+    if (ret != FREEXL_OK)
+	return ret;
+    if (p_col == NULL)
+      {
+	  /* any undefined Cell is assumed to be NULL */
+	  val->type = FREEXL_CELL_NULL;
+	  return FREEXL_OK;
+      }
+#ifndef OMIT_XMLDOC		/* only if XML support is enabled */
+    if (workbook->lazy_strings != NULL
+	&& p_col->is_datetime == XLSX_DATE_NONE
+	&& p_col->type == XLSX_STR_INDEX)
+      {
+	  /* 
+	   * lazy SharedStrings: the cache is shared by all cursors,
+	   * so a private copy is required
+	   */
+	  if (cur->texts[slot] != NULL)
+	      free (cur->texts[slot]);
+	  cur->texts[slot] =
+	      xlsx_copy_lazy_string (workbook, p_col->str_index);
+	  val->type = FREEXL_CELL_SST_TEXT;
+	  val->value.text_value = cur->texts[slot];
+	  return FREEXL_OK;
+      }
+#endif /* end conditional XML support */
+    fill_xlsx_value (workbook, p_col, val, cur->datetime[slot]);
+    return FREEXL_OK;
+}
+
+static int
+cursor_cell_value_ods (freexl_cursor * cur, unsigned int row,
+		       unsigned short column, FreeXL_CellValue * val,
+		       unsigned int slot)
+{
+/* ODS: fetching a cell value through a cursor */
+    ods_cell *p_col;
+    int ret;
+
+    ret = lookup_ods_cell (cur->ods_sheet, row, column, &p_col);
+    if (ret != FREEXL_OK)
+	return ret;
+    if (p_col == NULL)
+      {
+	  /* any undefined Cell is assumed to be NULL */
+	  val->type = FREEXL_CELL_NULL;
+	  return FREEXL_OK;
+      }
+    fill_ods_value (p_col, val, cur->datetime[slot]);
+    return FREEXL_OK;
+}
+
+FREEXL_DECLARE int
+freexl_cursor_get_cell_value (const void *cursor, unsigned int row,
+			      unsigned short column, FreeXL_CellValue * val)
+{
+/* fetching a cell value from the Worksheet selected by some cursor */
+    freexl_cursor *cur = (freexl_cursor *) cursor;
+    int ret = check_cursor (cursor);
+    biff_sheet *sheet;
+    unsigned int slot;
+    if (ret != FREEXL_OK)
+	return ret;
+    if (!val)
+	return FREEXL_NULL_ARGUMENT;
+
+/* recycling the scratch slots in round-robin order */
+    slot = cur->next_slot;
+    cur->next_slot = (slot + 1) % MAX_DATETIME_STR;
+
+    if (cur->handle->xlsx_handle != NULL)
+	return cursor_cell_value_xlsx (cur, row, column, val, slot);
+    if (cur->handle->ods_handle != NULL)
+	return cursor_cell_value_ods (cur, row, column, val, slot);
+
+/* XLS: all cells are already decoded, nothing is ever modified */
+    sheet = cur->xls_sheet;
+    if (sheet == NULL)
+	return FREEXL_BIFF_UNSELECTED_SHEET;
+    if (row >= sheet->rows || column >= sheet->columns)
+	return FREEXL_ILLEGAL_CELL_ROW_COL;
+    if (sheet->cell_values == NULL)
+	return FREEXL_ILLEGAL_CELL_ROW_COL;
+    fill_biff_value (sheet->cell_values + (row * sheet->columns) + column,
+		     val);
+    return FREEXL_OK;
+}
+
+FREEXL_DECLARE int
+freexl_destroy_cursor (const void *cursor)
+{
+/* destroying a cursor */
+    freexl_cursor *cur = (freexl_cursor *) cursor;
+    int ret = check_cursor (cursor);
+    int i;
+    if (ret != FREEXL_OK)
+	return ret;
+    for (i = 0; i < MAX_DATETIME_STR; i++)
+      {
+	  if (cur->texts[i] != NULL)
+	      free (cur->texts[i]);
+      }
+    cur->magic1 = 0;
+    cur->magic2 = 0;
+    free (cur);
     return FREEXL_OK;
 }
@@ -0,0 +1,692 @@
+/* 
+/ freexl_arrow.c
+/
+/ FreeXL implementation (Apache Arrow C stream export)
+/
+/ ------------------------------------------------------------------------------
+/ 
+/ Version: MPL 1.1/GPL 2.0/LGPL 2.1
+/ 
+/ The contents of this file are subject to the Mozilla Public License Version
+/ 1.1 (the "License"); you may not use this file except in compliance with
+/ the License. You may obtain a copy of the License at
+/ http://www.mozilla.org/MPL/
+/ 
+/ Software distributed under the License is distributed on an "AS IS" basis,
+/ WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+/ for the specific language governing rights and limitations under the
+/ License.
+/
+/ The Original Code is the FreeXL library
+/
+/ The Initial Developer of the Original Code is Alessandro Furieri
+/ 
+/ Portions created by the Initial Developer are Copyright (C) 2021
+/ the Initial Developer. All Rights Reserved.
+/ 
+/ Contributor(s):
+/ 
+/ Alternatively, the contents of this file may be used under the terms of
+/ either the GNU General Public License Version 2 or later (the "GPL"), or
+/ the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+/ in which case the provisions of the GPL or the LGPL are applicable instead
+/ of those above. If you wish to allow use of your version of this file only
+/ under the terms of either the GPL or the LGPL, and not to allow others to
+/ use your version of this file under the terms of the MPL, indicate your
+/ decision by deleting the provisions above and replace them with the notice
+/ and other provisions required by the GPL or the LGPL. If you do not delete
+/ the provisions above, a recipient may use your version of this file under
+/ the terms of any one of the MPL, the GPL or the LGPL.
+/ 
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+
+#if defined(_WIN32) && !defined(__MINGW32__)
+#include "config-msvc.h"
+#else
+#include "config.h"
+#endif
+
+#include "freexl.h"
+
+#define ARROW_DEFAULT_BATCH	65536
+
+/* inferred column types */
+#define ARROW_KIND_INT32	1
+#define ARROW_KIND_FLOAT64	2
+#define ARROW_KIND_UTF8		3
+#define ARROW_KIND_DATE32	4
+#define ARROW_KIND_TIMESTAMP	5
+
+/* cell types found while inferring */
+#define ARROW_SEEN_INT		0x01
+#define ARROW_SEEN_DOUBLE	0x02
+#define ARROW_SEEN_TEXT		0x04
+#define ARROW_SEEN_DATE		0x08
+#define ARROW_SEEN_DATETIME	0x10
+#define ARROW_SEEN_TIME		0x20
+
+typedef struct arrow_stream_private
+{
+/* the state of an Arrow C stream */
+    const void *handle;		/* the FreeXL handle being exported */
+    unsigned int next_row;	/* first row of the next batch */
+    unsigned int end_row;	/* one past the last exported row */
+    unsigned int batch_rows;	/* max rows per batch */
+    unsigned short columns;	/* number of columns */
+    unsigned char *kinds;	/* inferred type of each column */
+    unsigned int *text_hints;	/* last text size seen for each column */
+    char error[256];		/* last error message */
+} arrow_stream_private;
+
+static const char *
+arrow_format (unsigned char kind)
+{
+/* Arrow format string of some column type */
+    switch (kind)
+      {
+      case ARROW_KIND_INT32:
+	  return "i";
+      case ARROW_KIND_FLOAT64:
+	  return "g";
+      case ARROW_KIND_DATE32:
+	  return "tdD";
+      case ARROW_KIND_TIMESTAMP:
+	  return "tss:";
+      };
+    return "u";
+}
+
+static unsigned char
+arrow_kind (int seen)
+{
+/* choosing the Arrow type fitting all the cell types found */
+    if (seen == ARROW_SEEN_INT)
+	return ARROW_KIND_INT32;
+    if (seen != 0 && (seen & ~(ARROW_SEEN_INT | ARROW_SEEN_DOUBLE)) == 0)
+	return ARROW_KIND_FLOAT64;
+    if (seen == ARROW_SEEN_DATE)
+	return ARROW_KIND_DATE32;
+    if (seen != 0 && (seen & ~(ARROW_SEEN_DATE | ARROW_SEEN_DATETIME)) == 0)
+	return ARROW_KIND_TIMESTAMP;
+    return ARROW_KIND_UTF8;
+}
+
+static int
+infer_arrow_kinds (arrow_stream_private * priv)
+{
+/* inferring the type of each column from the whole range of rows */
+    FreeXL_ColumnBlock block;
+    unsigned char *types;
+    unsigned short col;
+    unsigned int row;
+    unsigned int i;
+    int ret;
+
+    types = malloc (priv->batch_rows);
+    if (types == NULL)
+	return FREEXL_INSUFFICIENT_MEMORY;
+    memset (&block, 0, sizeof (FreeXL_ColumnBlock));
+    block.types = types;
+    for (col = 0; col < priv->columns; col++)
+      {
+	  int seen = 0;
+	  for (row = priv->next_row; row < priv->end_row;
+	       row += priv->batch_rows)
+	    {
+		unsigned int n = priv->end_row - row;
+		if (n > priv->batch_rows)
+		    n = priv->batch_rows;
+		ret = freexl_get_column_block (priv->handle, col, row, n,
+					       &block);
+		if (ret != FREEXL_OK)
+		  {
+		      free (types);
+		      return ret;
+		  }
+		for (i = 0; i < n; i++)
+		  {
+		      switch (types[i])
+			{
+			case FREEXL_CELL_INT:
+			    seen |= ARROW_SEEN_INT;
+			    break;
+			case FREEXL_CELL_DOUBLE:
+			    seen |= ARROW_SEEN_DOUBLE;
+			    break;
+			case FREEXL_CELL_TEXT:
+			case FREEXL_CELL_SST_TEXT:
+			    seen |= ARROW_SEEN_TEXT;
+			    break;
+			case FREEXL_CELL_DATE:
+			    seen |= ARROW_SEEN_DATE;
+			    break;
+			case FREEXL_CELL_DATETIME:
+			    seen |= ARROW_SEEN_DATETIME;
+			    break;
+			case FREEXL_CELL_TIME:
+			    seen |= ARROW_SEEN_TIME;
+			    break;
+			};
+		  }
+		if (seen & (ARROW_SEEN_TEXT | ARROW_SEEN_TIME))
+		    break;	/* it will be UTF8 anyway */
+	    }
+	  priv->kinds[col] = arrow_kind (seen);
+      }
+    free (types);
+    return FREEXL_OK;
+}
+
+static int64_t
+days_from_civil (int y, int m, int d)
+{
+/* number of days since 1970-01-01 of some Gregorian date */
+    int era;
+    int yoe;
+    int doy;
+    int doe;
+    y -= (m <= 2);
+    era = (y >= 0 ? y : y - 399) / 400;
+    yoe = y - era * 400;
+    doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return (int64_t) era *146097 + doe - 719468;
+}
+
+static int64_t
+parse_arrow_datetime (const char *text, unsigned int len, int want_seconds)
+{
+/* converting a 'YYYY-MM-DD [HH:MM:SS]' string */
+    char buf[32];
+    int y = 1970;
+    int m = 1;
+    int d = 1;
+    int hh = 0;
+    int mm = 0;
+    int ss = 0;
+    int64_t days;
+    if (len >= sizeof (buf))
+	len = sizeof (buf) - 1;
+    memcpy (buf, text, len);
+    buf[len] = '\0';
+    sscanf (buf, "%d-%d-%d %d:%d:%d", &y, &m, &d, &hh, &mm, &ss);
+    days = days_from_civil (y, m, d);
+    if (!want_seconds)
+	return days;
+    return (days * 86400) + (hh * 3600) + (mm * 60) + ss;
+}
+
+static void
+release_arrow_schema (struct ArrowSchema *schema)
+{
+/* Arrow release callback: schema */
+    int64_t i;
+    for (i = 0; i < schema->n_children; i++)
+      {
+	  struct ArrowSchema *child = schema->children[i];
+	  if (child == NULL)
+	      continue;
+	  if (child->release != NULL)
+	      child->release (child);
+	  free (child);
+      }
+    if (schema->children != NULL)
+	free (schema->children);
+    if (schema->private_data != NULL)
+	free (schema->private_data);	/* the column name */
+    schema->release = NULL;
+}
+
+static void
+release_arrow_array (struct ArrowArray *array)
+{
+/* Arrow release callback: array */
+    int64_t i;
+    for (i = 0; i < array->n_children; i++)
+      {
+	  struct ArrowArray *child = array->children[i];
+	  if (child == NULL)
+	      continue;
+	  if (child->release != NULL)
+	      child->release (child);
+	  free (child);
+      }
+    if (array->children != NULL)
+	free (array->children);
+    if (array->buffers != NULL)
+      {
+	  for (i = 0; i < array->n_buffers; i++)
+	    {
+		if (array->buffers[i] != NULL)
+		    free ((void *) (array->buffers[i]));
+	    }
+	  free (array->buffers);
+      }
+    array->release = NULL;
+}
+
+static int
+arrow_get_schema (struct ArrowArrayStream *stream, struct ArrowSchema *out)
+{
+/* Arrow stream callback: building the schema */
+    arrow_stream_private *priv = stream->private_data;
+    unsigned short col;
+
+    memset (out, 0, sizeof (struct ArrowSchema));
+    out->format = "+s";
+    out->release = release_arrow_schema;
+    if (priv->columns > 0)
+      {
+	  out->children = calloc (priv->columns, sizeof (struct ArrowSchema *));
+	  if (out->children == NULL)
+	      goto oom;
+      }
+    out->n_children = priv->columns;
+    for (col = 0; col < priv->columns; col++)
+      {
+	  struct ArrowSchema *child = calloc (1, sizeof (struct ArrowSchema));
+	  char *name;
+	  if (child == NULL)
+	      goto oom;
+	  out->children[col] = child;
+	  child->release = release_arrow_schema;
+	  name = malloc (16);
+	  if (name == NULL)
+	      goto oom;
+	  sprintf (name, "col_%03u", col);
+	  child->name = name;
+	  child->private_data = name;
+	  child->format = arrow_format (priv->kinds[col]);
+	  child->flags = ARROW_FLAG_NULLABLE;
+      }
+    return 0;
+
+  oom:
+    out->release (out);
+    strcpy (priv->error, "insufficient memory");
+    return ENOMEM;
+}
+
+static int
+fetch_arrow_block (arrow_stream_private * priv, unsigned short col,
+		   unsigned int row, unsigned int n, FreeXL_ColumnBlock * block)
+{
+/* fetching a Column Block, growing the text buffer if required */
+    unsigned int size = priv->text_hints[col];
+    int ret;
+    block->text = malloc (size + 1);
+    if (block->text == NULL)
+	return FREEXL_INSUFFICIENT_MEMORY;
+    block->text_size = size;
+    ret = freexl_get_column_block (priv->handle, col, row, n, block);
+    if (ret == FREEXL_BUFFER_TOO_SMALL)
+      {
+	  /* second attempt, now the exact size is known */
+	  size = block->text_length;
+	  free (block->text);
+	  block->text = malloc (size + 1);
+	  if (block->text == NULL)
+	      return FREEXL_INSUFFICIENT_MEMORY;
+	  block->text_size = size;
+	  ret = freexl_get_column_block (priv->handle, col, row, n, block);
+      }
+    if (ret == FREEXL_OK)
+	priv->text_hints[col] = block->text_length;
+    return ret;
+}
+
+static int
+numbers_to_utf8 (FreeXL_ColumnBlock * block, unsigned int n)
+{
+/* rewriting a text block so to include any numeric cell as text */
+    unsigned int *offsets;
+    char *text;
+    char number[64];
+    unsigned int numbers = 0;
+    unsigned int len = 0;
+    unsigned int i;
+
+    for (i = 0; i < n; i++)
+      {
+	  if (block->types[i] == FREEXL_CELL_INT
+	      || block->types[i] == FREEXL_CELL_DOUBLE)
+	      numbers++;
+      }
+    if (numbers == 0)
+	return FREEXL_OK;
+    offsets = malloc (sizeof (unsigned int) * (n + 1));
+    text = malloc (block->text_length + (numbers * sizeof (number)) + 1);
+    if (offsets == NULL || text == NULL)
+      {
+	  if (offsets != NULL)
+	      free (offsets);
+	  if (text != NULL)
+	      free (text);
+	  return FREEXL_INSUFFICIENT_MEMORY;
+      }
+    offsets[0] = 0;
+    for (i = 0; i < n; i++)
+      {
+	  const char *p = block->text + block->offsets[i];
+	  unsigned int l = block->offsets[i + 1] - block->offsets[i];
+	  if (block->types[i] == FREEXL_CELL_INT)
+	    {
+		sprintf (number, "%d", block->int_values[i]);
+		p = number;
+		l = strlen (number);
+	    }
+	  else if (block->types[i] == FREEXL_CELL_DOUBLE)
+	    {
+		sprintf (number, "%1.15g", block->double_values[i]);
+		p = number;
+		l = strlen (number);
+	    }
+	  memcpy (text + len, p, l);
+	  len += l;
+	  offsets[i + 1] = len;
+      }
+    free (block->offsets);
+    free (block->text);
+    block->offsets = offsets;
+    block->text = text;
+    block->text_length = len;
+    return FREEXL_OK;
+}
+
+static int
+build_arrow_column (arrow_stream_private * priv, unsigned short col,
+		    unsigned int row, unsigned int n, struct ArrowArray *out)
+{
+/* building a single column of some record batch */
+    FreeXL_ColumnBlock block;
+    unsigned char kind = priv->kinds[col];
+    unsigned int i;
+    int ret = FREEXL_INSUFFICIENT_MEMORY;
+
+    memset (&block, 0, sizeof (FreeXL_ColumnBlock));
+    out->length = n;
+    out->n_buffers = (kind == ARROW_KIND_UTF8) ? 3 : 2;
+    out->buffers = calloc (out->n_buffers, sizeof (void *));
+    out->release = release_arrow_array;
+    if (out->buffers == NULL)
+	return ret;
+
+    block.types = malloc (n);
+    block.validity = malloc ((n + 7) / 8);
+    if (block.types == NULL || block.validity == NULL)
+	goto stop;
+    out->buffers[0] = block.validity;
+    if (kind == ARROW_KIND_INT32 || kind == ARROW_KIND_FLOAT64
+	|| kind == ARROW_KIND_UTF8)
+      {
+	  block.int_values = malloc (sizeof (int) * n);
+	  if (block.int_values == NULL)
+	      goto stop;
+      }
+    if (kind == ARROW_KIND_FLOAT64 || kind == ARROW_KIND_UTF8)
+      {
+	  block.double_values = malloc (sizeof (double) * n);
+	  if (block.double_values == NULL)
+	      goto stop;
+      }
+    if (kind != ARROW_KIND_INT32 && kind != ARROW_KIND_FLOAT64)
+      {
+	  block.offsets = malloc (sizeof (unsigned int) * (n + 1));
+	  if (block.offsets == NULL)
+	      goto stop;
+	  ret = fetch_arrow_block (priv, col, row, n, &block);
+      }
+    else
+	ret = freexl_get_column_block (priv->handle, col, row, n, &block);
+    if (ret != FREEXL_OK)
+	goto stop;
+
+    for (i = 0; i < n; i++)
+      {
+	  if (block.types[i] == FREEXL_CELL_NULL)
+	      out->null_count++;
+      }
+    switch (kind)
+      {
+      case ARROW_KIND_INT32:
+	  /* the block values are already laid out as Arrow expects */
+	  out->buffers[1] = block.int_values;
+	  block.int_values = NULL;
+	  break;
+      case ARROW_KIND_FLOAT64:
+	  for (i = 0; i < n; i++)
+	    {
+		if (block.types[i] == FREEXL_CELL_INT)
+		    block.double_values[i] = block.int_values[i];
+	    }
+	  out->buffers[1] = block.double_values;
+	  block.double_values = NULL;
+	  break;
+      case ARROW_KIND_DATE32:
+	  {
+	      int32_t *days = malloc (sizeof (int32_t) * n);
+	      if (days == NULL)
+		{
+		    ret = FREEXL_INSUFFICIENT_MEMORY;
+		    goto stop;
+		}
+	      for (i = 0; i < n; i++)
+		{
+		    days[i] = 0;
+		    if (block.types[i] != FREEXL_CELL_NULL)
+			days[i] = (int32_t)
+			    parse_arrow_datetime (block.text +
+						  block.offsets[i],
+						  block.offsets[i + 1] -
+						  block.offsets[i], 0);
+		}
+	      out->buffers[1] = days;
+	  }
+	  break;
+      case ARROW_KIND_TIMESTAMP:
+	  {
+	      int64_t *seconds = malloc (sizeof (int64_t) * n);
+	      if (seconds == NULL)
+		{
+		    ret = FREEXL_INSUFFICIENT_MEMORY;
+		    goto stop;
+		}
+	      for (i = 0; i < n; i++)
+		{
+		    seconds[i] = 0;
+		    if (block.types[i] != FREEXL_CELL_NULL)
+			seconds[i] =
+			    parse_arrow_datetime (block.text +
+						  block.offsets[i],
+						  block.offsets[i + 1] -
+						  block.offsets[i], 1);
+		}
+	      out->buffers[1] = seconds;
+	  }
+	  break;
+      default:
+	  ret = numbers_to_utf8 (&block, n);
+	  if (ret != FREEXL_OK)
+	      goto stop;
+	  if (block.text_length > INT32_MAX)
+	    {
+		/* plain utf8 arrays are limited to 2GB */
+		ret = FREEXL_BUFFER_TOO_SMALL;
+		goto stop;
+	    }
+	  out->buffers[1] = block.offsets;
+	  out->buffers[2] = block.text;
+	  block.offsets = NULL;
+	  block.text = NULL;
+	  break;
+      };
+    ret = FREEXL_OK;
+
+  stop:
+    free (block.types);
+    if (ret != FREEXL_OK && out->buffers[0] == NULL && block.validity != NULL)
+	free (block.validity);
+    if (block.int_values != NULL)
+	free (block.int_values);
+    if (block.double_values != NULL)
+	free (block.double_values);
+    if (block.offsets != NULL)
+	free (block.offsets);
+    if (block.text != NULL)
+	free (block.text);
+    return ret;
+}
+
+static int
+arrow_get_next (struct ArrowArrayStream *stream, struct ArrowArray *out)
+{
+/* Arrow stream callback: building the next record batch */
+    arrow_stream_private *priv = stream->private_data;
+    unsigned short col;
+    unsigned int n;
+    int ret;
+
+    memset (out, 0, sizeof (struct ArrowArray));
+    if (priv->next_row >= priv->end_row)
+	return 0;		/* end of stream: out->release stays NULL */
+
+    n = priv->end_row - priv->next_row;
+    if (n > priv->batch_rows)
+	n = priv->batch_rows;
+    out->length = n;
+    out->n_buffers = 1;
+    out->release = release_arrow_array;
+    out->buffers = calloc (1, sizeof (void *));
+    if (out->buffers == NULL)
+	goto oom;
+    if (priv->columns > 0)
+      {
+	  out->children = calloc (priv->columns, sizeof (struct ArrowArray *));
+	  if (out->children == NULL)
+	      goto oom;
+      }
+    out->n_children = priv->columns;
+    for (col = 0; col < priv->columns; col++)
+      {
+	  struct ArrowArray *child = calloc (1, sizeof (struct ArrowArray));
+	  if (child == NULL)
+	      goto oom;
+	  out->children[col] = child;
+	  ret = build_arrow_column (priv, col, priv->next_row, n, child);
+	  if (ret == FREEXL_INSUFFICIENT_MEMORY)
+	      goto oom;
+	  if (ret != FREEXL_OK)
+	    {
+		sprintf (priv->error,
+			 "unable to read column %u (rows %u-%u): error %d",
+			 col, priv->next_row, priv->next_row + n - 1, ret);
+		out->release (out);
+		return EIO;
+	    }
+      }
+    priv->next_row += n;
+    return 0;
+
+  oom:
+    out->release (out);
+    strcpy (priv->error, "insufficient memory");
+    return ENOMEM;
+}
+
+static const char *
+arrow_get_last_error (struct ArrowArrayStream *stream)
+{
+/* Arrow stream callback: last error message */
+    arrow_stream_private *priv = stream->private_data;
+    if (priv == NULL || *(priv->error) == '\0')
+	return NULL;
+    return priv->error;
+}
+
+static void
+arrow_release_stream (struct ArrowArrayStream *stream)
+{
+/* Arrow stream callback: releasing the stream */
+    arrow_stream_private *priv = stream->private_data;
+    if (priv != NULL)
+      {
+	  if (priv->kinds != NULL)
+	      free (priv->kinds);
+	  if (priv->text_hints != NULL)
+	      free (priv->text_hints);
+	  free (priv);
+      }
+    stream->private_data = NULL;
+    stream->release = NULL;
+}
+
+FREEXL_DECLARE int
+freexl_export_arrow_stream (const void *xl_handle, unsigned int first_row,
+			    unsigned int n_rows, unsigned int batch_rows,
+			    struct ArrowArrayStream *stream)
+{
+/* exporting the active Worksheet as an Arrow C stream */
+    arrow_stream_private *priv;
+    unsigned int rows;
+    unsigned short columns;
+    unsigned short col;
+    int ret;
+
+    if (!xl_handle)
+	return FREEXL_NULL_HANDLE;
+    if (!stream)
+	return FREEXL_NULL_ARGUMENT;
+    ret = freexl_worksheet_dimensions (xl_handle, &rows, &columns);
+    if (ret != FREEXL_OK)
+	return ret;
+    if (first_row > rows)
+	return FREEXL_ILLEGAL_CELL_ROW_COL;
+    if (n_rows == 0)
+	n_rows = rows - first_row;
+    if (n_rows > rows - first_row)
+	return FREEXL_ILLEGAL_CELL_ROW_COL;
+    if (batch_rows == 0)
+	batch_rows = ARROW_DEFAULT_BATCH;
+
+    priv = calloc (1, sizeof (arrow_stream_private));
+    if (priv == NULL)
+	return FREEXL_INSUFFICIENT_MEMORY;
+    priv->handle = xl_handle;
+    priv->next_row = first_row;
+    priv->end_row = first_row + n_rows;
+    priv->batch_rows = batch_rows;
+    priv->columns = columns;
+    priv->kinds = malloc (columns + 1);
+    priv->text_hints = malloc (sizeof (unsigned int) * (columns + 1));
+    if (priv->kinds == NULL || priv->text_hints == NULL)
+      {
+	  ret = FREEXL_INSUFFICIENT_MEMORY;
+	  goto error;
+      }
+    for (col = 0; col < columns; col++)
+	priv->text_hints[col] = 1024;
+    ret = infer_arrow_kinds (priv);
+    if (ret != FREEXL_OK)
+	goto error;
+
+    stream->get_schema = arrow_get_schema;
+    stream->get_next = arrow_get_next;
+    stream->get_last_error = arrow_get_last_error;
+    stream->release = arrow_release_stream;
+    stream->private_data = priv;
+    return FREEXL_OK;
+
+  error:
+    if (priv->kinds != NULL)
+	free (priv->kinds);
+    if (priv->text_hints != NULL)
+	free (priv->text_hints);
+    free (priv);
+    return ret;
+}
@@ -94,6 +94,8 @@ xmlCharData (void *data, const XML_Char * s, int len)
 {
 /* parsing XML char data */
     ods_workbook *workbook = (ods_workbook *) data;
+    if (workbook->SkipDepth > 0)
+	return;
     if ((workbook->CharDataLen + len) > workbook->CharDataMax)
       {
 	  /* we must increase the CharData buffer size */
@@ -126,12 +128,21 @@ alloc_workbook ()
     wb->last_date = NULL;
     wb->error = 0;
     wb->ContentZipEntry = NULL;
+    wb->ZipIndex = NULL;
+    wb->xml_pipeline = 0;
     wb->CharDataStep = 65536;
     wb->CharDataMax = wb->CharDataStep;
     wb->CharData = malloc (wb->CharDataStep);
     wb->CharDataLen = 0;
     wb->ContentOk = 0;
     wb->NextWorksheetId = 0;
+    wb->SheetNames = NULL;
+    wb->projection = NULL;
+    wb->info = 0;
+    wb->SkipDepth = 0;
+    wb->threads = 0;
+    wb->RowDates = NULL;
+    wb->RowDatesMax = 0;
     return wb;
 }
 
@@ -176,6 +187,8 @@ destroy_worksheet (ods_worksheet * ws)
 	free (ws->name);
     if (ws->rows != NULL)
 	free (ws->rows);
+    if (ws->column_stats != NULL)
+	free (ws->column_stats);
     free (ws);
 }
 
@@ -206,11 +219,150 @@ destroy_workbook (ods_workbook * wb)
       }
     if (wb->ContentZipEntry != NULL)
 	free (wb->ContentZipEntry);
+    if (wb->ZipIndex != NULL)
+	zip_destroy_index (wb->ZipIndex);
     if (wb->CharData != NULL)
 	free (wb->CharData);
+    if (wb->RowDates != NULL)
+	free (wb->RowDates);
+    freexl_destroy_projection (wb->projection);
     free (wb);
 }
 
+static const char *
+parse_ods_digits (const char *p, int min_digits, int max_digits, int *value)
+{
+/* parsing a sequence of decimal digits */
+    int n = 0;
+    *value = 0;
+    while (*p >= '0' && *p <= '9' && n < max_digits)
+      {
+	  *value = (*value * 10) + (*p - '0');
+	  p++;
+	  n++;
+      }
+    if (n < min_digits)
+	return NULL;
+    return p;
+}
+
+static const char *
+parse_ods_seconds (const char *p, double *seconds)
+{
+/* parsing seconds, possibly followed by some decimal fraction */
+    int secs;
+    double scale = 0.1;
+    p = parse_ods_digits (p, 1, 9, &secs);
+    if (p == NULL)
+	return NULL;
+    *seconds = secs;
+    if (*p == '.')
+      {
+	  p++;
+	  while (*p >= '0' && *p <= '9')
+	    {
+		*seconds += (*p - '0') * scale;
+		scale /= 10.0;
+		p++;
+	    }
+      }
+    return p;
+}
+
+static int
+parse_ods_date (const char *value, int *ymd, double *seconds)
+{
+/* 
+ * parsing an ODS date-value: "YYYY-MM-DD" or "YYYY-MM-DDTHH:MM:SS[.f]"
+ *
+ * returns ODS_DATE or ODS_DATETIME; 0 if not a plain date
+ */
+    int year;
+    int month;
+    int day;
+    int hh;
+    int mm;
+    const char *p = parse_ods_digits (value, 4, 4, &year);
+    if (p == NULL || *p != '-')
+	return 0;
+    p = parse_ods_digits (p + 1, 2, 2, &month);
+    if (p == NULL || *p != '-' || month < 1 || month > 12)
+	return 0;
+    p = parse_ods_digits (p + 1, 2, 2, &day);
+    if (p == NULL || day < 1 || day > 31)
+	return 0;
+    *ymd = (year * 10000) + (month * 100) + day;
+    *seconds = 0.0;
+    if (*p == '\0')
+	return ODS_DATE;
+    if (*p != 'T')
+	return 0;
+    p = parse_ods_digits (p + 1, 2, 2, &hh);
+    if (p == NULL || *p != ':' || hh > 23)
+	return 0;
+    p = parse_ods_digits (p + 1, 2, 2, &mm);
+    if (p == NULL || *p != ':' || mm > 59)
+	return 0;
+    p = parse_ods_seconds (p + 1, seconds);
+    if (p == NULL || *p != '\0' || *seconds >= 60.0)
+	return 0;
+    *seconds += (hh * 3600.0) + (mm * 60.0);
+    if (*seconds >= 86399.5)
+	return 0;		/* would be rounded up to the next day */
+    return ODS_DATETIME;
+}
+
+static int
+parse_ods_time (const char *value, double *seconds)
+{
+/* 
+ * parsing an ODS time-value, i.e. an ISO 8601 duration
+ * such as "PT12H30M00S" or "P1DT02H00M00.5S"
+ *
+ * returns 0 if not a plain (positive) duration, or if too long
+ */
+    int n;
+    double secs;
+    const char *p = value;
+    if (*p != 'P')
+	return 0;
+    p++;
+    *seconds = 0.0;
+    if (*p != 'T')
+      {
+	  p = parse_ods_digits (p, 1, 6, &n);
+	  if (p == NULL || *p != 'D')
+	      return 0;
+	  *seconds += n * 86400.0;
+	  p++;
+	  if (*p == '\0')
+	      return *seconds < ODS_MAX_TIME_SECONDS;
+	  if (*p != 'T')
+	      return 0;
+      }
+    p++;
+    if (*p == '\0')
+	return 0;
+    while (*p != '\0')
+      {
+	  const char *q = parse_ods_seconds (p, &secs);
+	  if (q == NULL)
+	      return 0;
+	  if (*q == 'H' && secs == (int) secs)
+	      *seconds += secs * 3600.0;
+	  else if (*q == 'M' && secs == (int) secs)
+	      *seconds += secs * 60.0;
+	  else if (*q == 'S')
+	      *seconds += secs;
+	  else
+	      return 0;
+	  p = q + 1;
+      }
+    if (*seconds >= ODS_MAX_TIME_SECONDS)
+	return 0;		/* will be kept just as it is */
+    return 1;
+}
+
 static void
 do_add_cell (ods_worksheet * worksheet, int type, const char *value)
 {
@@ -243,7 +395,34 @@ do_add_cell (ods_worksheet * worksheet, int type, const char *value)
 	  switch (cell->type)
 	    {
 	    case ODS_DATE:
+		/* normalizing once for all */
+		cell->type =
+		    parse_ods_date (value, &(cell->int_value),
+				    &(cell->dbl_value));
+		if (cell->type != 0)
+		  {
+		      cell->assigned = 1;
+		      break;
+		  }
+		/* unusual date-value: will be kept just as it is */
+		cell->type = ODS_DATE;
+		len = strlen (value);
+		cell->txt_value = malloc (len + 1);
+		strcpy (cell->txt_value, value);
+		cell->assigned = 1;
+		break;
 	    case ODS_TIME:
+		if (parse_ods_time (value, &(cell->dbl_value)))
+		  {
+		      cell->assigned = 1;
+		      break;
+		  }
+		/* unusual time-value: will be kept just as it is */
+		len = strlen (value);
+		cell->txt_value = malloc (len + 1);
+		strcpy (cell->txt_value, value);
+		cell->assigned = 1;
+		break;
 	    case ODS_STRING:
 		len = strlen (value);
 		cell->txt_value = malloc (len + 1);
@@ -251,20 +430,23 @@ do_add_cell (ods_worksheet * worksheet, int type, const char *value)
 		cell->assigned = 1;
 		break;
 	    case ODS_FLOAT:
-		int_val = atoi (value);
-		dbl_val = atof (value);
-		if (int_val == dbl_val)
+		if (parse_xml_number (value, &int_val, &dbl_val) ==
+		    XML_NUMBER_INTEGER)
 		  {
 		      cell->type = ODS_INTEGER;
 		      cell->int_value = int_val;
 		  }
 		else
-		    cell->dbl_value = atof (value);
+		    cell->dbl_value = dbl_val;
 		cell->assigned = 1;
 		break;
 	    case ODS_CURRENCY:
 	    case ODS_PERCENTAGE:
-		cell->dbl_value = atof (value);
+		if (parse_xml_number (value, &int_val, &dbl_val) ==
+		    XML_NUMBER_INTEGER)
+		    cell->dbl_value = int_val;
+		else
+		    cell->dbl_value = dbl_val;
 		cell->assigned = 1;
 		break;
 	    case ODS_BOOLEAN:
@@ -310,6 +492,75 @@ do_add_row (ods_worksheet * worksheet)
 	worksheet->max_row = row->row_no;
 }
 
+static void
+finalize_ods_worksheet (ods_worksheet * ws)
+{
+/* 
+ * a Worksheet has been completely parsed: setting its dimensions,
+ * creating the ROWS Array and releasing all rows lacking any value
+ */
+    int max_col_no;
+    ods_cell *cell;
+    ods_row *row;
+    ods_row *row_n;
+    ods_row *last = NULL;
+    ws->max_row = -1;
+    ws->max_cell = -1;
+    row = ws->first;
+    while (row != NULL)
+      {
+	  max_col_no = -1;
+	  cell = row->first;
+	  row->max_cell = -1;
+	  while (cell != NULL)
+	    {
+		if (cell->assigned && cell->type != ODS_VOID)
+		  {
+		      if (cell->col_no > max_col_no)
+			  max_col_no = cell->col_no;
+		  }
+		cell = cell->next;
+	    }
+	  row_n = row->next;
+	  if (max_col_no >= 0)
+	    {
+		row->max_cell = max_col_no;
+		if (row->row_no > ws->max_row)
+		    ws->max_row = row->row_no;
+		if (row->max_cell > ws->max_cell)
+		    ws->max_cell = row->max_cell;
+		if (last == NULL)
+		    ws->first = row;
+		else
+		    last->next = row;
+		last = row;
+	    }
+	  else
+	      destroy_row (row);
+	  row = row_n;
+      }
+    if (last == NULL)
+	ws->first = NULL;
+    else
+	last->next = NULL;
+    ws->last = last;
+    if (ws->max_row > 0)
+      {
+	  /* creating and populating the ROWS Array */
+	  int i;
+	  ws->rows = malloc (sizeof (ods_row *) * (ws->max_row + 1));
+	  for (i = 0; i < ws->max_row; i++)
+	      *(ws->rows + i) = NULL;
+	  row = ws->first;
+	  while (row != NULL)
+	    {
+		if (row->row_no > 0)
+		    *(ws->rows + row->row_no - 1) = row;
+		row = row->next;
+	    }
+      }
+}
+
 static void
 do_add_worksheet (ods_workbook * workbook, char *name)
 {
@@ -327,6 +578,8 @@ do_add_worksheet (ods_workbook * workbook, char *name)
     ws->ColOk = 0;
     ws->CellValueOk = 0;
     ws->NextRowNo = 1;
+    ws->skipped = 0;
+    ws->column_stats = NULL;
     ws->next = NULL;
     if (workbook->first == NULL)
 	workbook->first = ws;
@@ -345,48 +598,57 @@ setString (const char *entry)
 }
 
 static void
-do_list_zipfile_dir (unzFile uf, ods_workbook * workbook)
+do_list_zipfile_dir (const char *path, unzFile uf, ods_workbook * workbook)
 {
-/* parsing a Zipfile directory */
-    unz_global_info64 gi;
-    int ret;
-    unsigned int i;
-    ret = unzGetGlobalInfo64 (uf, &gi);
-    if (ret != UNZ_OK)
+/* indexing the Zipfile directory */
+    zip_entry *entry;
+
+    workbook->ZipIndex = zip_build_index (path, uf);
+    if (workbook->ZipIndex == NULL)
       {
 	  workbook->error = 1;
 	  return;
       }
 
-    for (i = 0; i < gi.number_entry; i++)
+    entry = zip_find_entry (workbook->ZipIndex, "content.xml");
+    if (entry != NULL)
       {
-	  /* looping on Zipfile entries */
-	  char filename[256];
-	  unz_file_info64 file_info;
-	  ret =
-	      unzGetCurrentFileInfo64 (uf, &file_info, filename, 256, NULL, 0,
-				       NULL, 0);
-	  if (ret != UNZ_OK)
-	    {
-		workbook->error = 1;
-		return;
-	    }
-
-	  if (strcasecmp (filename, "content.xml") == 0)
-	    {
-		/* found Workbook */
-		workbook->ContentZipEntry = setString (filename);
-	    }
+	  /* found Workbook */
+	  workbook->ContentZipEntry = setString (entry->name);
+      }
+}
 
-	  if (i == gi.number_entry - 1)
-	      break;
-	  ret = unzGoToNextFile (uf);
-	  if (ret != UNZ_OK)
-	    {
-		workbook->error = 1;
-		return;
-	    }
+static int
+is_wanted_ods_sheet (ods_workbook * workbook, const char *name)
+{
+/* checking if some Worksheet has to be loaded */
+    const char **p = workbook->SheetNames;
+    if (p == NULL)
+	return 1;
+    while (*p != NULL)
+      {
+	  if (strcmp (*p, name) == 0)
+	      return 1;
+	  p++;
       }
+    return 0;
+}
+
+static int
+is_ods_value_attribute (const char *name)
+{
+/* checking for any attribute holding the value of some cell */
+    if (strcmp (name, "office:value") == 0)
+	return 1;
+    if (strcmp (name, "office:string-value") == 0)
+	return 1;
+    if (strcmp (name, "office:boolean-value") == 0)
+	return 1;
+    if (strcmp (name, "office:date-value") == 0)
+	return 1;
+    if (strcmp (name, "office:time-value") == 0)
+	return 1;
+    return 0;
 }
 
 static void
@@ -398,6 +660,12 @@ start_tag (void *data, const char *el, const char **attr)
     const char *k;
     const char *v;
     ods_workbook *workbook = (ods_workbook *) data;
+    if (workbook->SkipDepth > 0)
+      {
+	  /* within a Worksheet not to be loaded */
+	  workbook->SkipDepth += 1;
+	  return;
+      }
     if (strcmp (el, "office:document-content") == 0)
 	workbook->ContentOk = 1;
     if (strcmp (el, "office:body") == 0)
@@ -435,7 +703,18 @@ start_tag (void *data, const char *el, const char **attr)
 		      count++;
 		  }
 		if (name != NULL)
-		    do_add_worksheet (workbook, name);
+		  {
+		      do_add_worksheet (workbook, name);
+		      if (workbook->info
+			  || !is_wanted_ods_sheet (workbook, name)
+			  || !freexl_projected_sheet (workbook->projection,
+						      workbook->last->id))
+			{
+			    /* skipping the whole table:table content */
+			    workbook->last->skipped = 1;
+			    workbook->SkipDepth = 1;
+			}
+		  }
 		else
 		    workbook->error = 1;
 	    }
@@ -449,6 +728,15 @@ start_tag (void *data, const char *el, const char **attr)
 	      workbook->error = 1;
 	  else
 	    {
+		if (workbook->ContentOk == 4 && worksheet->RowOk == 0
+		    && workbook->projection != NULL
+		    && (unsigned int) (worksheet->NextRowNo - 1) >=
+		    workbook->projection->end_row)
+		  {
+		      /* the requested rows are over: skipping up to the table end */
+		      workbook->SkipDepth = 2;
+		      return;
+		  }
 		if (workbook->ContentOk == 4 && worksheet->RowOk == 0)
 		  {
 		      int i;
@@ -497,6 +785,12 @@ start_tag (void *data, const char *el, const char **attr)
 		      int type = ODS_VOID;
 		      char *xtype = NULL;
 		      char *value = NULL;
+		      ods_row *row = worksheet->last;
+		      int wanted = 1;
+		      if (row == NULL
+			  || !freexl_projected_row (workbook->projection,
+						    row->row_no - 1))
+			  wanted = 0;	/* the whole row is to be discarded */
 		      count = 0;
 		      while (*attrib != NULL)
 			{
@@ -505,17 +799,10 @@ start_tag (void *data, const char *el, const char **attr)
 			    else
 			      {
 				  v = *attrib;
-				  if (strcmp (k, "office:value-type") == 0)
+				  if (wanted
+				      && strcmp (k, "office:value-type") == 0)
 				      xtype = setString (v);
-				  if (strcmp (k, "office:value") == 0)
-				      value = setString (v);
-				  if (strcmp (k, "office:string-value") == 0)
-				      value = setString (v);
-				  if (strcmp (k, "office:boolean-value") == 0)
-				      value = setString (v);
-				  if (strcmp (k, "office:date-value") == 0)
-				      value = setString (v);
-				  if (strcmp (k, "office:time-value") == 0)
+				  if (wanted && is_ods_value_attribute (k))
 				      value = setString (v);
 				  if (strcmp
 				      (k, "table:number-columns-repeated") == 0)
@@ -542,7 +829,15 @@ start_tag (void *data, const char *el, const char **attr)
 				type = ODS_TIME;
 			}
 		      for (i = 0; i < repeated; i++)
-			  do_add_cell (worksheet, type, value);
+			{
+			    if (wanted
+				&& freexl_projected_cell (workbook->projection,
+							  row->row_no - 1,
+							  row->NextColNo))
+				do_add_cell (worksheet, type, value);
+			    else
+				do_add_cell (worksheet, ODS_VOID, NULL);
+			}
 		      worksheet->ColOk = 1;
 		      if (xtype != NULL)
 			  free (xtype);
@@ -587,6 +882,8 @@ set_ods_cell_value (ods_worksheet * worksheet, const char *val)
     cell = row->last;
     if (cell == NULL)
 	return;
+    if (cell->col_no != row->NextColNo - 1)
+	return;			/* the current cell was discarded */
     if (cell->type != ODS_STRING)
 	return;
 
@@ -601,6 +898,14 @@ end_tag (void *data, const char *el)
 {
 /* some generic XML tag ends here */
     ods_workbook *workbook = (ods_workbook *) data;
+    if (workbook->SkipDepth > 0)
+      {
+	  /* within a Worksheet not to be loaded */
+	  workbook->SkipDepth -= 1;
+	  if (workbook->SkipDepth > 0)
+	      return;
+	  /* reaching the table:table end tag */
+      }
     if (strcmp (el, "office:document-content") == 0)
       {
 	  if (workbook->ContentOk == 1)
@@ -624,8 +929,14 @@ end_tag (void *data, const char *el)
       }
     if (strcmp (el, "table:table") == 0)
       {
-	  if (workbook->ContentOk == 4)
-	      workbook->ContentOk = 3;
+	  if (workbook->ContentOk == 4 && workbook->last != NULL)
+	    {
+		/* the current Worksheet is now complete */
+		finalize_ods_worksheet (workbook->last);
+		if (workbook->last->skipped)
+		    workbook->last->max_row = 0;
+		workbook->ContentOk = 3;
+	    }
 	  else
 	      workbook->error = 1;
       }
@@ -678,12 +989,14 @@ end_tag (void *data, const char *el)
 }
 
 static void
-do_parse_ods_worksheets (ods_workbook * workbook, unsigned char *buf,
-			 uint64_t size_buf)
+do_stream_ods_worksheets (ods_workbook * workbook, zip_pipeline * pipe)
 {
-/* parsing Content.xml */
+/* parsing Content.xml chunk by chunk, while it's still being inflated */
     XML_Parser parser;
     int done = 0;
+    const unsigned char *chunk;
+    unsigned int chunk_len;
+    int ret;
 
     parser = XML_ParserCreate (NULL);
     if (!parser)
@@ -695,149 +1008,441 @@ do_parse_ods_worksheets (ods_workbook * workbook, unsigned char *buf,
     XML_SetUserData (parser, workbook);
     XML_SetElementHandler (parser, start_tag, end_tag);
     XML_SetCharacterDataHandler (parser, xmlCharData);
-    if (!XML_Parse (parser, (char *) buf, size_buf, done))
-	workbook->error = 1;
+    while (1)
+      {
+	  ret = zip_pipeline_next (pipe, &chunk, &chunk_len);
+	  if (ret < 0)
+	      workbook->error = 1;
+	  if (ret <= 0)
+	      break;
+	  if (!XML_Parse (parser, (const char *) chunk, chunk_len, done))
+	      workbook->error = 1;
+	  zip_pipeline_release (pipe);
+	  if (workbook->error)
+	      break;
+      }
+    if (!workbook->error)
+      {
+	  /* the XML document must be complete */
+	  if (!XML_Parse (parser, NULL, 0, 1))
+	      workbook->error = 1;
+      }
     XML_ParserFree (parser);
 }
 
+#ifndef OMIT_THREADS		/* only if multithreading is enabled */
+static const unsigned char *
+skip_ods_markup (const unsigned char *p, const unsigned char *end,
+		 const char *terminator)
+{
+/* skipping up to the end of a comment, CDATA section or PI */
+    int len = strlen (terminator);
+    while (p < end)
+      {
+	  p = memchr (p, *terminator, end - p);
+	  if (p == NULL || end - p < len)
+	      return NULL;
+	  if (memcmp (p, terminator, len) == 0)
+	      return p + len;
+	  p++;
+      }
+    return NULL;
+}
+
+static const unsigned char *
+skip_ods_tag (const unsigned char *p, const unsigned char *end,
+	      int *self_closing)
+{
+/* skipping up to the end of a tag, ignoring any '>' within quotes */
+    unsigned char quote = '\0';
+    while (p < end)
+      {
+	  if (quote != '\0')
+	    {
+		if (*p == quote)
+		    quote = '\0';
+	    }
+	  else if (*p == '"' || *p == '\'')
+	      quote = *p;
+	  else if (*p == '>')
+	    {
+		*self_closing = (*(p - 1) == '/') ? 1 : 0;
+		return p + 1;
+	    }
+	  p++;
+      }
+    return NULL;
+}
+
+static int
+is_ods_table_tag (const unsigned char *p, const unsigned char *end,
+		  int closing)
+{
+/* testing for a <table:table> or </table:table> tag */
+    const char *name = closing ? "</table:table" : "<table:table";
+    int len = strlen (name);
+    unsigned char c;
+    if (end - p <= len || memcmp (p, name, len) != 0)
+	return 0;
+    c = *(p + len);
+    if (c == '>' || c == '/' || c == ' ' || c == '\t' || c == '\r'
+	|| c == '\n')
+	return 1;
+    return 0;
+}
+
+static int
+find_ods_tables (const unsigned char *buf, uint64_t size_buf,
+		 ods_table_range ** ranges, int *count)
+{
+/* 
+ * pre-scanning Content.xml so to locate all top-level table:table
+ * elements; returns 0 if the document can't be safely split
+ */
+    const unsigned char *p = buf;
+    const unsigned char *end = buf + size_buf;
+    const unsigned char *start = NULL;
+    ods_table_range *list = NULL;
+    int max_list = 0;
+    int n = 0;
+    int depth = 0;
+    int self_closing;
+    while (p < end)
+      {
+	  p = memchr (p, '<', end - p);
+	  if (p == NULL)
+	      break;
+	  if (end - p >= 4 && memcmp (p, "<!--", 4) == 0)
+	      p = skip_ods_markup (p + 4, end, "-->");
+	  else if (end - p >= 9 && memcmp (p, "<![CDATA[", 9) == 0)
+	      p = skip_ods_markup (p + 9, end, "]]>");
+	  else if (end - p >= 2 && memcmp (p, "<?", 2) == 0)
+	      p = skip_ods_markup (p + 2, end, "?>");
+	  else if (end - p >= 2 && memcmp (p, "<!", 2) == 0)
+	    {
+		/* a DTD could declare entities: giving up */
+		goto error;
+	    }
+	  else if (is_ods_table_tag (p, end, 0))
+	    {
+		const unsigned char *tag = p;
+		p = skip_ods_tag (p, end, &self_closing);
+		if (p == NULL)
+		    goto error;
+		if (depth == 0)
+		    start = tag;
+		if (!self_closing)
+		    depth++;
+	    }
+	  else if (is_ods_table_tag (p, end, 1))
+	    {
+		p = skip_ods_tag (p, end, &self_closing);
+		if (p == NULL || depth == 0)
+		    goto error;
+		depth--;
+		self_closing = 1;
+	    }
+	  else
+	    {
+		p++;
+		continue;
+	    }
+	  if (p == NULL)
+	      goto error;
+	  if (start != NULL && depth == 0 && self_closing)
+	    {
+		/* a complete top-level table:table */
+		if (n >= max_list)
+		  {
+		      ods_table_range *new_list;
+		      max_list = (max_list == 0) ? 16 : max_list * 2;
+		      new_list =
+			  realloc (list, sizeof (ods_table_range) * max_list);
+		      if (new_list == NULL)
+			  goto error;
+		      list = new_list;
+		  }
+		(list + n)->offset = start - buf;
+		(list + n)->length = p - start;
+		(list + n)->parsed = NULL;
+		n++;
+		start = NULL;
+	    }
+      }
+    if (depth != 0)
+	goto error;
+    *ranges = list;
+    *count = n;
+    return 1;
+
+  error:
+    if (list != NULL)
+	free (list);
+    return 0;
+}
+
 static void
-do_fetch_ods_worksheets (unzFile uf, ods_workbook * workbook)
+parse_ods_table (ods_table_jobs * jobs, ods_table_range * range)
 {
-/* uncompressing Content.xml */
-    int err;
-    char filename[256];
-    unz_file_info64 file_info;
-    uint64_t size_buf;
-    unsigned char *buf = NULL;
-    int is_open = 0;
-    uint64_t rd_cnt;
-    uint64_t unrd_cnt;
+/* parsing a single table:table into its own temporary Workbook */
+    XML_Parser parser;
+    ods_workbook *workbook = alloc_workbook ();
+    range->parsed = workbook;
+    if (workbook == NULL)
+	return;
+    workbook->SheetNames = jobs->SheetNames;
+    workbook->projection = jobs->projection;
+    /* the Worksheet index within the whole document */
+    workbook->NextWorksheetId = range - jobs->ranges;
+    /* just as if the office:spreadsheet start tag was already parsed */
+    workbook->ContentOk = 3;
 
-    err = unzLocateFile (uf, workbook->ContentZipEntry, 0);
-    if (err != UNZ_OK)
+    parser = XML_ParserCreate (NULL);
+    if (!parser)
       {
 	  workbook->error = 1;
-	  goto skip;
+	  return;
+      }
+    XML_SetUserData (parser, workbook);
+    XML_SetElementHandler (parser, start_tag, end_tag);
+    XML_SetCharacterDataHandler (parser, xmlCharData);
+    if (!XML_Parse
+	(parser, (const char *) (jobs->buf + range->offset), range->length,
+	 1))
+	workbook->error = 1;
+    XML_ParserFree (parser);
+    if (workbook->ContentOk != 3 || workbook->first == NULL)
+	workbook->error = 1;
+}
+
+static void
+ods_table_worker (void *arg)
+{
+/* thread function: parsing tables as long as any one is left */
+    ods_table_jobs *jobs = (ods_table_jobs *) arg;
+    while (1)
+      {
+	  int i;
+	  freexl_mutex_lock (jobs->mutex);
+	  i = jobs->next;
+	  jobs->next += 1;
+	  freexl_mutex_unlock (jobs->mutex);
+	  if (i >= jobs->count)
+	      return;
+	  parse_ods_table (jobs, jobs->ranges + i);
       }
-    err =
-	unzGetCurrentFileInfo64 (uf, &file_info, filename, 256, NULL, 0, NULL,
-				 0);
-    if (err != UNZ_OK)
+}
+
+static void
+do_parse_ods_worksheets (ods_workbook * workbook, const unsigned char *buf,
+			 uint64_t size_buf)
+{
+/* parsing the whole Content.xml at once */
+    XML_Parser parser;
+
+    parser = XML_ParserCreate (NULL);
+    if (!parser)
       {
 	  workbook->error = 1;
-	  goto skip;
+	  return;
+      }
+
+    XML_SetUserData (parser, workbook);
+    XML_SetElementHandler (parser, start_tag, end_tag);
+    XML_SetCharacterDataHandler (parser, xmlCharData);
+    if (!XML_Parse (parser, (const char *) buf, size_buf, 1))
+	workbook->error = 1;
+    XML_ParserFree (parser);
+}
+
+static int
+check_ods_skeleton (const unsigned char *buf, uint64_t size_buf,
+		    ods_table_range * ranges, int count)
+{
+/* 
+ * validating Content.xml outside of its Worksheets just as the
+ * sequential parser does: everything must be well-formed, and each
+ * table:table must lie directly within office:spreadsheet
+ */
+    XML_Parser parser;
+    ods_workbook *skeleton = alloc_workbook ();
+    uint64_t offset = 0;
+    int ok = 1;
+    int i;
+
+    if (skeleton == NULL)
+	return 0;
+    parser = XML_ParserCreate (NULL);
+    if (!parser)
+      {
+	  destroy_workbook (skeleton);
+	  return 0;
+      }
+    XML_SetUserData (parser, skeleton);
+    XML_SetElementHandler (parser, start_tag, end_tag);
+    XML_SetCharacterDataHandler (parser, xmlCharData);
+    for (i = 0; i < count && ok; i++)
+      {
+	  /* parsing up to the next table:table, and then skipping it */
+	  ods_table_range *range = ranges + i;
+	  if (!XML_Parse
+	      (parser, (const char *) (buf + offset), range->offset - offset,
+	       0))
+	      ok = 0;
+	  else if (skeleton->error || skeleton->ContentOk != 3)
+	      ok = 0;
+	  offset = range->offset + range->length;
+      }
+    if (ok
+	&& !XML_Parse (parser, (const char *) (buf + offset),
+		       size_buf - offset, 1))
+	ok = 0;
+    if (skeleton->error)
+	ok = 0;
+    XML_ParserFree (parser);
+    destroy_workbook (skeleton);
+    return ok;
+}
+
+static int
+do_parallel_ods_worksheets (ods_workbook * workbook,
+			    const unsigned char *buf, uint64_t size_buf)
+{
+/* 
+ * parsing each Worksheet of Content.xml by a separate thread
+ *
+ * returns 0 if the document can't be split into Worksheets (or
+ * isn't valid), so that it should rather be parsed sequentially
+ */
+    ods_table_jobs jobs;
+    void **threads;
+    int n_threads;
+    int i;
+
+    if (!find_ods_tables (buf, size_buf, &(jobs.ranges), &(jobs.count)))
+	return 0;
+    if (jobs.count < 2
+	|| !check_ods_skeleton (buf, size_buf, jobs.ranges, jobs.count))
+      {
+	  /* 
+	   * nothing to be parallelized, or some structural error that
+	   * the sequential parser will then report as usual
+	   */
+	  if (jobs.ranges != NULL)
+	      free (jobs.ranges);
+	  return 0;
       }
-    size_buf = file_info.uncompressed_size;
-    buf = malloc (size_buf);
-    err = unzOpenCurrentFile (uf);
-    if (err != UNZ_OK)
+    jobs.buf = buf;
+    jobs.next = 0;
+    jobs.SheetNames = workbook->SheetNames;
+    jobs.projection = workbook->projection;
+    jobs.mutex = freexl_mutex_create ();
+    /* the current thread will be a worker as well */
+    n_threads = workbook->threads - 1;
+    if (n_threads > jobs.count - 1)
+	n_threads = jobs.count - 1;
+    threads = malloc (sizeof (void *) * n_threads);
+    if (jobs.mutex == NULL || threads == NULL)
       {
 	  workbook->error = 1;
-	  goto skip;
-      }
-    is_open = 1;
-    rd_cnt = 0;
-    while (rd_cnt < size_buf)
-      {
-	  /* reading big chunks so to avoid large file issues */
-	  uint32_t max = 1000000000;	/* max chunk size */
-	  uint32_t len;
-	  unrd_cnt = size_buf - rd_cnt;
-	  if (unrd_cnt < max)
-	      len = unrd_cnt;
-	  else
-	      len = max;
-	  err = unzReadCurrentFile (uf, buf + rd_cnt, len);
-	  if (err < 0)
+	  goto stop;
+      }
+    for (i = 0; i < n_threads; i++)
+	*(threads + i) = freexl_thread_create (ods_table_worker, &jobs);
+    ods_table_worker (&jobs);
+    for (i = 0; i < n_threads; i++)
+      {
+	  if (*(threads + i) != NULL)
+	      freexl_thread_join (*(threads + i));
+      }
+
+    for (i = 0; i < jobs.count; i++)
+      {
+	  /* moving all Worksheets into the Workbook, in document order */
+	  ods_workbook *parsed = (jobs.ranges + i)->parsed;
+	  ods_worksheet *ws;
+	  if (parsed == NULL || parsed->error)
 	    {
 		workbook->error = 1;
-		goto skip;
+		continue;
 	    }
-	  rd_cnt += len;
+	  ws = parsed->first;
+	  parsed->first = NULL;
+	  parsed->last = NULL;
+	  ws->id = workbook->NextWorksheetId;
+	  workbook->NextWorksheetId += 1;
+	  if (workbook->first == NULL)
+	      workbook->first = ws;
+	  if (workbook->last != NULL)
+	      workbook->last->next = ws;
+	  workbook->last = ws;
+      }
+
+  stop:
+    for (i = 0; i < jobs.count; i++)
+      {
+	  ods_workbook *parsed = (jobs.ranges + i)->parsed;
+	  if (parsed != NULL)
+	      parsed->projection = NULL;	/* owned by the main Workbook */
+	  destroy_workbook (parsed);
       }
+    free (jobs.ranges);
+    if (threads != NULL)
+	free (threads);
+    if (jobs.mutex != NULL)
+	freexl_mutex_destroy (jobs.mutex);
+    return 1;
+}
+#endif /* end conditional multithreading support */
+
+static void
+do_fetch_ods_worksheets (unzFile uf, ods_workbook * workbook)
+{
+/* 
+ * uncompressing and parsing Content.xml
+ *
+ * the XML document is never loaded in memory as a whole; it's
+ * fed to the parser a chunk at a time as soon as it gets inflated
+ */
+    zip_entry *entry;
+    zip_pipeline *pipe;
 
-/* parsing Workbook.xml */
-    do_parse_ods_worksheets (workbook, buf, size_buf);
-    if (workbook->error == 0)
+    entry = zip_find_entry (workbook->ZipIndex, workbook->ContentZipEntry);
+#ifndef OMIT_THREADS
+    if (workbook->threads > 1)
       {
-	  /* adjusting all Worksheets */
-	  ods_worksheet *ws = workbook->first;
-	  while (ws != NULL)
+	  /* inflating the whole Content.xml, then parsing in parallel */
+	  uint64_t size_buf;
+	  unsigned char *buf =
+	      zip_fetch_entry (uf, workbook->ZipIndex, entry, &size_buf);
+	  if (buf == NULL)
 	    {
-		int max_col_no = -1;
-		ods_cell *cell;
-		ods_row *row = ws->first;
-		ws->max_row = -1;
-		ws->max_cell = -1;
-		while (row != NULL)
-		  {
-		      max_col_no = -1;
-		      cell = row->first;
-		      row->max_cell = -1;
-		      while (cell != NULL)
-			{
-			    if (cell->assigned && cell->type != ODS_VOID)
-			      {
-				  if (cell->col_no > max_col_no)
-				      max_col_no = cell->col_no;
-			      }
-			    cell = cell->next;
-			}
-		      if (max_col_no >= 0)
-			{
-			    row->max_cell = max_col_no;
-			    if (row->row_no > ws->max_row)
-				ws->max_row = row->row_no;
-			    if (row->max_cell > ws->max_cell)
-				ws->max_cell = row->max_cell;
-			}
-		      row = row->next;
-		  }
-		if (ws->max_row > 0)
-		  {
-		      /* creating and populating the ROWS Array */
-		      int i;
-		      ws->rows =
-			  malloc (sizeof (ods_row *) * (ws->max_row + 1));
-		      for (i = 0; i < ws->max_row; i++)
-			  *(ws->rows + i) = NULL;
-		      row = ws->first;
-		      while (row != NULL)
-			{
-			    max_col_no = -1;
-			    cell = row->first;
-			    while (cell != NULL)
-			      {
-				  if (cell->assigned && cell->type != ODS_VOID)
-				    {
-					if (cell->col_no > max_col_no)
-					    max_col_no = cell->col_no;
-				    }
-				  cell = cell->next;
-			      }
-			    if (max_col_no >= 0)
-			      {
-				  if (row->row_no > 0)
-				      *(ws->rows + row->row_no - 1) = row;
-			      }
-			    row = row->next;
-			}
-		  }
-		ws = ws->next;
+		workbook->error = 1;
+		return;
 	    }
+	  if (!do_parallel_ods_worksheets (workbook, buf, size_buf))
+	      do_parse_ods_worksheets (workbook, buf, size_buf);
+	  free (buf);
+	  return;
       }
-
-  skip:
-    if (buf != NULL)
-	free (buf);
-    if (is_open)
-	unzCloseCurrentFile (uf);
+#endif
+    pipe =
+	zip_pipeline_start (uf, workbook->ZipIndex, entry,
+			    workbook->xml_pipeline);
+    if (pipe == NULL)
+      {
+	  workbook->error = 1;
+	  return;
+      }
+    do_stream_ods_worksheets (workbook, pipe);
+    zip_pipeline_stop (pipe);
 }
 
-FREEXL_DECLARE int
-freexl_open_ods (const char *path, const void **xl_handle)
+static int
+common_open_ods (const char *path, const FreeXL_OpenOptions * options,
+		 int info, const void **xl_handle)
 {
-/* opening and initializing the Workbook - XLSX format expected */
+/* opening and initializing the Workbook - ODS format expected */
     ods_workbook *workbook;
     freexl_handle **handle = (freexl_handle **) xl_handle;
     unzFile uf = NULL;
@@ -857,9 +1462,26 @@ freexl_open_ods (const char *path, const void **xl_handle)
 /* allocating the Workbook struct */
     workbook = alloc_workbook ();
     if (!workbook)
-	return FREEXL_INSUFFICIENT_MEMORY;
+      {
+	  retval = FREEXL_INSUFFICIENT_MEMORY;
+	  goto stop;
+      }
+    if (options != NULL)
+      {
+	  /* applying the options */
+	  workbook->xml_pipeline = options->xml_pipeline;
+	  workbook->SheetNames = options->ods_sheets;
+	  workbook->threads = options->ods_threads;
+      }
+    workbook->info = info;
+    if (!freexl_create_projection (options, &(workbook->projection)))
+      {
+	  destroy_workbook (workbook);
+	  retval = FREEXL_INSUFFICIENT_MEMORY;
+	  goto stop;
+      }
 /* parsing the Zipfile directory */
-    do_list_zipfile_dir (uf, workbook);
+    do_list_zipfile_dir (path, uf, workbook);
     if (workbook->error)
       {
 	  destroy_workbook (workbook);
@@ -879,13 +1501,45 @@ freexl_open_ods (const char *path, const void **xl_handle)
 	    }
       }
     (*handle)->ods_handle = workbook;
+    workbook->SheetNames = NULL;
+/* the Zipfile directory index is no longer required */
+    zip_destroy_index (workbook->ZipIndex);
+    workbook->ZipIndex = NULL;
 
 /* closing the Zipfile and quitting */
   stop:
     unzClose (uf);
+    if (retval != FREEXL_OK)
+      {
+	  /* no Workbook is going to be returned */
+	  free (*handle);
+	  *handle = NULL;
+      }
     return retval;
 }
 
+FREEXL_DECLARE int
+freexl_open_ods (const char *path, const void **xl_handle)
+{
+/* opening and initializing the Workbook - ODS format expected */
+    return common_open_ods (path, NULL, 0, xl_handle);
+}
+
+FREEXL_DECLARE int
+freexl_open_ods_ex (const char *path, const FreeXL_OpenOptions * options,
+		    const void **xl_handle)
+{
+/* opening and initializing the Workbook - ODS format expected */
+    return common_open_ods (path, options, 0, xl_handle);
+}
+
+FREEXL_DECLARE int
+freexl_open_ods_info (const char *path, const void **xl_handle)
+{
+/* opening and initializing the Workbook (only for Info) - ODS format */
+    return common_open_ods (path, NULL, 1, xl_handle);
+}
+
 FREEXL_DECLARE int
 freexl_close_ods (const void *xl_handle)
 {
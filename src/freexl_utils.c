@@ -0,0 +1,587 @@
+/* 
+/ freexl_utils.c
+/
+/ FreeXL implementation (common utilities)
+/
+/ ------------------------------------------------------------------------------
+/ 
+/ Version: MPL 1.1/GPL 2.0/LGPL 2.1
+/ 
+/ The contents of this file are subject to the Mozilla Public License Version
+/ 1.1 (the "License"); you may not use this file except in compliance with
+/ the License. You may obtain a copy of the License at
+/ http://www.mozilla.org/MPL/
+/ 
+/ Software distributed under the License is distributed on an "AS IS" basis,
+/ WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+/ for the specific language governing rights and limitations under the
+/ License.
+/
+/ The Original Code is the FreeXL library
+/
+/ The Initial Developer of the Original Code is Alessandro Furieri
+/ 
+/ Portions created by the Initial Developer are Copyright (C) 2021
+/ the Initial Developer. All Rights Reserved.
+/ 
+/ Contributor(s):
+/ 
+/ Alternatively, the contents of this file may be used under the terms of
+/ either the GNU General Public License Version 2 or later (the "GPL"), or
+/ the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+/ in which case the provisions of the GPL or the LGPL are applicable instead
+/ of those above. If you wish to allow use of your version of this file only
+/ under the terms of either the GPL or the LGPL, and not to allow others to
+/ use your version of this file under the terms of the MPL, indicate your
+/ decision by deleting the provisions above and replace them with the notice
+/ and other provisions required by the GPL or the LGPL. If you do not delete
+/ the provisions above, a recipient may use your version of this file under
+/ the terms of any one of the MPL, the GPL or the LGPL.
+/ 
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+#include <limits.h>
+#include <float.h>
+#include <locale.h>
+
+#include <iconv.h>		/* iconv_t is used by freexl_internals.h */
+
+#if defined(_WIN32) && !defined(__MINGW32__)
+#include "config-msvc.h"
+#else
+#include "config.h"
+#endif
+
+#include "freexl.h"
+#include "freexl_internals.h"
+
+/* exact powers of ten (Clinger's fast path) */
+static const double exact_pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static double
+parse_number_slow (const char *str)
+{
+/* fallback: parsing by strtod(), always using '.' as decimal point */
+    char buf[256];
+    const char *point;
+    int point_len;
+    int len = 0;
+    const char *p;
+    struct lconv *lc = localeconv ();
+
+    point = lc->decimal_point;
+    if (point == NULL || strcmp (point, ".") == 0)
+	return strtod (str, NULL);
+
+/* the current locale has some different decimal point */
+    point_len = strlen (point);
+    for (p = str; *p != '\0'; p++)
+      {
+	  if (len + point_len >= (int) sizeof (buf))
+	      break;
+	  if (*p == '.')
+	    {
+		memcpy (buf + len, point, point_len);
+		len += point_len;
+	    }
+	  else
+	      buf[len++] = *p;
+      }
+    buf[len] = '\0';
+    return strtod (buf, NULL);
+}
+
+static int
+classify_number (double value, int *int_value, double *dbl_value)
+{
+/* checking if a number is an integer fitting into 32 bits */
+    if (value >= (double) INT_MIN && value <= (double) INT_MAX)
+      {
+	  int i_val = (int) value;
+	  if ((double) i_val == value)
+	    {
+		*int_value = i_val;
+		return XML_NUMBER_INTEGER;
+	    }
+      }
+    *dbl_value = value;
+    return XML_NUMBER_DOUBLE;
+}
+
+int
+parse_xml_number (const char *str, int *int_value, double *dbl_value)
+{
+/*
+ * parsing a numeric token from some XML cell value
+ *
+ * decimal notation always uses '.' whatever the current locale is;
+ * just as atof() does, any leading white space is skipped and parsing
+ * stops at the first unexpected char (an empty string is zero)
+ *
+ * returns XML_NUMBER_INTEGER if the value is integral and fits into
+ * an int (int_value is set), otherwise XML_NUMBER_DOUBLE (dbl_value
+ * is set, correctly rounded)
+ */
+    const char *p = str;
+    int negative = 0;
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exp10 = 0;
+    int any = 0;
+    int inexact = 0;
+    double value;
+
+    while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')
+	p++;
+    if (*p == '+' || *p == '-')
+      {
+	  negative = (*p == '-');
+	  p++;
+      }
+    while (*p >= '0' && *p <= '9')
+      {
+	  /* integer part */
+	  int d = *p++ - '0';
+	  any = 1;
+	  if (mantissa == 0 && d == 0)
+	      continue;
+	  if (digits < 19)
+	    {
+		mantissa = (mantissa * 10) + d;
+		digits++;
+	    }
+	  else
+	    {
+		exp10++;
+		if (d != 0)
+		    inexact = 1;
+	    }
+      }
+    if (*p == '.')
+      {
+	  p++;
+	  while (*p >= '0' && *p <= '9')
+	    {
+		/* fractional part */
+		int d = *p++ - '0';
+		any = 1;
+		if (mantissa == 0 && d == 0)
+		  {
+		      exp10--;
+		      continue;
+		  }
+		if (digits < 19)
+		  {
+		      mantissa = (mantissa * 10) + d;
+		      digits++;
+		      exp10--;
+		  }
+		else if (d != 0)
+		    inexact = 1;
+	    }
+      }
+    if (!any)
+      {
+	  /* not a plain decimal number: INF, NAN, hex or invalid */
+	  return classify_number (parse_number_slow (str), int_value,
+				  dbl_value);
+      }
+    if (*p == 'e' || *p == 'E')
+      {
+	  /* exponent */
+	  const char *q = p + 1;
+	  int exp_negative = 0;
+	  int exponent = 0;
+	  if (*q == '+' || *q == '-')
+	    {
+		exp_negative = (*q == '-');
+		q++;
+	    }
+	  if (*q >= '0' && *q <= '9')
+	    {
+		while (*q >= '0' && *q <= '9')
+		  {
+		      if (exponent < 100000)
+			  exponent = (exponent * 10) + (*q - '0');
+		      q++;
+		  }
+		if (exp_negative)
+		    exp10 -= exponent;
+		else
+		    exp10 += exponent;
+	    }
+      }
+
+    if (mantissa == 0)
+      {
+	  *int_value = 0;
+	  return XML_NUMBER_INTEGER;
+      }
+    if (!inexact && exp10 >= 0 && exp10 <= 9 && mantissa <= INT_MAX)
+      {
+	  /* fast path: plain integers */
+	  uint64_t limit = negative ? (uint64_t) INT_MAX + 1 : INT_MAX;
+	  uint64_t i_val = mantissa;
+	  int e;
+	  for (e = 0; e < exp10; e++)
+	      i_val *= 10;
+	  if (i_val <= limit)
+	    {
+		if (negative)
+		    *int_value = (int) (0 - (int64_t) i_val);
+		else
+		    *int_value = (int) i_val;
+		return XML_NUMBER_INTEGER;
+	    }
+      }
+#if !defined(FLT_EVAL_METHOD) || FLT_EVAL_METHOD == 0
+    if (!inexact && mantissa <= ((uint64_t) 1 << 53) && exp10 >= -22
+	&& exp10 <= 22)
+      {
+	  /*
+	   * fast path: both the mantissa and the power of ten are
+	   * exactly representable, so a single IEEE operation will
+	   * produce a correctly rounded result (Clinger, 1990)
+	   */
+	  value = (double) mantissa;
+	  if (exp10 < 0)
+	      value /= exact_pow10[-exp10];
+	  else
+	      value *= exact_pow10[exp10];
+	  if (negative)
+	      value = -value;
+	  return classify_number (value, int_value, dbl_value);
+      }
+#endif
+/* slow path */
+    return classify_number (parse_number_slow (str), int_value, dbl_value);
+}
+
+int
+freexl_create_projection (const FreeXL_OpenOptions * options,
+			  freexl_projection ** projection)
+{
+/* 
+ * preparing the projection requested by the open options
+ *
+ * *projection will be set to NULL if all cells have to be loaded;
+ * returns 0 on failure
+ */
+    freexl_projection *proj;
+    int i;
+    *projection = NULL;
+    if (options == NULL)
+	return 1;
+    if (options->sheet_index < 0 && options->columns == NULL
+	&& options->first_row == 0 && options->n_rows == 0
+	&& options->preview_rows == 0)
+	return 1;		/* nothing to be restricted */
+
+    proj = malloc (sizeof (freexl_projection));
+    if (proj == NULL)
+	return 0;
+    proj->sheet_index = options->sheet_index;
+    proj->columns = NULL;
+    proj->n_columns = 0;
+    proj->first_row = options->first_row;
+    proj->end_row = UINT_MAX;
+    if (options->n_rows > 0 && options->n_rows <= UINT_MAX - proj->first_row)
+	proj->end_row = proj->first_row + options->n_rows;
+    proj->preview = 0;
+    if (options->preview_rows > 0)
+      {
+	  /* preview mode: the rows to be loaded could be even less */
+	  proj->preview = 1;
+	  if (options->preview_rows <= UINT_MAX - proj->first_row
+	      && proj->first_row + options->preview_rows < proj->end_row)
+	      proj->end_row = proj->first_row + options->preview_rows;
+      }
+    if (options->columns != NULL)
+      {
+	  /* a flag for each column up to the highest requested one */
+	  for (i = 0; i < options->n_columns; i++)
+	    {
+		if ((unsigned int) (options->columns[i]) >= proj->n_columns)
+		    proj->n_columns = options->columns[i] + 1;
+	    }
+	  if (proj->n_columns > 0)
+	    {
+		proj->columns = calloc (proj->n_columns, 1);
+		if (proj->columns == NULL)
+		  {
+		      free (proj);
+		      return 0;
+		  }
+		for (i = 0; i < options->n_columns; i++)
+		    proj->columns[options->columns[i]] = 1;
+	    }
+	  else
+	    {
+		/* an empty set of columns: nothing at all will be loaded */
+		proj->end_row = 0;
+	    }
+      }
+    *projection = proj;
+    return 1;
+}
+
+void
+freexl_destroy_projection (freexl_projection * projection)
+{
+/* memory cleanup - destroying a projection */
+    if (projection == NULL)
+	return;
+    if (projection->columns != NULL)
+	free (projection->columns);
+    free (projection);
+}
+
+int
+freexl_projected_sheet (const freexl_projection * projection, int sheet_index)
+{
+/* checking if some Worksheet has to be loaded */
+    if (projection == NULL || projection->sheet_index < 0)
+	return 1;
+    return projection->sheet_index == sheet_index;
+}
+
+int
+freexl_projected_row (const freexl_projection * projection, unsigned int row)
+{
+/* checking if some row has to be loaded */
+    if (projection == NULL)
+	return 1;
+    return row >= projection->first_row && row < projection->end_row;
+}
+
+int
+freexl_projected_cell (const freexl_projection * projection,
+		       unsigned int row, unsigned int column)
+{
+/* checking if some cell has to be loaded */
+    if (projection == NULL)
+	return 1;
+    if (!freexl_projected_row (projection, row))
+	return 0;
+    if (projection->columns == NULL)
+	return 1;
+    if (column >= projection->n_columns)
+	return 0;
+    return projection->columns[column];
+}
+
+#ifndef OMIT_THREADS		/* only if multithreading is enabled */
+
+#ifdef _WIN32
+#include <windows.h>
+#include <process.h>
+#else
+#include <pthread.h>
+#endif
+
+struct freexl_thread_args
+{
+/* a struct wrapping the arguments of some thread function */
+    void (*func) (void *);
+    void *arg;
+};
+
+#ifdef _WIN32
+static unsigned __stdcall
+thread_entry (void *data)
+#else
+static void *
+thread_entry (void *data)
+#endif
+{
+/* common entry point for all threads */
+    struct freexl_thread_args *args = (struct freexl_thread_args *) data;
+    void (*func) (void *) = args->func;
+    void *arg = args->arg;
+    free (args);
+    func (arg);
+    return 0;
+}
+
+void *
+freexl_thread_create (void (*func) (void *), void *arg)
+{
+/* 
+ * starting a new thread
+ *
+ * returns an opaque thread handle (NULL on failure)
+ */
+    struct freexl_thread_args *args;
+#ifdef _WIN32
+    HANDLE *thread;
+#else
+    pthread_t *thread;
+#endif
+
+    args = malloc (sizeof (struct freexl_thread_args));
+    if (args == NULL)
+	return NULL;
+    args->func = func;
+    args->arg = arg;
+#ifdef _WIN32
+    thread = malloc (sizeof (HANDLE));
+    if (thread == NULL)
+	goto error;
+    *thread =
+	(HANDLE) _beginthreadex (NULL, 0, thread_entry, args, 0, NULL);
+    if (*thread == 0)
+	goto error;
+#else
+    thread = malloc (sizeof (pthread_t));
+    if (thread == NULL)
+	goto error;
+    if (pthread_create (thread, NULL, thread_entry, args) != 0)
+	goto error;
+#endif
+    return thread;
+
+  error:
+    if (thread != NULL)
+	free (thread);
+    free (args);
+    return NULL;
+}
+
+void
+freexl_thread_join (void *thread)
+{
+/* waiting for some thread to terminate */
+#ifdef _WIN32
+    HANDLE *handle = (HANDLE *) thread;
+    WaitForSingleObject (*handle, INFINITE);
+    CloseHandle (*handle);
+#else
+    pthread_join (*((pthread_t *) thread), NULL);
+#endif
+    free (thread);
+}
+
+void *
+freexl_mutex_create (void)
+{
+/* creating a new mutex (NULL on failure) */
+#ifdef _WIN32
+    CRITICAL_SECTION *mutex = malloc (sizeof (CRITICAL_SECTION));
+    if (mutex == NULL)
+	return NULL;
+    InitializeCriticalSection (mutex);
+#else
+    pthread_mutex_t *mutex = malloc (sizeof (pthread_mutex_t));
+    if (mutex == NULL)
+	return NULL;
+    if (pthread_mutex_init (mutex, NULL) != 0)
+      {
+	  free (mutex);
+	  return NULL;
+      }
+#endif
+    return mutex;
+}
+
+void
+freexl_mutex_lock (void *mutex)
+{
+/* locking a mutex */
+#ifdef _WIN32
+    EnterCriticalSection ((CRITICAL_SECTION *) mutex);
+#else
+    pthread_mutex_lock ((pthread_mutex_t *) mutex);
+#endif
+}
+
+void
+freexl_mutex_unlock (void *mutex)
+{
+/* unlocking a mutex */
+#ifdef _WIN32
+    LeaveCriticalSection ((CRITICAL_SECTION *) mutex);
+#else
+    pthread_mutex_unlock ((pthread_mutex_t *) mutex);
+#endif
+}
+
+void
+freexl_mutex_destroy (void *mutex)
+{
+/* destroying a mutex */
+    if (mutex == NULL)
+	return;
+#ifdef _WIN32
+    DeleteCriticalSection ((CRITICAL_SECTION *) mutex);
+#else
+    pthread_mutex_destroy ((pthread_mutex_t *) mutex);
+#endif
+    free (mutex);
+}
+
+void *
+freexl_cond_create (void)
+{
+/* creating a new condition variable (NULL on failure) */
+#ifdef _WIN32
+    CONDITION_VARIABLE *cond = malloc (sizeof (CONDITION_VARIABLE));
+    if (cond == NULL)
+	return NULL;
+    InitializeConditionVariable (cond);
+#else
+    pthread_cond_t *cond = malloc (sizeof (pthread_cond_t));
+    if (cond == NULL)
+	return NULL;
+    if (pthread_cond_init (cond, NULL) != 0)
+      {
+	  free (cond);
+	  return NULL;
+      }
+#endif
+    return cond;
+}
+
+void
+freexl_cond_wait (void *cond, void *mutex)
+{
+/* waiting on a condition variable (the mutex must be locked) */
+#ifdef _WIN32
+    SleepConditionVariableCS ((CONDITION_VARIABLE *) cond,
+			      (CRITICAL_SECTION *) mutex, INFINITE);
+#else
+    pthread_cond_wait ((pthread_cond_t *) cond, (pthread_mutex_t *) mutex);
+#endif
+}
+
+void
+freexl_cond_broadcast (void *cond)
+{
+/* waking up all threads waiting on a condition variable */
+#ifdef _WIN32
+    WakeAllConditionVariable ((CONDITION_VARIABLE *) cond);
+#else
+    pthread_cond_broadcast ((pthread_cond_t *) cond);
+#endif
+}
+
+void
+freexl_cond_destroy (void *cond)
+{
+/* destroying a condition variable */
+    if (cond == NULL)
+	return;
+#ifndef _WIN32
+    pthread_cond_destroy ((pthread_cond_t *) cond);
+#endif
+    free (cond);
+}
+
+#endif /* end conditional multithreading support */
@@ -90,6 +90,8 @@ extern const char *locale_charset (void);
 #define strcasecmp	_stricmp
 #endif /* not WIN32 */
 
+#define XLSX_LAZY_CHUNK		(1024 * 1024)	/* inflated while indexing */
+
 static void
 xmlCharData (void *data, const XML_Char * s, int len)
 {
@@ -149,6 +151,14 @@ alloc_workbook ()
     wb->n_strings = 0;
     wb->xml_strings = 0;
     wb->strings = NULL;
+    wb->strings_pool = NULL;
+    wb->strings_pool_len = 0;
+    wb->strings_pool_max = 0;
+    wb->strings_mode = FREEXL_XLSX_STRINGS_EAGER;
+    wb->strings_cache = 0;
+    wb->lazy_strings = NULL;
+    wb->RowTexts = NULL;
+    wb->RowTextsMax = 0;
     wb->n_formats = 0;
     wb->next_format = 0;
     wb->formats = NULL;
@@ -158,9 +168,15 @@ alloc_workbook ()
     wb->first_date = NULL;
     wb->last_date = NULL;
     wb->error = 0;
+    wb->no_memory = 0;
     wb->SharedStringsZipEntry = NULL;
     wb->WorkbookZipEntry = NULL;
     wb->StylesZipEntry = NULL;
+    wb->ZipIndex = NULL;
+    wb->xml_pipeline = 0;
+    wb->xml_only = 0;
+    wb->projection = NULL;
+    wb->info = 0;
     wb->CharDataStep = 65536;
     wb->CharDataMax = wb->CharDataStep;
     wb->CharData = malloc (wb->CharDataStep);
@@ -177,18 +193,11 @@ static void
 destroy_row (xlsx_row * row)
 {
 /* memory cleanup - destroying a WorkSheet Row */
-    xlsx_cell *col;
-    xlsx_cell *col_n;
     if (row == NULL)
 	return;
 
-    col = row->first;
-    while (col != NULL)
-      {
-	  col_n = col->next;
-	  free (col);
-	  col = col_n;
-      }
+    if (row->cells != NULL)
+	free (row->cells);
     free (row);
 }
 
@@ -214,9 +223,104 @@ destroy_worksheet (xlsx_worksheet * ws)
 	free (ws->rows);
     if (ws->CharData != NULL)
 	free (ws->CharData);
+    if (ws->column_stats != NULL)
+	free (ws->column_stats);
     free (ws);
 }
 
+static xlsx_lazy_strings *
+alloc_lazy_strings (int capacity)
+{
+/* allocating and initializing the lazy SharedStrings struct */
+    int i;
+    int failed;
+    xlsx_lazy_strings *lazy = malloc (sizeof (xlsx_lazy_strings));
+    if (lazy == NULL)
+	return NULL;
+    lazy->zdata = NULL;
+    lazy->tmp = NULL;
+    lazy->encoding = NULL;
+    lazy->parser = XML_ParserCreate (NULL);
+    lazy->buf = NULL;
+    lazy->buf_max = 0;
+    lazy->text_max = 1024;
+    lazy->text = malloc (lazy->text_max);
+    lazy->text_len = 0;
+    lazy->text_ok = 0;
+    if (capacity <= 0)
+	capacity = 4096;
+    lazy->capacity = capacity;
+    lazy->count = 0;
+    lazy->hash_size = 1;
+    while (lazy->hash_size < capacity)
+	lazy->hash_size *= 2;
+    lazy->hash = malloc (sizeof (xlsx_lazy_entry *) * lazy->hash_size);
+    lazy->first = NULL;
+    lazy->last = NULL;
+    failed = (lazy->parser == NULL || lazy->text == NULL
+	      || lazy->hash == NULL);
+#ifndef OMIT_THREADS		/* only if multithreading is enabled */
+    lazy->mutex = freexl_mutex_create ();
+    if (lazy->mutex == NULL)
+	failed = 1;
+#else
+    lazy->mutex = NULL;
+#endif
+    if (failed)
+      {
+#ifndef OMIT_THREADS
+	  freexl_mutex_destroy (lazy->mutex);
+#endif
+	  if (lazy->parser != NULL)
+	      XML_ParserFree (lazy->parser);
+	  if (lazy->text != NULL)
+	      free (lazy->text);
+	  if (lazy->hash != NULL)
+	      free (lazy->hash);
+	  free (lazy);
+	  return NULL;
+      }
+    for (i = 0; i < lazy->hash_size; i++)
+	*(lazy->hash + i) = NULL;
+    return lazy;
+}
+
+static void
+destroy_lazy_strings (xlsx_lazy_strings * lazy)
+{
+/* memory cleanup - destroying the lazy SharedStrings struct */
+    xlsx_lazy_entry *entry;
+    xlsx_lazy_entry *entry_n;
+    if (lazy == NULL)
+	return;
+
+    entry = lazy->first;
+    while (entry != NULL)
+      {
+	  entry_n = entry->next;
+	  free (entry->text);
+	  free (entry);
+	  entry = entry_n;
+      }
+    if (lazy->zdata != NULL)
+	zip_random_close (lazy->zdata);
+    if (lazy->tmp != NULL)
+	fclose (lazy->tmp);
+    if (lazy->encoding != NULL)
+	free (lazy->encoding);
+    if (lazy->parser != NULL)
+	XML_ParserFree (lazy->parser);
+    if (lazy->buf != NULL)
+	free (lazy->buf);
+    if (lazy->text != NULL)
+	free (lazy->text);
+    free (lazy->hash);
+#ifndef OMIT_THREADS
+    freexl_mutex_destroy (lazy->mutex);
+#endif
+    free (lazy);
+}
+
 static void
 destroy_workbook (xlsx_workbook * wb)
 {
@@ -225,6 +329,7 @@ destroy_workbook (xlsx_workbook * wb)
     xlsx_worksheet *ws_n;
     xml_datetime *date;
     xml_datetime *date_n;
+    int i;
     if (wb == NULL)
 	return;
 
@@ -243,15 +348,19 @@ destroy_workbook (xlsx_workbook * wb)
 	  date = date_n;
       }
     if (wb->strings != NULL)
-      {
-	  int i;
-	  for (i = 0; i < wb->n_strings; i++)
+	free (wb->strings);
+    if (wb->strings_pool != NULL)
+	free (wb->strings_pool);
+    if (wb->lazy_strings != NULL)
+	destroy_lazy_strings (wb->lazy_strings);
+    if (wb->RowTexts != NULL)
+      {
+	  for (i = 0; i < wb->RowTextsMax; i++)
 	    {
-		char *str = *(wb->strings + i);
-		if (str != NULL)
-		    free (str);
+		if (wb->RowTexts[i] != NULL)
+		    free (wb->RowTexts[i]);
 	    }
-	  free (wb->strings);
+	  free (wb->RowTexts);
       }
     if (wb->formats != NULL)
 	free (wb->formats);
@@ -263,6 +372,9 @@ destroy_workbook (xlsx_workbook * wb)
 	free (wb->WorkbookZipEntry);
     if (wb->StylesZipEntry != NULL)
 	free (wb->StylesZipEntry);
+    if (wb->ZipIndex != NULL)
+	zip_destroy_index (wb->ZipIndex);
+    freexl_destroy_projection (wb->projection);
     if (wb->CharData != NULL)
 	free (wb->CharData);
     free (wb);
@@ -278,134 +390,287 @@ setString (const char *entry)
 }
 
 static void
-do_list_zipfile_dir (unzFile uf, xlsx_workbook * workbook)
+do_list_zipfile_dir (const char *path, unzFile uf, xlsx_workbook * workbook)
 {
 /* parsing a Zipfile directory */
-    unz_global_info64 gi;
-    int ret;
-    unsigned int i;
-    ret = unzGetGlobalInfo64 (uf, &gi);
-    if (ret != UNZ_OK)
+    zip_entry *entry;
+    workbook->ZipIndex = zip_build_index (path, uf);
+    if (workbook->ZipIndex == NULL)
       {
 	  workbook->error = 1;
 	  return;
       }
 
-    for (i = 0; i < gi.number_entry; i++)
+    entry = zip_find_entry (workbook->ZipIndex, "xl/sharedStrings.xml");
+    if (entry != NULL)
       {
-	  /* looping on Zipfile entries */
-	  char filename[256];
-	  unz_file_info64 file_info;
-	  ret =
-	      unzGetCurrentFileInfo64 (uf, &file_info, filename, 256, NULL, 0,
-				       NULL, 0);
-	  if (ret != UNZ_OK)
-	    {
-		workbook->error = 1;
-		return;
-	    }
+	  /* found SharedStrings */
+	  workbook->SharedStringsZipEntry = setString (entry->name);
+      }
+    entry = zip_find_entry (workbook->ZipIndex, "xl/workbook.xml");
+    if (entry != NULL)
+      {
+	  /* found Workbook */
+	  workbook->WorkbookZipEntry = setString (entry->name);
+      }
+    entry = zip_find_entry (workbook->ZipIndex, "xl/styles.xml");
+    if (entry != NULL)
+      {
+	  /* found Styles */
+	  workbook->StylesZipEntry = setString (entry->name);
+      }
+}
 
-	  if (strcasecmp (filename, "xl/sharedStrings.xml") == 0)
-	    {
-		/* found SharedStrings */
-		workbook->SharedStringsZipEntry = setString (filename);
-	    }
-	  if (strcasecmp (filename, "xl/workbook.xml") == 0)
-	    {
-		/* found Workbook */
-		workbook->WorkbookZipEntry = setString (filename);
-	    }
-	  if (strcasecmp (filename, "xl/styles.xml") == 0)
-	    {
-		/* found Styles */
-		workbook->StylesZipEntry = setString (filename);
-	    }
+static int
+reserve_xlsx_rows (xlsx_worksheet * worksheet, int count)
+{
+/* ensuring that the ROWS Array is able to store so many rows */
+    xlsx_row **rows;
+    int alloc;
+    int i;
+    if (count <= worksheet->rows_alloc)
+	return 1;
+    alloc = worksheet->rows_alloc * 2;
+    if (alloc < count)
+	alloc = count;
+    if (alloc > XLSX_MAX_ROWS)
+	alloc = XLSX_MAX_ROWS;
+    rows = realloc (worksheet->rows, sizeof (xlsx_row *) * alloc);
+    if (rows == NULL)
+	return 0;
+    for (i = worksheet->rows_alloc; i < alloc; i++)
+	rows[i] = NULL;
+    worksheet->rows = rows;
+    worksheet->rows_alloc = alloc;
+    return 1;
+}
 
-	  if (i == gi.number_entry - 1)
-	      break;
-	  ret = unzGoToNextFile (uf);
-	  if (ret != UNZ_OK)
+static void
+end_xlsx_row (xlsx_worksheet * worksheet, xlsx_row * row)
+{
+/* a row has been completely parsed */
+    if (row->n_cells > 0)
+      {
+	  /* the next row will probably contain as many cells */
+	  worksheet->cells_hint = row->n_cells;
+      }
+    if (row->max_cells > row->n_cells * 2)
+      {
+	  /* releasing the unused capacity */
+	  xlsx_cell *cells;
+	  if (row->n_cells == 0)
 	    {
-		workbook->error = 1;
+		free (row->cells);
+		row->cells = NULL;
+		row->max_cells = 0;
 		return;
 	    }
+	  cells = realloc (row->cells, sizeof (xlsx_cell) * row->n_cells);
+	  if (cells != NULL)
+	    {
+		row->cells = cells;
+		row->max_cells = row->n_cells;
+	    }
       }
 }
 
 static void
-add_xlsx_row (xlsx_worksheet * worksheet, int row_no)
+add_xlsx_row (xlsx_worksheet * worksheet, int row_no, int implicit)
 {
-/* adding a row to a Worksheet */
-    xlsx_row *row = malloc (sizeof (xlsx_row));
+/* 
+ * adding a row to a Worksheet
+ *
+ * an implicit row (lacking any "r" attribute) provisionally follows
+ * the previous one, until some cell reference tells its actual number
+ */
+    xlsx_row *row;
+    freexl_projection *proj = worksheet->wbRef->projection;
+    worksheet->RowImplicit = 0;
+    if (proj != NULL && row_no > 0
+	&& (unsigned int) (row_no - 1) >= proj->end_row)
+      {
+	  /* past the requested rows: nothing else has to be parsed */
+	  worksheet->stop = 1;
+	  return;
+      }
+    if (row_no > XLSX_MAX_ROWS || !reserve_xlsx_rows (worksheet, row_no))
+      {
+	  worksheet->error = 1;
+	  return;
+      }
+    row = malloc (sizeof (xlsx_row));
     row->row_no = row_no;
     row->max_cell = -1;
-    row->first = NULL;
-    row->last = NULL;
+    row->cells = NULL;
+    row->n_cells = 0;
+    row->max_cells = 0;
+    row->sorted = 1;
     row->next = NULL;
 
+    if (worksheet->last != NULL)
+	end_xlsx_row (worksheet, worksheet->last);
     if (worksheet->first == NULL)
 	worksheet->first = row;
     if (worksheet->last != NULL)
 	worksheet->last->next = row;
     worksheet->last = row;
+    worksheet->CellPending = 0;
+    worksheet->LastColNo = -1;
+    worksheet->RowImplicit = implicit;
+}
+
+static int
+xlsx_decode_a1 (const char *ref, int len, int *row_no, int *col_no)
+{
+/*
+ * decoding an A1 cell reference (e.g. "B7" or "XFD1048576") in a single pass
+ *
+ * columns range from A (0) to XFD (16383), rows from 1 to 1048576;
+ * the row number is optional, and will be set to 0 when missing
+ */
+    int i = 0;
+    int col = 0;
+    int row = 0;
+    while (i < len)
+      {
+	  /* column letters */
+	  char c = ref[i];
+	  if (c >= 'a' && c <= 'z')
+	      c -= 'a' - 'A';
+	  if (c < 'A' || c > 'Z')
+	      break;
+	  if (i >= 3)
+	      return 0;
+	  col = (col * 26) + (c - 'A' + 1);
+	  i++;
+      }
+    if (i == 0 || col > XLSX_MAX_COLUMNS)
+	return 0;
+    while (i < len)
+      {
+	  /* row digits */
+	  char c = ref[i];
+	  if (c < '0' || c > '9')
+	      return 0;
+	  row = (row * 10) + (c - '0');
+	  if (row > XLSX_MAX_ROWS)
+	      return 0;
+	  i++;
+      }
+    *row_no = row;
+    *col_no = col - 1;
+    return 1;
+}
 
-    if (row_no > worksheet->max_row)
-	worksheet->max_row = row_no;
+static int
+next_xlsx_col_no (xlsx_worksheet * worksheet)
+{
+/* a cell lacking any "r" attribute simply follows the previous one */
+    if (worksheet->last == NULL)
+	return 0;
+    return worksheet->LastColNo + 1;
 }
 
 static int
-find_col_no (const char *sym)
+next_xlsx_row_no (xlsx_worksheet * worksheet)
 {
-/* attempting to get a column number */
-    int i;
-    int nro = 0;
-    char x1 = 'A';
-    char x2 = '\0';
-    char dummy[8];
-    char ref[128];
+/* a row lacking any "r" attribute simply follows the previous one */
+    if (worksheet->last == NULL)
+	return 1;
+    return worksheet->last->row_no + 1;
+}
 
-    strcpy (ref, sym);
-    for (i = strlen (ref); i >= 0; i--)
+static int
+set_xlsx_cell_row (xlsx_worksheet * worksheet, int row_no)
+{
+/*
+ * checking the row number of some <c r="..."> against the current row
+ *
+ * the first cell reference of an implicit row sets its actual number;
+ * as ever, any other cell simply belongs to the enclosing <row> even
+ * when its reference disagrees. returns 0 if there is no current row
+ */
+    xlsx_row *row = worksheet->last;
+    freexl_projection *proj = worksheet->wbRef->projection;
+    if (row_no == 0 || worksheet->stop)
+	return 1;		/* no row number, or nothing else to be stored */
+    if (row == NULL)
+	return 0;
+    if (!worksheet->RowImplicit)
+	return 1;
+    worksheet->RowImplicit = 0;
+    if (row_no <= row->row_no)
+	return 1;		/* rows must be in ascending order */
+    if (proj != NULL && (unsigned int) (row_no - 1) >= proj->end_row)
       {
-	  if (ref[i] >= '0' && ref[i] <= '9')
-	      ref[i] = '\0';
+	  /* past the requested rows: nothing else has to be parsed */
+	  worksheet->stop = 1;
+	  return 1;
       }
-    if (strlen (ref) == 1 || strlen (ref) == 2)
-	;
-    else
-	return -1;
-
-    while (1)
+    if (!reserve_xlsx_rows (worksheet, row_no))
       {
-	  if (x2 == '\0')
-	      sprintf (dummy, "%c", x1);
-	  else
-	      sprintf (dummy, "%c%c", x1, x2);
-	  if (strcmp (dummy, ref) == 0)
-	      return nro;
-	  nro++;
-	  if (x2 == '\0')
-	    {
-		if (x1 == 'Z')
-		  {
-		      x1 = 'A';
-		      x2 = 'A';
-		  }
-		else
-		    x1 += 1;
-	    }
-	  else
-	    {
-		if (x2 == 'Z' && x1 != 'Z')
-		  {
-		      x1 += 1;
-		      x2 = 'A';
-		  }
-		else
-		    x2 += 1;
-	    }
+	  worksheet->error = 1;
+	  return 1;
+      }
+    if (row->n_cells > 0)
+      {
+	  /* moving the cells already found into the actual row */
+	  worksheet->rows[row->row_no - 1] = NULL;
+	  worksheet->rows[row_no - 1] = row;
+	  if (row_no > worksheet->max_row)
+	      worksheet->max_row = row_no;
       }
-    return -1;
+    row->row_no = row_no;
+    return 1;
+}
+
+static int
+decode_xlsx_dimension (const char *ref, int *row_no, int *col_no)
+{
+/* decoding the bottom-right cell of some <dimension ref="A1:KZ500000"> */
+    const char *last = strchr (ref, ':');
+    if (last == NULL)
+	last = ref;
+    else
+	last++;
+    return xlsx_decode_a1 (last, strlen (last), row_no, col_no);
+}
+
+static void
+set_xlsx_dimension (xlsx_worksheet * worksheet, const char *ref)
+{
+/*
+ * using the declared <dimension ref="A1:KZ500000"> as a sizing hint
+ *
+ * the hint is only used so to pre-allocate the ROWS Array and
+ * the cells of each row; the actual dimensions will always
+ * depend on the cells really found while parsing
+ */
+    freexl_projection *proj = worksheet->wbRef->projection;
+    int row_no;
+    int col_no;
+    if (!decode_xlsx_dimension (ref, &row_no, &col_no))
+	return;
+    worksheet->declared_rows = row_no;
+    worksheet->declared_columns = col_no + 1;
+    if (proj != NULL)
+      {
+	  /* no cell outside the projection will ever be stored */
+	  if ((unsigned int) row_no > proj->end_row)
+	      row_no = proj->end_row;
+	  if (proj->columns != NULL && (unsigned int) col_no >= proj->n_columns)
+	      col_no = proj->n_columns - 1;
+      }
+    if (row_no > XLSX_MAX_ROWS_HINT)
+	row_no = XLSX_MAX_ROWS_HINT;
+    if (row_no > 0)
+      {
+	  /* just a hint: on failure the ROWS Array will grow as usual */
+	  reserve_xlsx_rows (worksheet, row_no);
+      }
+    worksheet->cells_hint = col_no + 1;
+    if (worksheet->cells_hint > XLSX_MAX_CELLS_HINT)
+	worksheet->cells_hint = XLSX_MAX_CELLS_HINT;
 }
 
 static void
@@ -422,23 +687,70 @@ add_xlsx_col (xlsx_worksheet * worksheet, int col_no, int type, int is_datetime)
 	  return;
       }
 
-    cell = malloc (sizeof (xlsx_cell));
+    if (row->n_cells >= row->max_cells)
+      {
+	  /* growing the cells array */
+	  int alloc = row->max_cells * 2;
+	  if (alloc < worksheet->cells_hint)
+	      alloc = worksheet->cells_hint;
+	  if (alloc < 4)
+	      alloc = 4;
+	  cell = realloc (row->cells, sizeof (xlsx_cell) * alloc);
+	  if (cell == NULL)
+	    {
+		worksheet->error = 1;
+		return;
+	    }
+	  row->cells = cell;
+	  row->max_cells = alloc;
+      }
+    if (row->n_cells == 0)
+      {
+	  /* the row becomes visible as soon as it contains some cell */
+	  worksheet->rows[row->row_no - 1] = row;
+      }
+    else if (col_no <= row->cells[row->n_cells - 1].col_no)
+	row->sorted = 0;
+    cell = row->cells + row->n_cells;
+    row->n_cells += 1;
     cell->col_no = col_no;
     cell->type = type;
     cell->is_datetime = is_datetime;
     cell->assigned = 0;
-    cell->next = NULL;
-
-    if (row->first == NULL)
-	row->first = cell;
-    if (row->last != NULL)
-	row->last->next = cell;
-    row->last = cell;
 
     if (col_no > row->max_cell)
 	row->max_cell = col_no;
     if (col_no > worksheet->max_cell)
 	worksheet->max_cell = col_no;
+    if (row->row_no > worksheet->max_row)
+	worksheet->max_row = row->row_no;
+}
+
+static void
+begin_xlsx_cell (xlsx_worksheet * worksheet, int col_no, int type,
+		 int is_datetime)
+{
+/* 
+ * a new cell starts here: it will be actually allocated only
+ * if some value follows, so that styled empty cells cost nothing
+ */
+    freexl_projection *proj = worksheet->wbRef->projection;
+    worksheet->LastColNo = col_no;
+    if (proj != NULL)
+      {
+	  /* any cell outside the projection is simply discarded */
+	  if (worksheet->stop || worksheet->last == NULL
+	      || !freexl_projected_cell (proj, worksheet->last->row_no - 1,
+					 col_no))
+	    {
+		worksheet->CellPending = 0;
+		return;
+	    }
+      }
+    worksheet->CellPending = 1;
+    worksheet->PendingColNo = col_no;
+    worksheet->PendingType = type;
+    worksheet->PendingIsDatetime = is_datetime;
 }
 
 static int
@@ -466,6 +778,25 @@ sheet_start_tag (void *data, const char *el, const char **attr)
     xlsx_worksheet *worksheet = (xlsx_worksheet *) data;
     if (strcmp (el, "worksheet") == 0)
 	worksheet->RowOk = 1;
+    if (strcmp (el, "dimension") == 0)
+      {
+	  if (worksheet->RowOk == 1)
+	    {
+		while (*attrib != NULL)
+		  {
+		      if ((count % 2) == 0)
+			  k = *attrib;
+		      else
+			{
+			    v = *attrib;
+			    if (strcmp (k, "ref") == 0)
+				set_xlsx_dimension (worksheet, v);
+			}
+		      attrib++;
+		      count++;
+		  }
+	    }
+      }
     if (strcmp (el, "sheetData") == 0)
       {
 	  if (worksheet->RowOk == 1)
@@ -477,7 +808,8 @@ sheet_start_tag (void *data, const char *el, const char **attr)
       {
 	  if (worksheet->RowOk == 2)
 	    {
-		int row_no = -1;
+		int row_no = next_xlsx_row_no (worksheet);
+		int implicit = 1;
 		while (*attrib != NULL)
 		  {
 		      if ((count % 2) == 0)
@@ -486,14 +818,17 @@ sheet_start_tag (void *data, const char *el, const char **attr)
 			{
 			    v = *attrib;
 			    if (strcmp (k, "r") == 0)
-				row_no = atoi (v);
+			      {
+				  row_no = atoi (v);
+				  implicit = 0;
+			      }
 			}
 		      attrib++;
 		      count++;
 		  }
 		if (row_no > 0)
 		  {
-		      add_xlsx_row (worksheet, row_no);
+		      add_xlsx_row (worksheet, row_no, implicit);
 		      worksheet->RowOk = 3;
 		  }
 		else
@@ -530,8 +865,20 @@ sheet_start_tag (void *data, const char *el, const char **attr)
 		      attrib++;
 		      count++;
 		  }
-		if (r != NULL)
-		    col_no = find_col_no (r);
+		if (r == NULL)
+		    col_no = next_xlsx_col_no (worksheet);
+		else
+		  {
+		      int row_no;
+		      if (!xlsx_decode_a1 (r, strlen (r), &row_no, &col_no))
+			  col_no = -1;
+		      else if (!set_xlsx_cell_row (worksheet, row_no))
+			{
+			    /* a cell outside of any row */
+			    worksheet->error = 1;
+			    col_no = -1;
+			}
+		  }
 		if (col_no >= 0)
 		  {
 		      int is_datetime = XLSX_DATE_NONE;
@@ -553,7 +900,7 @@ sheet_start_tag (void *data, const char *el, const char **attr)
 			    if (strcmp (t, "n") == 0)
 				type = XLSX_INTEGER;
 			}
-		      add_xlsx_col (worksheet, col_no, type, is_datetime);
+		      begin_xlsx_cell (worksheet, col_no, type, is_datetime);
 		      worksheet->ColOk = 1;
 		  }
 	    }
@@ -578,12 +925,19 @@ set_xlsx_cell_value (xlsx_worksheet * worksheet, const char *val)
 
     if (worksheet == NULL)
 	return;
-    row = worksheet->last;
-    if (row == NULL)
+    if (worksheet->CellPending == 0)
 	return;
-    cell = row->last;
-    if (cell == NULL)
+    if (worksheet->CellPending == 1)
+      {
+	  /* allocating the current cell */
+	  add_xlsx_col (worksheet, worksheet->PendingColNo,
+			worksheet->PendingType, worksheet->PendingIsDatetime);
+	  worksheet->CellPending = 2;
+      }
+    row = worksheet->last;
+    if (row == NULL || row->n_cells == 0)
 	return;
+    cell = row->cells + (row->n_cells - 1);
 
     if (cell->type == XLSX_NULL && val != NULL)
       {
@@ -598,9 +952,9 @@ set_xlsx_cell_value (xlsx_worksheet * worksheet, const char *val)
       }
     if (cell->type == XLSX_INTEGER)
       {
-	  int i_val = atoi (val);
-	  double d_val = atof (val);
-	  if (i_val != d_val)
+	  int i_val;
+	  double d_val;
+	  if (parse_xml_number (val, &i_val, &d_val) == XML_NUMBER_DOUBLE)
 	    {
 		cell->type = XLSX_DOUBLE;
 		cell->dbl_value = d_val;
@@ -659,140 +1013,814 @@ sheet_end_tag (void *data, const char *el)
       }
 }
 
-static void
-do_parse_worksheet (xlsx_worksheet * worksheet, unsigned char *buf,
-		    uint64_t size_buf)
+static int
+is_xml_space (char c)
 {
-/* parsing SheetN.xml */
-    XML_Parser parser;
-    int done = 0;
-    char *p_buf;
-    uint64_t done_buf;
-    int len;
+/* testing for XML white space */
+    if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
+	return 1;
+    return 0;
+}
 
-    parser = XML_ParserCreate (NULL);
-    if (!parser)
-      {
-	  worksheet->error = 1;
-	  return;
-      }
+static int
+is_xml_tag (const char *p, const char *end, const char *name)
+{
+/* testing if the buffer starts with the given tag name (no namespace) */
+    int len = strlen (name);
+    if (end - p <= len)
+	return 0;
+    if (memcmp (p, name, len) != 0)
+	return 0;
+    p += len;
+    if (*p == '>' || *p == '/' || is_xml_space (*p))
+	return 1;
+    return 0;
+}
 
-    XML_SetUserData (parser, worksheet);
-    XML_SetElementHandler (parser, sheet_start_tag, sheet_end_tag);
-    XML_SetCharacterDataHandler (parser, xmlCharDataSheet);
-    p_buf = (char *) buf;
-    if (size_buf < BUFSIZ)
-	len = size_buf;
-    else
-	len = BUFSIZ;
-    done_buf = 0;
+static const char *
+skip_xml_space (const char *p, const char *end)
+{
+/* skipping any white space */
+    while (p < end && is_xml_space (*p))
+	p++;
+    return p;
+}
+
+static const char *
+scan_xml_attributes (const char *p, const char *end, const char **r,
+		     int *r_len, const char **t, int *t_len, const char **s,
+		     int *s_len, int *empty)
+{
+/*
+ * scanning the attributes of a start tag up to its closing '>'
+ * the values of the "r", "t" and "s" attributes are returned
+ * by pointing directly into the buffer
+ *
+ * returns a pointer just after the tag, or NULL if the tag
+ * is incomplete or contains anything requiring the full parser
+ */
+    *r = NULL;
+    *t = NULL;
+    *s = NULL;
+    *r_len = 0;
+    *t_len = 0;
+    *s_len = 0;
+    *empty = 0;
     while (1)
       {
-	  /* reading small chunks to avoid memory overflow */
-	  if (!XML_Parse (parser, p_buf, len, done))
-	      worksheet->error = 1;
-	  /* next chunk */
-	  done_buf += len;
-	  p_buf += len;
-	  if (done_buf >= size_buf)
-	      break;
-	  if (done_buf + BUFSIZ <= size_buf)
-	      len = BUFSIZ;
-	  else
-	      len = size_buf - done_buf;
+	  const char *name;
+	  int name_len;
+	  const char *value;
+	  char quote;
+	  p = skip_xml_space (p, end);
+	  if (p >= end)
+	      return NULL;
+	  if (*p == '>')
+	      return p + 1;
+	  if (*p == '/')
+	    {
+		if (p + 1 < end && *(p + 1) == '>')
+		  {
+		      *empty = 1;
+		      return p + 2;
+		  }
+		return NULL;
+	    }
+	  /* attribute name */
+	  name = p;
+	  while (p < end && *p != '=' && *p != '>' && *p != '/'
+		 && !is_xml_space (*p))
+	      p++;
+	  name_len = p - name;
+	  p = skip_xml_space (p, end);
+	  if (p >= end || *p != '=' || name_len == 0)
+	      return NULL;
+	  p = skip_xml_space (p + 1, end);
+	  if (p >= end || (*p != '"' && *p != '\''))
+	      return NULL;
+	  /* attribute value: SIMD accelerated by most libc memchr() */
+	  quote = *p++;
+	  value = p;
+	  p = memchr (p, quote, end - p);
+	  if (p == NULL)
+	      return NULL;
+	  if (name_len == 1)
+	    {
+		if (memchr (value, '&', p - value) != NULL)
+		    return NULL;
+		if (*name == 'r')
+		  {
+		      *r = value;
+		      *r_len = p - value;
+		  }
+		if (*name == 't')
+		  {
+		      *t = value;
+		      *t_len = p - value;
+		  }
+		if (*name == 's')
+		  {
+		      *s = value;
+		      *s_len = p - value;
+		  }
+	    }
+	  p++;
       }
-    XML_ParserFree (parser);
 }
 
-static void
-do_fetch_worksheet (unzFile uf, xlsx_worksheet * worksheet)
+static int
+attribute_to_int (const char *value, int len)
 {
-/* uncompressing SheetN.xml */
-    int err;
-    char filename[256];
-    unz_file_info64 file_info;
-    uint64_t size_buf;
-    unsigned char *buf = NULL;
-    int is_open = 0;
-    uint64_t rd_cnt;
-    uint64_t unrd_cnt;
-    char *zip_entry = malloc (strlen ("xl/worksheets/sheet123456789.xml") + 1);
-    sprintf (zip_entry, "xl/worksheets/sheet%d.xml", worksheet->id);
+/* converting an attribute value into an Integer (as atoi() would do) */
+    char buf[32];
+    if (len >= (int) sizeof (buf))
+	len = sizeof (buf) - 1;
+    memcpy (buf, value, len);
+    buf[len] = '\0';
+    return atoi (buf);
+}
+
+static int
+attribute_equals (const char *value, int len, const char *str)
+{
+/* testing an attribute value against some string */
+    if ((int) strlen (str) != len)
+	return 0;
+    if (memcmp (value, str, len) == 0)
+	return 1;
+    return 0;
+}
 
-    err = unzLocateFile (uf, zip_entry, 0);
-    if (err != UNZ_OK)
+static const char *
+fast_scan_cell (xlsx_worksheet * worksheet, const char *p, const char *end)
+{
+/*
+ * fast path: parsing a <c> element (p points just after "<c")
+ * returns a pointer just after the element, or NULL on failure
+ */
+    const char *r;
+    const char *t;
+    const char *s;
+    int r_len;
+    int t_len;
+    int s_len;
+    int empty;
+    int row_no;
+    int col_no;
+    int type = XLSX_NULL;
+    int is_datetime = XLSX_DATE_NONE;
+
+    p = scan_xml_attributes (p, end, &r, &r_len, &t, &t_len, &s, &s_len,
+			     &empty);
+    if (p == NULL)
+	return NULL;
+    if (r == NULL)
+	col_no = next_xlsx_col_no (worksheet);
+    else if (!xlsx_decode_a1 (r, r_len, &row_no, &col_no))
+	return NULL;
+    else if (!set_xlsx_cell_row (worksheet, row_no))
+	return NULL;
+    if (s != NULL)
       {
-	  worksheet->error = 1;
-	  goto skip;
+	  int style = attribute_to_int (s, s_len);
+	  if (style >= 0)
+	      is_datetime = xlsx_is_datetime (worksheet->wbRef, style);
       }
-    err =
-	unzGetCurrentFileInfo64 (uf, &file_info, filename, 256, NULL, 0, NULL,
-				 0);
-    if (err != UNZ_OK)
+    if (t != NULL)
       {
-	  worksheet->error = 1;
-	  goto skip;
+	  if (attribute_equals (t, t_len, "s"))
+	      type = XLSX_STR_INDEX;
+	  if (attribute_equals (t, t_len, "n"))
+	      type = XLSX_INTEGER;
       }
-    size_buf = file_info.uncompressed_size;
-    buf = malloc (size_buf);
-    err = unzOpenCurrentFile (uf);
-    if (err != UNZ_OK)
+    begin_xlsx_cell (worksheet, col_no, type, is_datetime);
+    if (empty)
+	return p;
+
+    while (1)
       {
-	  worksheet->error = 1;
-	  goto skip;
-      }
-    is_open = 1;
-    rd_cnt = 0;
-    while (rd_cnt < size_buf)
-      {
-	  /* reading big chunks so to avoid large file issues */
-	  uint32_t max = 1000000000;	/* max chunk size */
-	  uint32_t len;
-	  unrd_cnt = size_buf - rd_cnt;
-	  if (unrd_cnt < max)
-	      len = unrd_cnt;
-	  else
-	      len = max;
-	  err = unzReadCurrentFile (uf, buf + rd_cnt, len);
-	  if (err < 0)
+	  /* looping on the cell children */
+	  p = skip_xml_space (p, end);
+	  if (p >= end || *p != '<')
+	      return NULL;
+	  if (end - p >= 4 && memcmp (p, "</c>", 4) == 0)
+	      return p + 4;
+	  if (is_xml_tag (p + 1, end, "v"))
 	    {
-		worksheet->error = 1;
-		goto skip;
+		/* the cell value */
+		const char *text = p + 3;
+		if (*(p + 2) == '/')
+		  {
+		      if (p + 3 >= end || *(p + 3) != '>')
+			  return NULL;
+		      set_xlsx_cell_value (worksheet, "");
+		      p += 4;
+		      continue;
+		  }
+		if (*(p + 2) != '>')
+		    return NULL;
+		p = memchr (text, '<', end - text);
+		if (p == NULL)
+		    return NULL;
+		if (end - p < 4 || memcmp (p, "</v>", 4) != 0)
+		    return NULL;
+		if (memchr (text, '&', p - text) != NULL)
+		    return NULL;
+		worksheet->CharDataLen = 0;
+		xmlCharDataSheet (worksheet, text, p - text);
+		xmlCharDataSheet (worksheet, "", 1);
+		set_xlsx_cell_value (worksheet, worksheet->CharData);
+		p += 4;
+		continue;
 	    }
-	  rd_cnt += len;
+	  if (is_xml_tag (p + 1, end, "f"))
+	    {
+		/* skipping a formula */
+		p = scan_xml_attributes (p + 2, end, &r, &r_len, &t, &t_len,
+					 &s, &s_len, &empty);
+		if (p == NULL)
+		    return NULL;
+		if (empty)
+		    continue;
+		p = memchr (p, '<', end - p);
+		if (p == NULL)
+		    return NULL;
+		if (end - p < 4 || memcmp (p, "</f>", 4) != 0)
+		    return NULL;
+		p += 4;
+		continue;
+	    }
+	  /* inline strings, rich text, extensions and alike */
+	  return NULL;
       }
+}
 
-/* parsing SheetN.xml */
-    do_parse_worksheet (worksheet, buf, size_buf);
+static const char *
+fast_scan_row (xlsx_worksheet * worksheet, const char *p, const char *end)
+{
+/*
+ * fast path: parsing a <row> element (p points just after "<row")
+ * returns a pointer just after the element, or NULL on failure
+ */
+    const char *r;
+    const char *t;
+    const char *s;
+    int r_len;
+    int t_len;
+    int s_len;
+    int empty;
+    int row_no = next_xlsx_row_no (worksheet);
+
+    p = scan_xml_attributes (p, end, &r, &r_len, &t, &t_len, &s, &s_len,
+			     &empty);
+    if (p == NULL)
+	return NULL;
+    if (r != NULL)
+	row_no = attribute_to_int (r, r_len);
+    if (row_no <= 0)
+	return NULL;
+    add_xlsx_row (worksheet, row_no, r == NULL);
+    if (empty)
+	return p;
 
-  skip:
-    if (zip_entry != NULL)
-	free (zip_entry);
-    if (buf != NULL)
-	free (buf);
-    if (is_open)
-	unzCloseCurrentFile (uf);
+    while (1)
+      {
+	  /* looping on the row cells */
+	  p = skip_xml_space (p, end);
+	  if (p >= end || *p != '<')
+	      return NULL;
+	  if (is_xml_tag (p + 1, end, "c"))
+	    {
+		p = fast_scan_cell (worksheet, p + 2, end);
+		if (p == NULL)
+		    return NULL;
+		continue;
+	    }
+	  if (end - p >= 5 && memcmp (p, "</row", 5) == 0)
+	    {
+		p = skip_xml_space (p + 5, end);
+		if (p >= end || *p != '>')
+		    return NULL;
+		return p + 1;
+	    }
+	  return NULL;
+      }
 }
 
 static void
-do_add_worksheet (xlsx_workbook * workbook, int id, char *name)
+discard_xlsx_rows (xlsx_worksheet * worksheet, xlsx_row * last, int max_row,
+		   int max_cell)
 {
-/* adding a Worksheet to the Workbook */
-    xlsx_worksheet *ws = malloc (sizeof (xlsx_worksheet));
-    ws->id = id;
-    ws->name = name;
-    ws->first = NULL;
-    ws->last = NULL;
-    ws->max_row = -1;
-    ws->max_cell = -1;
-    ws->rows = NULL;
-    ws->error = 0;
-    ws->CharDataStep = 65536;
-    ws->CharDataMax = ws->CharDataStep;
+/* rolling back all rows following the given one */
+    xlsx_row *row;
+    xlsx_row *row_n;
+    if (last == NULL)
+      {
+	  row = worksheet->first;
+	  worksheet->first = NULL;
+      }
+    else
+      {
+	  row = last->next;
+	  last->next = NULL;
+      }
+    while (row != NULL)
+      {
+	  row_n = row->next;
+	  if (worksheet->rows[row->row_no - 1] == row)
+	      worksheet->rows[row->row_no - 1] = NULL;
+	  destroy_row (row);
+	  row = row_n;
+      }
+    worksheet->last = last;
+    worksheet->max_row = max_row;
+    worksheet->max_cell = max_cell;
+}
+
+static uint64_t
+fast_scan_sheet_data (xlsx_worksheet * worksheet, const char *buf,
+		      uint64_t size_buf)
+{
+/*
+ * fast path for the <sheetData> content
+ *
+ * plain rows/cells/values are directly decoded without passing
+ * through Expat; the scan stops at </sheetData> or just before
+ * the first row containing anything unusual (entities, CDATA,
+ * comments, inline or rich strings, namespaces ...) so that
+ * the full XML parser can safely take care of all the remainder
+ *
+ * returns the number of bytes consumed
+ */
+    const char *p = buf;
+    const char *end = buf + size_buf;
+    while (1)
+      {
+	  const char *row;
+	  xlsx_row *last = worksheet->last;
+	  int max_row = worksheet->max_row;
+	  int max_cell = worksheet->max_cell;
+	  p = skip_xml_space (p, end);
+	  if (p >= end || *p != '<')
+	      break;
+	  if (!is_xml_tag (p + 1, end, "row"))
+	      break;
+	  row = fast_scan_row (worksheet, p + 4, end);
+	  if (row == NULL || worksheet->error)
+	    {
+		/* giving up; the full XML parser will restart from this row */
+		discard_xlsx_rows (worksheet, last, max_row, max_cell);
+		worksheet->error = 0;
+		break;
+	    }
+	  p = row;
+	  if (worksheet->stop)
+	      break;
+      }
+    return p - buf;
+}
+
+static int
+find_sheet_data (const char *buf, uint64_t size_buf, uint64_t *tag_end)
+{
+/* locating the end of the <sheetData> start tag */
+    const char *p = buf;
+    const char *end = buf + size_buf;
+    while (p < end)
+      {
+	  p = memchr (p, '<', end - p);
+	  if (p == NULL)
+	      return 0;
+	  p++;
+	  if (is_xml_tag (p, end, "sheetData"))
+	    {
+		const char *r;
+		const char *t;
+		const char *s;
+		int r_len;
+		int t_len;
+		int s_len;
+		int empty;
+		p = scan_xml_attributes (p + 9, end, &r, &r_len, &t, &t_len, &s,
+					 &s_len, &empty);
+		if (p == NULL || empty)
+		    return 0;
+		*tag_end = p - buf;
+		return 1;
+	    }
+      }
+    return 0;
+}
+
+static void
+feed_worksheet_parser (XML_Parser parser, xlsx_worksheet * worksheet,
+		       const char *buf, uint64_t size_buf)
+{
+/* feeding the XML parser */
+    int done = 0;
+    const char *p_buf = buf;
+    uint64_t done_buf;
+    int len;
+
+    if (size_buf == 0)
+	return;
+    if (size_buf < BUFSIZ)
+	len = size_buf;
+    else
+	len = BUFSIZ;
+    done_buf = 0;
+    while (1)
+      {
+	  /* reading small chunks to avoid memory overflow */
+	  if (!XML_Parse (parser, p_buf, len, done))
+	      worksheet->error = 1;
+	  if (worksheet->stop)
+	      break;		/* the requested rows are over */
+	  /* next chunk */
+	  done_buf += len;
+	  p_buf += len;
+	  if (done_buf >= size_buf)
+	      break;
+	  if (done_buf + BUFSIZ <= size_buf)
+	      len = BUFSIZ;
+	  else
+	      len = size_buf - done_buf;
+      }
+}
+
+static void
+do_parse_worksheet (xlsx_worksheet * worksheet, unsigned char *buf,
+		    uint64_t size_buf)
+{
+/* parsing SheetN.xml */
+    XML_Parser parser;
+    const char *p_buf = (const char *) buf;
+    uint64_t tag_end;
+
+    parser = XML_ParserCreate (NULL);
+    if (!parser)
+      {
+	  worksheet->error = 1;
+	  return;
+      }
+
+    XML_SetUserData (parser, worksheet);
+    XML_SetElementHandler (parser, sheet_start_tag, sheet_end_tag);
+    XML_SetCharacterDataHandler (parser, xmlCharDataSheet);
+    if (find_sheet_data (p_buf, size_buf, &tag_end))
+      {
+	  /* parsing everything up to <sheetData> */
+	  feed_worksheet_parser (parser, worksheet, p_buf, tag_end);
+	  p_buf += tag_end;
+	  size_buf -= tag_end;
+	  if (worksheet->RowOk == 2 && worksheet->error == 0
+	      && !worksheet->wbRef->xml_only)
+	    {
+		/* fast path for plain rows and cells */
+		uint64_t consumed =
+		    fast_scan_sheet_data (worksheet, p_buf, size_buf);
+		p_buf += consumed;
+		size_buf -= consumed;
+	    }
+      }
+/* the full XML parser takes care of the remainder */
+    if (!worksheet->stop)
+	feed_worksheet_parser (parser, worksheet, p_buf, size_buf);
+    XML_ParserFree (parser);
+}
+
+static uint64_t
+find_last_row_end (const char *buf, uint64_t size_buf)
+{
+/* returns the offset just after the last complete </row> (0 if none) */
+    const char *p = buf + size_buf;
+    while (p - buf >= 6)
+      {
+	  p--;
+	  if (*p == '>' && memcmp (p - 5, "</row", 5) == 0)
+	      return p + 1 - buf;
+      }
+    return 0;
+}
+
+static int
+append_pending_xml (char **pending, uint64_t * pending_len,
+		    uint64_t * pending_max, const unsigned char *chunk,
+		    unsigned int chunk_len)
+{
+/* appending a chunk to the not yet parsed XML */
+    if (*pending_len + chunk_len > *pending_max)
+      {
+	  uint64_t max = *pending_max * 2;
+	  char *ptr;
+	  if (max < *pending_len + chunk_len)
+	      max = *pending_len + chunk_len;
+	  ptr = realloc (*pending, max);
+	  if (ptr == NULL)
+	      return 0;
+	  *pending = ptr;
+	  *pending_max = max;
+      }
+    memcpy (*pending + *pending_len, chunk, chunk_len);
+    *pending_len += chunk_len;
+    return 1;
+}
+
+static void
+do_stream_worksheet (xlsx_worksheet * worksheet, zip_pipeline * pipe)
+{
+/* 
+ * parsing SheetN.xml chunk by chunk, while it's still being inflated
+ *
+ * the fast path is applied to complete rows only; any incomplete
+ * row at the end of a chunk is retained until the next one arrives
+ */
+    XML_Parser parser;
+    char *pending = NULL;
+    uint64_t pending_len = 0;
+    uint64_t pending_max = 0;
+    int phase = XLSX_STREAM_HEADER;
+    int eof = 0;
+
+    parser = XML_ParserCreate (NULL);
+    if (!parser)
+      {
+	  worksheet->error = 1;
+	  return;
+      }
+    XML_SetUserData (parser, worksheet);
+    XML_SetElementHandler (parser, sheet_start_tag, sheet_end_tag);
+    XML_SetCharacterDataHandler (parser, xmlCharDataSheet);
+
+    while (!eof && !worksheet->stop)
+      {
+	  const unsigned char *chunk;
+	  unsigned int chunk_len = 0;
+	  uint64_t consumed = 0;
+	  int ret = zip_pipeline_next (pipe, &chunk, &chunk_len);
+	  if (ret < 0)
+	    {
+		worksheet->error = 1;
+		break;
+	    }
+	  if (ret == 0)
+	      eof = 1;
+
+	  if (phase == XLSX_STREAM_XML)
+	    {
+		/* the full XML parser takes care of everything */
+		if (ret > 0)
+		  {
+		      feed_worksheet_parser (parser, worksheet,
+					     (const char *) chunk, chunk_len);
+		      zip_pipeline_release (pipe);
+		  }
+		continue;
+	    }
+	  if (ret > 0)
+	    {
+		ret =
+		    append_pending_xml (&pending, &pending_len, &pending_max,
+					chunk, chunk_len);
+		zip_pipeline_release (pipe);
+		if (!ret)
+		  {
+		      worksheet->error = 1;
+		      break;
+		  }
+	    }
+
+	  if (phase == XLSX_STREAM_HEADER)
+	    {
+		uint64_t tag_end;
+		if (find_sheet_data (pending, pending_len, &tag_end))
+		  {
+		      /* parsing everything up to <sheetData> */
+		      feed_worksheet_parser (parser, worksheet, pending,
+					     tag_end);
+		      consumed = tag_end;
+		      if (worksheet->RowOk == 2 && worksheet->error == 0
+			  && !worksheet->wbRef->xml_only)
+			  phase = XLSX_STREAM_FAST;
+		      else
+			  phase = XLSX_STREAM_XML;
+		  }
+		else if (eof || pending_len > XLSX_STREAM_MAX_HEADER)
+		    phase = XLSX_STREAM_XML;
+		else
+		    continue;	/* waiting for more data */
+	    }
+	  if (phase == XLSX_STREAM_FAST)
+	    {
+		/* fast path for plain rows and cells */
+		uint64_t limit = pending_len;
+		if (!eof)
+		    limit =
+			consumed + find_last_row_end (pending + consumed,
+						      pending_len - consumed);
+		consumed +=
+		    fast_scan_sheet_data (worksheet, pending + consumed,
+					  limit - consumed);
+		if (consumed < limit || eof)
+		    phase = XLSX_STREAM_XML;
+	    }
+	  if (phase == XLSX_STREAM_XML)
+	    {
+		feed_worksheet_parser (parser, worksheet, pending + consumed,
+				       pending_len - consumed);
+		consumed = pending_len;
+	    }
+
+	  /* retaining the unparsed tail */
+	  if (consumed > 0)
+	    {
+		memmove (pending, pending + consumed, pending_len - consumed);
+		pending_len -= consumed;
+	    }
+      }
+    if (pending != NULL)
+	free (pending);
+    XML_ParserFree (parser);
+}
+
+static void
+do_fetch_worksheet (unzFile uf, xlsx_worksheet * worksheet)
+{
+/* uncompressing SheetN.xml */
+    uint64_t size_buf;
+    unsigned char *buf = NULL;
+    zip_entry *entry;
+    char zip_entry_name[64];
+    sprintf (zip_entry_name, "xl/worksheets/sheet%d.xml", worksheet->id);
+
+    entry = zip_find_entry (worksheet->wbRef->ZipIndex, zip_entry_name);
+    if (worksheet->wbRef->xml_pipeline)
+      {
+	  /* inflating and parsing at the same time */
+	  zip_pipeline *pipe =
+	      zip_pipeline_start (uf, worksheet->wbRef->ZipIndex, entry, 1);
+	  if (pipe == NULL)
+	    {
+		worksheet->error = 1;
+		return;
+	    }
+	  do_stream_worksheet (worksheet, pipe);
+	  zip_pipeline_stop (pipe);
+	  return;
+      }
+
+    buf =
+	zip_fetch_entry (uf, worksheet->wbRef->ZipIndex, entry, &size_buf);
+    if (buf == NULL)
+      {
+	  worksheet->error = 1;
+	  return;
+      }
+
+/* parsing SheetN.xml */
+    do_parse_worksheet (worksheet, buf, size_buf);
+    free (buf);
+}
+
+static int
+peek_xlsx_entry (unzFile uf, zip_index * index, const char *name,
+		 XML_StartElementHandler handler, void *data, int *done)
+{
+/* 
+ * metadata only: parsing just the head of some XML document
+ *
+ * small chunks are inflated one at a time, until the start tag
+ * handler sets *done; returns 0 on failure
+ */
+    zip_entry *entry;
+    zip_stream *stream;
+    XML_Parser parser;
+    unsigned char buf[XLSX_PEEK_CHUNK];
+    int len;
+    int ok = 1;
+
+    entry = zip_find_entry (index, name);
+    stream = zip_open_stream (uf, index, entry);
+    if (stream == NULL)
+	return 0;
+    parser = XML_ParserCreate (NULL);
+    if (!parser)
+      {
+	  zip_close_stream (stream);
+	  return 0;
+      }
+    XML_SetUserData (parser, data);
+    XML_SetElementHandler (parser, handler, NULL);
+    while (!*done)
+      {
+	  len = zip_read_stream (stream, buf, sizeof (buf));
+	  if (len < 0)
+	      ok = 0;
+	  if (len <= 0)
+	      break;
+	  if (!XML_Parse (parser, (const char *) buf, len, 0))
+	    {
+		ok = 0;
+		break;
+	    }
+      }
+    XML_ParserFree (parser);
+    zip_close_stream (stream);
+    return ok;
+}
+
+static void
+peek_sheet_start_tag (void *data, const char *el, const char **attr)
+{
+/* metadata only: looking for the <dimension> of some Worksheet */
+    xlsx_worksheet *worksheet = (xlsx_worksheet *) data;
+    const char **attrib = attr;
+    int count = 0;
+    const char *k;
+    const char *v;
+    int row_no;
+    int col_no;
+    if (worksheet->stop)
+	return;
+    if (strcmp (el, "dimension") == 0)
+      {
+	  while (*attrib != NULL)
+	    {
+		if ((count % 2) == 0)
+		    k = *attrib;
+		else
+		  {
+		      v = *attrib;
+		      if (strcmp (k, "ref") == 0
+			  && decode_xlsx_dimension (v, &row_no, &col_no))
+			{
+			    worksheet->declared_rows = row_no;
+			    worksheet->declared_columns = col_no + 1;
+			}
+		  }
+		attrib++;
+		count++;
+	    }
+	  worksheet->stop = 1;
+      }
+    if (strcmp (el, "sheetData") == 0)
+	worksheet->stop = 1;	/* no <dimension> at all */
+}
+
+static void
+do_peek_worksheet (unzFile uf, xlsx_worksheet * worksheet)
+{
+/* metadata only: fetching the declared dimensions of SheetN.xml */
+    char zip_entry_name[64];
+    sprintf (zip_entry_name, "xl/worksheets/sheet%d.xml", worksheet->id);
+
+    if (!peek_xlsx_entry
+	(uf, worksheet->wbRef->ZipIndex, zip_entry_name, peek_sheet_start_tag,
+	 worksheet, &(worksheet->stop)))
+      {
+	  worksheet->error = 1;
+	  return;
+      }
+    if (worksheet->declared_rows >= 0)
+      {
+	  /* the declared dimensions are the only ones available */
+	  worksheet->max_row = worksheet->declared_rows;
+	  worksheet->max_cell = worksheet->declared_columns - 1;
+      }
+}
+
+static void
+do_add_worksheet (xlsx_workbook * workbook, int id, char *name)
+{
+/* adding a Worksheet to the Workbook */
+    xlsx_worksheet *ws = malloc (sizeof (xlsx_worksheet));
+    ws->id = id;
+    ws->name = name;
+    ws->first = NULL;
+    ws->last = NULL;
+    ws->max_row = -1;
+    ws->max_cell = -1;
+    ws->rows = NULL;
+    ws->rows_alloc = 0;
+    ws->cells_hint = 0;
+    ws->error = 0;
+    ws->CharDataStep = 65536;
+    ws->CharDataMax = ws->CharDataStep;
     ws->CharData = malloc (ws->CharDataStep);
     ws->CharDataLen = 0;
     ws->RowOk = 0;
     ws->ColOk = 0;
+    ws->CellValueOk = 0;
+    ws->CellPending = 0;
+    ws->PendingColNo = -1;
+    ws->PendingType = XLSX_NULL;
+    ws->PendingIsDatetime = XLSX_DATE_NONE;
+    ws->LastColNo = -1;
+    ws->RowImplicit = 0;
+    ws->stop = 0;
+    ws->declared_rows = -1;
+    ws->declared_columns = -1;
+    ws->column_stats = NULL;
     ws->wbRef = workbook;
     ws->next = NULL;
     if (workbook->first == NULL)
@@ -897,117 +1925,209 @@ do_parse_xlsx_worksheets (xlsx_workbook * workbook, unsigned char *buf,
     if (!XML_Parse (parser, (char *) buf, size_buf, done))
 	workbook->error = 1;
     XML_ParserFree (parser);
-}
-
-static void
-do_fetch_xlsx_worksheets (unzFile uf, xlsx_workbook * workbook)
-{
-/* uncompressing Workbook.xml */
-    int err;
-    char filename[256];
-    unz_file_info64 file_info;
-    uint64_t size_buf;
-    unsigned char *buf = NULL;
-    int is_open = 0;
-    uint64_t rd_cnt;
-    uint64_t unrd_cnt;
+}
+
+static void
+do_fetch_xlsx_worksheets (unzFile uf, xlsx_workbook * workbook)
+{
+/* uncompressing Workbook.xml */
+    uint64_t size_buf;
+    unsigned char *buf = NULL;
+    zip_entry *entry;
+
+    entry = zip_find_entry (workbook->ZipIndex, workbook->WorkbookZipEntry);
+    buf = zip_fetch_entry (uf, workbook->ZipIndex, entry, &size_buf);
+    if (buf == NULL)
+      {
+	  workbook->error = 1;
+	  return;
+      }
+
+/* parsing Workbook.xml */
+    do_parse_xlsx_worksheets (workbook, buf, size_buf);
+    free (buf);
+}
+
+static int
+add_shared_string (xlsx_workbook * workbook, const char *str,
+		   unsigned int len)
+{
+/* appending a SharedString to the strings pool */
+    xlsx_string *string;
+    if (workbook->strings_pool_len + len + 1 > workbook->strings_pool_max)
+      {
+	  /* we must increase the strings pool size */
+	  char *new_pool;
+	  size_t new_size = workbook->strings_pool_max;
+	  if (new_size < 65536)
+	      new_size = 65536;
+	  while (new_size < workbook->strings_pool_len + len + 1)
+	      new_size *= 2;
+	  new_pool = realloc (workbook->strings_pool, new_size);
+	  if (new_pool == NULL)
+	      return 0;
+	  workbook->strings_pool = new_pool;
+	  workbook->strings_pool_max = new_size;
+      }
+    string = workbook->strings + workbook->xml_strings;
+    string->offset = workbook->strings_pool_len;
+    string->length = len;
+    memcpy (workbook->strings_pool + workbook->strings_pool_len, str, len);
+    *(workbook->strings_pool + workbook->strings_pool_len + len) = '\0';
+    workbook->strings_pool_len += len + 1;
+    workbook->xml_strings += 1;
+    return 1;
+}
+
+static void
+parse_sst_count (xlsx_workbook * workbook, const char **attr)
+{
+/* fetching the Shared Strings count from the <sst> attributes */
+    const char **attrib = attr;
+    while (*attrib != NULL && *(attrib + 1) != NULL)
+      {
+	  /* attributes come as name/value pairs */
+	  if (strcmp (*attrib, "uniqueCount") == 0)
+	      workbook->n_strings = atoi (*(attrib + 1));
+	  attrib += 2;
+      }
+}
+
+static void
+parse_sst_tag (xlsx_workbook * workbook, const char **attr)
+{
+/* parsing the <sst> tag and allocating the SharedStrings array */
+    parse_sst_count (workbook, attr);
+    if (workbook->n_strings > 0)
+      {
+	  /* allocating the SharedStrings array */
+	  workbook->strings =
+	      malloc (sizeof (xlsx_string) * workbook->n_strings);
+	  if (workbook->strings == NULL)
+	    {
+		workbook->n_strings = 0;
+		workbook->error = 1;
+	    }
+      }
+    workbook->SharedStringsOk = 1;
+}
+
+static void
+shared_strings_start_tag (void *data, const char *el, const char **attr)
+{
+/* some generic XML tag starts here */
+    xlsx_workbook *workbook = (xlsx_workbook *) data;
+    if (strcmp (el, "sst") == 0)
+	parse_sst_tag (workbook, attr);
+    *(workbook->CharData) = '\0';
+    workbook->CharDataLen = 0;
+}
+
+static void
+shared_strings_end_tag (void *data, const char *el)
+{
+/* some generic XML tag ends here */
+    xlsx_workbook *workbook = (xlsx_workbook *) data;
+    if (strcmp (el, "sst") == 0)
+      {
+	  if (workbook->n_strings != workbook->xml_strings)
+	      workbook->error = 1;
+	  workbook->SharedStringsOk = 0;
+      }
+    if (strcmp (el, "si") == 0)
+      {
+	  if (workbook->SharedStringsOk == 0)
+	    {
+		workbook->error = 1;
+		return;
+	    }
+	  if (workbook->xml_strings < workbook->n_strings)
+	    {
+		if (!add_shared_string
+		    (workbook, workbook->CharData, workbook->CharDataLen))
+		    workbook->error = 1;
+	    }
+	  else
+	      workbook->error = 1;
+      }
+}
+
+static void
+do_parse_xlsx_shared_strings (xlsx_workbook * workbook, unsigned char *buf,
+			      uint64_t size_buf)
+{
+/* parsing SharedStrings.xml */
+    XML_Parser parser;
+    int done = 0;
+
+    parser = XML_ParserCreate (NULL);
+    if (!parser)
+      {
+	  workbook->error = 1;
+	  return;
+      }
+
+    XML_SetUserData (parser, workbook);
+    XML_SetElementHandler (parser, shared_strings_start_tag,
+			   shared_strings_end_tag);
+    XML_SetCharacterDataHandler (parser, xmlCharData);
+
+/* 
+ * presizing the strings pool: decoded strings are usually shorter than
+ * their XML source, and add_shared_string() will grow the pool anyway
+ * when they aren't (e.g. because of entities declared by some DTD)
+ */
+    workbook->strings_pool = malloc (size_buf + 1);
+    if (workbook->strings_pool != NULL)
+	workbook->strings_pool_max = size_buf + 1;
+
+    if (!XML_Parse (parser, (char *) buf, size_buf, done))
+	workbook->error = 1;
+    XML_ParserFree (parser);
 
-    err = unzLocateFile (uf, workbook->WorkbookZipEntry, 0);
-    if (err != UNZ_OK)
-      {
-	  workbook->error = 1;
-	  goto skip;
-      }
-    err =
-	unzGetCurrentFileInfo64 (uf, &file_info, filename, 256, NULL, 0, NULL,
-				 0);
-    if (err != UNZ_OK)
-      {
-	  workbook->error = 1;
-	  goto skip;
-      }
-    size_buf = file_info.uncompressed_size;
-    buf = malloc (size_buf);
-    err = unzOpenCurrentFile (uf);
-    if (err != UNZ_OK)
+    if (workbook->strings_pool_len > 0
+	&& workbook->strings_pool_len < workbook->strings_pool_max)
       {
-	  workbook->error = 1;
-	  goto skip;
-      }
-    is_open = 1;
-    rd_cnt = 0;
-    while (rd_cnt < size_buf)
-      {
-	  /* reading big chunks so to avoid large file issues */
-	  uint32_t max = 1000000000;	/* max chunk size */
-	  uint32_t len;
-	  unrd_cnt = size_buf - rd_cnt;
-	  if (unrd_cnt < max)
-	      len = unrd_cnt;
-	  else
-	      len = max;
-	  err = unzReadCurrentFile (uf, buf + rd_cnt, len);
-	  if (err < 0)
+	  /* releasing the unused space */
+	  char *pool =
+	      realloc (workbook->strings_pool, workbook->strings_pool_len);
+	  if (pool != NULL)
 	    {
-		workbook->error = 1;
-		goto skip;
+		workbook->strings_pool = pool;
+		workbook->strings_pool_max = workbook->strings_pool_len;
 	    }
-	  rd_cnt += len;
       }
-
-/* parsing Workbook.xml */
-    do_parse_xlsx_worksheets (workbook, buf, size_buf);
-
-  skip:
-    if (buf != NULL)
-	free (buf);
-    if (is_open)
-	unzCloseCurrentFile (uf);
 }
 
 static void
-shared_strings_start_tag (void *data, const char *el, const char **attr)
+lazy_index_start_tag (void *data, const char *el, const char **attr)
 {
-/* some generic XML tag starts here */
-    const char **attrib = attr;
-    int count = 0;
-    const char *k;
-    const char *v;
+/* some generic XML tag starts here (indexing SharedStrings) */
     xlsx_workbook *workbook = (xlsx_workbook *) data;
     if (strcmp (el, "sst") == 0)
+	parse_sst_tag (workbook, attr);
+    if (strcmp (el, "si") == 0)
       {
-	  while (*attrib != NULL)
+	  if (workbook->SharedStringsOk == 0)
 	    {
-		if ((count % 2) == 0)
-		    k = *attrib;
-		else
-		  {
-		      v = *attrib;
-		      if (strcmp (k, "uniqueCount") == 0)
-			  workbook->n_strings = atoi (v);
-		  }
-		attrib++;
-		count++;
+		workbook->error = 1;
+		return;
 	    }
-	  if (workbook->n_strings > 0)
+	  if (workbook->xml_strings < workbook->n_strings)
 	    {
-		/* allocating the SharedStrings array */
-		int i;
-		workbook->strings =
-		    malloc (sizeof (char *) * workbook->n_strings);
-		for (i = 0; i < workbook->n_strings; i++)
-		    *(workbook->strings + i) = NULL;
+		/* recording where this string starts */
+		XML_Parser parser = workbook->lazy_strings->parser;
+		xlsx_string *string = workbook->strings + workbook->xml_strings;
+		string->offset = XML_GetCurrentByteIndex (parser);
+		string->length = 0;
 	    }
-	  workbook->SharedStringsOk = 1;
       }
-    *(workbook->CharData) = '\0';
-    workbook->CharDataLen = 0;
 }
 
 static void
-shared_strings_end_tag (void *data, const char *el)
+lazy_index_end_tag (void *data, const char *el)
 {
-/* some generic XML tag ends here */
+/* some generic XML tag ends here (indexing SharedStrings) */
     xlsx_workbook *workbook = (xlsx_workbook *) data;
     if (strcmp (el, "sst") == 0)
       {
@@ -1024,12 +2144,13 @@ shared_strings_end_tag (void *data, const char *el)
 	    }
 	  if (workbook->xml_strings < workbook->n_strings)
 	    {
-		char *in;
-		*(workbook->CharData + workbook->CharDataLen) = '\0';
-		in = workbook->CharData;
-		*(workbook->strings + workbook->xml_strings) =
-		    malloc (strlen (in) + 1);
-		strcpy (*(workbook->strings + workbook->xml_strings), in);
+		/* recording where this string ends */
+		XML_Parser parser = workbook->lazy_strings->parser;
+		xlsx_string *string = workbook->strings + workbook->xml_strings;
+		uint64_t end =
+		    XML_GetCurrentByteIndex (parser) +
+		    XML_GetCurrentByteCount (parser);
+		string->length = end - string->offset;
 		workbook->xml_strings += 1;
 	    }
 	  else
@@ -1038,93 +2159,449 @@ shared_strings_end_tag (void *data, const char *el)
 }
 
 static void
-do_parse_xlsx_shared_strings (xlsx_workbook * workbook, unsigned char *buf,
-			      uint64_t size_buf)
+lazy_index_xml_decl (void *data, const XML_Char * version,
+		     const XML_Char * encoding, int standalone)
 {
-/* parsing SharedStrings.xml */
+/* the XML declaration: recording the document encoding */
+    xlsx_workbook *workbook = (xlsx_workbook *) data;
+    xlsx_lazy_strings *lazy = workbook->lazy_strings;
+    (void) version;
+    (void) standalone;
+    if (encoding == NULL || lazy->encoding != NULL)
+	return;
+    lazy->encoding = malloc (strlen (encoding) + 1);
+    if (lazy->encoding != NULL)
+	strcpy (lazy->encoding, encoding);
+}
+
+static void
+detect_lazy_encoding (xlsx_lazy_strings * lazy, const unsigned char *buf,
+		      unsigned int len)
+{
+/* 
+ * detecting a UTF-16 document from its very first bytes
+ *
+ * each <si> span will then be decoded without the document prologue,
+ * so the byte order must be explicitly known
+ */
+    const char *encoding = NULL;
+    if (len < 2)
+	return;
+    if ((buf[0] == 0xff && buf[1] == 0xfe) || (buf[0] == '<' && buf[1] == 0))
+	encoding = "UTF-16LE";
+    if ((buf[0] == 0xfe && buf[1] == 0xff) || (buf[0] == 0 && buf[1] == '<'))
+	encoding = "UTF-16BE";
+    if (encoding == NULL)
+	return;
+    lazy->encoding = malloc (strlen (encoding) + 1);
+    if (lazy->encoding != NULL)
+	strcpy (lazy->encoding, encoding);
+}
+
+static int
+lazy_index_chunk (void *ctx, const unsigned char *buf, unsigned int len)
+{
+/* indexing the next inflated chunk of SharedStrings.xml */
+    xlsx_workbook *workbook = (xlsx_workbook *) ctx;
+    xlsx_lazy_strings *lazy = workbook->lazy_strings;
+    if (XML_GetCurrentByteIndex (lazy->parser) <= 0 && lazy->encoding == NULL)
+	detect_lazy_encoding (lazy, buf, len);
+    if (lazy->tmp != NULL)
+      {
+	  /* spilling the inflated XML into the temporary file */
+	  if (fwrite (buf, 1, len, lazy->tmp) != len)
+	      return 0;
+      }
+    if (!XML_Parse (lazy->parser, (const char *) buf, len, 0))
+	return 0;
+    return !workbook->error;
+}
+
+static int
+stream_lazy_shared_strings (unzFile uf, xlsx_workbook * workbook,
+			    zip_entry * entry)
+{
+/* indexing SharedStrings.xml by sequentially inflating it */
+    zip_stream *stream;
+    unsigned char *buf;
+    int ok = 1;
+
+    buf = malloc (XLSX_LAZY_CHUNK);
+    if (buf == NULL)
+	return 0;
+    stream = zip_open_stream (uf, workbook->ZipIndex, entry);
+    if (stream == NULL)
+      {
+	  free (buf);
+	  return 0;
+      }
+    while (ok)
+      {
+	  int len = zip_read_stream (stream, buf, XLSX_LAZY_CHUNK);
+	  if (len == 0)
+	      break;		/* EOF */
+	  if (len < 0 || !lazy_index_chunk (workbook, buf, len))
+	      ok = 0;
+      }
+    zip_close_stream (stream);
+    free (buf);
+    return ok;
+}
+
+static void
+do_index_xlsx_shared_strings (unzFile uf, xlsx_workbook * workbook,
+			      zip_entry * entry)
+{
+/* 
+ * indexing SharedStrings.xml (lazy mode)
+ *
+ * only the byte span of each <si> is recorded while inflating the
+ * XML chunk by chunk; strings will then be decoded on demand by
+ * xlsx_get_lazy_string(), inflating just the few bytes required
+ * from the compressed data (kept in memory) or reading them back
+ * from a temporary file. So the whole inflated XML is never kept.
+ */
+    xlsx_lazy_strings *lazy;
     XML_Parser parser;
-    int done = 0;
+    int ok;
 
-    parser = XML_ParserCreate (NULL);
-    if (!parser)
+    lazy = alloc_lazy_strings (workbook->strings_cache);
+    if (lazy == NULL)
       {
 	  workbook->error = 1;
+	  workbook->no_memory = 1;
 	  return;
       }
-
+    workbook->lazy_strings = lazy;
+    parser = lazy->parser;
     XML_SetUserData (parser, workbook);
-    XML_SetElementHandler (parser, shared_strings_start_tag,
-			   shared_strings_end_tag);
-    XML_SetCharacterDataHandler (parser, xmlCharData);
-    if (!XML_Parse (parser, (char *) buf, size_buf, done))
+    XML_SetElementHandler (parser, lazy_index_start_tag, lazy_index_end_tag);
+    XML_SetXmlDeclHandler (parser, lazy_index_xml_decl);
+
+    if (workbook->strings_mode == FREEXL_XLSX_STRINGS_LAZY)
+	lazy->zdata = zip_random_open (workbook->ZipIndex, entry);
+    if (lazy->zdata != NULL)
+	ok = zip_random_scan (lazy->zdata, lazy_index_chunk, workbook);
+    else
+      {
+	  /* 
+	   * temporary file mode, or some entry that can't be randomly
+	   * accessed: spilling the inflated XML into a temporary file
+	   */
+	  lazy->tmp = tmpfile ();
+	  if (lazy->tmp == NULL)
+	      ok = 0;
+	  else
+	      ok = stream_lazy_shared_strings (uf, workbook, entry);
+      }
+    if (ok && !XML_Parse (parser, NULL, 0, 1))
+	ok = 0;
+    if (!ok)
 	workbook->error = 1;
-    XML_ParserFree (parser);
+}
+
+static void
+lazy_decode_start_tag (void *data, const char *el, const char **attr)
+{
+/* some generic XML tag starts here (decoding a SharedString) */
+    xlsx_lazy_strings *lazy = (xlsx_lazy_strings *) data;
+    (void) el;			/* any tag simply discards the pending text */
+    (void) attr;
+    lazy->text_len = 0;
+}
+
+static void
+lazy_decode_end_tag (void *data, const char *el)
+{
+/* some generic XML tag ends here (decoding a SharedString) */
+    xlsx_lazy_strings *lazy = (xlsx_lazy_strings *) data;
+    if (strcmp (el, "si") == 0)
+	lazy->text_ok = 1;
+}
+
+static void
+lazy_decode_char_data (void *data, const XML_Char * s, int len)
+{
+/* parsing XML char data (decoding a SharedString) */
+    xlsx_lazy_strings *lazy = (xlsx_lazy_strings *) data;
+    if (lazy->text_len + len + 1 > lazy->text_max)
+      {
+	  /* we must increase the text buffer size */
+	  char *new_buf;
+	  unsigned int new_size = lazy->text_max;
+	  while (new_size < lazy->text_len + len + 1)
+	      new_size *= 2;
+	  new_buf = realloc (lazy->text, new_size);
+	  if (new_buf == NULL)
+	      return;
+	  lazy->text = new_buf;
+	  lazy->text_max = new_size;
+      }
+    memcpy (lazy->text + lazy->text_len, s, len);
+    lazy->text_len += len;
+}
+
+static char *
+lazy_decode_string (xlsx_workbook * workbook, int string_index)
+{
+/* decoding a single SharedString */
+    xlsx_lazy_strings *lazy = workbook->lazy_strings;
+    xlsx_string *string = workbook->strings + string_index;
+    XML_Parser parser = lazy->parser;
+    char *text;
+
+    if (string->length > lazy->buf_max)
+      {
+	  char *new_buf = realloc (lazy->buf, string->length);
+	  if (new_buf == NULL)
+	      return NULL;
+	  lazy->buf = new_buf;
+	  lazy->buf_max = string->length;
+      }
+    if (lazy->zdata != NULL)
+      {
+	  /* inflating the <si> span from the compressed data */
+	  if (!zip_random_read
+	      (lazy->zdata, string->offset, (unsigned char *) (lazy->buf),
+	       string->length))
+	      return NULL;
+      }
+    else
+      {
+	  /* reading from the temporary file */
+	  if (fseek (lazy->tmp, string->offset, SEEK_SET) != 0)
+	      return NULL;
+	  if (fread (lazy->buf, 1, string->length, lazy->tmp) !=
+	      string->length)
+	      return NULL;
+      }
+
+/* the <si> span has no prologue: the document encoding must be set */
+    XML_ParserReset (parser, lazy->encoding);
+    XML_SetUserData (parser, lazy);
+    XML_SetElementHandler (parser, lazy_decode_start_tag,
+			   lazy_decode_end_tag);
+    XML_SetCharacterDataHandler (parser, lazy_decode_char_data);
+    lazy->text_len = 0;
+    lazy->text_ok = 0;
+    if (!XML_Parse (parser, lazy->buf, string->length, 1))
+	return NULL;
+    if (!lazy->text_ok)
+	return NULL;
+
+    text = malloc (lazy->text_len + 1);
+    if (text == NULL)
+	return NULL;
+    memcpy (text, lazy->text, lazy->text_len);
+    *(text + lazy->text_len) = '\0';
+    return text;
+}
+
+static const char *
+get_lazy_string (xlsx_workbook * workbook, int string_index)
+{
+/* returning a SharedString, decoding it if not already cached */
+    xlsx_lazy_strings *lazy = workbook->lazy_strings;
+    xlsx_lazy_entry *entry;
+    int bucket;
+    char *text;
+
+    if (lazy == NULL || workbook->strings == NULL)
+	return NULL;
+    if (string_index < 0 || string_index >= workbook->xml_strings)
+	return NULL;
+
+    bucket = string_index & (lazy->hash_size - 1);
+    entry = *(lazy->hash + bucket);
+    while (entry != NULL)
+      {
+	  if (entry->index == string_index)
+	    {
+		/* cache hit: becoming the most recently used */
+		if (entry != lazy->first)
+		  {
+		      entry->prev->next = entry->next;
+		      if (entry->next != NULL)
+			  entry->next->prev = entry->prev;
+		      else
+			  lazy->last = entry->prev;
+		      entry->prev = NULL;
+		      entry->next = lazy->first;
+		      lazy->first->prev = entry;
+		      lazy->first = entry;
+		  }
+		return entry->text;
+	    }
+	  entry = entry->hash_next;
+      }
+
+    text = lazy_decode_string (workbook, string_index);
+    if (text == NULL)
+	return NULL;
+
+    if (lazy->count >= lazy->capacity)
+      {
+	  /* recycling the least recently used entry */
+	  xlsx_lazy_entry **prev;
+	  entry = lazy->last;
+	  lazy->last = entry->prev;
+	  if (lazy->last != NULL)
+	      lazy->last->next = NULL;
+	  else
+	      lazy->first = NULL;
+	  prev = lazy->hash + (entry->index & (lazy->hash_size - 1));
+	  while (*prev != entry)
+	      prev = &((*prev)->hash_next);
+	  *prev = entry->hash_next;
+	  free (entry->text);
+      }
+    else
+      {
+	  entry = malloc (sizeof (xlsx_lazy_entry));
+	  if (entry == NULL)
+	    {
+		free (text);
+		return NULL;
+	    }
+	  lazy->count += 1;
+      }
+    entry->index = string_index;
+    entry->text = text;
+    entry->prev = NULL;
+    entry->next = lazy->first;
+    if (lazy->first != NULL)
+	lazy->first->prev = entry;
+    lazy->first = entry;
+    if (lazy->last == NULL)
+	lazy->last = entry;
+    entry->hash_next = *(lazy->hash + bucket);
+    *(lazy->hash + bucket) = entry;
+    return entry->text;
+}
+
+static void
+lock_lazy_strings (xlsx_lazy_strings * lazy)
+{
+/* serializing any access to the decoder and to the LRU list */
+#ifndef OMIT_THREADS		/* only if multithreading is enabled */
+    if (lazy->mutex != NULL)
+	freexl_mutex_lock (lazy->mutex);
+#else
+    (void) lazy;
+#endif
+}
+
+static void
+unlock_lazy_strings (xlsx_lazy_strings * lazy)
+{
+/* releasing the decoder and the LRU list */
+#ifndef OMIT_THREADS		/* only if multithreading is enabled */
+    if (lazy->mutex != NULL)
+	freexl_mutex_unlock (lazy->mutex);
+#else
+    (void) lazy;
+#endif
+}
+
+const char *
+xlsx_get_lazy_string (xlsx_workbook * workbook, int string_index)
+{
+/* 
+ * returning a SharedString (owned by the cache)
+ *
+ * the returned pointer is valid until the entry gets recycled
+ */
+    const char *text;
+    if (workbook->lazy_strings == NULL)
+	return NULL;
+    lock_lazy_strings (workbook->lazy_strings);
+    text = get_lazy_string (workbook, string_index);
+    unlock_lazy_strings (workbook->lazy_strings);
+    return text;
+}
+
+char *
+xlsx_copy_lazy_string (xlsx_workbook * workbook, int string_index)
+{
+/* 
+ * returning a private copy of some SharedString
+ *
+ * safe even when many cursors share the same cache
+ */
+    const char *text;
+    char *copy = NULL;
+    if (workbook->lazy_strings == NULL)
+	return NULL;
+    lock_lazy_strings (workbook->lazy_strings);
+    text = get_lazy_string (workbook, string_index);
+    if (text != NULL)
+      {
+	  int len = strlen (text);
+	  copy = malloc (len + 1);
+	  if (copy != NULL)
+	      memcpy (copy, text, len + 1);
+      }
+    unlock_lazy_strings (workbook->lazy_strings);
+    return copy;
+}
+
+static void
+peek_sst_start_tag (void *data, const char *el, const char **attr)
+{
+/* metadata only: fetching the Shared Strings count from the <sst> tag */
+    xlsx_workbook *workbook = (xlsx_workbook *) data;
+    if (workbook->SharedStringsOk)
+	return;
+    if (strcmp (el, "sst") == 0)
+	parse_sst_count (workbook, attr);
+    /* the root element is the only one of interest */
+    workbook->SharedStringsOk = 1;
+}
+
+static void
+do_peek_xlsx_shared_strings (unzFile uf, xlsx_workbook * workbook)
+{
+/* metadata only: fetching the Shared Strings count */
+    if (!peek_xlsx_entry
+	(uf, workbook->ZipIndex, workbook->SharedStringsZipEntry,
+	 peek_sst_start_tag, workbook, &(workbook->SharedStringsOk)))
+	workbook->error = 1;
+    workbook->SharedStringsOk = 0;
+    if (workbook->n_strings < 0)
+	workbook->n_strings = 0;
 }
 
 static void
 do_fetch_xlsx_shared_strings (unzFile uf, xlsx_workbook * workbook)
 {
 /* uncompressing SharedStrings.xml */
-    int err;
-    char filename[256];
-    unz_file_info64 file_info;
     uint64_t size_buf;
     unsigned char *buf = NULL;
-    int is_open = 0;
-    uint64_t rd_cnt;
-    uint64_t unrd_cnt;
+    zip_entry *entry;
 
-    err = unzLocateFile (uf, workbook->SharedStringsZipEntry, 0);
-    if (err != UNZ_OK)
+    entry =
+	zip_find_entry (workbook->ZipIndex, workbook->SharedStringsZipEntry);
+    if (entry == NULL)
       {
 	  workbook->error = 1;
-	  goto skip;
+	  return;
       }
-    err =
-	unzGetCurrentFileInfo64 (uf, &file_info, filename, 256, NULL, 0, NULL,
-				 0);
-    if (err != UNZ_OK)
+    if (workbook->strings_mode != FREEXL_XLSX_STRINGS_EAGER)
       {
-	  workbook->error = 1;
-	  goto skip;
+	  /* indexing SharedStrings.xml */
+	  do_index_xlsx_shared_strings (uf, workbook, entry);
+	  return;
       }
-    size_buf = file_info.uncompressed_size;
-    buf = malloc (size_buf);
-    err = unzOpenCurrentFile (uf);
-    if (err != UNZ_OK)
+
+    buf = zip_fetch_entry (uf, workbook->ZipIndex, entry, &size_buf);
+    if (buf == NULL)
       {
 	  workbook->error = 1;
-	  goto skip;
-      }
-    is_open = 1;
-    rd_cnt = 0;
-    while (rd_cnt < size_buf)
-      {
-	  /* reading big chunks so to avoid large file issues */
-	  uint32_t max = 1000000000;	/* max chunk size */
-	  uint32_t len;
-	  unrd_cnt = size_buf - rd_cnt;
-	  if (unrd_cnt < max)
-	      len = unrd_cnt;
-	  else
-	      len = max;
-	  err = unzReadCurrentFile (uf, buf + rd_cnt, len);
-	  if (err < 0)
-	    {
-		workbook->error = 1;
-		goto skip;
-	    }
-	  rd_cnt += len;
+	  return;
       }
-
 /* parsing SharedStrings.xml */
     do_parse_xlsx_shared_strings (workbook, buf, size_buf);
-
-  skip:
-    if (buf != NULL)
-	free (buf);
-    if (is_open)
-	unzCloseCurrentFile (uf);
+    free (buf);
 }
 
 static int
@@ -1379,70 +2856,26 @@ static void
 do_fetch_xlsx_styles (unzFile uf, xlsx_workbook * workbook)
 {
 /* uncompressing Styles.xml */
-    int err;
-    char filename[256];
-    unz_file_info64 file_info;
     uint64_t size_buf;
     unsigned char *buf = NULL;
-    int is_open = 0;
-    uint64_t rd_cnt;
-    uint64_t unrd_cnt;
+    zip_entry *entry;
 
-    err = unzLocateFile (uf, workbook->StylesZipEntry, 0);
-    if (err != UNZ_OK)
-      {
-	  workbook->error = 1;
-	  goto skip;
-      }
-    err =
-	unzGetCurrentFileInfo64 (uf, &file_info, filename, 256, NULL, 0, NULL,
-				 0);
-    if (err != UNZ_OK)
-      {
-	  workbook->error = 1;
-	  goto skip;
-      }
-    size_buf = file_info.uncompressed_size;
-    buf = malloc (size_buf);
-    err = unzOpenCurrentFile (uf);
-    if (err != UNZ_OK)
+    entry = zip_find_entry (workbook->ZipIndex, workbook->StylesZipEntry);
+    buf = zip_fetch_entry (uf, workbook->ZipIndex, entry, &size_buf);
+    if (buf == NULL)
       {
 	  workbook->error = 1;
-	  goto skip;
-      }
-    is_open = 1;
-    rd_cnt = 0;
-    while (rd_cnt < size_buf)
-      {
-	  /* reading big chunks so to avoid large file issues */
-	  uint32_t max = 1000000000;	/* max chunk size */
-	  uint32_t len;
-	  unrd_cnt = size_buf - rd_cnt;
-	  if (unrd_cnt < max)
-	      len = unrd_cnt;
-	  else
-	      len = max;
-	  err = unzReadCurrentFile (uf, buf + rd_cnt, len);
-	  if (err < 0)
-	    {
-		workbook->error = 1;
-		goto skip;
-	    }
-	  rd_cnt += len;
+	  return;
       }
 
 /* parsing Syles.xml */
     do_parse_xlsx_styles (workbook, buf, size_buf);
-
-  skip:
-    if (buf != NULL)
-	free (buf);
-    if (is_open)
-	unzCloseCurrentFile (uf);
+    free (buf);
 }
 
-FREEXL_DECLARE int
-freexl_open_xlsx (const char *path, const void **xl_handle)
+static int
+common_open_xlsx (const char *path, const FreeXL_OpenOptions * options,
+		  int info, const void **xl_handle)
 {
 /* opening and initializing the Workbook - XLSX format expected */
     xlsx_workbook *workbook;
@@ -1450,6 +2883,7 @@ freexl_open_xlsx (const char *path, const void **xl_handle)
     freexl_handle **handle = (freexl_handle **) xl_handle;
     unzFile uf = NULL;
     int retval = 0;
+    int index;
 
 /* opening the XLSX Spreadsheet as a Zipfile */
     uf = unzOpen64 (path);
@@ -1465,9 +2899,30 @@ freexl_open_xlsx (const char *path, const void **xl_handle)
 /* allocating the Workbook struct */
     workbook = alloc_workbook ();
     if (!workbook)
-	return FREEXL_INSUFFICIENT_MEMORY;
+      {
+	  retval = FREEXL_INSUFFICIENT_MEMORY;
+	  goto stop;
+      }
+    if (options != NULL)
+      {
+	  /* applying the options */
+	  if (options->xlsx_strings_mode == FREEXL_XLSX_STRINGS_LAZY
+	      || options->xlsx_strings_mode ==
+	      FREEXL_XLSX_STRINGS_LAZY_TMPFILE)
+	      workbook->strings_mode = options->xlsx_strings_mode;
+	  workbook->strings_cache = options->xlsx_strings_cache;
+	  workbook->xml_pipeline = options->xml_pipeline;
+	  workbook->xml_only = options->xlsx_xml_only;
+      }
+    workbook->info = info;
+    if (!freexl_create_projection (options, &(workbook->projection)))
+      {
+	  destroy_workbook (workbook);
+	  retval = FREEXL_INSUFFICIENT_MEMORY;
+	  goto stop;
+      }
 /* parsing the Zipfile directory */
-    do_list_zipfile_dir (uf, workbook);
+    do_list_zipfile_dir (path, uf, workbook);
     if (workbook->error)
       {
 	  destroy_workbook (workbook);
@@ -1478,15 +2933,21 @@ freexl_open_xlsx (const char *path, const void **xl_handle)
     if (workbook->SharedStringsZipEntry != NULL)
       {
 	  /* parsing SharedStrings.xml */
-	  do_fetch_xlsx_shared_strings (uf, workbook);
+	  if (info)
+	      do_peek_xlsx_shared_strings (uf, workbook);
+	  else
+	      do_fetch_xlsx_shared_strings (uf, workbook);
 	  if (workbook->error)
 	    {
+		if (workbook->no_memory)
+		    retval = FREEXL_INSUFFICIENT_MEMORY;
+		else
+		    retval = FREEXL_INVALID_XLSX;
 		destroy_workbook (workbook);
-		retval = FREEXL_INVALID_XLSX;
 		goto stop;
 	    }
       }
-    if (workbook->StylesZipEntry != NULL)
+    if (workbook->StylesZipEntry != NULL && !info)
       {
 	  /* parsing Styles.xml */
 	  do_fetch_xlsx_styles (uf, workbook);
@@ -1509,10 +2970,20 @@ freexl_open_xlsx (const char *path, const void **xl_handle)
 	    }
       }
     worksheet = workbook->first;
+    index = 0;
     while (worksheet != NULL)
       {
 	  /* parsing all Worksheets */
-	  do_fetch_worksheet (uf, worksheet);
+	  if (!freexl_projected_sheet (workbook->projection, index++))
+	    {
+		/* a Worksheet not to be loaded: it will stay empty */
+		worksheet = worksheet->next;
+		continue;
+	    }
+	  if (info)
+	      do_peek_worksheet (uf, worksheet);
+	  else
+	      do_fetch_worksheet (uf, worksheet);
 	  if (worksheet->error)
 	    {
 		destroy_workbook (workbook);
@@ -1521,82 +2992,45 @@ freexl_open_xlsx (const char *path, const void **xl_handle)
 	    }
 	  worksheet = worksheet->next;
       }
-    if (workbook->error == 0)
-      {
-	  /* adjusting all Worksheets */
-	  xlsx_worksheet *ws = workbook->first;
-	  while (ws != NULL)
-	    {
-		int max_col_no = -1;
-		xlsx_cell *cell;
-		xlsx_row *row = ws->first;
-		ws->max_row = -1;
-		ws->max_cell = -1;
-		while (row != NULL)
-		  {
-		      max_col_no = -1;
-		      cell = row->first;
-		      row->max_cell = -1;
-		      while (cell != NULL)
-			{
-			    if (cell->assigned && cell->type != XLSX_NULL)
-			      {
-				  if (cell->col_no > max_col_no)
-				      max_col_no = cell->col_no;
-			      }
-			    cell = cell->next;
-			}
-		      if (max_col_no >= 0)
-			{
-			    row->max_cell = max_col_no;
-			    if (row->row_no > ws->max_row)
-				ws->max_row = row->row_no;
-			    if (row->max_cell > ws->max_cell)
-				ws->max_cell = row->max_cell;
-			}
-		      row = row->next;
-		  }
-		if (ws->max_row > 0)
-		  {
-		      /* creating and populating the ROWS Array */
-		      int i;
-		      ws->rows =
-			  malloc (sizeof (ods_row *) * (ws->max_row + 1));
-		      for (i = 0; i < ws->max_row; i++)
-			  *(ws->rows + i) = NULL;
-		      row = ws->first;
-		      while (row != NULL)
-			{
-			    max_col_no = -1;
-			    cell = row->first;
-			    while (cell != NULL)
-			      {
-				  if (cell->assigned && cell->type != ODS_VOID)
-				    {
-					if (cell->col_no > max_col_no)
-					    max_col_no = cell->col_no;
-				    }
-				  cell = cell->next;
-			      }
-			    if (max_col_no >= 0)
-			      {
-				  if (row->row_no > 0)
-				      *(ws->rows + row->row_no - 1) = row;
-			      }
-			    row = row->next;
-			}
-		  }
-		ws = ws->next;
-	    }
-      }
     (*handle)->xlsx_handle = workbook;
+/* the Zipfile directory index is no longer required */
+    zip_destroy_index (workbook->ZipIndex);
+    workbook->ZipIndex = NULL;
 
 /* closing the Zipfile and quitting */
   stop:
     unzClose (uf);
+    if (retval != FREEXL_OK)
+      {
+	  /* no Workbook is going to be returned */
+	  free (*handle);
+	  *handle = NULL;
+      }
     return retval;
 }
 
+FREEXL_DECLARE int
+freexl_open_xlsx (const char *path, const void **xl_handle)
+{
+/* opening and initializing the Workbook - XLSX format expected */
+    return common_open_xlsx (path, NULL, 0, xl_handle);
+}
+
+FREEXL_DECLARE int
+freexl_open_xlsx_ex (const char *path, const FreeXL_OpenOptions * options,
+		     const void **xl_handle)
+{
+/* opening and initializing the Workbook - XLSX format expected */
+    return common_open_xlsx (path, options, 0, xl_handle);
+}
+
+FREEXL_DECLARE int
+freexl_open_xlsx_info (const char *path, const void **xl_handle)
+{
+/* opening and initializing the Workbook (only for Info) - XLSX format */
+    return common_open_xlsx (path, NULL, 1, xl_handle);
+}
+
 FREEXL_DECLARE int
 freexl_close_xlsx (const void *xl_handle)
 {
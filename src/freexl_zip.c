@@ -0,0 +1,1487 @@
+/* 
+/ freexl_zip.c
+/
+/ FreeXL implementation (Zipfile directory index)
+/
+/ ------------------------------------------------------------------------------
+/ 
+/ Version: MPL 1.1/GPL 2.0/LGPL 2.1
+/ 
+/ The contents of this file are subject to the Mozilla Public License Version
+/ 1.1 (the "License"); you may not use this file except in compliance with
+/ the License. You may obtain a copy of the License at
+/ http://www.mozilla.org/MPL/
+/ 
+/ Software distributed under the License is distributed on an "AS IS" basis,
+/ WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+/ for the specific language governing rights and limitations under the
+/ License.
+/
+/ The Original Code is the FreeXL library
+/
+/ The Initial Developer of the Original Code is Alessandro Furieri
+/ 
+/ Portions created by the Initial Developer are Copyright (C) 2021
+/ the Initial Developer. All Rights Reserved.
+/ 
+/ Contributor(s):
+/ 
+/ Alternatively, the contents of this file may be used under the terms of
+/ either the GNU General Public License Version 2 or later (the "GPL"), or
+/ the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+/ in which case the provisions of the GPL or the LGPL are applicable instead
+/ of those above. If you wish to allow use of your version of this file only
+/ under the terms of either the GPL or the LGPL, and not to allow others to
+/ use your version of this file under the terms of the MPL, indicate your
+/ decision by deleting the provisions above and replace them with the notice
+/ and other provisions required by the GPL or the LGPL. If you do not delete
+/ the provisions above, a recipient may use your version of this file under
+/ the terms of any one of the MPL, the GPL or the LGPL.
+/ 
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+
+#include <iconv.h>		/* iconv_t is used by freexl_internals.h */
+
+#if defined(_WIN32) && !defined(__MINGW32__)
+#include "config-msvc.h"
+#else
+#include "config.h"
+#endif
+
+
+#ifndef OMIT_XMLDOC		/* only if XML support is enabled */
+
+#include "freexl.h"
+#include "freexl_internals.h"
+
+#include <minizip/unzip.h>
+#include <zlib.h>
+
+#ifdef ENABLE_LIBDEFLATE
+#include <libdeflate.h>
+#endif
+
+#ifdef _WIN32
+#define strcasecmp	_stricmp
+#endif /* not WIN32 */
+
+#if defined(_WIN32) && !defined(__MINGW32__)
+#define zip_fseek	_fseeki64
+#define zip_ftell	_ftelli64
+#else
+#define zip_fseek	fseeko
+#define zip_ftell	ftello
+#endif
+
+#define ZIP_SIG_LOCAL		0x04034b50
+#define ZIP_SIG_CENTRAL		0x02014b50
+#define ZIP_SIG_EOCD		0x06054b50
+#define ZIP_SIG_EOCD64_LOC	0x07064b50
+#define ZIP_SIG_EOCD64		0x06064b50
+
+#define ZIP_METHOD_STORED	0
+#define ZIP_METHOD_DEFLATED	8
+
+#define ZIP_IO_CHUNK		65536	/* compressed data read size */
+#define ZIP_MAX_DIRECTORY	0x40000000	/* 1 GB */
+#define ZIP_MAX_READ		0x40000000	/* 1 GB */
+
+#define ZIP_PIPELINE_SLOTS	4
+#define ZIP_PIPELINE_SLOT_SIZE	(1024 * 1024)
+
+#define ZIP_WINDOW_SIZE		32768	/* deflate history window */
+#define ZIP_ACCESS_SPAN		(1024 * 1024)	/* between two access points */
+#define ZIP_MAX_FEED		0x40000000	/* compressed bytes per feed */
+
+static unsigned int
+zip_get_u16 (const unsigned char *p)
+{
+/* decoding a little-endian 16 bit value */
+    return (unsigned int) p[0] | ((unsigned int) p[1] << 8);
+}
+
+static unsigned long
+zip_get_u32 (const unsigned char *p)
+{
+/* decoding a little-endian 32 bit value */
+    return (unsigned long) p[0] | ((unsigned long) p[1] << 8) |
+	((unsigned long) p[2] << 16) | ((unsigned long) p[3] << 24);
+}
+
+static uint64_t
+zip_get_u64 (const unsigned char *p)
+{
+/* decoding a little-endian 64 bit value */
+    return (uint64_t) zip_get_u32 (p) | ((uint64_t) zip_get_u32 (p + 4) << 32);
+}
+
+static int
+zip_read_at (FILE * in, uint64_t offset, unsigned char *buf, size_t len)
+{
+/* reading some bytes starting from a given file position */
+    if (zip_fseek (in, offset, SEEK_SET) != 0)
+	return 0;
+    if (fread (buf, 1, len, in) != len)
+	return 0;
+    return 1;
+}
+
+static unsigned int
+zip_hash_name (const char *name)
+{
+/* case-insensitive hash (FNV-1a) of some Zipfile entry name */
+    unsigned int hash = 2166136261u;
+    const unsigned char *p = (const unsigned char *) name;
+    while (*p != '\0')
+      {
+	  unsigned char c = *p++;
+	  if (c >= 'A' && c <= 'Z')
+	      c += 'a' - 'A';
+	  hash ^= c;
+	  hash *= 16777619u;
+      }
+    return hash;
+}
+
+static void
+zip_reset_index (zip_index * index)
+{
+/* removing all entries from a Zipfile directory index */
+    zip_entry *entry;
+    zip_entry *entry_n;
+
+    entry = index->first;
+    while (entry != NULL)
+      {
+	  entry_n = entry->next;
+	  free (entry->name);
+	  free (entry);
+	  entry = entry_n;
+      }
+    if (index->buckets != NULL)
+	free (index->buckets);
+    index->n_entries = 0;
+    index->n_buckets = 0;
+    index->buckets = NULL;
+    index->first = NULL;
+    index->last = NULL;
+}
+
+void
+zip_destroy_index (zip_index * index)
+{
+/* memory cleanup - destroying a Zipfile directory index */
+    if (index == NULL)
+	return;
+    zip_reset_index (index);
+    if (index->in != NULL)
+	fclose (index->in);
+#ifdef ENABLE_LIBDEFLATE
+    if (index->decompressor != NULL)
+	libdeflate_free_decompressor (index->decompressor);
+#endif
+    free (index);
+}
+
+static int
+zip_alloc_buckets (zip_index * index, uint64_t n_entries)
+{
+/* allocating the hash buckets */
+    int i;
+    index->n_buckets = 64;
+    while ((uint64_t) index->n_buckets < n_entries * 2
+	   && index->n_buckets < 1024 * 1024)
+	index->n_buckets *= 2;
+    index->buckets = malloc (sizeof (zip_entry *) * index->n_buckets);
+    if (index->buckets == NULL)
+	return 0;
+    for (i = 0; i < index->n_buckets; i++)
+	*(index->buckets + i) = NULL;
+    return 1;
+}
+
+static zip_entry *
+zip_add_entry (zip_index * index, const char *name, size_t name_len,
+	       int *duplicate)
+{
+/* inserting a new entry into the index (duplicates are ignored) */
+    zip_entry *entry;
+    unsigned int bucket;
+    char *str;
+
+    *duplicate = 0;
+    str = malloc (name_len + 1);
+    if (str == NULL)
+	return NULL;
+    memcpy (str, name, name_len);
+    *(str + name_len) = '\0';
+    if (zip_find_entry (index, str) != NULL)
+      {
+	  free (str);
+	  *duplicate = 1;
+	  return NULL;
+      }
+    entry = malloc (sizeof (zip_entry));
+    if (entry == NULL)
+      {
+	  free (str);
+	  return NULL;
+      }
+    entry->name = str;
+    entry->pos_in_zip_directory = 0;
+    entry->num_of_file = 0;
+    entry->compressed_size = 0;
+    entry->uncompressed_size = 0;
+    entry->local_header_offset = 0;
+    entry->crc = 0;
+    entry->method = -1;
+    entry->direct = 0;
+    entry->next = NULL;
+    bucket = zip_hash_name (str) & (index->n_buckets - 1);
+    entry->hash_next = *(index->buckets + bucket);
+    *(index->buckets + bucket) = entry;
+    if (index->first == NULL)
+	index->first = entry;
+    if (index->last != NULL)
+	index->last->next = entry;
+    index->last = entry;
+    index->n_entries += 1;
+    return entry;
+}
+
+static int
+zip_locate_directory (FILE * in, uint64_t * cd_offset, uint64_t * cd_size,
+		      uint64_t * n_entries, uint64_t * bytes_before)
+{
+/* locating the Central Directory via the End Of Central Directory record */
+    unsigned char *buf;
+    unsigned char rec[56];
+    int64_t file_size;
+    uint64_t start;
+    uint64_t eocd_pos;
+    uint64_t cd_end;
+    size_t len;
+    size_t i;
+    int found = 0;
+
+    if (zip_fseek (in, 0, SEEK_END) != 0)
+	return 0;
+    file_size = zip_ftell (in);
+    if (file_size < 22)
+	return 0;
+/* the EOCD record may be followed by a comment up to 64 KB long */
+    start = 0;
+    if (file_size > 22 + 65535)
+	start = file_size - (22 + 65535);
+    len = (size_t) (file_size - start);
+    buf = malloc (len);
+    if (buf == NULL)
+	return 0;
+    if (!zip_read_at (in, start, buf, len))
+      {
+	  free (buf);
+	  return 0;
+      }
+    i = len - 22;
+    while (1)
+      {
+	  if (zip_get_u32 (buf + i) == ZIP_SIG_EOCD)
+	    {
+		found = 1;
+		break;
+	    }
+	  if (i == 0)
+	      break;
+	  i--;
+      }
+    if (!found || zip_get_u16 (buf + i + 4) != 0
+	|| zip_get_u16 (buf + i + 6) != 0)
+      {
+	  /* not found, or multi-disk archive */
+	  free (buf);
+	  return 0;
+      }
+    eocd_pos = start + i;
+    *n_entries = zip_get_u16 (buf + i + 10);
+    *cd_size = zip_get_u32 (buf + i + 12);
+    *cd_offset = zip_get_u32 (buf + i + 16);
+    free (buf);
+    cd_end = eocd_pos;
+
+    if (*n_entries == 0xffff || *cd_size == 0xffffffff
+	|| *cd_offset == 0xffffffff)
+      {
+	  /* ZIP64 archive */
+	  uint64_t eocd64_pos;
+	  if (eocd_pos < 20)
+	      return 0;
+	  if (!zip_read_at (in, eocd_pos - 20, rec, 20))
+	      return 0;
+	  if (zip_get_u32 (rec) != ZIP_SIG_EOCD64_LOC)
+	      return 0;
+	  eocd64_pos = zip_get_u64 (rec + 8);
+	  if (!zip_read_at (in, eocd64_pos, rec, 56))
+	      return 0;
+	  if (zip_get_u32 (rec) != ZIP_SIG_EOCD64)
+	      return 0;
+	  *n_entries = zip_get_u64 (rec + 32);
+	  *cd_size = zip_get_u64 (rec + 40);
+	  *cd_offset = zip_get_u64 (rec + 48);
+	  cd_end = eocd64_pos;
+      }
+
+/* checking for some extra data preceding the Zipfile */
+    if (*cd_offset > cd_end || *cd_size > cd_end - *cd_offset)
+	return 0;
+    *bytes_before = cd_end - (*cd_offset + *cd_size);
+    return 1;
+}
+
+static int
+zip_parse_zip64_extra (const unsigned char *p, unsigned int len,
+		       uint64_t * uncompressed, uint64_t * compressed,
+		       uint64_t * local)
+{
+/* parsing the ZIP64 Extended Information extra field */
+    while (len >= 4)
+      {
+	  unsigned int id = zip_get_u16 (p);
+	  unsigned int sz = zip_get_u16 (p + 2);
+	  if (sz > len - 4)
+	      return 0;
+	  if (id == 0x0001)
+	    {
+		const unsigned char *q = p + 4;
+		if (*uncompressed == 0xffffffff)
+		  {
+		      if (q + 8 > p + 4 + sz)
+			  return 0;
+		      *uncompressed = zip_get_u64 (q);
+		      q += 8;
+		  }
+		if (*compressed == 0xffffffff)
+		  {
+		      if (q + 8 > p + 4 + sz)
+			  return 0;
+		      *compressed = zip_get_u64 (q);
+		      q += 8;
+		  }
+		if (*local == 0xffffffff)
+		  {
+		      if (q + 8 > p + 4 + sz)
+			  return 0;
+		      *local = zip_get_u64 (q);
+		  }
+		return 1;
+	    }
+	  p += 4 + sz;
+	  len -= 4 + sz;
+      }
+    return 0;
+}
+
+static int
+zip_parse_directory (zip_index * index)
+{
+/* directly parsing the Central Directory */
+    uint64_t cd_offset;
+    uint64_t cd_size;
+    uint64_t n_entries;
+    uint64_t bytes_before;
+    uint64_t i;
+    unsigned char *cd = NULL;
+    const unsigned char *p;
+    const unsigned char *end;
+
+    if (!zip_locate_directory
+	(index->in, &cd_offset, &cd_size, &n_entries, &bytes_before))
+	return 0;
+    if (cd_size > ZIP_MAX_DIRECTORY || n_entries > cd_size / 46)
+	return 0;
+    cd = malloc (cd_size + 1);
+    if (cd == NULL)
+	return 0;
+    if (!zip_read_at (index->in, cd_offset + bytes_before, cd, cd_size))
+	goto error;
+    if (!zip_alloc_buckets (index, n_entries))
+	goto error;
+
+    p = cd;
+    end = cd + cd_size;
+    for (i = 0; i < n_entries; i++)
+      {
+	  /* looping on Central Directory records */
+	  zip_entry *entry;
+	  int duplicate;
+	  unsigned int flags;
+	  unsigned int method;
+	  unsigned int name_len;
+	  unsigned int extra_len;
+	  unsigned int comment_len;
+	  uint64_t compressed;
+	  uint64_t uncompressed;
+	  uint64_t local;
+	  if (end - p < 46 || zip_get_u32 (p) != ZIP_SIG_CENTRAL)
+	      goto error;
+	  flags = zip_get_u16 (p + 8);
+	  method = zip_get_u16 (p + 10);
+	  compressed = zip_get_u32 (p + 20);
+	  uncompressed = zip_get_u32 (p + 24);
+	  name_len = zip_get_u16 (p + 28);
+	  extra_len = zip_get_u16 (p + 30);
+	  comment_len = zip_get_u16 (p + 32);
+	  local = zip_get_u32 (p + 42);
+	  if ((size_t) (end - p) <
+	      (size_t) 46 + name_len + extra_len + comment_len)
+	      goto error;
+	  if (uncompressed == 0xffffffff || compressed == 0xffffffff
+	      || local == 0xffffffff)
+	    {
+		if (!zip_parse_zip64_extra
+		    (p + 46 + name_len, extra_len, &uncompressed,
+		     &compressed, &local))
+		    goto error;
+	    }
+	  entry =
+	      zip_add_entry (index, (const char *) (p + 46), name_len,
+			     &duplicate);
+	  if (entry == NULL && !duplicate)
+	      goto error;
+	  if (entry != NULL)
+	    {
+		entry->pos_in_zip_directory = cd_offset + (p - cd);
+		entry->num_of_file = i;
+		entry->compressed_size = compressed;
+		entry->uncompressed_size = uncompressed;
+		entry->local_header_offset = local + bytes_before;
+		entry->crc = zip_get_u32 (p + 16);
+		entry->method = method;
+		/* encrypted or exotic entries are left to minizip */
+		if ((flags & 0x0001) == 0)
+		  {
+		      if (method == ZIP_METHOD_DEFLATED)
+			  entry->direct = 1;
+		      if (method == ZIP_METHOD_STORED
+			  && compressed == uncompressed)
+			  entry->direct = 1;
+		  }
+	    }
+	  p += 46 + name_len + extra_len + comment_len;
+      }
+    free (cd);
+    return 1;
+
+  error:
+    if (cd != NULL)
+	free (cd);
+    zip_reset_index (index);
+    return 0;
+}
+
+static int
+zip_walk_directory (zip_index * index, unzFile uf)
+{
+/* walking the Zipfile directory by means of minizip */
+    unz_global_info64 gi;
+    int ret;
+    unsigned int i;
+
+    ret = unzGetGlobalInfo64 (uf, &gi);
+    if (ret != UNZ_OK)
+	return 0;
+    if (!zip_alloc_buckets (index, gi.number_entry))
+	return 0;
+    ret = unzGoToFirstFile (uf);
+    if (ret != UNZ_OK)
+	return 0;
+    for (i = 0; i < gi.number_entry; i++)
+      {
+	  /* looping on Zipfile entries */
+	  char filename[256];
+	  unz_file_info64 file_info;
+	  unz64_file_pos pos;
+	  zip_entry *entry;
+	  int duplicate;
+	  ret =
+	      unzGetCurrentFileInfo64 (uf, &file_info, filename, 256, NULL, 0,
+				       NULL, 0);
+	  if (ret != UNZ_OK)
+	      return 0;
+	  ret = unzGetFilePos64 (uf, &pos);
+	  if (ret != UNZ_OK)
+	      return 0;
+	  entry = zip_add_entry (index, filename, strlen (filename), &duplicate);
+	  if (entry == NULL && !duplicate)
+	      return 0;
+	  if (entry != NULL)
+	    {
+		entry->pos_in_zip_directory = pos.pos_in_zip_directory;
+		entry->num_of_file = pos.num_of_file;
+		entry->compressed_size = file_info.compressed_size;
+		entry->uncompressed_size = file_info.uncompressed_size;
+		entry->crc = file_info.crc;
+		entry->method = file_info.compression_method;
+	    }
+
+	  if (i == gi.number_entry - 1)
+	      break;
+	  ret = unzGoToNextFile (uf);
+	  if (ret != UNZ_OK)
+	      return 0;
+      }
+    return 1;
+}
+
+zip_index *
+zip_build_index (const char *path, void *zip_handle)
+{
+/* 
+ * parsing the Zipfile directory just once, so to build
+ * a name-based hash index of all entries
+ */
+    zip_index *index;
+
+    index = malloc (sizeof (zip_index));
+    if (index == NULL)
+	return NULL;
+    index->n_entries = 0;
+    index->n_buckets = 0;
+    index->buckets = NULL;
+    index->first = NULL;
+    index->last = NULL;
+    index->in = NULL;
+    index->decompressor = NULL;
+
+    if (path != NULL)
+	index->in = fopen (path, "rb");
+    if (index->in != NULL)
+      {
+	  /* directly reading the Central Directory */
+	  if (zip_parse_directory (index))
+	      return index;
+	  fclose (index->in);
+	  index->in = NULL;
+      }
+
+/* some unusual layout: falling back to minizip */
+    if (!zip_walk_directory (index, (unzFile) zip_handle))
+      {
+	  zip_destroy_index (index);
+	  return NULL;
+      }
+    return index;
+}
+
+zip_entry *
+zip_find_entry (zip_index * index, const char *name)
+{
+/* case-insensitive lookup of some Zipfile entry */
+    zip_entry *entry;
+    if (index == NULL || name == NULL || index->buckets == NULL)
+	return NULL;
+    entry =
+	*(index->buckets + (zip_hash_name (name) & (index->n_buckets - 1)));
+    while (entry != NULL)
+      {
+	  if (strcasecmp (entry->name, name) == 0)
+	      return entry;
+	  entry = entry->hash_next;
+      }
+    return NULL;
+}
+
+int
+zip_goto_entry (void *zip_handle, zip_entry * entry)
+{
+/* directly positioning the Zipfile on some entry */
+    unzFile uf = (unzFile) zip_handle;
+    unz64_file_pos pos;
+    pos.pos_in_zip_directory = entry->pos_in_zip_directory;
+    pos.num_of_file = entry->num_of_file;
+    if (unzGoToFilePos64 (uf, &pos) != UNZ_OK)
+	return 0;
+    return 1;
+}
+
+static int
+zip_data_offset (zip_index * index, zip_entry * entry, uint64_t * offset)
+{
+/* skipping the Local File Header preceding the entry data */
+    unsigned char hdr[30];
+    if (!zip_read_at (index->in, entry->local_header_offset, hdr, 30))
+	return 0;
+    if (zip_get_u32 (hdr) != ZIP_SIG_LOCAL)
+	return 0;
+    *offset =
+	entry->local_header_offset + 30 + zip_get_u16 (hdr + 26) +
+	zip_get_u16 (hdr + 28);
+    return 1;
+}
+
+static int
+zip_open_direct (zip_stream * stream)
+{
+/* preparing to directly inflate some entry (bypassing minizip) */
+    z_stream *strm;
+    uint64_t offset;
+
+    if (!zip_data_offset (stream->index, stream->entry, &offset))
+	return 0;
+    if (stream->entry->method == ZIP_METHOD_DEFLATED)
+      {
+	  stream->in_buf = malloc (ZIP_IO_CHUNK);
+	  if (stream->in_buf == NULL)
+	      return 0;
+	  strm = malloc (sizeof (z_stream));
+	  if (strm == NULL)
+	      goto error;
+	  memset (strm, 0, sizeof (z_stream));
+	  strm->zalloc = Z_NULL;
+	  strm->zfree = Z_NULL;
+	  strm->opaque = Z_NULL;
+	  strm->next_in = Z_NULL;
+	  strm->avail_in = 0;
+	  /* raw deflate data: no zlib header */
+	  if (inflateInit2 (strm, -MAX_WBITS) != Z_OK)
+	    {
+		free (strm);
+		goto error;
+	    }
+	  stream->inflater = strm;
+      }
+    stream->in_offset = offset;
+    stream->in_left = stream->entry->compressed_size;
+    stream->direct = 1;
+    return 1;
+
+  error:
+    free (stream->in_buf);
+    stream->in_buf = NULL;
+    return 0;
+}
+
+zip_stream *
+zip_open_stream (void *zip_handle, zip_index * index, zip_entry * entry)
+{
+/* opening some Zipfile entry for sequential uncompressing */
+    zip_stream *stream;
+
+    if (entry == NULL)
+	return NULL;
+    stream = malloc (sizeof (zip_stream));
+    if (stream == NULL)
+	return NULL;
+    stream->zip_handle = zip_handle;
+    stream->index = index;
+    stream->entry = entry;
+    stream->direct = 0;
+    stream->inflater = NULL;
+    stream->in_buf = NULL;
+    stream->in_offset = 0;
+    stream->in_left = 0;
+    stream->out_left = entry->uncompressed_size;
+    stream->crc = crc32 (0L, Z_NULL, 0);
+
+    if (entry->direct && index != NULL && index->in != NULL)
+      {
+	  if (zip_open_direct (stream))
+	      return stream;
+      }
+
+/* falling back to minizip */
+    if (!zip_goto_entry (zip_handle, entry))
+	goto error;
+    if (unzOpenCurrentFile ((unzFile) zip_handle) != UNZ_OK)
+	goto error;
+    return stream;
+
+  error:
+    free (stream);
+    return NULL;
+}
+
+int
+zip_read_stream (zip_stream * stream, unsigned char *buf, unsigned int len)
+{
+/* 
+ * uncompressing the next chunk of some Zipfile entry
+ *
+ * returns the number of bytes actually read, 0 on EOF, -1 on failure
+ */
+    unsigned int got;
+
+    if (!stream->direct)
+      {
+	  int ret = unzReadCurrentFile ((unzFile) stream->zip_handle, buf, len);
+	  if (ret < 0)
+	      return -1;
+	  return ret;
+      }
+
+    if (len > ZIP_MAX_READ)
+	len = ZIP_MAX_READ;
+    if ((uint64_t) len > stream->out_left)
+	len = (unsigned int) (stream->out_left);
+    if (len == 0)
+	return 0;
+
+    if (stream->inflater == NULL)
+      {
+	  /* stored entry: plain copy */
+	  if (!zip_read_at (stream->index->in, stream->in_offset, buf, len))
+	      return -1;
+	  stream->in_offset += len;
+	  stream->in_left -= len;
+	  got = len;
+      }
+    else
+      {
+	  /* deflated entry: inflating straight into the caller's buffer */
+	  z_stream *strm = stream->inflater;
+	  int ret;
+	  strm->next_out = buf;
+	  strm->avail_out = len;
+	  while (strm->avail_out > 0)
+	    {
+		if (strm->avail_in == 0 && stream->in_left > 0)
+		  {
+		      /* feeding more compressed data */
+		      unsigned int sz = ZIP_IO_CHUNK;
+		      if ((uint64_t) sz > stream->in_left)
+			  sz = (unsigned int) (stream->in_left);
+		      if (!zip_read_at
+			  (stream->index->in, stream->in_offset,
+			   stream->in_buf, sz))
+			  return -1;
+		      stream->in_offset += sz;
+		      stream->in_left -= sz;
+		      strm->next_in = stream->in_buf;
+		      strm->avail_in = sz;
+		  }
+		ret = inflate (strm, Z_NO_FLUSH);
+		if (ret == Z_STREAM_END)
+		    break;
+		if (ret != Z_OK)
+		    return -1;
+	    }
+	  got = len - strm->avail_out;
+      }
+
+    if (got == 0)
+	return -1;		/* premature end of data */
+    stream->out_left -= got;
+    stream->crc = crc32 (stream->crc, buf, got);
+    if (stream->out_left == 0 && stream->crc != stream->entry->crc)
+	return -1;
+    return (int) got;
+}
+
+void
+zip_close_stream (zip_stream * stream)
+{
+/* closing an open Zipfile entry */
+    if (stream == NULL)
+	return;
+    if (stream->direct)
+      {
+	  if (stream->inflater != NULL)
+	    {
+		inflateEnd (stream->inflater);
+		free (stream->inflater);
+	    }
+	  if (stream->in_buf != NULL)
+	      free (stream->in_buf);
+      }
+    else
+	unzCloseCurrentFile ((unzFile) stream->zip_handle);
+    free (stream);
+}
+
+#ifdef ENABLE_LIBDEFLATE
+static int
+zip_inflate_whole (zip_index * index, zip_entry * entry, unsigned char *buf)
+{
+/* inflating a whole deflated entry in a single pass (libdeflate) */
+    uint64_t offset;
+    unsigned char *in;
+    size_t actual;
+    enum libdeflate_result ret;
+
+    if (!zip_data_offset (index, entry, &offset))
+	return 0;
+    if (index->decompressor == NULL)
+      {
+	  index->decompressor = libdeflate_alloc_decompressor ();
+	  if (index->decompressor == NULL)
+	      return 0;
+      }
+    in = malloc (entry->compressed_size + 1);
+    if (in == NULL)
+	return 0;
+    if (!zip_read_at (index->in, offset, in, entry->compressed_size))
+      {
+	  free (in);
+	  return 0;
+      }
+    ret =
+	libdeflate_deflate_decompress (index->decompressor, in,
+				       entry->compressed_size, buf,
+				       entry->uncompressed_size, &actual);
+    free (in);
+    if (ret != LIBDEFLATE_SUCCESS || actual != entry->uncompressed_size)
+	return 0;
+    if (libdeflate_crc32 (0, buf, actual) != entry->crc)
+	return 0;
+    return 1;
+}
+#endif /* end libdeflate */
+
+unsigned char *
+zip_fetch_entry (void *zip_handle, zip_index * index, zip_entry * entry,
+		 uint64_t * size)
+{
+/* 
+ * uncompressing a whole Zipfile entry into memory
+ *
+ * returns a malloc'ed buffer (NULL on failure)
+ */
+    zip_stream *stream = NULL;
+    uint64_t size_buf;
+    unsigned char *buf = NULL;
+    uint64_t rd_cnt;
+    uint64_t unrd_cnt;
+    int ret;
+
+    *size = 0;
+    if (entry == NULL)
+	return NULL;
+    size_buf = entry->uncompressed_size;
+    buf = malloc (size_buf + 1);
+    if (buf == NULL)
+	return NULL;
+
+#ifdef ENABLE_LIBDEFLATE
+    if (entry->direct && entry->method == ZIP_METHOD_DEFLATED
+	&& index != NULL && index->in != NULL)
+      {
+	  if (zip_inflate_whole (index, entry, buf))
+	      goto done;
+      }
+#endif
+
+    stream = zip_open_stream (zip_handle, index, entry);
+    if (stream == NULL)
+	goto error;
+    rd_cnt = 0;
+    while (rd_cnt < size_buf)
+      {
+	  /* reading big chunks so to avoid large file issues */
+	  uint32_t max = 1000000000;	/* max chunk size */
+	  uint32_t len;
+	  unrd_cnt = size_buf - rd_cnt;
+	  if (unrd_cnt < max)
+	      len = unrd_cnt;
+	  else
+	      len = max;
+	  ret = zip_read_stream (stream, buf + rd_cnt, len);
+	  if (ret <= 0)
+	      goto error;
+	  rd_cnt += ret;
+      }
+    zip_close_stream (stream);
+    stream = NULL;
+
+#ifdef ENABLE_LIBDEFLATE
+  done:
+#endif
+    *(buf + size_buf) = '\0';
+    *size = size_buf;
+    return buf;
+
+  error:
+    if (buf != NULL)
+	free (buf);
+    if (stream != NULL)
+	zip_close_stream (stream);
+    return NULL;
+}
+
+zip_random *
+zip_random_open (zip_index * index, zip_entry * entry)
+{
+/* 
+ * loading the compressed data of some Zipfile entry into memory,
+ * so that it can then be randomly accessed
+ *
+ * only entries that can be directly inflated are supported
+ * (returns NULL in any other case)
+ */
+    zip_random *rnd;
+    uint64_t offset;
+
+    if (entry == NULL || index == NULL || index->in == NULL || !entry->direct)
+	return NULL;
+    if (!zip_data_offset (index, entry, &offset))
+	return NULL;
+    rnd = malloc (sizeof (zip_random));
+    if (rnd == NULL)
+	return NULL;
+    rnd->data_size = entry->compressed_size;
+    rnd->size = entry->uncompressed_size;
+    rnd->crc = entry->crc;
+    rnd->deflated = (entry->method == ZIP_METHOD_DEFLATED);
+    rnd->points = NULL;
+    rnd->n_points = 0;
+    rnd->max_points = 0;
+    rnd->inflater = NULL;
+    rnd->pos = 0;
+    rnd->positioned = 0;
+    rnd->scratch = NULL;
+    rnd->data = malloc (rnd->data_size + 1);
+    if (rnd->data == NULL)
+	goto error;
+    if (!zip_read_at (index->in, offset, rnd->data, rnd->data_size))
+	goto error;
+    if (rnd->deflated)
+      {
+	  z_stream *strm = malloc (sizeof (z_stream));
+	  if (strm == NULL)
+	      goto error;
+	  memset (strm, 0, sizeof (z_stream));
+	  /* raw deflate data: no zlib header */
+	  if (inflateInit2 (strm, -MAX_WBITS) != Z_OK)
+	    {
+		free (strm);
+		goto error;
+	    }
+	  rnd->inflater = strm;
+	  rnd->scratch = malloc (ZIP_WINDOW_SIZE);
+	  if (rnd->scratch == NULL)
+	      goto error;
+      }
+    return rnd;
+
+  error:
+    zip_random_close (rnd);
+    return NULL;
+}
+
+void
+zip_random_close (zip_random * rnd)
+{
+/* memory cleanup - destroying a randomly accessed Zipfile entry */
+    int i;
+    if (rnd == NULL)
+	return;
+    if (rnd->data != NULL)
+	free (rnd->data);
+    for (i = 0; i < rnd->n_points; i++)
+	free ((rnd->points + i)->window);
+    if (rnd->points != NULL)
+	free (rnd->points);
+    if (rnd->inflater != NULL)
+      {
+	  inflateEnd (rnd->inflater);
+	  free (rnd->inflater);
+      }
+    if (rnd->scratch != NULL)
+	free (rnd->scratch);
+    free (rnd);
+}
+
+static void
+zip_random_feed (zip_random * rnd, z_stream * strm)
+{
+/* feeding more compressed data to the inflater (if any is left) */
+    uint64_t used;
+    uint64_t left;
+    if (strm->avail_in > 0)
+	return;
+    used = strm->next_in - rnd->data;
+    left = rnd->data_size - used;
+    strm->avail_in = (left > ZIP_MAX_FEED) ? ZIP_MAX_FEED : (uInt) left;
+}
+
+static int
+zip_add_access_point (zip_random * rnd, z_stream * strm, uint64_t out,
+		      const unsigned char *window)
+{
+/* 
+ * recording a further access point (the inflater lies on a block boundary)
+ *
+ * the circular window is stored in order, the oldest byte first
+ */
+    zip_access_point *point;
+    unsigned int left = strm->avail_out;
+    if (rnd->n_points == rnd->max_points)
+      {
+	  int max = (rnd->max_points == 0) ? 16 : rnd->max_points * 2;
+	  zip_access_point *points =
+	      realloc (rnd->points, sizeof (zip_access_point) * max);
+	  if (points == NULL)
+	      return 0;
+	  rnd->points = points;
+	  rnd->max_points = max;
+      }
+    point = rnd->points + rnd->n_points;
+    point->window = malloc (ZIP_WINDOW_SIZE);
+    if (point->window == NULL)
+	return 0;
+    point->out = out;
+    point->in = strm->next_in - rnd->data;
+    point->bits = strm->data_type & 7;
+    if (left > 0)
+	memcpy (point->window, window + ZIP_WINDOW_SIZE - left, left);
+    if (left < ZIP_WINDOW_SIZE)
+	memcpy (point->window + left, window, ZIP_WINDOW_SIZE - left);
+    rnd->n_points += 1;
+    return 1;
+}
+
+int
+zip_random_scan (zip_random * rnd, zip_chunk_callback callback, void *ctx)
+{
+/* 
+ * uncompressing the whole entry just once, chunk by chunk
+ *
+ * an access point is recorded every ZIP_ACCESS_SPAN inflated bytes
+ * or so, and each chunk is passed to the callback, which is expected
+ * to return 0 so to abort the scan
+ */
+    z_stream strm;
+    unsigned char *window;
+    uint64_t total = 0;
+    uint64_t last = 0;
+    unsigned long crc = crc32 (0L, Z_NULL, 0);
+    int ok = 0;
+    int ret;
+
+    if (!rnd->deflated)
+      {
+	  /* stored entry: the data is already uncompressed */
+	  while (total < rnd->size)
+	    {
+		unsigned int len = ZIP_ACCESS_SPAN;
+		if ((uint64_t) len > rnd->size - total)
+		    len = (unsigned int) (rnd->size - total);
+		crc = crc32 (crc, rnd->data + total, len);
+		if (!callback (ctx, rnd->data + total, len))
+		    return 0;
+		total += len;
+	    }
+	  return crc == rnd->crc;
+      }
+
+    window = malloc (ZIP_WINDOW_SIZE);
+    if (window == NULL)
+	return 0;
+    memset (&strm, 0, sizeof (z_stream));
+    if (inflateInit2 (&strm, -MAX_WBITS) != Z_OK)
+      {
+	  free (window);
+	  return 0;
+      }
+    strm.next_in = rnd->data;
+    strm.avail_in = 0;
+    strm.avail_out = 0;
+    while (1)
+      {
+	  unsigned char *out;
+	  unsigned int got;
+	  zip_random_feed (rnd, &strm);
+	  if (strm.avail_out == 0)
+	    {
+		/* the window is full: starting over again */
+		strm.next_out = window;
+		strm.avail_out = ZIP_WINDOW_SIZE;
+	    }
+	  out = strm.next_out;
+	  ret = inflate (&strm, Z_BLOCK);
+	  if (ret != Z_OK && ret != Z_STREAM_END)
+	      break;
+	  got = strm.next_out - out;
+	  if (got > 0)
+	    {
+		if (total + got > rnd->size)
+		    break;
+		crc = crc32 (crc, out, got);
+		if (!callback (ctx, out, got))
+		    break;
+		total += got;
+	    }
+	  if (ret == Z_STREAM_END)
+	    {
+		ok = (total == rnd->size && crc == rnd->crc);
+		break;
+	    }
+	  if ((strm.data_type & 128) && !(strm.data_type & 64)
+	      && total - last > ZIP_ACCESS_SPAN)
+	    {
+		/* end of a deflate block, but not the last one */
+		if (!zip_add_access_point (rnd, &strm, total, window))
+		    break;
+		last = total;
+	    }
+      }
+    inflateEnd (&strm);
+    free (window);
+    return ok;
+}
+
+static int
+zip_random_inflate (zip_random * rnd, unsigned char *buf, unsigned int len)
+{
+/* inflating the next len bytes, from the current position onwards */
+    z_stream *strm = rnd->inflater;
+    strm->next_out = buf;
+    strm->avail_out = len;
+    while (strm->avail_out > 0)
+      {
+	  int ret;
+	  zip_random_feed (rnd, strm);
+	  ret = inflate (strm, Z_NO_FLUSH);
+	  if (ret == Z_STREAM_END && strm->avail_out > 0)
+	      return 0;
+	  if (ret != Z_OK && ret != Z_STREAM_END)
+	      return 0;
+      }
+    rnd->pos += len;
+    return 1;
+}
+
+static int
+zip_random_rewind (zip_random * rnd, uint64_t offset)
+{
+/* restarting the inflater from the nearest access point before offset */
+    z_stream *strm = rnd->inflater;
+    zip_access_point *point;
+    unsigned int dict_len;
+    int lo = 0;
+    int hi = rnd->n_points - 1;
+
+    if (rnd->n_points == 0 || rnd->points->out > offset)
+      {
+	  /* restarting from the very beginning */
+	  if (inflateReset (strm) != Z_OK)
+	      return 0;
+	  strm->next_in = rnd->data;
+	  strm->avail_in = 0;
+	  rnd->pos = 0;
+	  return 1;
+      }
+    while (lo < hi)
+      {
+	  /* binary search */
+	  int mid = (lo + hi + 1) / 2;
+	  if ((rnd->points + mid)->out <= offset)
+	      lo = mid;
+	  else
+	      hi = mid - 1;
+      }
+    point = rnd->points + lo;
+    if (inflateReset (strm) != Z_OK)
+	return 0;
+    strm->next_in = rnd->data + point->in;
+    strm->avail_in = 0;
+    if (point->bits > 0)
+      {
+	  /* the access point lies within some byte */
+	  int value = *(rnd->data + point->in - 1) >> (8 - point->bits);
+	  if (inflatePrime (strm, point->bits, value) != Z_OK)
+	      return 0;
+      }
+    dict_len = ZIP_WINDOW_SIZE;
+    if (point->out < dict_len)
+	dict_len = (unsigned int) (point->out);
+    if (dict_len > 0
+	&& inflateSetDictionary (strm,
+				 point->window + ZIP_WINDOW_SIZE - dict_len,
+				 dict_len) != Z_OK)
+	return 0;
+    rnd->pos = point->out;
+    return 1;
+}
+
+int
+zip_random_read (zip_random * rnd, uint64_t offset, unsigned char *buf,
+		 unsigned int len)
+{
+/* 
+ * reading len uncompressed bytes starting at some offset
+ *
+ * the inflater simply goes on when the offset lies shortly ahead,
+ * and is otherwise restarted from the nearest access point
+ */
+    if (offset > rnd->size || len > rnd->size - offset)
+	return 0;
+    if (!rnd->deflated)
+      {
+	  /* stored entry: plain copy */
+	  memcpy (buf, rnd->data + offset, len);
+	  return 1;
+      }
+    if (!rnd->positioned || offset < rnd->pos
+	|| offset - rnd->pos > ZIP_ACCESS_SPAN)
+      {
+	  if (!zip_random_rewind (rnd, offset))
+	      return 0;
+	  rnd->positioned = 1;
+      }
+    while (rnd->pos < offset)
+      {
+	  /* skipping the data preceding the offset */
+	  unsigned int skip = ZIP_WINDOW_SIZE;
+	  if ((uint64_t) skip > offset - rnd->pos)
+	      skip = (unsigned int) (offset - rnd->pos);
+	  if (!zip_random_inflate (rnd, rnd->scratch, skip))
+	    {
+		rnd->positioned = 0;
+		return 0;
+	    }
+      }
+    if (!zip_random_inflate (rnd, buf, len))
+      {
+	  rnd->positioned = 0;
+	  return 0;
+      }
+    return 1;
+}
+
+static int
+zip_pipeline_fill (zip_pipeline * pipe, int slot)
+{
+/* inflating the next chunk: 1 on success, 0 on EOF, -1 on failure */
+    int ret = zip_read_stream (pipe->stream, *(pipe->slots + slot),
+			       pipe->slot_size);
+    if (ret < 0)
+	return -1;
+    if (ret == 0)
+	return 0;
+    *(pipe->lengths + slot) = ret;
+    return 1;
+}
+
+#ifndef OMIT_THREADS
+static void
+zip_pipeline_producer (void *arg)
+{
+/* thread function: inflating chunks as long as free slots are available */
+    zip_pipeline *pipe = (zip_pipeline *) arg;
+    while (1)
+      {
+	  int slot;
+	  int ret;
+	  freexl_mutex_lock (pipe->mutex);
+	  while (pipe->count >= pipe->n_slots && !pipe->abort)
+	      freexl_cond_wait (pipe->cond, pipe->mutex);
+	  if (pipe->abort)
+	    {
+		freexl_mutex_unlock (pipe->mutex);
+		return;
+	    }
+	  /* the first free slot doesn't change when the consumer releases */
+	  slot = (pipe->head + pipe->count) % pipe->n_slots;
+	  freexl_mutex_unlock (pipe->mutex);
+
+	  ret = zip_pipeline_fill (pipe, slot);
+
+	  freexl_mutex_lock (pipe->mutex);
+	  if (ret > 0)
+	      pipe->count += 1;
+	  else if (ret == 0)
+	      pipe->eof = 1;
+	  else
+	      pipe->error = 1;
+	  freexl_cond_broadcast (pipe->cond);
+	  freexl_mutex_unlock (pipe->mutex);
+	  if (ret <= 0)
+	      return;
+      }
+}
+#endif /* end conditional multithreading support */
+
+zip_pipeline *
+zip_pipeline_start (void *zip_handle, zip_index * index, zip_entry * entry,
+		    int threaded)
+{
+/* 
+ * opening some Zipfile entry for chunked reading
+ *
+ * in threaded mode a separate thread will keep inflating the next
+ * chunks while the current one is being consumed
+ */
+    zip_pipeline *pipe;
+    int i;
+
+    pipe = malloc (sizeof (zip_pipeline));
+    if (pipe == NULL)
+	return NULL;
+#ifdef OMIT_THREADS
+    threaded = 0;
+#endif
+    pipe->stream = NULL;
+    pipe->threaded = 0;
+    pipe->thread = NULL;
+    pipe->mutex = NULL;
+    pipe->cond = NULL;
+    pipe->n_slots = threaded ? ZIP_PIPELINE_SLOTS : 1;
+    pipe->slot_size = ZIP_PIPELINE_SLOT_SIZE;
+    pipe->slots = NULL;
+    pipe->lengths = NULL;
+    pipe->head = 0;
+    pipe->count = 0;
+    pipe->eof = 0;
+    pipe->error = 0;
+    pipe->abort = 0;
+
+    pipe->slots = malloc (sizeof (unsigned char *) * pipe->n_slots);
+    pipe->lengths = malloc (sizeof (unsigned int) * pipe->n_slots);
+    if (pipe->slots == NULL || pipe->lengths == NULL)
+	goto error;
+    for (i = 0; i < pipe->n_slots; i++)
+	*(pipe->slots + i) = NULL;
+    for (i = 0; i < pipe->n_slots; i++)
+      {
+	  *(pipe->slots + i) = malloc (pipe->slot_size);
+	  if (*(pipe->slots + i) == NULL)
+	      goto error;
+      }
+    pipe->stream = zip_open_stream (zip_handle, index, entry);
+    if (pipe->stream == NULL)
+	goto error;
+
+#ifndef OMIT_THREADS
+    if (threaded)
+      {
+	  pipe->mutex = freexl_mutex_create ();
+	  pipe->cond = freexl_cond_create ();
+	  if (pipe->mutex != NULL && pipe->cond != NULL)
+	      pipe->thread =
+		  freexl_thread_create (zip_pipeline_producer, pipe);
+	  if (pipe->thread != NULL)
+	      pipe->threaded = 1;
+	  else
+	    {
+		/* unable to start the thread: sequential reading */
+		freexl_mutex_destroy (pipe->mutex);
+		freexl_cond_destroy (pipe->cond);
+		pipe->mutex = NULL;
+		pipe->cond = NULL;
+	    }
+      }
+#endif
+    return pipe;
+
+  error:
+    zip_pipeline_stop (pipe);
+    return NULL;
+}
+
+int
+zip_pipeline_next (zip_pipeline * pipe, const unsigned char **buf,
+		   unsigned int *len)
+{
+/* 
+ * fetching the next inflated chunk
+ *
+ * returns 1 on success, 0 on EOF, -1 on failure
+ */
+    int ret;
+
+    if (!pipe->threaded)
+      {
+	  /* sequential reading */
+	  if (pipe->error)
+	      return -1;
+	  if (pipe->eof)
+	      return 0;
+	  ret = zip_pipeline_fill (pipe, 0);
+	  if (ret < 0)
+	      pipe->error = 1;
+	  if (ret == 0)
+	      pipe->eof = 1;
+	  if (ret <= 0)
+	      return ret;
+	  *buf = *(pipe->slots);
+	  *len = *(pipe->lengths);
+	  return 1;
+      }
+
+#ifndef OMIT_THREADS
+    freexl_mutex_lock (pipe->mutex);
+    while (pipe->count == 0 && !pipe->eof && !pipe->error)
+	freexl_cond_wait (pipe->cond, pipe->mutex);
+    if (pipe->count > 0)
+      {
+	  *buf = *(pipe->slots + pipe->head);
+	  *len = *(pipe->lengths + pipe->head);
+	  ret = 1;
+      }
+    else if (pipe->error)
+	ret = -1;
+    else
+	ret = 0;
+    freexl_mutex_unlock (pipe->mutex);
+    return ret;
+#else
+    return -1;
+#endif
+}
+
+void
+zip_pipeline_release (zip_pipeline * pipe)
+{
+/* releasing the chunk returned by the latest zip_pipeline_next() */
+    if (!pipe->threaded)
+	return;
+#ifndef OMIT_THREADS
+    freexl_mutex_lock (pipe->mutex);
+    pipe->head = (pipe->head + 1) % pipe->n_slots;
+    pipe->count -= 1;
+    freexl_cond_broadcast (pipe->cond);
+    freexl_mutex_unlock (pipe->mutex);
+#endif
+}
+
+void
+zip_pipeline_stop (zip_pipeline * pipe)
+{
+/* stopping the pipeline and releasing all resources */
+    int i;
+    if (pipe == NULL)
+	return;
+#ifndef OMIT_THREADS
+    if (pipe->threaded)
+      {
+	  freexl_mutex_lock (pipe->mutex);
+	  pipe->abort = 1;
+	  freexl_cond_broadcast (pipe->cond);
+	  freexl_mutex_unlock (pipe->mutex);
+	  freexl_thread_join (pipe->thread);
+	  freexl_mutex_destroy (pipe->mutex);
+	  freexl_cond_destroy (pipe->cond);
+      }
+#endif
+    if (pipe->stream != NULL)
+	zip_close_stream (pipe->stream);
+    if (pipe->slots != NULL)
+      {
+	  for (i = 0; i < pipe->n_slots; i++)
+	    {
+		if (*(pipe->slots + i) != NULL)
+		    free (*(pipe->slots + i));
+	    }
+	  free (pipe->slots);
+      }
+    if (pipe->lengths != NULL)
+	free (pipe->lengths);
+    free (pipe);
+}
+
+#endif /* end conditional XML support */
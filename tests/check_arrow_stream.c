@@ -0,0 +1,436 @@
+/* 
+/ check_arrow_stream.c
+/
+/ Test cases for the Apache Arrow C stream export
+/
+/ ------------------------------------------------------------------------------
+/ 
+/ Version: MPL 1.1/GPL 2.0/LGPL 2.1
+/ 
+/ The contents of this file are subject to the Mozilla Public License Version
+/ 1.1 (the "License"); you may not use this file except in compliance with
+/ the License. You may obtain a copy of the License at
+/ http://www.mozilla.org/MPL/
+/ 
+/ Software distributed under the License is distributed on an "AS IS" basis,
+/ WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+/ for the specific language governing rights and limitations under the
+/ License.
+/
+/ The Original Code is the FreeXL library
+/
+/ The Initial Developer of the Original Code is Alessandro Furieri
+/ 
+/ Portions created by the Initial Developer are Copyright (C) 2021
+/ the Initial Developer. All Rights Reserved.
+/ 
+/ Contributor(s):
+/
+/ Alternatively, the contents of this file may be used under the terms of
+/ either the GNU General Public License Version 2 or later (the "GPL"), or
+/ the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+/ in which case the provisions of the GPL or the LGPL are applicable instead
+/ of those above. If you wish to allow use of your version of this file only
+/ under the terms of either the GPL or the LGPL, and not to allow others to
+/ use your version of this file under the terms of the MPL, indicate your
+/ decision by deleting the provisions above and replace them with the notice
+/ and other provisions required by the GPL or the LGPL. If you do not delete
+/ the provisions above, a recipient may use your version of this file under
+/ the terms of any one of the MPL, the GPL or the LGPL.
+/ 
+*/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "freexl.h"
+
+#if defined(_WIN32) && !defined(__MINGW32__)
+#include "config-msvc.h"
+#else
+#include "config.h"
+#endif
+
+#if defined(__GLIBC__) \
+    && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+#include <malloc.h>
+#define HEAP_IN_USE()	(mallinfo2 ().uordblks)
+#else
+#define HEAP_IN_USE()	((size_t) 0)	/* unknown: always bounded */
+#endif
+
+static void
+civil_from_days (int64_t z, int *y, int *m, int *d)
+{
+/* converting days since 1970-01-01 into a Gregorian date */
+    int64_t era;
+    int64_t doe;
+    int64_t yoe;
+    int64_t doy;
+    int64_t mp;
+    z += 719468;
+    era = (z >= 0 ? z : z - 146096) / 146097;
+    doe = z - era * 146097;
+    yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    mp = (5 * doy + 2) / 153;
+    *d = (int) (doy - (153 * mp + 2) / 5 + 1);
+    *m = (int) (mp < 10 ? mp + 3 : mp - 9);
+    *y = (int) (yoe + era * 400 + (*m <= 2));
+}
+
+static int
+check_arrow_cell (const struct ArrowSchema *field,
+		  const struct ArrowArray *column, int64_t i,
+		  const FreeXL_CellValue * cell)
+{
+/* comparing an Arrow value against a single Cell */
+    const unsigned char *validity = column->buffers[0];
+    int valid = (validity[i / 8] >> (i % 8)) & 1;
+    char buf[128];
+    int y;
+    int m;
+    int d;
+
+    if (valid != (cell->type != FREEXL_CELL_NULL))
+	return 0;
+    if (!valid)
+	return 1;
+    if (strcmp (field->format, "i") == 0)
+	return cell->type == FREEXL_CELL_INT
+	    && ((const int32_t *) column->buffers[1])[i] ==
+	    cell->value.int_value;
+    if (strcmp (field->format, "g") == 0)
+      {
+	  double v = ((const double *) column->buffers[1])[i];
+	  if (cell->type == FREEXL_CELL_INT)
+	      return v == cell->value.int_value;
+	  return cell->type == FREEXL_CELL_DOUBLE
+	      && v == cell->value.double_value;
+      }
+    if (strcmp (field->format, "tdD") == 0)
+      {
+	  civil_from_days (((const int32_t *) column->buffers[1])[i], &y, &m,
+			   &d);
+	  sprintf (buf, "%04d-%02d-%02d", y, m, d);
+	  return cell->type == FREEXL_CELL_DATE
+	      && strcmp (buf, cell->value.text_value) == 0;
+      }
+    if (strcmp (field->format, "tss:") == 0)
+      {
+	  int64_t secs = ((const int64_t *) column->buffers[1])[i];
+	  int64_t days = secs / 86400;
+	  int64_t rem = secs % 86400;
+	  if (rem < 0)
+	    {
+		rem += 86400;
+		days--;
+	    }
+	  civil_from_days (days, &y, &m, &d);
+	  if (cell->type == FREEXL_CELL_DATE)
+	    {
+		sprintf (buf, "%04d-%02d-%02d", y, m, d);
+		return rem == 0 && strcmp (buf, cell->value.text_value) == 0;
+	    }
+	  sprintf (buf, "%04d-%02d-%02d %02d:%02d:%02d", y, m, d,
+		   (int) (rem / 3600), (int) ((rem / 60) % 60),
+		   (int) (rem % 60));
+	  return cell->type == FREEXL_CELL_DATETIME
+	      && strcmp (buf, cell->value.text_value) == 0;
+      }
+    if (strcmp (field->format, "u") == 0)
+      {
+	  const int32_t *offsets = column->buffers[1];
+	  const char *text = (const char *) (column->buffers[2]) + offsets[i];
+	  size_t len = offsets[i + 1] - offsets[i];
+	  const char *expected = buf;
+	  if (cell->type == FREEXL_CELL_INT)
+	      sprintf (buf, "%d", cell->value.int_value);
+	  else if (cell->type == FREEXL_CELL_DOUBLE)
+	      sprintf (buf, "%1.15g", cell->value.double_value);
+	  else
+	      expected = cell->value.text_value;
+	  return len == strlen (expected) && memcmp (text, expected, len) == 0;
+      }
+    return 0;
+}
+
+static int
+check_stream (const void *handle, unsigned int first_row,
+	      unsigned int n_rows, unsigned int batch_rows, int *n_batches)
+{
+/* consuming a whole Arrow stream */
+    struct ArrowArrayStream stream;
+    struct ArrowSchema schema;
+    struct ArrowArray batch;
+    FreeXL_CellValue cell;
+    unsigned int rows;
+    unsigned short columns;
+    unsigned int row = first_row;
+    int64_t i;
+    int64_t c;
+    int ret;
+    int ok = 0;
+
+    *n_batches = 0;
+    ret = freexl_worksheet_dimensions (handle, &rows, &columns);
+    if (ret != FREEXL_OK)
+	return 0;
+    if (n_rows == 0)
+	n_rows = rows - first_row;
+    ret = freexl_export_arrow_stream (handle, first_row, n_rows, batch_rows,
+				      &stream);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "Error exporting Arrow stream: %d\n", ret);
+	  return 0;
+      }
+    if (stream.get_schema (&stream, &schema) != 0)
+      {
+	  fprintf (stderr, "Error getting Arrow schema\n");
+	  stream.release (&stream);
+	  return 0;
+      }
+    if (strcmp (schema.format, "+s") != 0 || schema.n_children != columns)
+      {
+	  fprintf (stderr, "Unexpected Arrow schema\n");
+	  goto end;
+      }
+    while (1)
+      {
+	  if (stream.get_next (&stream, &batch) != 0)
+	    {
+		fprintf (stderr, "Error getting Arrow batch: %s\n",
+			 stream.get_last_error (&stream));
+		goto end;
+	    }
+	  if (batch.release == NULL)
+	      break;		/* end of stream */
+	  *n_batches += 1;
+	  if (batch.n_children != columns
+	      || (batch_rows > 0 && batch.length > (int64_t) batch_rows))
+	    {
+		fprintf (stderr, "Unexpected Arrow batch\n");
+		batch.release (&batch);
+		goto end;
+	    }
+	  for (i = 0; i < batch.length; i++, row++)
+	    {
+		for (c = 0; c < columns; c++)
+		  {
+		      ret = freexl_get_cell_value (handle, row, c, &cell);
+		      if (ret != FREEXL_OK
+			  || !check_arrow_cell (schema.children[c],
+						batch.children[c], i, &cell))
+			{
+			    fprintf (stderr, "Mismatching cell (%u,%d) %s\n",
+				     row, (int) c, schema.children[c]->format);
+			    batch.release (&batch);
+			    goto end;
+			}
+		  }
+	    }
+	  batch.release (&batch);
+	  if (batch.release != NULL)
+	    {
+		fprintf (stderr, "Arrow batch not released\n");
+		goto end;
+	    }
+      }
+    if (row != first_row + n_rows)
+      {
+	  fprintf (stderr, "Unexpected Arrow row count %u\n", row);
+	  goto end;
+      }
+    ok = 1;
+  end:
+    schema.release (&schema);
+    stream.release (&stream);
+    if (stream.release != NULL)
+      {
+	  fprintf (stderr, "Arrow stream not released\n");
+	  return 0;
+      }
+    return ok;
+}
+
+static int
+check_document (const void *handle, const char *expected_formats)
+{
+/* exporting every Worksheet */
+    struct ArrowArrayStream stream;
+    struct ArrowSchema schema;
+    unsigned int max_worksheet;
+    unsigned int idx;
+    unsigned int rows;
+    unsigned short columns;
+    int batches;
+    int ret;
+    char formats[1024];
+
+    *formats = '\0';
+    ret = freexl_get_worksheets_count (handle, &max_worksheet);
+    if (ret != FREEXL_OK)
+	return -10;
+    for (idx = 0; idx < max_worksheet; idx++)
+      {
+	  ret = freexl_select_active_worksheet (handle, idx);
+	  if (ret != FREEXL_OK)
+	      return -11;
+	  ret = freexl_worksheet_dimensions (handle, &rows, &columns);
+	  if (ret != FREEXL_OK)
+	      return -12;
+	  if (!check_stream (handle, 0, 0, 0, &batches))
+	      return -13;
+	  if (rows > 0 && batches != 1)
+	      return -14;
+	  if (!check_stream (handle, 0, 0, 2, &batches))
+	      return -15;
+	  if (batches != (int) ((rows + 1) / 2))
+	      return -16;
+	  if (rows > 1 && !check_stream (handle, 1, rows - 1, 3, &batches))
+	      return -17;
+
+	  /* collecting the inferred column types */
+	  ret = freexl_export_arrow_stream (handle, 0, 0, 0, &stream);
+	  if (ret != FREEXL_OK)
+	      return -18;
+	  if (stream.get_schema (&stream, &schema) == 0)
+	    {
+		int64_t c;
+		for (c = 0; c < schema.n_children; c++)
+		  {
+		      if (strlen (formats) + 8 < sizeof (formats))
+			{
+			    strcat (formats, schema.children[c]->format);
+			    strcat (formats, " ");
+			}
+		  }
+		schema.release (&schema);
+	    }
+	  stream.release (&stream);
+	  strcat (formats, "| ");
+	  if (rows == 0)
+	      continue;
+	  ret = freexl_export_arrow_stream (handle, rows, 1, 0, &stream);
+	  if (ret != FREEXL_ILLEGAL_CELL_ROW_COL)
+	    {
+		fprintf (stderr, "Unexpected result for illegal range: %d\n",
+			 ret);
+		return -19;
+	    }
+      }
+    if (expected_formats != NULL && strcmp (formats, expected_formats) != 0)
+      {
+	  fprintf (stderr, "Unexpected Arrow types: %s\n", formats);
+	  return -20;
+      }
+    return 0;
+}
+
+static int
+check_bounded_memory (const void *handle)
+{
+/* exporting the same dates over and over must not grow the heap */
+    struct ArrowArrayStream stream;
+    struct ArrowArray batch;
+    size_t before = 0;
+    size_t after;
+    int i;
+    int ret;
+
+    ret = freexl_select_active_worksheet (handle, 0);
+    if (ret != FREEXL_OK)
+	return 0;
+    for (i = 0; i < 5000; i++)
+      {
+	  if (i == 100)
+	      before = HEAP_IN_USE ();
+	  ret = freexl_export_arrow_stream (handle, 0, 0, 0, &stream);
+	  if (ret != FREEXL_OK)
+	      return 0;
+	  while (stream.get_next (&stream, &batch) == 0
+		 && batch.release != NULL)
+	      batch.release (&batch);
+	  stream.release (&stream);
+      }
+    after = HEAP_IN_USE ();
+    if (after > before + 65536)
+      {
+	  fprintf (stderr, "Arrow exports grew the heap by %lu bytes\n",
+		   (unsigned long) (after - before));
+	  return 0;
+      }
+    return 1;
+}
+
+int
+main (int argc, char *argv[])
+{
+    const void *handle;
+    int ret;
+    int ret2;
+
+    ret = freexl_open ("testdata/testcase1.xls", &handle);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "OPEN ERROR: %d\n", ret);
+	  return -1;
+      }
+    ret2 = check_document (handle,
+			   "i u u u g g u u u u i i u u i u i u u | u u u u u u u u u tdD u u tss: u u u i u u | | ");
+    ret = freexl_close (handle);
+    if (ret2 != 0)
+	return ret2;
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "CLOSE ERROR: %d\n", ret);
+	  return -2;
+      }
+
+#ifdef OMIT_XMLDOC		/* XML support is not enabled */
+    fprintf (stderr,
+	     "Sorry, this version of check_arrow_stream was built by disabling support XML documents\n");
+#else
+    ret = freexl_open_xlsx ("testdata/test_xml.xlsx", &handle);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "OPEN XLSX ERROR: %d\n", ret);
+	  return -3;
+      }
+    ret2 = check_document (handle, NULL);
+    if (ret2 == 0 && !check_bounded_memory (handle))
+	ret2 = -21;
+    ret = freexl_close (handle);
+    if (ret2 != 0)
+	return ret2 - 20;
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "CLOSE XLSX ERROR: %d\n", ret);
+	  return -4;
+      }
+
+    ret = freexl_open_ods ("testdata/test_dates.ods", &handle);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "OPEN ODS ERROR: %d\n", ret);
+	  return -5;
+      }
+    ret2 = check_document (handle, "u u u u | ");
+    ret = freexl_close (handle);
+    if (ret2 != 0)
+	return ret2 - 40;
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "CLOSE ODS ERROR: %d\n", ret);
+	  return -6;
+      }
+#endif /* end conditional XML support */
+
+    if (argc > 1 || argv[0] == NULL)
+	argc = 1;		/* silencing stupid compiler warnings */
+
+    return 0;
+}
@@ -0,0 +1,309 @@
+/* 
+/ check_cell_iterator.c
+/
+/ Test cases for the sparse cell iterator
+/
+/ ------------------------------------------------------------------------------
+/ 
+/ Version: MPL 1.1/GPL 2.0/LGPL 2.1
+/ 
+/ The contents of this file are subject to the Mozilla Public License Version
+/ 1.1 (the "License"); you may not use this file except in compliance with
+/ the License. You may obtain a copy of the License at
+/ http://www.mozilla.org/MPL/
+/ 
+/ Software distributed under the License is distributed on an "AS IS" basis,
+/ WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+/ for the specific language governing rights and limitations under the
+/ License.
+/
+/ The Original Code is the FreeXL library
+/
+/ The Initial Developer of the Original Code is Alessandro Furieri
+/ 
+/ Portions created by the Initial Developer are Copyright (C) 2021
+/ the Initial Developer. All Rights Reserved.
+/ 
+/ Contributor(s):
+/
+/ Alternatively, the contents of this file may be used under the terms of
+/ either the GNU General Public License Version 2 or later (the "GPL"), or
+/ the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+/ in which case the provisions of the GPL or the LGPL are applicable instead
+/ of those above. If you wish to allow use of your version of this file only
+/ under the terms of either the GPL or the LGPL, and not to allow others to
+/ use your version of this file under the terms of the MPL, indicate your
+/ decision by deleting the provisions above and replace them with the notice
+/ and other provisions required by the GPL or the LGPL. If you do not delete
+/ the provisions above, a recipient may use your version of this file under
+/ the terms of any one of the MPL, the GPL or the LGPL.
+/ 
+*/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "freexl.h"
+
+#if defined(_WIN32) && !defined(__MINGW32__)
+#include "config-msvc.h"
+#else
+#include "config.h"
+#endif
+
+#include "check_helpers.h"
+
+static int
+next_dense_cell (const void *handle, unsigned int rows,
+		 unsigned short columns, unsigned int *row,
+		 unsigned short *col, FreeXL_CellValue * cell)
+{
+/* scanning the whole Worksheet for the next non-NULL Cell */
+    while (*row < rows)
+      {
+	  while (*col < columns)
+	    {
+		if (freexl_get_cell_value (handle, *row, *col, cell) !=
+		    FREEXL_OK)
+		    return 0;
+		*col += 1;
+		if (cell->type != FREEXL_CELL_NULL)
+		    return 1;
+	    }
+	  *row += 1;
+	  *col = 0;
+      }
+    return 0;
+}
+
+static int
+check_document (const void *handle, int *total)
+{
+/* comparing the iterator against a dense scan, for each Worksheet */
+    unsigned int max_worksheet;
+    unsigned int idx;
+    int ret;
+
+    *total = 0;
+    ret = freexl_get_worksheets_count (handle, &max_worksheet);
+    if (ret != FREEXL_OK)
+	return -10;
+    for (idx = 0; idx < max_worksheet; idx++)
+      {
+	  const void *iter;
+	  unsigned int rows;
+	  unsigned short columns;
+	  unsigned int dense_row = 0;
+	  unsigned short dense_col = 0;
+	  unsigned int row;
+	  unsigned short col;
+	  FreeXL_CellValue cell;
+	  FreeXL_CellValue dense;
+
+	  ret = freexl_select_active_worksheet (handle, idx);
+	  if (ret != FREEXL_OK)
+	      return -11;
+	  ret = freexl_worksheet_dimensions (handle, &rows, &columns);
+	  if (ret != FREEXL_OK)
+	      return -12;
+	  ret = freexl_create_cell_iterator (handle, &iter);
+	  if (ret != FREEXL_OK)
+	    {
+		fprintf (stderr, "Error creating cell iterator: %d\n", ret);
+		return -13;
+	    }
+	  while (1)
+	    {
+		int more =
+		    next_dense_cell (handle, rows, columns, &dense_row,
+				     &dense_col, &dense);
+		ret = freexl_next_cell (iter, &row, &col, &cell);
+		if (ret != FREEXL_OK)
+		  {
+		      fprintf (stderr, "Error getting next cell: %d\n", ret);
+		      freexl_destroy_cell_iterator (iter);
+		      return -14;
+		  }
+		if (!more)
+		  {
+		      if (cell.type != FREEXL_CELL_NULL)
+			{
+			    fprintf (stderr, "Unexpected cell (%u,%u)\n", row,
+				     col);
+			    freexl_destroy_cell_iterator (iter);
+			    return -15;
+			}
+		      break;
+		  }
+		if (row != dense_row || col != dense_col - 1
+		    || !same_value (&cell, &dense))
+		  {
+		      fprintf (stderr,
+			       "Mismatching cell (%u,%u), expected (%u,%u)\n",
+			       row, col, dense_row, dense_col - 1);
+		      freexl_destroy_cell_iterator (iter);
+		      return -16;
+		  }
+		*total += 1;
+	    }
+	  /* once exhausted, the iterator keeps signalling the end */
+	  ret = freexl_next_cell (iter, &row, &col, &cell);
+	  if (ret != FREEXL_OK || cell.type != FREEXL_CELL_NULL)
+	    {
+		freexl_destroy_cell_iterator (iter);
+		return -17;
+	    }
+	  freexl_destroy_cell_iterator (iter);
+      }
+    return 0;
+}
+
+static int
+check_file (const char *path, int mode, int expected)
+{
+/* testing a single document */
+    const void *handle;
+    int ret;
+    int ret2;
+    int total;
+
+    if (mode == 0)
+	ret = freexl_open (path, &handle);
+#ifndef OMIT_XMLDOC
+    else if (mode == 1)
+	ret = freexl_open_xlsx (path, &handle);
+    else
+	ret = freexl_open_ods (path, &handle);
+#endif
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "OPEN ERROR (%s): %d\n", path, ret);
+	  return -1;
+      }
+    ret2 = check_document (handle, &total);
+    ret = freexl_close (handle);
+    if (ret2 != 0)
+      {
+	  fprintf (stderr, "%s: error %d\n", path, ret2);
+	  return ret2;
+      }
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "CLOSE ERROR (%s): %d\n", path, ret);
+	  return -2;
+      }
+    if (total != expected)
+      {
+	  fprintf (stderr, "%s: unexpected number of cells %d\n", path,
+		   total);
+	  return -3;
+      }
+    return 0;
+}
+
+#ifndef OMIT_XMLDOC
+static int
+check_date_slot (const char *path)
+{
+/* every XLSX date text is formatted into the same iterator buffer */
+    const void *handle;
+    const void *iter;
+    const char *slot = NULL;
+    unsigned int row;
+    unsigned short col;
+    FreeXL_CellValue cell;
+    int dates = 0;
+    int ret;
+
+    ret = freexl_open_xlsx (path, &handle);
+    if (ret != FREEXL_OK)
+	return -1;
+    ret = freexl_select_active_worksheet (handle, 0);
+    if (ret == FREEXL_OK)
+	ret = freexl_create_cell_iterator (handle, &iter);
+    if (ret != FREEXL_OK)
+      {
+	  freexl_close (handle);
+	  return -2;
+      }
+    while (freexl_next_cell (iter, &row, &col, &cell) == FREEXL_OK
+	   && cell.type != FREEXL_CELL_NULL)
+      {
+	  if (cell.type != FREEXL_CELL_DATE
+	      && cell.type != FREEXL_CELL_DATETIME
+	      && cell.type != FREEXL_CELL_TIME)
+	      continue;
+	  if (slot == NULL)
+	      slot = cell.value.text_value;
+	  if (cell.value.text_value != slot)
+	      break;
+	  dates++;
+      }
+    freexl_destroy_cell_iterator (iter);
+    freexl_close (handle);
+    if (dates != 2)
+      {
+	  fprintf (stderr, "%s: unexpected date slots (%d dates)\n", path,
+		   dates);
+	  return -3;
+      }
+    return 0;
+}
+#endif
+
+int
+main (int argc, char *argv[])
+{
+    const void *handle;
+    const void *iter;
+    int ret;
+
+    ret = check_file ("testdata/testcase1.xls", 0, 503);
+    if (ret != 0)
+	return ret;
+
+    ret = freexl_create_cell_iterator (NULL, &iter);
+    if (ret != FREEXL_NULL_HANDLE)
+      {
+	  fprintf (stderr, "Unexpected result for NULL handle: %d\n", ret);
+	  return -20;
+      }
+    ret = freexl_open ("testdata/testcase1.xls", &handle);
+    if (ret != FREEXL_OK)
+	return -21;
+    ret = freexl_create_cell_iterator (handle, NULL);
+    freexl_close (handle);
+    if (ret != FREEXL_NULL_ARGUMENT)
+      {
+	  fprintf (stderr, "Unexpected result for NULL iterator: %d\n", ret);
+	  return -22;
+      }
+
+#ifdef OMIT_XMLDOC		/* XML support is not enabled */
+    fprintf (stderr,
+	     "Sorry, this version of check_cell_iterator was built by disabling support XML documents\n");
+#else
+    ret = check_file ("testdata/test_xml.xlsx", 1, 28);
+    if (ret != 0)
+	return ret - 30;
+    ret = check_file ("testdata/test_styled.xlsx", 1, 28);
+    if (ret != 0)
+	return ret - 40;
+    ret = check_file ("testdata/test_xml.ods", 2, 28);
+    if (ret != 0)
+	return ret - 50;
+    ret = check_file ("testdata/test_dates.ods", 2, 8);
+    if (ret != 0)
+	return ret - 60;
+    ret = check_date_slot ("testdata/test_xml.xlsx");
+    if (ret != 0)
+	return ret - 70;
+#endif /* end conditional XML support */
+
+    if (argc > 1 || argv[0] == NULL)
+	argc = 1;		/* silencing stupid compiler warnings */
+
+    return 0;
+}
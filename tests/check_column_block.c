@@ -0,0 +1,287 @@
+/* 
+/ check_column_block.c
+/
+/ Test cases for fetching columnar blocks
+/
+/ ------------------------------------------------------------------------------
+/ 
+/ Version: MPL 1.1/GPL 2.0/LGPL 2.1
+/ 
+/ The contents of this file are subject to the Mozilla Public License Version
+/ 1.1 (the "License"); you may not use this file except in compliance with
+/ the License. You may obtain a copy of the License at
+/ http://www.mozilla.org/MPL/
+/ 
+/ Software distributed under the License is distributed on an "AS IS" basis,
+/ WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+/ for the specific language governing rights and limitations under the
+/ License.
+/
+/ The Original Code is the FreeXL library
+/
+/ The Initial Developer of the Original Code is Alessandro Furieri
+/ 
+/ Portions created by the Initial Developer are Copyright (C) 2021
+/ the Initial Developer. All Rights Reserved.
+/ 
+/ Contributor(s):
+/
+/ Alternatively, the contents of this file may be used under the terms of
+/ either the GNU General Public License Version 2 or later (the "GPL"), or
+/ the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+/ in which case the provisions of the GPL or the LGPL are applicable instead
+/ of those above. If you wish to allow use of your version of this file only
+/ under the terms of either the GPL or the LGPL, and not to allow others to
+/ use your version of this file under the terms of the MPL, indicate your
+/ decision by deleting the provisions above and replace them with the notice
+/ and other provisions required by the GPL or the LGPL. If you do not delete
+/ the provisions above, a recipient may use your version of this file under
+/ the terms of any one of the MPL, the GPL or the LGPL.
+/ 
+*/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "freexl.h"
+
+#if defined(_WIN32) && !defined(__MINGW32__)
+#include "config-msvc.h"
+#else
+#include "config.h"
+#endif
+
+static int
+check_cell (const FreeXL_ColumnBlock * block, unsigned int i,
+	    const FreeXL_CellValue * cell)
+{
+/* comparing a Column Block entry against a single Cell */
+    int valid = (block->validity[i / 8] >> (i % 8)) & 1;
+    unsigned int len = block->offsets[i + 1] - block->offsets[i];
+    if (block->types[i] != cell->type)
+	return 0;
+    if (valid != (cell->type != FREEXL_CELL_NULL))
+	return 0;
+    switch (cell->type)
+      {
+      case FREEXL_CELL_INT:
+	  return block->int_values[i] == cell->value.int_value && len == 0;
+      case FREEXL_CELL_DOUBLE:
+	  return block->double_values[i] == cell->value.double_value
+	      && len == 0;
+      case FREEXL_CELL_TEXT:
+      case FREEXL_CELL_SST_TEXT:
+      case FREEXL_CELL_DATE:
+      case FREEXL_CELL_DATETIME:
+      case FREEXL_CELL_TIME:
+	  return len == strlen (cell->value.text_value)
+	      && memcmp (block->text + block->offsets[i],
+			 cell->value.text_value, len) == 0;
+      };
+    return len == 0;
+}
+
+static int
+check_column (const void *handle, unsigned short col, unsigned int rows)
+{
+/* comparing a whole Column against single Cell access */
+    FreeXL_ColumnBlock block;
+    FreeXL_CellValue cell;
+    unsigned int i;
+    int ret;
+    int ok = 0;
+
+    memset (&block, 0, sizeof (block));
+    block.types = malloc (rows);
+    block.int_values = malloc (sizeof (int) * rows);
+    block.double_values = malloc (sizeof (double) * rows);
+    block.validity = malloc ((rows + 7) / 8);
+    block.offsets = malloc (sizeof (unsigned int) * (rows + 1));
+
+/* a first pass only measures the text buffer */
+    ret = freexl_get_column_block (handle, col, 0, rows, &block);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "Error sizing column block (%u): %d\n", col, ret);
+	  goto end;
+      }
+    if (block.text_length > 0)
+      {
+	  /* a buffer one byte too short must be rejected */
+	  block.text = malloc (block.text_length);
+	  block.text_size = block.text_length - 1;
+	  ret = freexl_get_column_block (handle, col, 0, rows, &block);
+	  if (ret != FREEXL_BUFFER_TOO_SMALL)
+	    {
+		fprintf (stderr, "Unexpected result for short buffer: %d\n",
+			 ret);
+		goto end;
+	    }
+	  block.text_size = block.text_length;
+      }
+    ret = freexl_get_column_block (handle, col, 0, rows, &block);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "Error getting column block (%u): %d\n", col, ret);
+	  goto end;
+      }
+    for (i = 0; i < rows; i++)
+      {
+	  ret = freexl_get_cell_value (handle, i, col, &cell);
+	  if (ret != FREEXL_OK)
+	    {
+		fprintf (stderr, "Error getting cell value (%u,%u): %d\n", i,
+			 col, ret);
+		goto end;
+	    }
+	  if (!check_cell (&block, i, &cell))
+	    {
+		fprintf (stderr, "Mismatching cell (%u,%u)\n", i, col);
+		goto end;
+	    }
+      }
+    ok = 1;
+  end:
+    free (block.types);
+    free (block.int_values);
+    free (block.double_values);
+    free (block.validity);
+    free (block.offsets);
+    if (block.text != NULL)
+	free (block.text);
+    return ok;
+}
+
+static int
+check_document (const void *handle)
+{
+/* comparing every Column of every Worksheet */
+    FreeXL_ColumnBlock block;
+    unsigned int max_worksheet;
+    unsigned int idx;
+    int ret;
+
+    ret = freexl_get_worksheets_count (handle, &max_worksheet);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "GET-WORKSHEETS-COUNT Error: %d\n", ret);
+	  return -10;
+      }
+    for (idx = 0; idx < max_worksheet; idx++)
+      {
+	  unsigned int rows;
+	  unsigned short columns;
+	  unsigned short col;
+	  ret = freexl_select_active_worksheet (handle, idx);
+	  if (ret != FREEXL_OK)
+	    {
+		fprintf (stderr, "Error setting active worksheet: %d\n", ret);
+		return -11;
+	    }
+	  ret = freexl_worksheet_dimensions (handle, &rows, &columns);
+	  if (ret != FREEXL_OK)
+	    {
+		fprintf (stderr, "Error getting worksheet dimensions: %d\n",
+			 ret);
+		return -12;
+	    }
+	  if (rows == 0 || columns == 0)
+	      continue;
+	  for (col = 0; col < columns; col++)
+	    {
+		if (!check_column (handle, col, rows))
+		    return -13;
+	    }
+	  /* blocks beyond the Worksheet end are invalid */
+	  memset (&block, 0, sizeof (block));
+	  ret = freexl_get_column_block (handle, 0, 1, rows, &block);
+	  if (ret != FREEXL_ILLEGAL_CELL_ROW_COL)
+	    {
+		fprintf (stderr, "Unexpected result for illegal range: %d\n",
+			 ret);
+		return -14;
+	    }
+	  ret = freexl_get_column_block (handle, columns, 0, 1, &block);
+	  if (ret != FREEXL_ILLEGAL_CELL_ROW_COL)
+	    {
+		fprintf (stderr, "Unexpected result for illegal column: %d\n",
+			 ret);
+		return -15;
+	    }
+      }
+    ret = freexl_get_column_block (handle, 0, 0, 1, NULL);
+    if (ret != FREEXL_NULL_ARGUMENT)
+      {
+	  fprintf (stderr, "Unexpected result for NULL block: %d\n", ret);
+	  return -16;
+      }
+    return 0;
+}
+
+int
+main (int argc, char *argv[])
+{
+    const void *handle;
+    int ret;
+    int ret2;
+
+    ret = freexl_open ("testdata/testcase1.xls", &handle);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "OPEN ERROR: %d\n", ret);
+	  return -1;
+      }
+    ret2 = check_document (handle);
+    ret = freexl_close (handle);
+    if (ret2 != 0)
+	return ret2;
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "CLOSE ERROR: %d\n", ret);
+	  return -2;
+      }
+
+#ifdef OMIT_XMLDOC		/* XML support is not enabled */
+    fprintf (stderr,
+	     "Sorry, this version of check_column_block was built by disabling support XML documents\n");
+#else
+    ret = freexl_open_xlsx ("testdata/test_xml.xlsx", &handle);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "OPEN XLSX ERROR: %d\n", ret);
+	  return -3;
+      }
+    ret2 = check_document (handle);
+    ret = freexl_close (handle);
+    if (ret2 != 0)
+	return ret2 - 20;
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "CLOSE XLSX ERROR: %d\n", ret);
+	  return -4;
+      }
+
+    ret = freexl_open_ods ("testdata/test_dates.ods", &handle);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "OPEN ODS ERROR: %d\n", ret);
+	  return -5;
+      }
+    ret2 = check_document (handle);
+    ret = freexl_close (handle);
+    if (ret2 != 0)
+	return ret2 - 40;
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "CLOSE ODS ERROR: %d\n", ret);
+	  return -6;
+      }
+#endif /* end conditional XML support */
+
+    if (argc > 1 || argv[0] == NULL)
+	argc = 1;		/* silencing stupid compiler warnings */
+
+    return 0;
+}
@@ -0,0 +1,343 @@
+/* 
+/ check_column_stats.c
+/
+/ Test cases for per-column statistics
+/
+/ ------------------------------------------------------------------------------
+/ 
+/ Version: MPL 1.1/GPL 2.0/LGPL 2.1
+/ 
+/ The contents of this file are subject to the Mozilla Public License Version
+/ 1.1 (the "License"); you may not use this file except in compliance with
+/ the License. You may obtain a copy of the License at
+/ http://www.mozilla.org/MPL/
+/ 
+/ Software distributed under the License is distributed on an "AS IS" basis,
+/ WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+/ for the specific language governing rights and limitations under the
+/ License.
+/
+/ The Original Code is the FreeXL library
+/
+/ The Initial Developer of the Original Code is Alessandro Furieri
+/ 
+/ Portions created by the Initial Developer are Copyright (C) 2021
+/ the Initial Developer. All Rights Reserved.
+/ 
+/ Contributor(s):
+/
+/ Alternatively, the contents of this file may be used under the terms of
+/ either the GNU General Public License Version 2 or later (the "GPL"), or
+/ the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+/ in which case the provisions of the GPL or the LGPL are applicable instead
+/ of those above. If you wish to allow use of your version of this file only
+/ under the terms of either the GPL or the LGPL, and not to allow others to
+/ use your version of this file under the terms of the MPL, indicate your
+/ decision by deleting the provisions above and replace them with the notice
+/ and other provisions required by the GPL or the LGPL. If you do not delete
+/ the provisions above, a recipient may use your version of this file under
+/ the terms of any one of the MPL, the GPL or the LGPL.
+/ 
+*/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "freexl.h"
+
+#if defined(_WIN32) && !defined(__MINGW32__)
+#include "config-msvc.h"
+#else
+#include "config.h"
+#endif
+
+static int
+dense_column_stats (const void *handle, unsigned int rows,
+		    unsigned short column, FreeXL_ColumnStats * stats)
+{
+/* computing the expected statistics by querying each Cell in turn */
+    unsigned int row;
+    FreeXL_CellValue cell;
+    unsigned int numbers = 0;
+    size_t len;
+
+    memset (stats, 0, sizeof (FreeXL_ColumnStats));
+    for (row = 0; row < rows; row++)
+      {
+	  double num = 0.0;
+	  if (freexl_get_cell_value (handle, row, column, &cell) != FREEXL_OK)
+	      return 0;
+	  switch (cell.type)
+	    {
+	    case FREEXL_CELL_NULL:
+		stats->null_count++;
+		break;
+	    case FREEXL_CELL_INT:
+		stats->int_count++;
+		num = cell.value.int_value;
+		break;
+	    case FREEXL_CELL_DOUBLE:
+		stats->double_count++;
+		num = cell.value.double_value;
+		break;
+	    case FREEXL_CELL_TEXT:
+	    case FREEXL_CELL_SST_TEXT:
+		stats->text_count++;
+		len = strlen (cell.value.text_value);
+		if (len > stats->max_text_length)
+		    stats->max_text_length = len;
+		break;
+	    case FREEXL_CELL_DATE:
+		stats->date_count++;
+		break;
+	    case FREEXL_CELL_DATETIME:
+		stats->datetime_count++;
+		break;
+	    case FREEXL_CELL_TIME:
+		stats->time_count++;
+		break;
+	    };
+	  if (cell.type == FREEXL_CELL_INT || cell.type == FREEXL_CELL_DOUBLE)
+	    {
+		if (numbers == 0 || num < stats->min_value)
+		    stats->min_value = num;
+		if (numbers == 0 || num > stats->max_value)
+		    stats->max_value = num;
+		numbers++;
+	    }
+      }
+    return 1;
+}
+
+static int
+same_stats (const FreeXL_ColumnStats * a, const FreeXL_ColumnStats * b)
+{
+/* comparing two sets of statistics (but the suggested type) */
+    return a->null_count == b->null_count && a->int_count == b->int_count
+	&& a->double_count == b->double_count
+	&& a->text_count == b->text_count && a->date_count == b->date_count
+	&& a->datetime_count == b->datetime_count
+	&& a->time_count == b->time_count && a->min_value == b->min_value
+	&& a->max_value == b->max_value
+	&& a->max_text_length == b->max_text_length;
+}
+
+static int
+check_document (const void *handle, int *n_typed)
+{
+/* comparing the statistics against a dense scan, for each Worksheet */
+    unsigned int max_worksheet;
+    unsigned int idx;
+    int ret;
+
+    *n_typed = 0;
+    ret = freexl_get_worksheets_count (handle, &max_worksheet);
+    if (ret != FREEXL_OK)
+	return -10;
+    for (idx = 0; idx < max_worksheet; idx++)
+      {
+	  unsigned int rows;
+	  unsigned short columns;
+	  unsigned short col;
+	  FreeXL_ColumnStats *stats;
+	  FreeXL_ColumnStats one;
+	  FreeXL_ColumnStats dense;
+
+	  ret = freexl_select_active_worksheet (handle, idx);
+	  if (ret != FREEXL_OK)
+	      return -11;
+	  ret = freexl_worksheet_dimensions (handle, &rows, &columns);
+	  if (ret != FREEXL_OK)
+	      return -12;
+	  if (columns == 0)
+	      continue;
+	  stats = malloc (sizeof (FreeXL_ColumnStats) * columns);
+	  ret = freexl_get_column_stats (handle, 0, columns, stats);
+	  if (ret != FREEXL_OK)
+	    {
+		fprintf (stderr, "Error getting column stats: %d\n", ret);
+		free (stats);
+		return -13;
+	    }
+	  for (col = 0; col < columns; col++)
+	    {
+		if (!dense_column_stats (handle, rows, col, &dense))
+		  {
+		      free (stats);
+		      return -14;
+		  }
+		if (!same_stats (stats + col, &dense))
+		  {
+		      fprintf (stderr, "Mismatching stats: sheet %u col %u\n",
+			       idx, col);
+		      free (stats);
+		      return -15;
+		  }
+		/* a single column gives just the same result */
+		ret = freexl_get_column_stats (handle, col, 1, &one);
+		if (ret != FREEXL_OK || !same_stats (&one, &dense)
+		    || one.suggested_type != stats[col].suggested_type)
+		  {
+		      free (stats);
+		      return -16;
+		  }
+		if (stats[col].suggested_type != FREEXL_CELL_NULL)
+		    *n_typed += 1;
+	    }
+	  /* the columns must lie within the Worksheet */
+	  ret = freexl_get_column_stats (handle, 0, columns + 1, stats);
+	  free (stats);
+	  if (ret != FREEXL_ILLEGAL_CELL_ROW_COL)
+	      return -17;
+      }
+    for (idx = max_worksheet; idx > 0; idx--)
+      {
+	  /* going back: each Worksheet keeps its own statistics */
+	  unsigned int rows;
+	  unsigned short columns;
+	  FreeXL_ColumnStats one;
+	  FreeXL_ColumnStats dense;
+
+	  ret = freexl_select_active_worksheet (handle, idx - 1);
+	  if (ret != FREEXL_OK)
+	      return -18;
+	  ret = freexl_worksheet_dimensions (handle, &rows, &columns);
+	  if (ret != FREEXL_OK)
+	      return -19;
+	  if (columns == 0)
+	      continue;
+	  ret = freexl_get_column_stats (handle, columns - 1, 1, &one);
+	  if (ret != FREEXL_OK)
+	      return -20;
+	  if (!dense_column_stats (handle, rows, columns - 1, &dense)
+	      || !same_stats (&one, &dense))
+	    {
+		fprintf (stderr, "Mismatching cached stats: sheet %u\n",
+			 idx - 1);
+		return -21;
+	    }
+      }
+    return 0;
+}
+
+static int
+check_file (const char *path, int mode, int expected)
+{
+/* testing a single document */
+    const void *handle;
+    int ret;
+    int ret2;
+    int n_typed;
+
+    if (mode == 0)
+	ret = freexl_open (path, &handle);
+#ifndef OMIT_XMLDOC
+    else if (mode == 1)
+	ret = freexl_open_xlsx (path, &handle);
+    else
+	ret = freexl_open_ods (path, &handle);
+#endif
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "OPEN ERROR (%s): %d\n", path, ret);
+	  return -1;
+      }
+    ret2 = check_document (handle, &n_typed);
+    ret = freexl_close (handle);
+    if (ret2 != 0)
+      {
+	  fprintf (stderr, "%s: error %d\n", path, ret2);
+	  return ret2;
+      }
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "CLOSE ERROR (%s): %d\n", path, ret);
+	  return -2;
+      }
+    if (n_typed != expected)
+      {
+	  fprintf (stderr, "%s: unexpected number of non-empty columns %d\n",
+		   path, n_typed);
+	  return -3;
+      }
+    return 0;
+}
+
+int
+main (int argc, char *argv[])
+{
+    const void *handle;
+    FreeXL_ColumnStats stats[8];
+    int ret;
+
+    ret = check_file ("testdata/testcase1.xls", 0, 33);
+    if (ret != 0)
+	return ret;
+    ret = check_file ("testdata/datetime2003.xls", 0, 2);
+    if (ret != 0)
+	return ret - 20;
+
+    ret = freexl_get_column_stats (NULL, 0, 1, stats);
+    if (ret != FREEXL_NULL_HANDLE)
+      {
+	  fprintf (stderr, "Unexpected result for NULL handle: %d\n", ret);
+	  return -30;
+      }
+    ret = freexl_open ("testdata/datetime2003.xls", &handle);
+    if (ret != FREEXL_OK)
+	return -31;
+    ret = freexl_get_column_stats (handle, 0, 1, NULL);
+    if (ret != FREEXL_NULL_ARGUMENT)
+      {
+	  freexl_close (handle);
+	  fprintf (stderr, "Unexpected result for NULL stats: %d\n", ret);
+	  return -32;
+      }
+    ret = freexl_select_active_worksheet (handle, 0);
+    if (ret != FREEXL_OK)
+      {
+	  freexl_close (handle);
+	  return -33;
+      }
+    ret = freexl_get_column_stats (handle, 0, 2, stats);
+    freexl_close (handle);
+    if (ret != FREEXL_OK)
+	return -34;
+    /* a header, then a mix of dates, datetimes and times */
+    if (stats[0].null_count != 0 || stats[0].text_count != 1
+	|| stats[0].date_count != 4 || stats[0].datetime_count != 1
+	|| stats[0].time_count != 9 || stats[0].max_text_length != 4
+	|| stats[0].suggested_type != FREEXL_CELL_TEXT)
+	return -35;
+    /* a blank header, then floating point numbers only */
+    if (stats[1].null_count != 4 || stats[1].double_count != 11
+	|| stats[1].int_count != 0 || stats[1].min_value != 14.0
+	|| stats[1].max_value != 46.0
+	|| stats[1].suggested_type != FREEXL_CELL_DOUBLE)
+	return -36;
+
+#ifdef OMIT_XMLDOC		/* XML support is not enabled */
+    fprintf (stderr,
+	     "Sorry, this version of check_column_stats was built by disabling support XML documents\n");
+#else
+    ret = check_file ("testdata/test_xml.xlsx", 1, 15);
+    if (ret != 0)
+	return ret - 40;
+    ret = check_file ("testdata/test_styled.xlsx", 1, 15);
+    if (ret != 0)
+	return ret - 50;
+    ret = check_file ("testdata/test_xml.ods", 2, 15);
+    if (ret != 0)
+	return ret - 60;
+    ret = check_file ("testdata/test_dates.ods", 2, 4);
+    if (ret != 0)
+	return ret - 70;
+#endif /* end conditional XML support */
+
+    if (argc > 1 || argv[0] == NULL)
+	argc = 1;		/* silencing stupid compiler warnings */
+
+    return 0;
+}
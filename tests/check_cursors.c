@@ -0,0 +1,416 @@
+/* 
+/ check_cursors.c
+/
+/ Test cases for read-only cursors shared by many threads
+/
+/ ------------------------------------------------------------------------------
+/ 
+/ Version: MPL 1.1/GPL 2.0/LGPL 2.1
+/ 
+/ The contents of this file are subject to the Mozilla Public License Version
+/ 1.1 (the "License"); you may not use this file except in compliance with
+/ the License. You may obtain a copy of the License at
+/ http://www.mozilla.org/MPL/
+/ 
+/ Software distributed under the License is distributed on an "AS IS" basis,
+/ WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+/ for the specific language governing rights and limitations under the
+/ License.
+/
+/ The Original Code is the FreeXL library
+/
+/ The Initial Developer of the Original Code is Alessandro Furieri
+/ 
+/ Portions created by the Initial Developer are Copyright (C) 2021
+/ the Initial Developer. All Rights Reserved.
+/ 
+/ Contributor(s):
+/
+/ Alternatively, the contents of this file may be used under the terms of
+/ either the GNU General Public License Version 2 or later (the "GPL"), or
+/ the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+/ in which case the provisions of the GPL or the LGPL are applicable instead
+/ of those above. If you wish to allow use of your version of this file only
+/ under the terms of either the GPL or the LGPL, and not to allow others to
+/ use your version of this file under the terms of the MPL, indicate your
+/ decision by deleting the provisions above and replace them with the notice
+/ and other provisions required by the GPL or the LGPL. If you do not delete
+/ the provisions above, a recipient may use your version of this file under
+/ the terms of any one of the MPL, the GPL or the LGPL.
+/ 
+*/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "freexl.h"
+
+#if defined(_WIN32) && !defined(__MINGW32__)
+#include "config-msvc.h"
+#else
+#include "config.h"
+#endif
+
+#if !defined(OMIT_THREADS) && !defined(_WIN32)
+#include <pthread.h>
+#define CURSOR_THREADS
+#endif
+
+#define N_WORKERS	4
+#define N_SHEETS	8
+
+struct worker
+{
+    const void *handle;		/* the shared Workbook */
+    unsigned int n_sheets;
+    unsigned int first;		/* first Worksheet to be checked */
+    const unsigned int *expected;	/* expected checksum of each Worksheet */
+    int error;
+};
+
+static unsigned int
+hash_bytes (unsigned int hash, const void *data, size_t len)
+{
+/* FNV-1a */
+    const unsigned char *p = data;
+    size_t i;
+    for (i = 0; i < len; i++)
+      {
+	  hash ^= p[i];
+	  hash *= 16777619;
+      }
+    return hash;
+}
+
+static unsigned int
+hash_value (unsigned int hash, const FreeXL_CellValue * cell)
+{
+/* adding a Cell value to a checksum */
+    hash = hash_bytes (hash, &(cell->type), sizeof (cell->type));
+    switch (cell->type)
+      {
+      case FREEXL_CELL_INT:
+	  return hash_bytes (hash, &(cell->value.int_value),
+			     sizeof (cell->value.int_value));
+      case FREEXL_CELL_DOUBLE:
+	  return hash_bytes (hash, &(cell->value.double_value),
+			     sizeof (cell->value.double_value));
+      case FREEXL_CELL_TEXT:
+      case FREEXL_CELL_SST_TEXT:
+      case FREEXL_CELL_DATE:
+      case FREEXL_CELL_DATETIME:
+      case FREEXL_CELL_TIME:
+	  if (cell->value.text_value == NULL)
+	      return 0;
+	  return hash_bytes (hash, cell->value.text_value,
+			     strlen (cell->value.text_value));
+      };
+    return hash;
+}
+
+static int
+hash_handle_sheet (const void *handle, unsigned short sheet,
+		   unsigned int *hash)
+{
+/* computing the checksum of a Worksheet through the handle */
+    unsigned int rows;
+    unsigned short columns;
+    unsigned int row;
+    unsigned short col;
+    FreeXL_CellValue cell;
+
+    *hash = 2166136261u;
+    if (freexl_select_active_worksheet (handle, sheet) != FREEXL_OK)
+	return 0;
+    if (freexl_worksheet_dimensions (handle, &rows, &columns) != FREEXL_OK)
+	return 0;
+    for (row = 0; row < rows; row++)
+      {
+	  for (col = 0; col < columns; col++)
+	    {
+		if (freexl_get_cell_value (handle, row, col, &cell) !=
+		    FREEXL_OK)
+		    return 0;
+		*hash = hash_value (*hash, &cell);
+	    }
+      }
+    return 1;
+}
+
+static int
+hash_cursor_sheet (const void *cursor, unsigned short sheet,
+		   unsigned int *hash)
+{
+/* computing the checksum of a Worksheet through a cursor */
+    unsigned int rows;
+    unsigned short columns;
+    unsigned int row;
+    unsigned short col;
+    FreeXL_CellValue cell;
+
+    *hash = 2166136261u;
+    if (freexl_cursor_select_worksheet (cursor, sheet) != FREEXL_OK)
+	return 0;
+    if (freexl_cursor_worksheet_dimensions (cursor, &rows, &columns) !=
+	FREEXL_OK)
+	return 0;
+    for (row = 0; row < rows; row++)
+      {
+	  for (col = 0; col < columns; col++)
+	    {
+		if (freexl_cursor_get_cell_value (cursor, row, col, &cell) !=
+		    FREEXL_OK)
+		    return 0;
+		*hash = hash_value (*hash, &cell);
+	    }
+      }
+    return 1;
+}
+
+static void *
+run_worker (void *arg)
+{
+/* checking all Worksheets through a private cursor */
+    struct worker *w = (struct worker *) arg;
+    const void *cursor;
+    unsigned int i;
+    int pass;
+
+    if (freexl_create_cursor (w->handle, &cursor) != FREEXL_OK)
+      {
+	  w->error = -1;
+	  return NULL;
+      }
+    for (pass = 0; pass < 4; pass++)
+      {
+	  for (i = 0; i < w->n_sheets; i++)
+	    {
+		unsigned int hash;
+		unsigned short sheet = (w->first + i) % w->n_sheets;
+		if (!hash_cursor_sheet (cursor, sheet, &hash))
+		  {
+		      w->error = -2;
+		      break;
+		  }
+		if (hash != w->expected[sheet])
+		  {
+		      w->error = -3;
+		      break;
+		  }
+	    }
+      }
+    freexl_destroy_cursor (cursor);
+    return NULL;
+}
+
+static int
+check_handle (const void *handle)
+{
+/* comparing many concurrent cursors against the handle itself */
+    unsigned int expected[N_SHEETS];
+    struct worker workers[N_WORKERS];
+#ifdef CURSOR_THREADS
+    pthread_t threads[N_WORKERS];
+#endif
+    unsigned int n_sheets;
+    unsigned int i;
+
+    if (freexl_get_worksheets_count (handle, &n_sheets) != FREEXL_OK)
+	return -1;
+    if (n_sheets > N_SHEETS)
+	n_sheets = N_SHEETS;
+    for (i = 0; i < n_sheets; i++)
+      {
+	  if (!hash_handle_sheet (handle, i, expected + i))
+	      return -2;
+      }
+    for (i = 0; i < N_WORKERS; i++)
+      {
+	  workers[i].handle = handle;
+	  workers[i].n_sheets = n_sheets;
+	  workers[i].first = i;
+	  workers[i].expected = expected;
+	  workers[i].error = 0;
+#ifdef CURSOR_THREADS
+	  if (pthread_create (threads + i, NULL, run_worker, workers + i) !=
+	      0)
+	      return -3;
+#else
+	  run_worker (workers + i);
+#endif
+      }
+    for (i = 0; i < N_WORKERS; i++)
+      {
+#ifdef CURSOR_THREADS
+	  pthread_join (threads[i], NULL);
+#endif
+	  if (workers[i].error != 0)
+	    {
+		fprintf (stderr, "worker #%u: error %d\n", i,
+			 workers[i].error);
+		return -4;
+	    }
+      }
+    return 0;
+}
+
+static int
+check_api (const void *handle)
+{
+/* checking the cursor API itself */
+    const void *cursor;
+    unsigned short active;
+    unsigned int rows;
+    unsigned short columns;
+    FreeXL_CellValue cell;
+    int ret;
+
+    ret = freexl_create_cursor (NULL, &cursor);
+    if (ret != FREEXL_NULL_HANDLE)
+	return -1;
+    ret = freexl_create_cursor (handle, NULL);
+    if (ret != FREEXL_NULL_ARGUMENT)
+	return -2;
+    ret = freexl_cursor_get_cell_value (NULL, 0, 0, &cell);
+    if (ret != FREEXL_NULL_HANDLE)
+	return -3;
+    ret = freexl_cursor_get_cell_value (handle, 0, 0, &cell);
+    if (ret != FREEXL_INVALID_HANDLE)
+	return -4;
+
+    ret = freexl_select_active_worksheet (handle, 0);
+    if (ret != FREEXL_OK)
+	return -5;
+    ret = freexl_create_cursor (handle, &cursor);
+    if (ret != FREEXL_OK)
+	return -6;
+    ret = freexl_cursor_select_worksheet (cursor, 999);
+    if (ret == FREEXL_OK)
+	return -7;
+    ret = freexl_cursor_worksheet_dimensions (cursor, &rows, &columns);
+    if (ret != FREEXL_OK)
+	return -8;
+    ret = freexl_cursor_get_cell_value (cursor, rows, 0, &cell);
+    if (ret != FREEXL_ILLEGAL_CELL_ROW_COL)
+	return -9;
+    ret = freexl_cursor_get_cell_value (cursor, 0, 0, NULL);
+    if (ret != FREEXL_NULL_ARGUMENT)
+	return -10;
+    ret = freexl_cursor_select_worksheet (cursor, 1);
+    if (ret != FREEXL_OK)
+	return -11;
+    /* selecting a Worksheet on a cursor never affects the handle */
+    ret = freexl_get_active_worksheet (handle, &active);
+    if (ret != FREEXL_OK || active != 0)
+	return -12;
+    ret = freexl_destroy_cursor (cursor);
+    if (ret != FREEXL_OK)
+	return -13;
+    return 0;
+}
+
+static int
+check_file (const void *handle, const char *path, int api)
+{
+/* testing a single document */
+    int ret;
+    if (api)
+      {
+	  ret = check_api (handle);
+	  if (ret != 0)
+	    {
+		fprintf (stderr, "%s: API error %d\n", path, ret);
+		freexl_close (handle);
+		return ret - 20;
+	    }
+      }
+    ret = check_handle (handle);
+    freexl_close (handle);
+    if (ret != 0)
+      {
+	  fprintf (stderr, "%s: error %d\n", path, ret);
+	  return ret;
+      }
+    return 0;
+}
+
+int
+main (int argc, char *argv[])
+{
+    const void *handle;
+    const void *cursor;
+    int ret;
+
+    ret = freexl_open ("testdata/testcase1.xls", &handle);
+    if (ret != FREEXL_OK)
+	return -1;
+    ret = check_file (handle, "testcase1.xls", 1);
+    if (ret != 0)
+	return ret - 100;
+    ret = freexl_open ("testdata/datetime2003.xls", &handle);
+    if (ret != FREEXL_OK)
+	return -2;
+    ret = check_file (handle, "datetime2003.xls", 0);
+    if (ret != 0)
+	return ret - 200;
+
+/* INFO handles contain no cells at all */
+    ret = freexl_open_info ("testdata/testcase1.xls", &handle);
+    if (ret != FREEXL_OK)
+	return -3;
+    ret = freexl_create_cursor (handle, &cursor);
+    freexl_close (handle);
+    if (ret != FREEXL_INVALID_HANDLE)
+	return -4;
+
+#ifdef OMIT_XMLDOC		/* XML support is not enabled */
+    fprintf (stderr,
+	     "Sorry, this version of check_cursors was built by disabling support XML documents\n");
+#else
+    ret = freexl_open_xlsx ("testdata/test_xml.xlsx", &handle);
+    if (ret != FREEXL_OK)
+	return -5;
+    ret = check_file (handle, "test_xml.xlsx", 1);
+    if (ret != 0)
+	return ret - 300;
+    ret = freexl_open_xlsx ("testdata/test_styled.xlsx", &handle);
+    if (ret != FREEXL_OK)
+	return -6;
+    ret = check_file (handle, "test_styled.xlsx", 0);
+    if (ret != 0)
+	return ret - 400;
+    {
+	/* lazy SharedStrings: a tiny cache shared by all cursors */
+	FreeXL_OpenOptions options;
+	freexl_init_open_options (&options);
+	options.xlsx_strings_mode = FREEXL_XLSX_STRINGS_LAZY;
+	options.xlsx_strings_cache = 2;
+	ret = freexl_open_xlsx_ex ("testdata/test_xml.xlsx", &options,
+				   &handle);
+	if (ret != FREEXL_OK)
+	    return -7;
+	ret = check_file (handle, "test_xml.xlsx (lazy)", 0);
+	if (ret != 0)
+	    return ret - 500;
+    }
+    ret = freexl_open_ods ("testdata/test_xml.ods", &handle);
+    if (ret != FREEXL_OK)
+	return -8;
+    ret = check_file (handle, "test_xml.ods", 1);
+    if (ret != 0)
+	return ret - 600;
+    ret = freexl_open_ods ("testdata/test_dates.ods", &handle);
+    if (ret != FREEXL_OK)
+	return -9;
+    ret = check_file (handle, "test_dates.ods", 0);
+    if (ret != 0)
+	return ret - 700;
+#endif /* end conditional XML support */
+
+    if (argc > 1 || argv[0] == NULL)
+	argc = 1;		/* silencing stupid compiler warnings */
+
+    return 0;
+}
@@ -0,0 +1,132 @@
+/* 
+/ check_helpers.h
+/
+/ Helper functions shared by many test cases
+/
+/ ------------------------------------------------------------------------------
+/ 
+/ Version: MPL 1.1/GPL 2.0/LGPL 2.1
+/ 
+/ The contents of this file are subject to the Mozilla Public License Version
+/ 1.1 (the "License"); you may not use this file except in compliance with
+/ the License. You may obtain a copy of the License at
+/ http://www.mozilla.org/MPL/
+/ 
+/ Software distributed under the License is distributed on an "AS IS" basis,
+/ WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+/ for the specific language governing rights and limitations under the
+/ License.
+/
+/ The Original Code is the FreeXL library
+/
+/ The Initial Developer of the Original Code is Alessandro Furieri
+/ 
+/ Portions created by the Initial Developer are Copyright (C) 2021
+/ the Initial Developer. All Rights Reserved.
+/ 
+/ Contributor(s):
+/
+/ Alternatively, the contents of this file may be used under the terms of
+/ either the GNU General Public License Version 2 or later (the "GPL"), or
+/ the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+/ in which case the provisions of the GPL or the LGPL are applicable instead
+/ of those above. If you wish to allow use of your version of this file only
+/ under the terms of either the GPL or the LGPL, and not to allow others to
+/ use your version of this file under the terms of the MPL, indicate your
+/ decision by deleting the provisions above and replace them with the notice
+/ and other provisions required by the GPL or the LGPL. If you do not delete
+/ the provisions above, a recipient may use your version of this file under
+/ the terms of any one of the MPL, the GPL or the LGPL.
+/ 
+*/
+
+#ifndef CHECK_HELPERS_H
+#define CHECK_HELPERS_H
+
+#include <stdio.h>
+#include <string.h>
+
+#include "freexl.h"
+
+static int
+same_value (const FreeXL_CellValue * a, const FreeXL_CellValue * b)
+{
+/* comparing two Cell values */
+    if (a->type != b->type)
+	return 0;
+    switch (a->type)
+      {
+      case FREEXL_CELL_INT:
+	  return a->value.int_value == b->value.int_value;
+      case FREEXL_CELL_DOUBLE:
+	  return a->value.double_value == b->value.double_value;
+      case FREEXL_CELL_TEXT:
+      case FREEXL_CELL_SST_TEXT:
+      case FREEXL_CELL_DATE:
+      case FREEXL_CELL_DATETIME:
+      case FREEXL_CELL_TIME:
+	  return strcmp (a->value.text_value, b->value.text_value) == 0;
+      };
+    return 1;
+}
+
+static int
+compare_sheet (const void *expected, const void *actual, unsigned short sheet)
+{
+/* comparing all cells from the same Worksheet of two Workbooks */
+    int ret;
+    unsigned int num_rows;
+    unsigned short num_columns;
+    unsigned int num_rows2;
+    unsigned short num_columns2;
+    unsigned int row;
+    unsigned short col;
+    FreeXL_CellValue cell1;
+    FreeXL_CellValue cell2;
+
+    ret = freexl_select_active_worksheet (expected, sheet);
+    if (ret != FREEXL_OK)
+	return 0;
+    ret = freexl_select_active_worksheet (actual, sheet);
+    if (ret != FREEXL_OK)
+	return 0;
+    ret = freexl_worksheet_dimensions (expected, &num_rows, &num_columns);
+    if (ret != FREEXL_OK)
+	return 0;
+    ret = freexl_worksheet_dimensions (actual, &num_rows2, &num_columns2);
+    if (ret != FREEXL_OK)
+	return 0;
+    if (num_rows != num_rows2 || num_columns != num_columns2)
+      {
+	  fprintf (stderr, "Mismatching sheet #%u dimensions: %u x %u\n",
+		   sheet, num_rows2, num_columns2);
+	  return 0;
+      }
+    for (row = 0; row < num_rows; row++)
+      {
+	  for (col = 0; col < num_columns; col++)
+	    {
+		ret = freexl_get_cell_value (expected, row, col, &cell1);
+		if (ret != FREEXL_OK)
+		    return 0;
+		ret = freexl_get_cell_value (actual, row, col, &cell2);
+		if (ret != FREEXL_OK)
+		    return 0;
+		if (cell1.type != cell2.type)
+		  {
+		      fprintf (stderr, "Mismatching cell (%u,%u) type: %u %u\n",
+			       row, col, cell1.type, cell2.type);
+		      return 0;
+		  }
+		if (!same_value (&cell1, &cell2))
+		  {
+		      fprintf (stderr, "Mismatching cell (%u,%u) value\n", row,
+			       col);
+		      return 0;
+		  }
+	    }
+      }
+    return 1;
+}
+
+#endif /* CHECK_HELPERS_H */
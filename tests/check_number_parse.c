@@ -0,0 +1,293 @@
+/* 
+/ check_number_parse.c
+/
+/ Test cases (and micro-benchmark) for XML numeric tokens parsing
+/
+/ ------------------------------------------------------------------------------
+/ 
+/ Version: MPL 1.1/GPL 2.0/LGPL 2.1
+/ 
+/ The contents of this file are subject to the Mozilla Public License Version
+/ 1.1 (the "License"); you may not use this file except in compliance with
+/ the License. You may obtain a copy of the License at
+/ http://www.mozilla.org/MPL/
+/ 
+/ Software distributed under the License is distributed on an "AS IS" basis,
+/ WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+/ for the specific language governing rights and limitations under the
+/ License.
+/
+/ The Original Code is the FreeXL library
+/
+/ The Initial Developer of the Original Code is Alessandro Furieri
+/ 
+/ Portions created by the Initial Developer are Copyright (C) 2021
+/ the Initial Developer. All Rights Reserved.
+/ 
+/ Contributor(s):
+/
+/ Alternatively, the contents of this file may be used under the terms of
+/ either the GNU General Public License Version 2 or later (the "GPL"), or
+/ the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+/ in which case the provisions of the GPL or the LGPL are applicable instead
+/ of those above. If you wish to allow use of your version of this file only
+/ under the terms of either the GPL or the LGPL, and not to allow others to
+/ use your version of this file under the terms of the MPL, indicate your
+/ decision by deleting the provisions above and replace them with the notice
+/ and other provisions required by the GPL or the LGPL. If you do not delete
+/ the provisions above, a recipient may use your version of this file under
+/ the terms of any one of the MPL, the GPL or the LGPL.
+/ 
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <locale.h>
+#include <time.h>
+
+#include "freexl.h"
+
+/* 
+ * internal functions: not part of the public API (and not exported by
+ * the library), so this test is statically linked to libfreexl_utils
+ */
+#define XML_NUMBER_INTEGER	1
+#define XML_NUMBER_DOUBLE	2
+extern int parse_xml_number (const char *str, int *int_value,
+			     double *dbl_value);
+
+#define N_VALUES	100000
+
+static int
+check_int (const char *str, int expected)
+{
+/* checking a token expected to be an INTEGER */
+    int i_val;
+    double d_val;
+    if (parse_xml_number (str, &i_val, &d_val) != XML_NUMBER_INTEGER)
+      {
+	  fprintf (stderr, "\"%s\": INTEGER expected\n", str);
+	  return 0;
+      }
+    if (i_val != expected)
+      {
+	  fprintf (stderr, "\"%s\": unexpected value %d\n", str, i_val);
+	  return 0;
+      }
+    return 1;
+}
+
+static int
+check_double (const char *str, double expected)
+{
+/* checking a token expected to be a DOUBLE */
+    int i_val;
+    double d_val;
+    if (parse_xml_number (str, &i_val, &d_val) != XML_NUMBER_DOUBLE)
+      {
+	  fprintf (stderr, "\"%s\": DOUBLE expected\n", str);
+	  return 0;
+      }
+    if (memcmp (&d_val, &expected, sizeof (double)) != 0)
+      {
+	  fprintf (stderr, "\"%s\": unexpected value %1.17g\n", str, d_val);
+	  return 0;
+      }
+    return 1;
+}
+
+static double
+random_double (unsigned int *seed)
+{
+/* a pseudo-random finite double, spanning all magnitudes */
+    double value;
+    unsigned char bytes[sizeof (double)];
+    unsigned int i;
+    while (1)
+      {
+	  for (i = 0; i < sizeof (double); i++)
+	    {
+		*seed = (*seed * 1103515245) + 12345;
+		bytes[i] = (*seed >> 16) & 0xff;
+	    }
+	  memcpy (&value, bytes, sizeof (double));
+	  if (value == value && value - value == 0.0)
+	      return value;
+      }
+}
+
+static int
+check_random (void)
+{
+/* checking random values against strtod() */
+    unsigned int seed = 1;
+    int i;
+    char str[64];
+    for (i = 0; i < N_VALUES; i++)
+      {
+	  double value = random_double (&seed);
+	  double expected;
+	  int i_val;
+	  double d_val;
+	  int type;
+	  sprintf (str, (i % 2) ? "%1.17g" : "%1.15g", value);
+	  expected = strtod (str, NULL);
+	  type = parse_xml_number (str, &i_val, &d_val);
+	  if (type == XML_NUMBER_INTEGER)
+	      d_val = i_val;
+	  if (d_val != expected)
+	    {
+		fprintf (stderr, "\"%s\": unexpected value %1.17g\n", str,
+			 d_val);
+		return 0;
+	    }
+      }
+    return 1;
+}
+
+static char **
+build_samples (void)
+{
+/* building a realistic mix of cell values */
+    unsigned int seed = 7;
+    int i;
+    char str[64];
+    char **samples = malloc (sizeof (char *) * N_VALUES);
+    for (i = 0; i < N_VALUES; i++)
+      {
+	  seed = (seed * 1103515245) + 12345;
+	  switch ((seed >> 16) % 6)
+	    {
+	    case 0:		/* small counters */
+		sprintf (str, "%u", (seed >> 8) % 1000);
+		break;
+	    case 1:		/* identifiers */
+		sprintf (str, "%u", (seed >> 1) % 1000000000);
+		break;
+	    case 2:		/* currency amounts */
+		sprintf (str, "%u.%02u", (seed >> 8) % 100000, seed % 100);
+		break;
+	    case 3:		/* date serials */
+		sprintf (str, "%u", 30000 + ((seed >> 8) % 20000));
+		break;
+	    case 4:		/* times and percentages */
+		sprintf (str, "%1.16g", ((seed >> 8) % 86400) / 86400.0);
+		break;
+	    default:		/* computed values */
+		sprintf (str, "%1.17g", ((seed >> 8) % 1000000) / 7.0);
+		break;
+	    };
+	  samples[i] = malloc (strlen (str) + 1);
+	  strcpy (samples[i], str);
+      }
+    return samples;
+}
+
+static void
+do_benchmark (void)
+{
+/* comparing against the former atoi() + atof() approach */
+    char **samples = build_samples ();
+    int loop;
+    int i;
+    clock_t t0;
+    double t_old;
+    double t_new;
+    double sum = 0.0;
+    t0 = clock ();
+    for (loop = 0; loop < 20; loop++)
+      {
+	  for (i = 0; i < N_VALUES; i++)
+	    {
+		int i_val = atoi (samples[i]);
+		double d_val = atof (samples[i]);
+		if (i_val != d_val)
+		    sum += d_val;
+		else
+		    sum += i_val;
+	    }
+      }
+    t_old = (double) (clock () - t0) / CLOCKS_PER_SEC;
+    t0 = clock ();
+    for (loop = 0; loop < 20; loop++)
+      {
+	  for (i = 0; i < N_VALUES; i++)
+	    {
+		int i_val;
+		double d_val;
+		if (parse_xml_number (samples[i], &i_val, &d_val) ==
+		    XML_NUMBER_INTEGER)
+		    sum += i_val;
+		else
+		    sum += d_val;
+	    }
+      }
+    t_new = (double) (clock () - t0) / CLOCKS_PER_SEC;
+    printf ("%d values: atoi+atof %1.3fs, parse_xml_number %1.3fs (%g)\n",
+	    N_VALUES * 20, t_old, t_new, sum);
+    for (i = 0; i < N_VALUES; i++)
+	free (samples[i]);
+    free (samples);
+}
+
+int
+main (int argc, char *argv[])
+{
+    if (!check_int ("0", 0))
+	return -1;
+    if (!check_int ("42", 42))
+	return -2;
+    if (!check_int ("-17", -17))
+	return -3;
+    if (!check_int ("2147483647", INT_MAX))
+	return -4;
+    if (!check_int ("-2147483648", INT_MIN))
+	return -5;
+    if (!check_double ("2147483648", 2147483648.0))
+	return -6;
+    if (!check_int ("1.0", 1))
+	return -7;
+    if (!check_int ("1E3", 1000))
+	return -8;
+    if (!check_int ("  12abc", 12))
+	return -9;
+    if (!check_int ("", 0))
+	return -10;
+    if (!check_double ("1.5", 1.5))
+	return -11;
+    if (!check_double ("0.1", 0.1))
+	return -12;
+    if (!check_double ("-1.2345e-7", -1.2345e-7))
+	return -13;
+    if (!check_double ("0.30000000000000004", 0.30000000000000004))
+	return -14;
+    if (!check_double ("1.7976931348623157E+308", 1.7976931348623157e308))
+	return -15;
+    if (!check_double ("4.9406564584124654e-324", 4.9406564584124654e-324))
+	return -16;
+    if (!check_double ("123456789012345678901234567890",
+		       123456789012345678901234567890.0))
+	return -17;
+    if (!check_double ("0.000001", 0.000001))
+	return -18;
+    if (!check_random ())
+	return -19;
+
+    if (setlocale (LC_NUMERIC, "de_DE.UTF-8") != NULL
+	|| setlocale (LC_NUMERIC, "fr_FR.UTF-8") != NULL)
+      {
+	  /* the decimal point must not depend on the current locale */
+	  if (!check_double ("1.5", 1.5))
+	      return -20;
+	  if (!check_double ("0.30000000000000004", 0.30000000000000004))
+	      return -21;
+	  setlocale (LC_NUMERIC, "C");
+      }
+
+    if (argc > 1 && strcmp (argv[1], "--bench") == 0)
+	do_benchmark ();
+
+    return 0;
+}
@@ -0,0 +1,197 @@
+/* 
+/ check_ods_dates.c
+/
+/ Test cases for ODS dates and times
+/
+/ ------------------------------------------------------------------------------
+/ 
+/ Version: MPL 1.1/GPL 2.0/LGPL 2.1
+/ 
+/ The contents of this file are subject to the Mozilla Public License Version
+/ 1.1 (the "License"); you may not use this file except in compliance with
+/ the License. You may obtain a copy of the License at
+/ http://www.mozilla.org/MPL/
+/ 
+/ Software distributed under the License is distributed on an "AS IS" basis,
+/ WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+/ for the specific language governing rights and limitations under the
+/ License.
+/
+/ The Original Code is the FreeXL library
+/
+/ The Initial Developer of the Original Code is Alessandro Furieri
+/ 
+/ Portions created by the Initial Developer are Copyright (C) 2021
+/ the Initial Developer. All Rights Reserved.
+/ 
+/ Contributor(s):
+/
+/ Alternatively, the contents of this file may be used under the terms of
+/ either the GNU General Public License Version 2 or later (the "GPL"), or
+/ the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+/ in which case the provisions of the GPL or the LGPL are applicable instead
+/ of those above. If you wish to allow use of your version of this file only
+/ under the terms of either the GPL or the LGPL, and not to allow others to
+/ use your version of this file under the terms of the MPL, indicate your
+/ decision by deleting the provisions above and replace them with the notice
+/ and other provisions required by the GPL or the LGPL. If you do not delete
+/ the provisions above, a recipient may use your version of this file under
+/ the terms of any one of the MPL, the GPL or the LGPL.
+/ 
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "freexl.h"
+
+#if defined(_WIN32) && !defined(__MINGW32__)
+#include "config-msvc.h"
+#else
+#include "config.h"
+#endif
+
+static int
+check_text (const void *handle, unsigned int row, unsigned short col,
+	    const char *expected)
+{
+/* checking a single Cell, expected to contain some text */
+    FreeXL_CellValue cell;
+    int ret = freexl_get_cell_value (handle, row, col, &cell);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "Error getting cell value (%u,%u): %d\n", row, col,
+		   ret);
+	  return 0;
+      }
+    if (cell.type != FREEXL_CELL_TEXT)
+      {
+	  fprintf (stderr, "Unexpected cell (%u,%u) type: %u\n", row, col,
+		   cell.type);
+	  return 0;
+      }
+    if (strcmp (cell.value.text_value, expected) != 0)
+      {
+	  fprintf (stderr, "Unexpected cell (%u,%u) value: %s\n", row, col,
+		   cell.value.text_value);
+	  return 0;
+      }
+    return 1;
+}
+
+int
+main (int argc, char *argv[])
+{
+#ifdef OMIT_XMLDOC		/* XML support is not enabled */
+    fprintf (stderr,
+	     "Sorry, this version of check_ods_dates was built by disabling support XML documents\n");
+    return 0;
+#else
+    const void *handle;
+    FreeXL_CellValue cell;
+    const char *first;
+    unsigned int rows;
+    unsigned short columns;
+    int ret;
+    int i;
+
+    ret = freexl_open_ods ("testdata/test_dates.ods", &handle);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "OPEN ERROR: %d\n", ret);
+	  return -1;
+      }
+    ret = freexl_select_active_worksheet (handle, 0);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "SELECT ERROR: %d\n", ret);
+	  return -2;
+      }
+    ret = freexl_worksheet_dimensions (handle, &rows, &columns);
+    if (ret != FREEXL_OK || rows != 2 || columns != 4)
+      {
+	  fprintf (stderr, "Unexpected dimensions: %u x %u\n", rows, columns);
+	  return -3;
+      }
+
+/* dates */
+    if (!check_text (handle, 0, 0, "1956-02-02"))
+	return -4;
+    if (!check_text (handle, 0, 1, "2021-06-06 19:23:05"))
+	return -5;
+    if (!check_text (handle, 0, 2, "2021-06-06 07:08:10"))
+	return -6;
+    if (!check_text (handle, 0, 3, "2021-13-45"))
+	return -7;
+
+/* times */
+    if (!check_text (handle, 1, 0, "12:30:00"))
+	return -8;
+    if (!check_text (handle, 1, 1, "26:05:07"))
+	return -9;
+    if (!check_text (handle, 1, 2, "00:01:00"))
+	return -10;
+    if (!check_text (handle, 1, 3, "-PT01H00M00S"))
+	return -11;
+
+/* any returned value must survive until the Workbook is closed */
+    ret = freexl_get_cell_value (handle, 0, 0, &cell);
+    if (ret != FREEXL_OK)
+	return -12;
+    first = cell.value.text_value;
+    for (i = 0; i < 1000; i++)
+      {
+	  if (!check_text (handle, 1, 0, "12:30:00"))
+	      return -13;
+      }
+    if (strcmp (first, "1956-02-02") != 0)
+      {
+	  fprintf (stderr, "Unexpected recycled value: %s\n", first);
+	  return -14;
+      }
+
+/* reading the same Cell again allocates nothing: the same text is returned */
+    ret = freexl_get_cell_value (handle, 0, 0, &cell);
+    if (ret != FREEXL_OK || cell.value.text_value != first)
+      {
+	  fprintf (stderr, "Unexpected further DATE text\n");
+	  return -22;
+      }
+
+    ret = freexl_close (handle);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "CLOSE ERROR: %d\n", ret);
+	  return -15;
+      }
+
+/* rounding, and values too long to be normalized */
+    ret = freexl_open_ods ("testdata/test_durations.ods", &handle);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "OPEN ERROR: %d\n", ret);
+	  return -16;
+      }
+    ret = freexl_select_active_worksheet (handle, 0);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "SELECT ERROR: %d\n", ret);
+	  return -17;
+      }
+    if (!check_text (handle, 0, 0, "2021-06-06T23:59:59.7"))
+	return -18;
+    if (!check_text (handle, 0, 1, "P999999D"))
+	return -19;
+    if (!check_text (handle, 0, 2, "480000:00:00"))
+	return -20;
+    if (!check_text (handle, 0, 3, "01:02:04"))
+	return -21;
+    freexl_close (handle);
+
+    if (argc > 1 || argv[0] == NULL)
+	argc = 1;		/* silencing stupid compiler warnings */
+
+    return 0;
+#endif /* end conditional XML support */
+}
@@ -0,0 +1,208 @@
+/* 
+/ check_ods_sheets.c
+/
+/ Test cases for ODS documents loading only some Worksheets
+/
+/ ------------------------------------------------------------------------------
+/ 
+/ Version: MPL 1.1/GPL 2.0/LGPL 2.1
+/ 
+/ The contents of this file are subject to the Mozilla Public License Version
+/ 1.1 (the "License"); you may not use this file except in compliance with
+/ the License. You may obtain a copy of the License at
+/ http://www.mozilla.org/MPL/
+/ 
+/ Software distributed under the License is distributed on an "AS IS" basis,
+/ WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+/ for the specific language governing rights and limitations under the
+/ License.
+/
+/ The Original Code is the FreeXL library
+/
+/ The Initial Developer of the Original Code is Alessandro Furieri
+/ 
+/ Portions created by the Initial Developer are Copyright (C) 2021
+/ the Initial Developer. All Rights Reserved.
+/ 
+/ Contributor(s):
+/
+/ Alternatively, the contents of this file may be used under the terms of
+/ either the GNU General Public License Version 2 or later (the "GPL"), or
+/ the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+/ in which case the provisions of the GPL or the LGPL are applicable instead
+/ of those above. If you wish to allow use of your version of this file only
+/ under the terms of either the GPL or the LGPL, and not to allow others to
+/ use your version of this file under the terms of the MPL, indicate your
+/ decision by deleting the provisions above and replace them with the notice
+/ and other provisions required by the GPL or the LGPL. If you do not delete
+/ the provisions above, a recipient may use your version of this file under
+/ the terms of any one of the MPL, the GPL or the LGPL.
+/ 
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "freexl.h"
+
+#if defined(_WIN32) && !defined(__MINGW32__)
+#include "config-msvc.h"
+#else
+#include "config.h"
+#endif
+
+#include "check_helpers.h"
+
+static int
+check_selection (const void *plain, const char *path, const char **sheets,
+		 unsigned int count)
+{
+/* opening again the same document, but only loading some Worksheets */
+    const void *selected;
+    FreeXL_OpenOptions options;
+    unsigned int count2;
+    unsigned int rows;
+    unsigned short columns;
+    const char *name;
+    const char *name2;
+    const char **p;
+    unsigned int i;
+    int wanted;
+    int ret;
+
+    freexl_init_open_options (&options);
+    options.ods_sheets = sheets;
+    ret = freexl_open_ods_ex (path, &options, &selected);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "OPEN ERROR (selected): %d\n", ret);
+	  return 0;
+      }
+
+/* all Worksheets are expected to be reported anyway */
+    ret = freexl_get_worksheets_count (selected, &count2);
+    if (ret != FREEXL_OK || count != count2)
+      {
+	  fprintf (stderr, "Mismatching worksheet count: %u\n", count2);
+	  return 0;
+      }
+    for (i = 0; i < count; i++)
+      {
+	  ret = freexl_get_worksheet_name (plain, i, &name);
+	  if (ret != FREEXL_OK)
+	      return 0;
+	  ret = freexl_get_worksheet_name (selected, i, &name2);
+	  if (ret != FREEXL_OK || strcmp (name, name2) != 0)
+	    {
+		fprintf (stderr, "Mismatching worksheet #%u name\n", i);
+		return 0;
+	    }
+	  wanted = 0;
+	  for (p = sheets; *p != NULL; p++)
+	    {
+		if (strcmp (*p, name) == 0)
+		    wanted = 1;
+	    }
+	  if (wanted)
+	    {
+		if (!compare_sheet (plain, selected, i))
+		    return 0;
+	    }
+	  else
+	    {
+		/* skipped Worksheets are always empty */
+		ret = freexl_select_active_worksheet (selected, i);
+		if (ret != FREEXL_OK)
+		    return 0;
+		ret = freexl_worksheet_dimensions (selected, &rows, &columns);
+		if (ret != FREEXL_OK || rows != 0 || columns != 0)
+		  {
+		      fprintf (stderr,
+			       "Unexpected skipped sheet #%u dimensions: %u x %u\n",
+			       i, rows, columns);
+		      return 0;
+		  }
+	    }
+      }
+
+    ret = freexl_close (selected);
+    if (ret != FREEXL_OK)
+	return 0;
+    return 1;
+}
+
+int
+main (int argc, char *argv[])
+{
+#ifdef OMIT_XMLDOC		/* XML support is not enabled */
+    fprintf (stderr,
+	     "Sorry, this version of check_ods_sheets was built by disabling support XML documents\n");
+    return 0;
+#else
+    const char *path = "testdata/test_xml.ods";
+    const void *plain;
+    const char *sheets[4];
+    const char *name0;
+    const char *name1;
+    unsigned int count;
+    int ret;
+
+    ret = freexl_open_ods (path, &plain);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "OPEN ERROR: %d\n", ret);
+	  return -1;
+      }
+    ret = freexl_get_worksheets_count (plain, &count);
+    if (ret != FREEXL_OK || count != 2)
+      {
+	  fprintf (stderr, "Unexpected worksheet count: %u\n", count);
+	  return -2;
+      }
+    ret = freexl_get_worksheet_name (plain, 0, &name0);
+    if (ret != FREEXL_OK)
+	return -3;
+    ret = freexl_get_worksheet_name (plain, 1, &name1);
+    if (ret != FREEXL_OK)
+	return -3;
+
+/* only the first Worksheet */
+    sheets[0] = name0;
+    sheets[1] = NULL;
+    if (!check_selection (plain, path, sheets, count))
+	return -4;
+
+/* only the second Worksheet */
+    sheets[0] = name1;
+    sheets[1] = NULL;
+    if (!check_selection (plain, path, sheets, count))
+	return -5;
+
+/* both Worksheets, plus a not existing one */
+    sheets[0] = "no such sheet";
+    sheets[1] = name1;
+    sheets[2] = name0;
+    sheets[3] = NULL;
+    if (!check_selection (plain, path, sheets, count))
+	return -6;
+
+/* nothing at all */
+    sheets[0] = "no such sheet";
+    sheets[1] = NULL;
+    if (!check_selection (plain, path, sheets, count))
+	return -7;
+
+    ret = freexl_close (plain);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "CLOSE ERROR: %d\n", ret);
+	  return -8;
+      }
+
+    if (argc > 1 || argv[0] == NULL)
+	argc = 1;		/* silencing stupid compiler warnings */
+
+    return 0;
+#endif /* end conditional XML support */
+}
@@ -0,0 +1,318 @@
+/* 
+/ check_preview.c
+/
+/ Test cases for the preview open mode
+/
+/ ------------------------------------------------------------------------------
+/ 
+/ Version: MPL 1.1/GPL 2.0/LGPL 2.1
+/ 
+/ The contents of this file are subject to the Mozilla Public License Version
+/ 1.1 (the "License"); you may not use this file except in compliance with
+/ the License. You may obtain a copy of the License at
+/ http://www.mozilla.org/MPL/
+/ 
+/ Software distributed under the License is distributed on an "AS IS" basis,
+/ WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+/ for the specific language governing rights and limitations under the
+/ License.
+/
+/ The Original Code is the FreeXL library
+/
+/ The Initial Developer of the Original Code is Alessandro Furieri
+/ 
+/ Portions created by the Initial Developer are Copyright (C) 2021
+/ the Initial Developer. All Rights Reserved.
+/ 
+/ Contributor(s):
+/
+/ Alternatively, the contents of this file may be used under the terms of
+/ either the GNU General Public License Version 2 or later (the "GPL"), or
+/ the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+/ in which case the provisions of the GPL or the LGPL are applicable instead
+/ of those above. If you wish to allow use of your version of this file only
+/ under the terms of either the GPL or the LGPL, and not to allow others to
+/ use your version of this file under the terms of the MPL, indicate your
+/ decision by deleting the provisions above and replace them with the notice
+/ and other provisions required by the GPL or the LGPL. If you do not delete
+/ the provisions above, a recipient may use your version of this file under
+/ the terms of any one of the MPL, the GPL or the LGPL.
+/ 
+*/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "freexl.h"
+
+#if defined(_WIN32) && !defined(__MINGW32__)
+#include "config-msvc.h"
+#else
+#include "config.h"
+#endif
+
+#include "check_helpers.h"
+
+#define MODE_XLS	0
+#define MODE_XLSX	1
+#define MODE_ODS	2
+
+static int
+open_document (const char *path, int mode, const FreeXL_OpenOptions * options,
+	       const void **handle)
+{
+/* opening a document of any supported format */
+    if (mode == MODE_XLS)
+	return freexl_open_ex (path, options, handle);
+#ifndef OMIT_XMLDOC
+    if (mode == MODE_XLSX)
+	return freexl_open_xlsx_ex (path, options, handle);
+    return freexl_open_ods_ex (path, options, handle);
+#else
+    return FREEXL_INVALID_HANDLE;
+#endif
+}
+
+static int
+compare_worksheet (const void *full, const void *preview, unsigned int limit,
+		   int excluded, int *loaded)
+{
+/* comparing a previewed Worksheet against the complete one */
+    unsigned int rows;
+    unsigned short columns;
+    unsigned int p_rows;
+    unsigned short p_columns;
+    unsigned int d_rows;
+    unsigned short d_columns;
+    unsigned int pd_rows;
+    unsigned short pd_columns;
+    unsigned int row;
+    unsigned short col;
+    FreeXL_CellValue cell;
+    FreeXL_CellValue p_cell;
+    int ret;
+    int p_ret;
+
+    if (freexl_worksheet_dimensions (full, &rows, &columns) != FREEXL_OK)
+	return -20;
+    if (freexl_worksheet_dimensions (preview, &p_rows, &p_columns) !=
+	FREEXL_OK)
+	return -21;
+    /* an empty XLSX or ODS Worksheet has no meaningful row count */
+    if (columns == 0)
+	rows = 0;
+    if (p_columns == 0)
+	p_rows = 0;
+    if (p_rows > limit || p_rows > rows || p_columns > columns)
+	return -22;
+
+    /* the declared dimensions are never affected by the preview */
+    ret = freexl_worksheet_declared_dimensions (full, &d_rows, &d_columns);
+    p_ret =
+	freexl_worksheet_declared_dimensions (preview, &pd_rows, &pd_columns);
+    if (excluded)
+	;			/* an excluded XLSX Worksheet isn't even fetched */
+    else if (ret != p_ret)
+	return -23;
+    else if (ret == FREEXL_OK && (d_rows != pd_rows || d_columns != pd_columns))
+	return -24;
+    if (ret != FREEXL_OK && ret != FREEXL_UNDECLARED_DIMENSION)
+	return -25;
+
+    for (row = 0; row < rows && row < limit; row++)
+      {
+	  for (col = 0; col < columns; col++)
+	    {
+		if (freexl_get_cell_value (full, row, col, &cell) != FREEXL_OK)
+		    return -26;
+		if (row >= p_rows || col >= p_columns)
+		  {
+		      if (cell.type != FREEXL_CELL_NULL)
+			{
+			    fprintf (stderr, "Missing cell (%u,%u)\n", row,
+				     col);
+			    return -27;
+			}
+		      continue;
+		  }
+		if (freexl_get_cell_value (preview, row, col, &p_cell) !=
+		    FREEXL_OK)
+		    return -28;
+		if (!same_value (&cell, &p_cell))
+		  {
+		      fprintf (stderr, "Mismatching cell (%u,%u)\n", row, col);
+		      return -29;
+		  }
+		if (p_cell.type != FREEXL_CELL_NULL)
+		    *loaded += 1;
+	    }
+      }
+    return 0;
+}
+
+static int
+check_preview (const char *path, int mode, const FreeXL_OpenOptions * options,
+	       int expected)
+{
+/* comparing a previewed document against the complete one */
+    const void *full;
+    const void *preview;
+    unsigned int max_worksheet;
+    unsigned int p_max_worksheet;
+    unsigned int idx;
+    int loaded = 0;
+    int ret;
+
+    ret = open_document (path, mode, NULL, &full);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "OPEN ERROR (%s): %d\n", path, ret);
+	  return -1;
+      }
+    ret = open_document (path, mode, options, &preview);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "OPEN ERROR (%s, preview): %d\n", path, ret);
+	  freexl_close (full);
+	  return -2;
+      }
+    ret = freexl_get_worksheets_count (full, &max_worksheet);
+    if (ret == FREEXL_OK)
+	ret = freexl_get_worksheets_count (preview, &p_max_worksheet);
+    if (ret != FREEXL_OK || max_worksheet != p_max_worksheet)
+      {
+	  ret = -3;
+	  goto stop;
+      }
+    for (idx = 0; idx < max_worksheet; idx++)
+      {
+	  const char *name;
+	  const char *p_name;
+	  unsigned int limit = options->preview_rows;
+	  int excluded = 0;
+	  if (freexl_select_active_worksheet (full, idx) != FREEXL_OK
+	      || freexl_select_active_worksheet (preview, idx) != FREEXL_OK)
+	    {
+		ret = -4;
+		goto stop;
+	    }
+	  /* the Worksheet names are always reported */
+	  if (freexl_get_worksheet_name (full, idx, &name) != FREEXL_OK
+	      || freexl_get_worksheet_name (preview, idx, &p_name) !=
+	      FREEXL_OK || strcmp (name, p_name) != 0)
+	    {
+		ret = -5;
+		goto stop;
+	    }
+	  if (options->sheet_index >= 0 && (int) idx != options->sheet_index)
+	    {
+		/* not loaded at all */
+		limit = 0;
+		excluded = 1;
+	    }
+	  ret = compare_worksheet (full, preview, limit, excluded, &loaded);
+	  if (ret != 0)
+	    {
+		fprintf (stderr, "%s: Worksheet #%u error %d\n", path, idx,
+			 ret);
+		goto stop;
+	    }
+      }
+    ret = 0;
+    if (loaded != expected)
+      {
+	  fprintf (stderr, "%s: unexpected number of cells %d\n", path,
+		   loaded);
+	  ret = -6;
+      }
+
+  stop:
+    freexl_close (full);
+    freexl_close (preview);
+    return ret;
+}
+
+static int
+check_document (const char *path, int mode, const int *expected)
+{
+/* testing several previews of the same document */
+    FreeXL_OpenOptions options;
+    int ret;
+
+    /* the first rows of each Worksheet */
+    freexl_init_open_options (&options);
+    options.preview_rows = 3;
+    ret = check_preview (path, mode, &options, expected[0]);
+    if (ret != 0)
+	return ret;
+
+    /* the same, while parsing in parallel */
+    options.xls_threads = 4;
+    options.ods_threads = 4;
+    options.xml_pipeline = 1;
+    ret = check_preview (path, mode, &options, expected[0]);
+    if (ret != 0)
+	return ret - 10;
+
+    /* the first rows of the second Worksheet only */
+    freexl_init_open_options (&options);
+    options.preview_rows = 5;
+    options.sheet_index = 1;
+    ret = check_preview (path, mode, &options, expected[1]);
+    if (ret != 0)
+	return ret - 20;
+
+    /* a preview wider than any Worksheet loads everything */
+    freexl_init_open_options (&options);
+    options.preview_rows = 1000000;
+    ret = check_preview (path, mode, &options, expected[2]);
+    if (ret != 0)
+	return ret - 30;
+    return 0;
+}
+
+int
+main (int argc, char *argv[])
+{
+    int ret;
+    int testcase1[3] = { 87, 72, 503 };
+    int simple2003[3] = { 21, 17, 33 };
+    int biff3[3] = { 9, 0, 14 };
+
+    ret = check_document ("testdata/testcase1.xls", MODE_XLS, testcase1);
+    if (ret != 0)
+	return ret;
+    ret = check_document ("testdata/simple2003.xls", MODE_XLS, simple2003);
+    if (ret != 0)
+	return ret - 100;
+    ret = check_document ("testdata/simple2003_3.xls", MODE_XLS, biff3);
+    if (ret != 0)
+	return ret - 200;
+
+#ifdef OMIT_XMLDOC		/* XML support is not enabled */
+    fprintf (stderr,
+	     "Sorry, this version of check_preview was built by disabling support XML documents\n");
+#else
+    {
+	int xlsx[3] = { 7, 3, 28 };
+	int styled[3] = { 7, 3, 28 };
+	int ods[3] = { 7, 3, 28 };
+	ret = check_document ("testdata/test_xml.xlsx", MODE_XLSX, xlsx);
+	if (ret != 0)
+	    return ret - 300;
+	ret = check_document ("testdata/test_styled.xlsx", MODE_XLSX, styled);
+	if (ret != 0)
+	    return ret - 400;
+	ret = check_document ("testdata/test_xml.ods", MODE_ODS, ods);
+	if (ret != 0)
+	    return ret - 500;
+    }
+#endif /* end conditional XML support */
+
+    if (argc > 1 || argv[0] == NULL)
+	argc = 1;		/* silencing stupid compiler warnings */
+
+    return 0;
+}
@@ -0,0 +1,345 @@
+/* 
+/ check_projection.c
+/
+/ Test cases for projection and row-range options
+/
+/ ------------------------------------------------------------------------------
+/ 
+/ Version: MPL 1.1/GPL 2.0/LGPL 2.1
+/ 
+/ The contents of this file are subject to the Mozilla Public License Version
+/ 1.1 (the "License"); you may not use this file except in compliance with
+/ the License. You may obtain a copy of the License at
+/ http://www.mozilla.org/MPL/
+/ 
+/ Software distributed under the License is distributed on an "AS IS" basis,
+/ WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+/ for the specific language governing rights and limitations under the
+/ License.
+/
+/ The Original Code is the FreeXL library
+/
+/ The Initial Developer of the Original Code is Alessandro Furieri
+/ 
+/ Portions created by the Initial Developer are Copyright (C) 2021
+/ the Initial Developer. All Rights Reserved.
+/ 
+/ Contributor(s):
+/
+/ Alternatively, the contents of this file may be used under the terms of
+/ either the GNU General Public License Version 2 or later (the "GPL"), or
+/ the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+/ in which case the provisions of the GPL or the LGPL are applicable instead
+/ of those above. If you wish to allow use of your version of this file only
+/ under the terms of either the GPL or the LGPL, and not to allow others to
+/ use your version of this file under the terms of the MPL, indicate your
+/ decision by deleting the provisions above and replace them with the notice
+/ and other provisions required by the GPL or the LGPL. If you do not delete
+/ the provisions above, a recipient may use your version of this file under
+/ the terms of any one of the MPL, the GPL or the LGPL.
+/ 
+*/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "freexl.h"
+
+#if defined(_WIN32) && !defined(__MINGW32__)
+#include "config-msvc.h"
+#else
+#include "config.h"
+#endif
+
+#include "check_helpers.h"
+
+#define MODE_XLS	0
+#define MODE_XLSX	1
+#define MODE_ODS	2
+
+static int
+open_document (const char *path, int mode, const FreeXL_OpenOptions * options,
+	       const void **handle)
+{
+/* opening a document of any supported format */
+    if (mode == MODE_XLS)
+	return freexl_open_ex (path, options, handle);
+#ifndef OMIT_XMLDOC
+    if (mode == MODE_XLSX)
+	return freexl_open_xlsx_ex (path, options, handle);
+    return freexl_open_ods_ex (path, options, handle);
+#else
+    return FREEXL_INVALID_HANDLE;
+#endif
+}
+
+static int
+is_projected (const FreeXL_OpenOptions * options, unsigned int row,
+	      unsigned short col)
+{
+/* checking if some Cell is expected to be loaded */
+    int i;
+    if (row < options->first_row)
+	return 0;
+    if (options->n_rows > 0 && row >= options->first_row + options->n_rows)
+	return 0;
+    if (options->columns == NULL)
+	return 1;
+    for (i = 0; i < options->n_columns; i++)
+      {
+	  if (options->columns[i] == col)
+	      return 1;
+      }
+    return 0;
+}
+
+static int
+compare_worksheet (const void *full, const void *proj,
+		   const FreeXL_OpenOptions * options, int *loaded)
+{
+/* comparing a projected Worksheet against the complete one */
+    unsigned int rows;
+    unsigned short columns;
+    unsigned int p_rows;
+    unsigned short p_columns;
+    unsigned int row;
+    unsigned short col;
+    FreeXL_CellValue cell;
+    FreeXL_CellValue p_cell;
+
+    if (freexl_worksheet_dimensions (full, &rows, &columns) != FREEXL_OK)
+	return -20;
+    if (freexl_worksheet_dimensions (proj, &p_rows, &p_columns) != FREEXL_OK)
+	return -21;
+    /* an empty XLSX or ODS Worksheet has no meaningful row count */
+    if (columns == 0)
+	rows = 0;
+    if (p_columns == 0)
+	p_rows = 0;
+    if (p_rows > rows || p_columns > columns)
+	return -22;
+    if (options->n_rows > 0 && p_rows > options->first_row + options->n_rows)
+	return -23;
+    for (row = 0; row < rows; row++)
+      {
+	  for (col = 0; col < columns; col++)
+	    {
+		if (freexl_get_cell_value (full, row, col, &cell) != FREEXL_OK)
+		    return -24;
+		if (row >= p_rows || col >= p_columns)
+		  {
+		      /* outside the projected Worksheet */
+		      if (cell.type != FREEXL_CELL_NULL
+			  && is_projected (options, row, col))
+			{
+			    fprintf (stderr, "Missing cell (%u,%u)\n", row,
+				     col);
+			    return -25;
+			}
+		      continue;
+		  }
+		if (freexl_get_cell_value (proj, row, col, &p_cell) !=
+		    FREEXL_OK)
+		    return -26;
+		if (!is_projected (options, row, col))
+		  {
+		      if (p_cell.type != FREEXL_CELL_NULL)
+			{
+			    fprintf (stderr, "Unexpected cell (%u,%u)\n", row,
+				     col);
+			    return -27;
+			}
+		      continue;
+		  }
+		if (!same_value (&cell, &p_cell))
+		  {
+		      fprintf (stderr, "Mismatching cell (%u,%u)\n", row, col);
+		      return -28;
+		  }
+		if (p_cell.type != FREEXL_CELL_NULL)
+		    *loaded += 1;
+	    }
+      }
+    return 0;
+}
+
+static int
+check_projection (const char *path, int mode,
+		  const FreeXL_OpenOptions * options, int expected)
+{
+/* comparing a projected document against the complete one */
+    const void *full;
+    const void *proj;
+    unsigned int max_worksheet;
+    unsigned int p_max_worksheet;
+    unsigned int idx;
+    int loaded = 0;
+    int ret;
+
+    ret = open_document (path, mode, NULL, &full);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "OPEN ERROR (%s): %d\n", path, ret);
+	  return -1;
+      }
+    ret = open_document (path, mode, options, &proj);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "OPEN ERROR (%s, projected): %d\n", path, ret);
+	  freexl_close (full);
+	  return -2;
+      }
+    ret = freexl_get_worksheets_count (full, &max_worksheet);
+    if (ret == FREEXL_OK)
+	ret = freexl_get_worksheets_count (proj, &p_max_worksheet);
+    if (ret != FREEXL_OK || max_worksheet != p_max_worksheet)
+      {
+	  ret = -3;
+	  goto stop;
+      }
+    for (idx = 0; idx < max_worksheet; idx++)
+      {
+	  unsigned int rows;
+	  unsigned short columns;
+	  if (freexl_select_active_worksheet (full, idx) != FREEXL_OK
+	      || freexl_select_active_worksheet (proj, idx) != FREEXL_OK)
+	    {
+		ret = -4;
+		goto stop;
+	    }
+	  if (options->sheet_index >= 0 && (int) idx != options->sheet_index)
+	    {
+		/* any other Worksheet is expected to be empty */
+		FreeXL_CellValue cell;
+		if (freexl_worksheet_dimensions (proj, &rows, &columns) !=
+		    FREEXL_OK)
+		  {
+		      ret = -5;
+		      goto stop;
+		  }
+		if (rows > 0 && columns > 0
+		    && freexl_get_cell_value (proj, 0, 0, &cell) == FREEXL_OK
+		    && cell.type != FREEXL_CELL_NULL)
+		  {
+		      fprintf (stderr, "%s: Worksheet #%u was loaded\n", path,
+			       idx);
+		      ret = -6;
+		      goto stop;
+		  }
+		continue;
+	    }
+	  ret = compare_worksheet (full, proj, options, &loaded);
+	  if (ret != 0)
+	    {
+		fprintf (stderr, "%s: Worksheet #%u error %d\n", path, idx,
+			 ret);
+		goto stop;
+	    }
+      }
+    ret = 0;
+    if (loaded != expected)
+      {
+	  fprintf (stderr, "%s: unexpected number of cells %d\n", path,
+		   loaded);
+	  ret = -7;
+      }
+
+  stop:
+    freexl_close (full);
+    freexl_close (proj);
+    return ret;
+}
+
+static int
+check_document (const char *path, int mode, const int *expected)
+{
+/* testing several projections on the same document */
+    FreeXL_OpenOptions options;
+    unsigned short columns[3] = { 2, 0, 5 };
+    int ret;
+
+    /* a column subset */
+    freexl_init_open_options (&options);
+    options.columns = columns;
+    options.n_columns = 3;
+    ret = check_projection (path, mode, &options, expected[0]);
+    if (ret != 0)
+	return ret;
+
+    /* a row range */
+    freexl_init_open_options (&options);
+    options.first_row = 2;
+    options.n_rows = 5;
+    ret = check_projection (path, mode, &options, expected[1]);
+    if (ret != 0)
+	return ret - 10;
+
+    /* a single Worksheet, some columns, a few rows */
+    freexl_init_open_options (&options);
+    options.sheet_index = 0;
+    options.columns = columns;
+    options.n_columns = 2;
+    options.first_row = 1;
+    options.n_rows = 3;
+    ret = check_projection (path, mode, &options, expected[2]);
+    if (ret != 0)
+	return ret - 20;
+
+    /* the same, while parsing in parallel */
+    options.xls_threads = 4;
+    options.ods_threads = 4;
+    options.xml_pipeline = 1;
+    ret = check_projection (path, mode, &options, expected[2]);
+    if (ret != 0)
+	return ret - 30;
+
+    /* an empty set of columns: nothing at all is loaded */
+    freexl_init_open_options (&options);
+    options.columns = columns;
+    options.n_columns = 0;
+    ret = check_projection (path, mode, &options, 0);
+    if (ret != 0)
+	return ret - 40;
+    return 0;
+}
+
+int
+main (int argc, char *argv[])
+{
+    int ret;
+    int testcase1[3] = { 111, 137, 6 };
+    int biff3[3] = { 8, 8, 6 };
+
+    ret = check_document ("testdata/testcase1.xls", MODE_XLS, testcase1);
+    if (ret != 0)
+	return ret;
+    ret = check_document ("testdata/simple2003_3.xls", MODE_XLS, biff3);
+    if (ret != 0)
+	return ret - 100;
+
+#ifdef OMIT_XMLDOC		/* XML support is not enabled */
+    fprintf (stderr,
+	     "Sorry, this version of check_projection was built by disabling support XML documents\n");
+#else
+    {
+	int xlsx[3] = { 7, 9, 1 };
+	int ods[3] = { 7, 9, 1 };
+	ret = check_document ("testdata/test_xml.xlsx", MODE_XLSX, xlsx);
+	if (ret != 0)
+	    return ret - 200;
+	ret = check_document ("testdata/test_styled.xlsx", MODE_XLSX, xlsx);
+	if (ret != 0)
+	    return ret - 300;
+	ret = check_document ("testdata/test_xml.ods", MODE_ODS, ods);
+	if (ret != 0)
+	    return ret - 400;
+    }
+#endif /* end conditional XML support */
+
+    if (argc > 1 || argv[0] == NULL)
+	argc = 1;		/* silencing stupid compiler warnings */
+
+    return 0;
+}
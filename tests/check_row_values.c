@@ -0,0 +1,257 @@
+/* 
+/ check_row_values.c
+/
+/ Test cases for fetching a whole row at once
+/
+/ ------------------------------------------------------------------------------
+/ 
+/ Version: MPL 1.1/GPL 2.0/LGPL 2.1
+/ 
+/ The contents of this file are subject to the Mozilla Public License Version
+/ 1.1 (the "License"); you may not use this file except in compliance with
+/ the License. You may obtain a copy of the License at
+/ http://www.mozilla.org/MPL/
+/ 
+/ Software distributed under the License is distributed on an "AS IS" basis,
+/ WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+/ for the specific language governing rights and limitations under the
+/ License.
+/
+/ The Original Code is the FreeXL library
+/
+/ The Initial Developer of the Original Code is Alessandro Furieri
+/ 
+/ Portions created by the Initial Developer are Copyright (C) 2021
+/ the Initial Developer. All Rights Reserved.
+/ 
+/ Contributor(s):
+/
+/ Alternatively, the contents of this file may be used under the terms of
+/ either the GNU General Public License Version 2 or later (the "GPL"), or
+/ the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+/ in which case the provisions of the GPL or the LGPL are applicable instead
+/ of those above. If you wish to allow use of your version of this file only
+/ under the terms of either the GPL or the LGPL, and not to allow others to
+/ use your version of this file under the terms of the MPL, indicate your
+/ decision by deleting the provisions above and replace them with the notice
+/ and other provisions required by the GPL or the LGPL. If you do not delete
+/ the provisions above, a recipient may use your version of this file under
+/ the terms of any one of the MPL, the GPL or the LGPL.
+/ 
+*/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "freexl.h"
+
+#if defined(_WIN32) && !defined(__MINGW32__)
+#include "config-msvc.h"
+#else
+#include "config.h"
+#endif
+
+#include "check_helpers.h"
+
+static int
+check_range (const void *handle, unsigned int row, unsigned short first,
+	     unsigned short n, FreeXL_CellValue * values)
+{
+/* comparing a Row range against single Cell access */
+    FreeXL_CellValue cell;
+    unsigned short i;
+    int ret = freexl_get_row_values (handle, row, first, n, values);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "Error getting row values (%u,%u,%u): %d\n", row,
+		   first, n, ret);
+	  return 0;
+      }
+    for (i = 0; i < n; i++)
+      {
+	  ret = freexl_get_cell_value (handle, row, first + i, &cell);
+	  if (ret != FREEXL_OK)
+	    {
+		fprintf (stderr, "Error getting cell value (%u,%u): %d\n",
+			 row, first + i, ret);
+		return 0;
+	    }
+	  if (!same_value (values + i, &cell))
+	    {
+		fprintf (stderr, "Mismatching cell (%u,%u) type %u/%u\n",
+			 row, first + i, values[i].type, cell.type);
+		return 0;
+	    }
+      }
+    return 1;
+}
+
+static int
+check_document (const void *handle)
+{
+/* comparing every Row of every Worksheet */
+    unsigned int max_worksheet;
+    unsigned int idx;
+    FreeXL_CellValue *values;
+    int ret;
+
+    ret = freexl_get_worksheets_count (handle, &max_worksheet);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "GET-WORKSHEETS-COUNT Error: %d\n", ret);
+	  return -10;
+      }
+    for (idx = 0; idx < max_worksheet; idx++)
+      {
+	  unsigned int rows;
+	  unsigned short columns;
+	  unsigned int row;
+	  ret = freexl_select_active_worksheet (handle, idx);
+	  if (ret != FREEXL_OK)
+	    {
+		fprintf (stderr, "Error setting active worksheet: %d\n", ret);
+		return -11;
+	    }
+	  ret = freexl_worksheet_dimensions (handle, &rows, &columns);
+	  if (ret != FREEXL_OK)
+	    {
+		fprintf (stderr, "Error getting worksheet dimensions: %d\n",
+			 ret);
+		return -12;
+	    }
+	  if (columns == 0)
+	      continue;
+	  values = malloc (sizeof (FreeXL_CellValue) * columns);
+	  for (row = 0; row < rows; row++)
+	    {
+		if (!check_range (handle, row, 0, columns, values))
+		  {
+		      free (values);
+		      return -13;
+		  }
+		if (columns > 2
+		    && !check_range (handle, row, 1, columns - 2, values))
+		  {
+		      free (values);
+		      return -14;
+		  }
+	    }
+	  /* ranges beyond the Worksheet end are invalid */
+	  ret = freexl_get_row_values (handle, rows, 0, 1, values);
+	  if (ret != FREEXL_ILLEGAL_CELL_ROW_COL)
+	    {
+		fprintf (stderr, "Unexpected result for illegal row: %d\n",
+			 ret);
+		free (values);
+		return -15;
+	    }
+	  ret = freexl_get_row_values (handle, 0, 1, columns, values);
+	  if (ret != FREEXL_ILLEGAL_CELL_ROW_COL)
+	    {
+		fprintf (stderr, "Unexpected result for illegal range: %d\n",
+			 ret);
+		free (values);
+		return -16;
+	    }
+	  free (values);
+	  ret = freexl_get_row_values (handle, 0, 0, 1, NULL);
+	  if (ret != FREEXL_NULL_ARGUMENT)
+	    {
+		fprintf (stderr, "Unexpected result for NULL values: %d\n",
+			 ret);
+		return -17;
+	    }
+      }
+    return 0;
+}
+
+int
+main (int argc, char *argv[])
+{
+    const void *handle;
+    int ret;
+    int ret2;
+#ifndef OMIT_XMLDOC		/* XML support is enabled */
+    FreeXL_OpenOptions options;
+#endif
+
+    ret = freexl_open ("testdata/testcase1.xls", &handle);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "OPEN ERROR: %d\n", ret);
+	  return -1;
+      }
+    ret2 = check_document (handle);
+    ret = freexl_close (handle);
+    if (ret2 != 0)
+	return ret2;
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "CLOSE ERROR: %d\n", ret);
+	  return -2;
+      }
+
+#ifdef OMIT_XMLDOC		/* XML support is not enabled */
+    fprintf (stderr,
+	     "Sorry, this version of check_row_values was built by disabling support XML documents\n");
+#else
+    ret = freexl_open_xlsx ("testdata/test_dimension.xlsx", &handle);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "OPEN XLSX ERROR: %d\n", ret);
+	  return -3;
+      }
+    ret2 = check_document (handle);
+    ret = freexl_close (handle);
+    if (ret2 != 0)
+	return ret2 - 20;
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "CLOSE XLSX ERROR: %d\n", ret);
+	  return -4;
+      }
+
+    ret = freexl_open_ods ("testdata/test_dates.ods", &handle);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "OPEN ODS ERROR: %d\n", ret);
+	  return -5;
+      }
+    ret2 = check_document (handle);
+    ret = freexl_close (handle);
+    if (ret2 != 0)
+	return ret2 - 40;
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "CLOSE ODS ERROR: %d\n", ret);
+	  return -6;
+      }
+
+/* lazy SharedStrings, recycled as soon as another one is decoded */
+    freexl_init_open_options (&options);
+    options.xlsx_strings_mode = FREEXL_XLSX_STRINGS_LAZY;
+    options.xlsx_strings_cache = 1;
+    ret = freexl_open_xlsx_ex ("testdata/test_xml.xlsx", &options, &handle);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "OPEN LAZY XLSX ERROR: %d\n", ret);
+	  return -7;
+      }
+    ret2 = check_document (handle);
+    ret = freexl_close (handle);
+    if (ret2 != 0)
+	return ret2 - 60;
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "CLOSE LAZY XLSX ERROR: %d\n", ret);
+	  return -8;
+      }
+#endif /* end conditional XML support */
+
+    if (argc > 1 || argv[0] == NULL)
+	argc = 1;		/* silencing stupid compiler warnings */
+
+    return 0;
+}
@@ -0,0 +1,268 @@
+/* 
+/ check_xls_scan.c
+/
+/ Test cases for streaming an XLS worksheet through a callback
+/
+/ ------------------------------------------------------------------------------
+/ 
+/ Version: MPL 1.1/GPL 2.0/LGPL 2.1
+/ 
+/ The contents of this file are subject to the Mozilla Public License Version
+/ 1.1 (the "License"); you may not use this file except in compliance with
+/ the License. You may obtain a copy of the License at
+/ http://www.mozilla.org/MPL/
+/ 
+/ Software distributed under the License is distributed on an "AS IS" basis,
+/ WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+/ for the specific language governing rights and limitations under the
+/ License.
+/
+/ The Original Code is the FreeXL library
+/
+/ The Initial Developer of the Original Code is Alessandro Furieri
+/ 
+/ Portions created by the Initial Developer are Copyright (C) 2021
+/ the Initial Developer. All Rights Reserved.
+/ 
+/ Contributor(s):
+/
+/ Alternatively, the contents of this file may be used under the terms of
+/ either the GNU General Public License Version 2 or later (the "GPL"), or
+/ the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+/ in which case the provisions of the GPL or the LGPL are applicable instead
+/ of those above. If you wish to allow use of your version of this file only
+/ under the terms of either the GPL or the LGPL, and not to allow others to
+/ use your version of this file under the terms of the MPL, indicate your
+/ decision by deleting the provisions above and replace them with the notice
+/ and other provisions required by the GPL or the LGPL. If you do not delete
+/ the provisions above, a recipient may use your version of this file under
+/ the terms of any one of the MPL, the GPL or the LGPL.
+/ 
+*/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "freexl.h"
+
+#if defined(_WIN32) && !defined(__MINGW32__)
+#include "config-msvc.h"
+#else
+#include "config.h"
+#endif
+
+#include "check_helpers.h"
+
+struct scan_check
+{
+    const void *handle;		/* the same document, open the usual way */
+    int count;			/* number of cells received so far */
+    int rows;			/* number of rows received so far */
+    int max_rows;		/* stopping after so many rows (0 = never) */
+    unsigned int last_row;	/* the previously received row */
+    int error;			/* first detected mismatch (if any) */
+};
+
+static int
+row_callback (void *ctx, unsigned int row, unsigned short n_cells,
+	      const unsigned short *columns, const FreeXL_CellValue * values)
+{
+/* checking each received Cell against freexl_get_cell_value() */
+    struct scan_check *check = (struct scan_check *) ctx;
+    unsigned short i;
+    if (n_cells == 0)
+      {
+	  check->error = -1;
+	  return 1;
+      }
+    if (check->rows > 0 && row <= check->last_row)
+      {
+	  fprintf (stderr, "Row %u reported twice or out of order\n", row);
+	  check->error = -2;
+	  return 1;
+      }
+    for (i = 0; i < n_cells; i++)
+      {
+	  FreeXL_CellValue cell;
+	  if (freexl_get_cell_value (check->handle, row, columns[i], &cell) !=
+	      FREEXL_OK || !same_value (values + i, &cell))
+	    {
+		fprintf (stderr, "Mismatching cell (%u,%u)\n", row,
+			 columns[i]);
+		check->error = -3;
+		return 1;
+	    }
+	  if (values[i].type == FREEXL_CELL_NULL)
+	    {
+		check->error = -4;
+		return 1;
+	    }
+      }
+    check->count += n_cells;
+    check->rows += 1;
+    check->last_row = row;
+    if (check->max_rows > 0 && check->rows >= check->max_rows)
+	return 1;
+    return 0;
+}
+
+static int
+count_cells (const void *handle)
+{
+/* counting the non-NULL Cells of the active Worksheet */
+    const void *iter;
+    unsigned int row;
+    unsigned short col;
+    FreeXL_CellValue cell;
+    int count = 0;
+    if (freexl_create_cell_iterator (handle, &iter) != FREEXL_OK)
+	return -1;
+    while (1)
+      {
+	  if (freexl_next_cell (iter, &row, &col, &cell) != FREEXL_OK)
+	    {
+		count = -1;
+		break;
+	    }
+	  if (cell.type == FREEXL_CELL_NULL)
+	      break;
+	  count++;
+      }
+    freexl_destroy_cell_iterator (iter);
+    return count;
+}
+
+static int
+check_file (const char *path, int *total)
+{
+/* comparing the streaming scan against freexl_open(), for each Worksheet */
+    const void *handle;
+    unsigned int max_worksheet;
+    unsigned int idx;
+    int ret;
+
+    *total = 0;
+    ret = freexl_open (path, &handle);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "OPEN ERROR (%s): %d\n", path, ret);
+	  return -1;
+      }
+    ret = freexl_get_worksheets_count (handle, &max_worksheet);
+    if (ret != FREEXL_OK)
+      {
+	  freexl_close (handle);
+	  return -2;
+      }
+    for (idx = 0; idx < max_worksheet; idx++)
+      {
+	  struct scan_check check;
+	  int expected;
+
+	  ret = freexl_select_active_worksheet (handle, idx);
+	  if (ret != FREEXL_OK)
+	    {
+		freexl_close (handle);
+		return -3;
+	    }
+	  memset (&check, 0, sizeof (struct scan_check));
+	  check.handle = handle;
+	  ret = freexl_scan_xls (path, idx, row_callback, &check);
+	  if (ret != FREEXL_OK || check.error != 0)
+	    {
+		fprintf (stderr, "SCAN ERROR (%s #%u): %d %d\n", path, idx,
+			 ret, check.error);
+		freexl_close (handle);
+		return -4;
+	    }
+	  expected = count_cells (handle);
+	  if (check.count != expected)
+	    {
+		fprintf (stderr, "%s #%u: %d cells scanned, %d expected\n",
+			 path, idx, check.count, expected);
+		freexl_close (handle);
+		return -5;
+	    }
+	  *total += check.count;
+      }
+    freexl_close (handle);
+    return 0;
+}
+
+int
+main (int argc, char *argv[])
+{
+    const void *handle;
+    struct scan_check check;
+    int total;
+    int ret;
+
+    ret = check_file ("testdata/testcase1.xls", &total);
+    if (ret != 0)
+	return ret;
+    if (total != 503)
+      {
+	  fprintf (stderr, "testcase1.xls: unexpected number of cells %d\n",
+		   total);
+	  return -6;
+      }
+    ret = check_file ("testdata/datetime2003.xls", &total);
+    if (ret != 0)
+	return ret - 10;
+    ret = check_file ("testdata/simple2003_21.xls", &total);
+    if (ret != 0)
+	return ret - 20;
+    ret = check_file ("testdata/simple2003_3.xls", &total);
+    if (ret != 0)
+	return ret - 30;
+    ret = check_file ("testdata/oocalc_simple95.xls", &total);
+    if (ret != 0)
+	return ret - 40;
+
+/* the callback is free to stop the scan at any time */
+    ret = freexl_open ("testdata/testcase1.xls", &handle);
+    if (ret != FREEXL_OK)
+	return -50;
+    ret = freexl_select_active_worksheet (handle, 0);
+    if (ret != FREEXL_OK)
+	return -50;
+    memset (&check, 0, sizeof (struct scan_check));
+    check.handle = handle;
+    check.max_rows = 1;
+    ret = freexl_scan_xls ("testdata/testcase1.xls", 0, row_callback, &check);
+    freexl_close (handle);
+    if (ret != FREEXL_OK || check.error != 0 || check.rows != 1)
+      {
+	  fprintf (stderr, "Unexpected result for stopped scan: %d %d %d\n",
+		   ret, check.error, check.rows);
+	  return -51;
+      }
+
+/* error checks */
+    ret = freexl_scan_xls ("testdata/testcase1.xls", 99, row_callback, &check);
+    if (ret != FREEXL_BIFF_ILLEGAL_SHEET_INDEX)
+      {
+	  fprintf (stderr, "Unexpected result for invalid sheet: %d\n", ret);
+	  return -52;
+      }
+    ret = freexl_scan_xls (NULL, 0, row_callback, &check);
+    if (ret != FREEXL_NULL_ARGUMENT)
+	return -53;
+    ret = freexl_scan_xls ("testdata/testcase1.xls", 0, NULL, &check);
+    if (ret != FREEXL_NULL_ARGUMENT)
+	return -54;
+    ret = freexl_scan_xls ("testdata/not_existing.xls", 0, row_callback,
+			   &check);
+    if (ret != FREEXL_FILE_NOT_FOUND)
+      {
+	  fprintf (stderr, "Unexpected result for missing file: %d\n", ret);
+	  return -55;
+      }
+
+    if (argc > 1 || argv[0] == NULL)
+	argc = 1;		/* silencing stupid compiler warnings */
+
+    return 0;
+}
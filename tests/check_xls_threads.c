@@ -0,0 +1,137 @@
+/* 
+/ check_xls_threads.c
+/
+/ Test cases for XLS documents parsed by several threads
+/
+/ ------------------------------------------------------------------------------
+/ 
+/ Version: MPL 1.1/GPL 2.0/LGPL 2.1
+/ 
+/ The contents of this file are subject to the Mozilla Public License Version
+/ 1.1 (the "License"); you may not use this file except in compliance with
+/ the License. You may obtain a copy of the License at
+/ http://www.mozilla.org/MPL/
+/ 
+/ Software distributed under the License is distributed on an "AS IS" basis,
+/ WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+/ for the specific language governing rights and limitations under the
+/ License.
+/
+/ The Original Code is the FreeXL library
+/
+/ The Initial Developer of the Original Code is Alessandro Furieri
+/ 
+/ Portions created by the Initial Developer are Copyright (C) 2021
+/ the Initial Developer. All Rights Reserved.
+/ 
+/ Contributor(s):
+/
+/ Alternatively, the contents of this file may be used under the terms of
+/ either the GNU General Public License Version 2 or later (the "GPL"), or
+/ the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+/ in which case the provisions of the GPL or the LGPL are applicable instead
+/ of those above. If you wish to allow use of your version of this file only
+/ under the terms of either the GPL or the LGPL, and not to allow others to
+/ use your version of this file under the terms of the MPL, indicate your
+/ decision by deleting the provisions above and replace them with the notice
+/ and other provisions required by the GPL or the LGPL. If you do not delete
+/ the provisions above, a recipient may use your version of this file under
+/ the terms of any one of the MPL, the GPL or the LGPL.
+/ 
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "freexl.h"
+
+#if defined(_WIN32) && !defined(__MINGW32__)
+#include "config-msvc.h"
+#else
+#include "config.h"
+#endif
+
+#include "check_helpers.h"
+
+static int
+check_threads (const char *path, int threads)
+{
+/* comparing the parallel and the plain opening of the same document */
+    const void *plain;
+    const void *threaded;
+    FreeXL_OpenOptions options;
+    unsigned int count;
+    unsigned int count2;
+    unsigned int i;
+    int ret;
+
+    freexl_init_open_options (&options);
+    options.xls_threads = threads;
+    ret = freexl_open (path, &plain);
+    if (ret == FREEXL_OK)
+	ret = freexl_open_ex (path, &options, &threaded);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "OPEN ERROR (%s): %d\n", path, ret);
+	  return 0;
+      }
+
+    ret = freexl_get_worksheets_count (plain, &count);
+    if (ret != FREEXL_OK)
+	return 0;
+    ret = freexl_get_worksheets_count (threaded, &count2);
+    if (ret != FREEXL_OK || count != count2)
+      {
+	  fprintf (stderr, "Mismatching worksheet count (%s): %u\n", path,
+		   count2);
+	  return 0;
+      }
+    for (i = 0; i < count; i++)
+      {
+	  if (!compare_sheet (plain, threaded, i))
+	    {
+		fprintf (stderr, "Mismatching sheet #%u (%s)\n", i, path);
+		return 0;
+	    }
+      }
+
+    ret = freexl_close (threaded);
+    if (ret != FREEXL_OK)
+	return 0;
+    ret = freexl_close (plain);
+    if (ret != FREEXL_OK)
+	return 0;
+    return 1;
+}
+
+int
+main (int argc, char *argv[])
+{
+    static const char *files[] = {
+	"testdata/testcase1.xls",
+	"testdata/testbool.xls",
+	"testdata/datetime2003.xls",
+	"testdata/simple2003.xls",
+	"testdata/simple2003_5WB.xls",
+	"testdata/oocalc_simple97.xls",	/* mini-stream: always sequential */
+	"testdata/simple2003_3.xls",	/* legacy BIFF3: always sequential */
+	NULL
+    };
+    int i;
+
+    for (i = 0; files[i] != NULL; i++)
+      {
+	  if (!check_threads (files[i], 1))
+	      return -1 - (i * 10);
+	  if (!check_threads (files[i], 2))
+	      return -2 - (i * 10);
+	  if (!check_threads (files[i], 8))
+	      return -3 - (i * 10);
+      }
+
+    if (argc > 1 || argv[0] == NULL)
+	argc = 1;		/* silencing stupid compiler warnings */
+
+    return 0;
+}
@@ -0,0 +1,146 @@
+/* 
+/ check_xlsx_dimension.c
+/
+/ Test cases for XLSX documents declaring wrong dimensions
+/
+/ ------------------------------------------------------------------------------
+/ 
+/ Version: MPL 1.1/GPL 2.0/LGPL 2.1
+/ 
+/ The contents of this file are subject to the Mozilla Public License Version
+/ 1.1 (the "License"); you may not use this file except in compliance with
+/ the License. You may obtain a copy of the License at
+/ http://www.mozilla.org/MPL/
+/ 
+/ Software distributed under the License is distributed on an "AS IS" basis,
+/ WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+/ for the specific language governing rights and limitations under the
+/ License.
+/
+/ The Original Code is the FreeXL library
+/
+/ The Initial Developer of the Original Code is Alessandro Furieri
+/ 
+/ Portions created by the Initial Developer are Copyright (C) 2021
+/ the Initial Developer. All Rights Reserved.
+/ 
+/ Contributor(s):
+/
+/ Alternatively, the contents of this file may be used under the terms of
+/ either the GNU General Public License Version 2 or later (the "GPL"), or
+/ the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+/ in which case the provisions of the GPL or the LGPL are applicable instead
+/ of those above. If you wish to allow use of your version of this file only
+/ under the terms of either the GPL or the LGPL, and not to allow others to
+/ use your version of this file under the terms of the MPL, indicate your
+/ decision by deleting the provisions above and replace them with the notice
+/ and other provisions required by the GPL or the LGPL. If you do not delete
+/ the provisions above, a recipient may use your version of this file under
+/ the terms of any one of the MPL, the GPL or the LGPL.
+/ 
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "freexl.h"
+
+#if defined(_WIN32) && !defined(__MINGW32__)
+#include "config-msvc.h"
+#else
+#include "config.h"
+#endif
+
+#include "check_helpers.h"
+
+int
+main (int argc, char *argv[])
+{
+#ifdef OMIT_XMLDOC		/* XML support is not enabled */
+    fprintf (stderr,
+	     "Sorry, this version of check_xlsx_dimension was built by disabling support XML documents\n");
+    return 0;
+#else
+    const void *plain;
+    const void *hinted;
+    int ret;
+    unsigned int count;
+    unsigned int rows;
+    unsigned short columns;
+
+    ret = freexl_open_xlsx ("testdata/test_xml.xlsx", &plain);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "OPEN ERROR: %d\n", ret);
+	  return -1;
+      }
+
+/*
+ * same Workbook, but the first Worksheet declares a far too small
+ * <dimension> and the second one a far too large <dimension>
+ */
+    ret = freexl_open_xlsx ("testdata/test_dimension.xlsx", &hinted);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "OPEN ERROR (hinted): %d\n", ret);
+	  return -2;
+      }
+
+    ret = freexl_select_active_worksheet (hinted, 0);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "SELECT ERROR: %d\n", ret);
+	  return -3;
+      }
+    ret = freexl_worksheet_dimensions (hinted, &rows, &columns);
+    if (ret != FREEXL_OK || rows != 31 || columns != 66)
+      {
+	  fprintf (stderr, "Unexpected dimensions #0: %u x %u\n", rows,
+		   columns);
+	  return -3;
+      }
+    ret = freexl_select_active_worksheet (hinted, 1);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "SELECT ERROR: %d\n", ret);
+	  return -3;
+      }
+    ret = freexl_worksheet_dimensions (hinted, &rows, &columns);
+    if (ret != FREEXL_OK || rows != 14 || columns != 8)
+      {
+	  fprintf (stderr, "Unexpected dimensions #1: %u x %u\n", rows,
+		   columns);
+	  return -3;
+      }
+    ret = freexl_get_worksheets_count (hinted, &count);
+    if (ret != FREEXL_OK || count != 2)
+      {
+	  fprintf (stderr, "Unexpected worksheet count: %u\n", count);
+	  return -4;
+      }
+
+    if (!compare_sheet (plain, hinted, 0))
+	return -5;
+    if (!compare_sheet (plain, hinted, 1))
+	return -6;
+
+    ret = freexl_close (hinted);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "CLOSE ERROR: %d\n", ret);
+	  return -7;
+      }
+    ret = freexl_close (plain);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "CLOSE ERROR: %d\n", ret);
+	  return -8;
+      }
+
+    if (argc > 1 || argv[0] == NULL)
+	argc = 1;		/* silencing stupid compiler warnings */
+
+    return 0;
+#endif /* end conditional XML support */
+}
@@ -0,0 +1,215 @@
+/* 
+/ check_xlsx_fast_scan.c
+/
+/ Test cases for the XLSX sheetData fast scanner against the XML parser
+/
+/ ------------------------------------------------------------------------------
+/ 
+/ Version: MPL 1.1/GPL 2.0/LGPL 2.1
+/ 
+/ The contents of this file are subject to the Mozilla Public License Version
+/ 1.1 (the "License"); you may not use this file except in compliance with
+/ the License. You may obtain a copy of the License at
+/ http://www.mozilla.org/MPL/
+/ 
+/ Software distributed under the License is distributed on an "AS IS" basis,
+/ WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+/ for the specific language governing rights and limitations under the
+/ License.
+/
+/ The Original Code is the FreeXL library
+/
+/ The Initial Developer of the Original Code is Alessandro Furieri
+/ 
+/ Portions created by the Initial Developer are Copyright (C) 2021
+/ the Initial Developer. All Rights Reserved.
+/ 
+/ Contributor(s):
+/
+/ Alternatively, the contents of this file may be used under the terms of
+/ either the GNU General Public License Version 2 or later (the "GPL"), or
+/ the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+/ in which case the provisions of the GPL or the LGPL are applicable instead
+/ of those above. If you wish to allow use of your version of this file only
+/ under the terms of either the GPL or the LGPL, and not to allow others to
+/ use your version of this file under the terms of the MPL, indicate your
+/ decision by deleting the provisions above and replace them with the notice
+/ and other provisions required by the GPL or the LGPL. If you do not delete
+/ the provisions above, a recipient may use your version of this file under
+/ the terms of any one of the MPL, the GPL or the LGPL.
+/ 
+*/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "freexl.h"
+
+#if defined(_WIN32) && !defined(__MINGW32__)
+#include "config-msvc.h"
+#else
+#include "config.h"
+#endif
+
+#include "check_helpers.h"
+
+#ifndef OMIT_XMLDOC		/* XML support is enabled */
+static int
+check_document (const char *path, int xml_pipeline)
+{
+/* opening the same document both ways, then comparing every cell */
+    FreeXL_OpenOptions options;
+    const void *fast;
+    const void *xml;
+    unsigned int count;
+    unsigned int xml_count;
+    unsigned short idx;
+    int ret;
+
+    freexl_init_open_options (&options);
+    options.xml_pipeline = xml_pipeline;
+    ret = freexl_open_xlsx_ex (path, &options, &fast);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "OPEN ERROR %s: %d\n", path, ret);
+	  return -1;
+      }
+    options.xlsx_xml_only = 1;
+    ret = freexl_open_xlsx_ex (path, &options, &xml);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "OPEN XML ONLY ERROR %s: %d\n", path, ret);
+	  return -2;
+      }
+
+    ret = freexl_get_worksheets_count (fast, &count);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "GET SHEET COUNT ERROR %s: %d\n", path, ret);
+	  return -3;
+      }
+    ret = freexl_get_worksheets_count (xml, &xml_count);
+    if (ret != FREEXL_OK || xml_count != count)
+      {
+	  fprintf (stderr, "Unexpected sheet count %s: %d %u/%u\n", path, ret,
+		   xml_count, count);
+	  return -4;
+      }
+
+    for (idx = 0; idx < count; idx++)
+      {
+	  unsigned int rows;
+	  unsigned short columns;
+	  unsigned int xml_rows;
+	  unsigned short xml_columns;
+	  unsigned int row;
+	  unsigned short col;
+
+	  ret = freexl_select_active_worksheet (fast, idx);
+	  if (ret != FREEXL_OK)
+	    {
+		fprintf (stderr, "SELECT ERROR %s: %d\n", path, ret);
+		return -5;
+	    }
+	  ret = freexl_select_active_worksheet (xml, idx);
+	  if (ret != FREEXL_OK)
+	    {
+		fprintf (stderr, "SELECT XML ONLY ERROR %s: %d\n", path, ret);
+		return -6;
+	    }
+	  ret = freexl_worksheet_dimensions (fast, &rows, &columns);
+	  if (ret != FREEXL_OK)
+	    {
+		fprintf (stderr, "DIMENSIONS ERROR %s: %d\n", path, ret);
+		return -7;
+	    }
+	  ret = freexl_worksheet_dimensions (xml, &xml_rows, &xml_columns);
+	  if (ret != FREEXL_OK)
+	    {
+		fprintf (stderr, "DIMENSIONS XML ONLY ERROR %s: %d\n", path,
+			 ret);
+		return -8;
+	    }
+	  if (xml_rows != rows || xml_columns != columns)
+	    {
+		fprintf (stderr, "Unexpected dimensions %s: %u/%u %u/%u\n",
+			 path, xml_rows, xml_columns, rows, columns);
+		return -9;
+	    }
+	  if (columns == 0)
+	      continue;		/* empty sheet */
+
+	  for (row = 0; row < rows; row++)
+	    {
+		for (col = 0; col < columns; col++)
+		  {
+		      FreeXL_CellValue cell;
+		      FreeXL_CellValue xml_cell;
+		      ret = freexl_get_cell_value (fast, row, col, &cell);
+		      if (ret != FREEXL_OK)
+			{
+			    fprintf (stderr, "GET CELL ERROR %s: %d\n", path,
+				     ret);
+			    return -10;
+			}
+		      ret = freexl_get_cell_value (xml, row, col, &xml_cell);
+		      if (ret != FREEXL_OK)
+			{
+			    fprintf (stderr, "GET CELL XML ONLY ERROR %s: %d\n",
+				     path, ret);
+			    return -11;
+			}
+		      if (!same_value (&cell, &xml_cell))
+			{
+			    fprintf (stderr,
+				     "Mismatching cell %s sheet %u %u/%u\n",
+				     path, idx, row, col);
+			    return -12;
+			}
+		  }
+	    }
+      }
+
+    freexl_close (xml);
+    freexl_close (fast);
+    return 0;
+}
+#endif /* end conditional XML support */
+
+int
+main (int argc, char *argv[])
+{
+#ifdef OMIT_XMLDOC		/* XML support is not enabled */
+    fprintf (stderr,
+	     "Sorry, this version of check_xlsx_fast_scan was built by disabling support XML documents\n");
+#else
+    const char *paths[] = {
+	"testdata/test_xml.xlsx",
+	"testdata/test_wide.xlsx",
+	"testdata/test_stored.xlsx",
+	"testdata/test_styled.xlsx",
+	"testdata/test_dimension.xlsx",
+	"testdata/test_rowless.xlsx",
+	NULL
+    };
+    int i;
+    int ret;
+
+    for (i = 0; paths[i] != NULL; i++)
+      {
+	  ret = check_document (paths[i], 0);
+	  if (ret != 0)
+	      return ret - (i * 100);
+	  ret = check_document (paths[i], 1);
+	  if (ret != 0)
+	      return ret - (i * 100) - 50;
+      }
+#endif /* end conditional XML support */
+
+    if (argc > 1 || argv[0] == NULL)
+	argc = 1;		/* silencing stupid compiler warnings */
+
+    return 0;
+}
@@ -0,0 +1,229 @@
+/* 
+/ check_xlsx_lazy_strings.c
+/
+/ Test cases for XLSX lazy SharedStrings
+/
+/ ------------------------------------------------------------------------------
+/ 
+/ Version: MPL 1.1/GPL 2.0/LGPL 2.1
+/ 
+/ The contents of this file are subject to the Mozilla Public License Version
+/ 1.1 (the "License"); you may not use this file except in compliance with
+/ the License. You may obtain a copy of the License at
+/ http://www.mozilla.org/MPL/
+/ 
+/ Software distributed under the License is distributed on an "AS IS" basis,
+/ WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+/ for the specific language governing rights and limitations under the
+/ License.
+/
+/ The Original Code is the FreeXL library
+/
+/ The Initial Developer of the Original Code is Alessandro Furieri
+/ 
+/ Portions created by the Initial Developer are Copyright (C) 2021
+/ the Initial Developer. All Rights Reserved.
+/ 
+/ Contributor(s):
+/
+/ Alternatively, the contents of this file may be used under the terms of
+/ either the GNU General Public License Version 2 or later (the "GPL"), or
+/ the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+/ in which case the provisions of the GPL or the LGPL are applicable instead
+/ of those above. If you wish to allow use of your version of this file only
+/ under the terms of either the GPL or the LGPL, and not to allow others to
+/ use your version of this file under the terms of the MPL, indicate your
+/ decision by deleting the provisions above and replace them with the notice
+/ and other provisions required by the GPL or the LGPL. If you do not delete
+/ the provisions above, a recipient may use your version of this file under
+/ the terms of any one of the MPL, the GPL or the LGPL.
+/ 
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "freexl.h"
+
+#if defined(_WIN32) && !defined(__MINGW32__)
+#include "config-msvc.h"
+#else
+#include "config.h"
+#endif
+
+#include "check_helpers.h"
+
+#define LOOKUPS	100
+
+static int
+check_mode (const char *path, const void *eager, unsigned int expected,
+	    int mode, int cache)
+{
+/* checking a lazy mode against the eager one */
+    const void *handle;
+    int ret;
+    unsigned int count;
+    unsigned int i;
+    unsigned int idx;
+    const char *string1;
+    const char *string2;
+    FreeXL_OpenOptions options;
+
+    freexl_init_open_options (&options);
+    options.xlsx_strings_mode = mode;
+    options.xlsx_strings_cache = cache;
+    ret = freexl_open_xlsx_ex (path, &options, &handle);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "OPEN ERROR (mode %d): %d\n", mode, ret);
+	  return 0;
+      }
+
+    ret = freexl_get_strings_count (handle, &count);
+    if (ret != FREEXL_OK || count != expected)
+      {
+	  fprintf (stderr, "Unexpected string count (mode %d): %u\n", mode,
+		   count);
+	  return 0;
+      }
+    for (i = 0; i < 2 * count + 2 * LOOKUPS; i++)
+      {
+	  /* all strings, twice so to exercise the LRU cache, and then
+	     a few ones in scrambled order and backwards so to exercise
+	     the backward seeks */
+	  if (i < 2 * count)
+	      idx = i % count;
+	  else if (i < 2 * count + LOOKUPS)
+	      idx = (unsigned int) (((unsigned long long) i * 7919) % count);
+	  else
+	      idx = count - 1 - ((i - 2 * count - LOOKUPS) % count);
+	  ret = freexl_get_SST_string (eager, idx, &string1);
+	  if (ret != FREEXL_OK)
+	      return 0;
+	  ret = freexl_get_SST_string (handle, idx, &string2);
+	  if (ret != FREEXL_OK || string2 == NULL)
+	    {
+		fprintf (stderr, "Error getting string #%u (mode %d)\n", idx,
+			 mode);
+		return 0;
+	    }
+	  if (strcmp (string1, string2) != 0)
+	    {
+		fprintf (stderr, "Mismatching string #%u (mode %d): %s\n",
+			 idx, mode, string2);
+		return 0;
+	    }
+      }
+    ret = freexl_get_SST_string (handle, count, &string2);
+    if (ret != FREEXL_XLSX_ILLEGAL_SST_INDEX)
+      {
+	  fprintf (stderr, "Unexpected result for string #%u: %d\n", count,
+		   ret);
+	  return 0;
+      }
+
+    if (!compare_sheet (eager, handle, 0))
+	return 0;
+    if (!compare_sheet (eager, handle, 1))
+	return 0;
+
+    ret = freexl_close (handle);
+    if (ret != FREEXL_OK)
+	return 0;
+    return 1;
+}
+
+static int
+check_file (const char *path, unsigned int expected)
+{
+/* checking all lazy modes for the same file */
+    const void *handle;
+    int ret;
+
+    ret = freexl_open_xlsx (path, &handle);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "OPEN ERROR (%s): %d\n", path, ret);
+	  return 0;
+      }
+
+    if (!check_mode (path, handle, expected, FREEXL_XLSX_STRINGS_LAZY, 0))
+	return 0;
+    if (!check_mode (path, handle, expected, FREEXL_XLSX_STRINGS_LAZY, 2))
+	return 0;
+    if (!check_mode
+	(path, handle, expected, FREEXL_XLSX_STRINGS_LAZY_TMPFILE, 3))
+	return 0;
+
+    ret = freexl_close (handle);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "CLOSE ERROR (%s): %d\n", path, ret);
+	  return 0;
+      }
+    return 1;
+}
+
+static int
+check_utf16 (void)
+{
+/* the UTF-16 sharedStrings must decode just as the UTF-8 ones */
+    const void *handle1;
+    const void *handle2;
+    FreeXL_OpenOptions options;
+    unsigned int i;
+    const char *string1;
+    const char *string2;
+    int ok = 1;
+
+    freexl_init_open_options (&options);
+    options.xlsx_strings_mode = FREEXL_XLSX_STRINGS_LAZY;
+    if (freexl_open_xlsx ("testdata/test_xml.xlsx", &handle1) != FREEXL_OK)
+	return 0;
+    if (freexl_open_xlsx_ex ("testdata/test_utf16.xlsx", &options, &handle2)
+	!= FREEXL_OK)
+      {
+	  freexl_close (handle1);
+	  return 0;
+      }
+    for (i = 0; i < 21; i++)
+      {
+	  if (freexl_get_SST_string (handle1, i, &string1) != FREEXL_OK
+	      || freexl_get_SST_string (handle2, i, &string2) != FREEXL_OK
+	      || string1 == NULL || string2 == NULL
+	      || strcmp (string1, string2) != 0)
+	    {
+		fprintf (stderr, "Mismatching UTF-16 string #%u\n", i);
+		ok = 0;
+		break;
+	    }
+      }
+    freexl_close (handle1);
+    freexl_close (handle2);
+    return ok;
+}
+
+int
+main (int argc, char *argv[])
+{
+#ifdef OMIT_XMLDOC		/* XML support is not enabled */
+    fprintf (stderr,
+	     "Sorry, this version of check_xlsx_lazy_strings was built by disabling support XML documents\n");
+    return 0;
+#else
+    if (!check_file ("testdata/test_xml.xlsx", 21))
+	return -1;
+    if (!check_file ("testdata/test_utf16.xlsx", 21))
+	return -2;
+    if (!check_file ("testdata/test_manystrings.xlsx", 12000))
+	return -3;
+    if (!check_utf16 ())
+	return -4;
+
+    if (argc > 1 || argv[0] == NULL)
+	argc = 1;		/* silencing stupid compiler warnings */
+
+    return 0;
+#endif /* end conditional XML support */
+}
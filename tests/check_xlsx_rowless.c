@@ -0,0 +1,253 @@
+/* 
+/ check_xlsx_rowless.c
+/
+/ Test cases for XLSX rows lacking any "r" attribute
+/
+/ ------------------------------------------------------------------------------
+/ 
+/ Version: MPL 1.1/GPL 2.0/LGPL 2.1
+/ 
+/ The contents of this file are subject to the Mozilla Public License Version
+/ 1.1 (the "License"); you may not use this file except in compliance with
+/ the License. You may obtain a copy of the License at
+/ http://www.mozilla.org/MPL/
+/ 
+/ Software distributed under the License is distributed on an "AS IS" basis,
+/ WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+/ for the specific language governing rights and limitations under the
+/ License.
+/
+/ The Original Code is the FreeXL library
+/
+/ The Initial Developer of the Original Code is Alessandro Furieri
+/ 
+/ Portions created by the Initial Developer are Copyright (C) 2021
+/ the Initial Developer. All Rights Reserved.
+/ 
+/ Contributor(s):
+/
+/ Alternatively, the contents of this file may be used under the terms of
+/ either the GNU General Public License Version 2 or later (the "GPL"), or
+/ the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+/ in which case the provisions of the GPL or the LGPL are applicable instead
+/ of those above. If you wish to allow use of your version of this file only
+/ under the terms of either the GPL or the LGPL, and not to allow others to
+/ use your version of this file under the terms of the MPL, indicate your
+/ decision by deleting the provisions above and replace them with the notice
+/ and other provisions required by the GPL or the LGPL. If you do not delete
+/ the provisions above, a recipient may use your version of this file under
+/ the terms of any one of the MPL, the GPL or the LGPL.
+/ 
+*/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "freexl.h"
+
+#if defined(_WIN32) && !defined(__MINGW32__)
+#include "config-msvc.h"
+#else
+#include "config.h"
+#endif
+
+#ifndef OMIT_XMLDOC		/* XML support is enabled */
+struct expected_cell
+{
+    unsigned short sheet;
+    unsigned int row;
+    unsigned short col;
+    int type;
+    double value;
+    const char *text;
+};
+
+static const struct expected_cell expected[] = {
+    {0, 0, 0, FREEXL_CELL_INT, 1, NULL},
+    {0, 0, 1, FREEXL_CELL_INT, 2, NULL},
+    {0, 4, 0, FREEXL_CELL_INT, 5, NULL},
+    {0, 4, 1, FREEXL_CELL_INT, 6, NULL},
+    {0, 5, 0, FREEXL_CELL_INT, 7, NULL},
+    {0, 5, 1, FREEXL_CELL_INT, 8, NULL},
+    {0, 6, 0, FREEXL_CELL_INT, 9, NULL},
+    {0, 11, 0, FREEXL_CELL_INT, 10, NULL},
+    {0, 11, 2, FREEXL_CELL_INT, 11, NULL},
+    {0, 13, 0, FREEXL_CELL_INT, 14, NULL},
+    {1, 1, 0, FREEXL_CELL_SST_TEXT, 0, "alpha"},
+    {1, 3, 0, FREEXL_CELL_INT, 4, NULL},
+    {1, 4, 0, FREEXL_CELL_DOUBLE, 1.5, NULL},
+    {1, 4, 1, FREEXL_CELL_DOUBLE, 2.5, NULL},
+    {1, 5, 1, FREEXL_CELL_SST_TEXT, 0, NULL},
+    {0, 0, 0, FREEXL_CELL_NULL, 0, NULL}
+};
+
+static int
+check_cell (const FreeXL_CellValue * cell, const struct expected_cell *exp)
+{
+/* checking a Cell value against the expected one */
+    if (cell->type != exp->type)
+	return 0;
+    switch (cell->type)
+      {
+      case FREEXL_CELL_INT:
+	  return cell->value.int_value == (int) (exp->value);
+      case FREEXL_CELL_DOUBLE:
+	  return cell->value.double_value == exp->value;
+      case FREEXL_CELL_SST_TEXT:
+	  if (exp->text == NULL)
+	      return 1;
+	  return strcmp (cell->value.text_value, exp->text) == 0;
+      };
+    return 0;
+}
+
+static int
+check_document (const FreeXL_OpenOptions * options)
+{
+/* checking every cell of both Worksheets */
+    const void *handle;
+    unsigned short idx;
+    int found = 0;
+    int n_expected = 0;
+    int ret;
+    FreeXL_CellValue value;
+
+    ret = freexl_open_xlsx_ex ("testdata/test_rowless.xlsx", options, &handle);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "OPEN ERROR: %d\n", ret);
+	  return -1;
+      }
+    while (expected[n_expected].type != FREEXL_CELL_NULL)
+	n_expected++;
+
+    for (idx = 0; idx < 2; idx++)
+      {
+	  unsigned int rows;
+	  unsigned short columns;
+	  unsigned int row;
+	  unsigned short col;
+
+	  ret = freexl_select_active_worksheet (handle, idx);
+	  if (ret != FREEXL_OK)
+	    {
+		fprintf (stderr, "SELECT ERROR: %d\n", ret);
+		return -2;
+	    }
+	  ret = freexl_worksheet_dimensions (handle, &rows, &columns);
+	  if (ret != FREEXL_OK)
+	    {
+		fprintf (stderr, "DIMENSIONS ERROR: %d\n", ret);
+		return -3;
+	    }
+	  if (rows != (idx == 0 ? 14 : 6) || columns != (idx == 0 ? 3 : 2))
+	    {
+		fprintf (stderr, "Unexpected dimensions #%u: %u/%u\n", idx,
+			 rows, columns);
+		return -4;
+	    }
+
+	  for (row = 0; row < rows; row++)
+	    {
+		for (col = 0; col < columns; col++)
+		  {
+		      FreeXL_CellValue cell;
+		      int i;
+		      ret = freexl_get_cell_value (handle, row, col, &cell);
+		      if (ret != FREEXL_OK)
+			{
+			    fprintf (stderr, "GET CELL ERROR: %d\n", ret);
+			    return -5;
+			}
+		      if (cell.type == FREEXL_CELL_NULL)
+			  continue;
+		      for (i = 0; i < n_expected; i++)
+			{
+			    if (expected[i].sheet == idx
+				&& expected[i].row == row
+				&& expected[i].col == col)
+				break;
+			}
+		      if (i == n_expected || !check_cell (&cell, expected + i))
+			{
+			    fprintf (stderr, "Unexpected cell #%u %u/%u\n",
+				     idx, row, col);
+			    return -6;
+			}
+		      found++;
+		  }
+	    }
+      }
+    if (found != n_expected)
+      {
+	  fprintf (stderr, "Unexpected cell count: %d\n", found);
+	  return -7;
+      }
+    freexl_close (handle);
+
+/* a cell reference disagreeing with its own row: the row wins */
+    ret = freexl_open_xlsx_ex ("testdata/test_badrow.xlsx", options, &handle);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "OPEN ERROR test_badrow.xlsx: %d\n", ret);
+	  return -8;
+      }
+    ret = freexl_select_active_worksheet (handle, 0);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "SELECT ERROR test_badrow.xlsx: %d\n", ret);
+	  return -9;
+      }
+    ret = freexl_get_cell_value (handle, 1, 0, &value);
+    if (ret != FREEXL_OK || value.type != FREEXL_CELL_INT
+	|| value.value.int_value != 3)
+      {
+	  fprintf (stderr, "Unexpected cell test_badrow.xlsx: %d\n", ret);
+	  return -10;
+      }
+    ret = freexl_get_cell_value (handle, 2, 0, &value);
+    if (ret == FREEXL_OK && value.type != FREEXL_CELL_NULL)
+      {
+	  fprintf (stderr, "Unexpected cell #3 test_badrow.xlsx\n");
+	  return -11;
+      }
+    freexl_close (handle);
+    return 0;
+}
+#endif /* end conditional XML support */
+
+int
+main (int argc, char *argv[])
+{
+#ifdef OMIT_XMLDOC		/* XML support is not enabled */
+    fprintf (stderr,
+	     "Sorry, this version of check_xlsx_rowless was built by disabling support XML documents\n");
+#else
+    FreeXL_OpenOptions options;
+    int ret;
+
+    freexl_init_open_options (&options);
+    ret = check_document (&options);
+    if (ret != 0)
+	return ret;
+    options.xml_pipeline = 1;
+    ret = check_document (&options);
+    if (ret != 0)
+	return ret - 10;
+    options.xlsx_xml_only = 1;
+    ret = check_document (&options);
+    if (ret != 0)
+	return ret - 20;
+    options.xml_pipeline = 0;
+    ret = check_document (&options);
+    if (ret != 0)
+	return ret - 30;
+#endif /* end conditional XML support */
+
+    if (argc > 1 || argv[0] == NULL)
+	argc = 1;		/* silencing stupid compiler warnings */
+
+    return 0;
+}
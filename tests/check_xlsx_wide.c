@@ -0,0 +1,180 @@
+/* 
+/ check_xlsx_wide.c
+/
+/ Test cases for XLSX cell references (wide sheets)
+/
+/ ------------------------------------------------------------------------------
+/ 
+/ Version: MPL 1.1/GPL 2.0/LGPL 2.1
+/ 
+/ The contents of this file are subject to the Mozilla Public License Version
+/ 1.1 (the "License"); you may not use this file except in compliance with
+/ the License. You may obtain a copy of the License at
+/ http://www.mozilla.org/MPL/
+/ 
+/ Software distributed under the License is distributed on an "AS IS" basis,
+/ WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+/ for the specific language governing rights and limitations under the
+/ License.
+/
+/ The Original Code is the FreeXL library
+/
+/ The Initial Developer of the Original Code is Alessandro Furieri
+/ 
+/ Portions created by the Initial Developer are Copyright (C) 2021
+/ the Initial Developer. All Rights Reserved.
+/ 
+/ Contributor(s):
+/
+/ Alternatively, the contents of this file may be used under the terms of
+/ either the GNU General Public License Version 2 or later (the "GPL"), or
+/ the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+/ in which case the provisions of the GPL or the LGPL are applicable instead
+/ of those above. If you wish to allow use of your version of this file only
+/ under the terms of either the GPL or the LGPL, and not to allow others to
+/ use your version of this file under the terms of the MPL, indicate your
+/ decision by deleting the provisions above and replace them with the notice
+/ and other provisions required by the GPL or the LGPL. If you do not delete
+/ the provisions above, a recipient may use your version of this file under
+/ the terms of any one of the MPL, the GPL or the LGPL.
+/ 
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "freexl.h"
+
+#if defined(_WIN32) && !defined(__MINGW32__)
+#include "config-msvc.h"
+#else
+#include "config.h"
+#endif
+
+static int
+check_int_cell (const void *handle, unsigned int row, unsigned short col,
+		int expected)
+{
+/* checking an INTEGER cell value */
+    FreeXL_CellValue cell_value;
+    int ret = freexl_get_cell_value (handle, row, col, &cell_value);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "Error on cell (%u,%u): %d\n", row, col, ret);
+	  return 0;
+      }
+    if (cell_value.type != FREEXL_CELL_INT)
+      {
+	  fprintf (stderr, "Unexpected cell (%u,%u) type: %u\n", row, col,
+		   cell_value.type);
+	  return 0;
+      }
+    if (cell_value.value.int_value != expected)
+      {
+	  fprintf (stderr, "Unexpected cell (%u,%u) value: %d\n", row, col,
+		   cell_value.value.int_value);
+	  return 0;
+      }
+    return 1;
+}
+
+int
+main (int argc, char *argv[])
+{
+#ifdef OMIT_XMLDOC		/* XML support is not enabled */
+    fprintf (stderr,
+	     "Sorry, this version of check_xlsx_wide was built by disabling support XML documents\n");
+    return 0;
+#else
+    const void *handle;
+    int ret;
+    unsigned int num_rows;
+    unsigned short num_columns;
+    FreeXL_CellValue cell_value;
+
+    ret = freexl_open_xlsx ("testdata/test_wide.xlsx", &handle);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "OPEN ERROR: %d\n", ret);
+	  return -1;
+      }
+
+    ret = freexl_select_active_worksheet (handle, 0);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "Error setting active worksheet: %d\n", ret);
+	  return -2;
+      }
+
+    ret = freexl_worksheet_dimensions (handle, &num_rows, &num_columns);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "Error getting worksheet dimensions: %d\n", ret);
+	  return -3;
+      }
+    if ((num_rows != 4) || (num_columns != 16384))
+      {
+	  fprintf (stderr, "Unexpected active sheet dimensions: %u x %u\n",
+		   num_rows, num_columns);
+	  return -4;
+      }
+
+    /* one, two and three letters column references */
+    if (!check_int_cell (handle, 0, 0, 1))
+	return -5;
+    if (!check_int_cell (handle, 0, 25, 26))
+	return -6;
+    if (!check_int_cell (handle, 0, 26, 27))
+	return -7;
+    if (!check_int_cell (handle, 0, 51, 52))
+	return -8;
+    if (!check_int_cell (handle, 0, 701, 702))
+	return -9;
+    if (!check_int_cell (handle, 0, 702, 703))
+	return -10;
+    if (!check_int_cell (handle, 0, 16383, 16384))
+	return -11;
+
+    /* row and cells lacking any reference */
+    if (!check_int_cell (handle, 1, 0, 10))
+	return -12;
+    if (!check_int_cell (handle, 1, 1, 20))
+	return -13;
+    if (!check_int_cell (handle, 1, 4, 50))
+	return -14;
+    if (!check_int_cell (handle, 1, 5, 60))
+	return -15;
+
+    ret = freexl_get_cell_value (handle, 3, 16383, &cell_value);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "Error on cell (3,16383): %d\n", ret);
+	  return -16;
+      }
+    if (cell_value.type != FREEXL_CELL_SST_TEXT)
+      {
+	  fprintf (stderr, "Unexpected cell (3,16383) type: %u\n",
+		   cell_value.type);
+	  return -17;
+      }
+    if (strcmp (cell_value.value.text_value, "alpha") != 0)
+      {
+	  fprintf (stderr, "Unexpected cell (3,16383) value: %s\n",
+		   cell_value.value.text_value);
+	  return -18;
+      }
+
+    ret = freexl_close (handle);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "CLOSE ERROR: %d\n", ret);
+	  return -19;
+      }
+
+    if (argc > 1 || argv[0] == NULL)
+	argc = 1;		/* silencing stupid compiler warnings */
+
+    return 0;
+#endif /* end conditional XML support */
+}
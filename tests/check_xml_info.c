@@ -0,0 +1,313 @@
+/* 
+/ check_xml_info.c
+/
+/ Test cases for the metadata-only XLSX and ODS open
+/
+/ ------------------------------------------------------------------------------
+/ 
+/ Version: MPL 1.1/GPL 2.0/LGPL 2.1
+/ 
+/ The contents of this file are subject to the Mozilla Public License Version
+/ 1.1 (the "License"); you may not use this file except in compliance with
+/ the License. You may obtain a copy of the License at
+/ http://www.mozilla.org/MPL/
+/ 
+/ Software distributed under the License is distributed on an "AS IS" basis,
+/ WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+/ for the specific language governing rights and limitations under the
+/ License.
+/
+/ The Original Code is the FreeXL library
+/
+/ The Initial Developer of the Original Code is Alessandro Furieri
+/ 
+/ Portions created by the Initial Developer are Copyright (C) 2021
+/ the Initial Developer. All Rights Reserved.
+/ 
+/ Contributor(s):
+/
+/ Alternatively, the contents of this file may be used under the terms of
+/ either the GNU General Public License Version 2 or later (the "GPL"), or
+/ the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+/ in which case the provisions of the GPL or the LGPL are applicable instead
+/ of those above. If you wish to allow use of your version of this file only
+/ under the terms of either the GPL or the LGPL, and not to allow others to
+/ use your version of this file under the terms of the MPL, indicate your
+/ decision by deleting the provisions above and replace them with the notice
+/ and other provisions required by the GPL or the LGPL. If you do not delete
+/ the provisions above, a recipient may use your version of this file under
+/ the terms of any one of the MPL, the GPL or the LGPL.
+/ 
+*/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "freexl.h"
+
+#if defined(_WIN32) && !defined(__MINGW32__)
+#include "config-msvc.h"
+#else
+#include "config.h"
+#endif
+
+#define MODE_XLSX	1
+#define MODE_ODS	2
+
+#ifndef OMIT_XMLDOC		/* XML support is enabled */
+static int
+check_document (const char *path, int mode, int string_count)
+{
+/* comparing the metadata-only open against the full open */
+    const void *full;
+    const void *info;
+    unsigned int count;
+    unsigned int info_count;
+    unsigned int strings;
+    unsigned short idx;
+    int ret;
+
+    if (mode == MODE_XLSX)
+	ret = freexl_open_xlsx (path, &full);
+    else
+	ret = freexl_open_ods (path, &full);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "OPEN ERROR %s: %d\n", path, ret);
+	  return -1;
+      }
+    if (mode == MODE_XLSX)
+	ret = freexl_open_xlsx_info (path, &info);
+    else
+	ret = freexl_open_ods_info (path, &info);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "OPEN INFO ERROR %s: %d\n", path, ret);
+	  return -2;
+      }
+
+    ret = freexl_get_worksheets_count (full, &count);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "GET SHEET COUNT ERROR %s: %d\n", path, ret);
+	  return -3;
+      }
+    ret = freexl_get_info (info, FREEXL_BIFF_SHEET_COUNT, &info_count);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "GET INFO SHEET COUNT ERROR %s: %d\n", path, ret);
+	  return -4;
+      }
+    if (info_count != count)
+      {
+	  fprintf (stderr, "Unexpected sheet count %s: %u/%u\n", path,
+		   info_count, count);
+	  return -5;
+      }
+
+    ret = freexl_get_info (info, FREEXL_BIFF_STRING_COUNT, &strings);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "GET INFO STRING COUNT ERROR %s: %d\n", path, ret);
+	  return -6;
+      }
+    if ((int) strings != string_count)
+      {
+	  fprintf (stderr, "Unexpected string count %s: %u\n", path, strings);
+	  return -7;
+      }
+    if (mode == MODE_XLSX)
+      {
+	  unsigned int full_strings;
+	  ret = freexl_get_strings_count (full, &full_strings);
+	  if (ret != FREEXL_OK || full_strings != strings)
+	    {
+		fprintf (stderr, "Mismatching string count %s: %u/%u\n",
+			 path, strings, full_strings);
+		return -20;
+	    }
+      }
+    ret = freexl_get_info (info, FREEXL_BIFF_CODEPAGE, &strings);
+    if (ret != FREEXL_OK || strings != FREEXL_UNKNOWN)
+      {
+	  fprintf (stderr, "Unexpected codepage info %s: %d\n", path, ret);
+	  return -8;
+      }
+
+    for (idx = 0; idx < count; idx++)
+      {
+	  const char *name;
+	  const char *info_name;
+	  unsigned int rows;
+	  unsigned short columns;
+	  unsigned int info_rows;
+	  unsigned int info_columns;
+	  FreeXL_CellValue cell;
+	  const void *iterator;
+
+	  ret = freexl_get_worksheet_name (full, idx, &name);
+	  if (ret != FREEXL_OK)
+	    {
+		fprintf (stderr, "GET NAME ERROR %s: %d\n", path, ret);
+		return -9;
+	    }
+	  ret = freexl_get_worksheet_name (info, idx, &info_name);
+	  if (ret != FREEXL_OK)
+	    {
+		fprintf (stderr, "GET INFO NAME ERROR %s: %d\n", path, ret);
+		return -10;
+	    }
+	  if (strcmp (name, info_name) != 0)
+	    {
+		fprintf (stderr, "Unexpected sheet name %s: %s/%s\n", path,
+			 info_name, name);
+		return -11;
+	    }
+
+	  ret = freexl_select_active_worksheet (info, idx);
+	  if (ret != FREEXL_OK)
+	    {
+		fprintf (stderr, "SELECT INFO ERROR %s: %d\n", path, ret);
+		return -12;
+	    }
+	  ret = freexl_get_info (info, FREEXL_SHEET_ROWS, &info_rows);
+	  if (ret != FREEXL_OK)
+	    {
+		fprintf (stderr, "GET INFO ROWS ERROR %s: %d\n", path, ret);
+		return -13;
+	    }
+	  ret = freexl_get_info (info, FREEXL_SHEET_COLUMNS, &info_columns);
+	  if (ret != FREEXL_OK)
+	    {
+		fprintf (stderr, "GET INFO COLUMNS ERROR %s: %d\n", path, ret);
+		return -14;
+	    }
+
+	  /* no cell at all is loaded: cell reads are rejected */
+	  ret = freexl_get_cell_value (info, 0, 0, &cell);
+	  if (ret != FREEXL_INVALID_HANDLE)
+	    {
+		fprintf (stderr, "Unexpected cell read %s: %d\n", path, ret);
+		return -19;
+	    }
+	  ret = freexl_get_row_values (info, 0, 0, 1, &cell);
+	  if (ret != FREEXL_INVALID_HANDLE)
+	    {
+		fprintf (stderr, "Unexpected row read %s: %d\n", path, ret);
+		return -21;
+	    }
+	  ret = freexl_create_cell_iterator (info, &iterator);
+	  if (ret != FREEXL_INVALID_HANDLE || iterator != NULL)
+	    {
+		fprintf (stderr, "Unexpected iterator %s: %d\n", path, ret);
+		return -22;
+	    }
+
+	  if (mode == MODE_ODS)
+	    {
+		/* ODS never declares any dimension */
+		if (info_rows != FREEXL_UNKNOWN
+		    || info_columns != FREEXL_UNKNOWN)
+		  {
+		      fprintf (stderr, "Unexpected ODS dimension %s: %u/%u\n",
+			       path, info_rows, info_columns);
+		      return -15;
+		  }
+		continue;
+	    }
+
+	  /* the declared dimension must match the full open */
+	  ret = freexl_select_active_worksheet (full, idx);
+	  if (ret != FREEXL_OK)
+	    {
+		fprintf (stderr, "SELECT ERROR %s: %d\n", path, ret);
+		return -16;
+	    }
+	  ret = freexl_worksheet_declared_dimensions (full, &rows, &columns);
+	  if (ret != FREEXL_OK)
+	    {
+		fprintf (stderr, "DECLARED DIMENSIONS ERROR %s: %d\n", path,
+			 ret);
+		return -17;
+	    }
+	  if (info_rows != rows || info_columns != columns)
+	    {
+		fprintf (stderr, "Unexpected dimension %s: %u/%u %u/%u\n",
+			 path, info_rows, info_columns, rows, columns);
+		return -18;
+	    }
+
+      }
+
+    freexl_close (info);
+    freexl_close (full);
+    return 0;
+}
+#endif /* end conditional XML support */
+
+int
+main (int argc, char *argv[])
+{
+    int ret;
+    const void *handle;
+    unsigned int info;
+    FreeXL_CellValue cell;
+
+/* XLS reports the declared dimensions as well */
+    ret = freexl_open_info ("testdata/testcase1.xls", &handle);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "OPEN INFO ERROR: %d\n", ret);
+	  return -1;
+      }
+    ret = freexl_select_active_worksheet (handle, 0);
+    if (ret != FREEXL_OK)
+      {
+	  fprintf (stderr, "SELECT ERROR: %d\n", ret);
+	  return -2;
+      }
+    ret = freexl_get_info (handle, FREEXL_SHEET_ROWS, &info);
+    if (ret != FREEXL_OK || info != 17)
+      {
+	  fprintf (stderr, "Unexpected XLS rows: %d/%u\n", ret, info);
+	  return -3;
+      }
+    ret = freexl_get_info (handle, FREEXL_SHEET_COLUMNS, &info);
+    if (ret != FREEXL_OK || info != 19)
+      {
+	  fprintf (stderr, "Unexpected XLS columns: %d/%u\n", ret, info);
+	  return -4;
+      }
+    ret = freexl_get_cell_value (handle, 0, 0, &cell);
+    if (ret != FREEXL_INVALID_HANDLE)
+      {
+	  fprintf (stderr, "Unexpected XLS cell read: %d\n", ret);
+	  return -5;
+      }
+    freexl_close (handle);
+
+#ifdef OMIT_XMLDOC		/* XML support is not enabled */
+    fprintf (stderr,
+	     "Sorry, this version of check_xml_info was built by disabling support XML documents\n");
+#else
+    ret = check_document ("testdata/test_xml.xlsx", MODE_XLSX, 21);
+    if (ret != 0)
+	return ret - 100;
+    ret = check_document ("testdata/test_styled.xlsx", MODE_XLSX, 21);
+    if (ret != 0)
+	return ret - 200;
+    ret = check_document ("testdata/test_dimension.xlsx", MODE_XLSX, 21);
+    if (ret != 0)
+	return ret - 300;
+    ret = check_document ("testdata/test_xml.ods", MODE_ODS, 0);
+    if (ret != 0)
+	return ret - 400;
+#endif /* end conditional XML support */
+
+    if (argc > 1 || argv[0] == NULL)
+	argc = 1;		/* silencing stupid compiler warnings */
+
+    return 0;
+}